@@ -10,9 +10,24 @@ LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
 LOCAL_CFLAGS := -DVDEF_API_EXPORTS -fvisibility=hidden -std=gnu11 -D_GNU_SOURCE
 LOCAL_SRC_FILES := \
 	src/vdefs.c \
+	src/vdefs_chroma.c \
+	src/vdefs_convert.c \
+	src/vdefs_data.c \
+	src/vdefs_demosaic.c \
 	src/vdefs_formats.c \
+	src/vdefs_gamut.c \
 	src/vdefs_json.c \
-	src/vdefs_params.c
+	src/vdefs_layout.c \
+	src/vdefs_lut3d.c \
+	src/vdefs_order.c \
+	src/vdefs_params.c \
+	src/vdefs_plan.c \
+	src/vdefs_pool.c \
+	src/vdefs_scale.c \
+	src/vdefs_thread.c \
+	src/vdefs_tile.c \
+	src/vdefs_tone_map.c \
+	src/vdefs_transfer.c
 
 # Public API headers - top level headers first
 # This header list is currently used to generate a python binding
@@ -27,6 +42,8 @@ LOCAL_PRIVATE_LIBRARIES := \
 	json \
 	libulog
 
+LOCAL_LDLIBS := -lm -lpthread
+
 include $(BUILD_LIBRARY)
 
 
@@ -42,16 +59,43 @@ LOCAL_LIBRARIES := \
 	libulog \
 	libvideo-defs
 LOCAL_CFLAGS := -std=gnu11
+LOCAL_LDLIBS := -lm -lpthread
 LOCAL_SRC_FILES := \
 	tests/vdefs_test_calc.c \
+	tests/vdefs_test_convert.c \
 	tests/vdefs_test_csv.c \
+	tests/vdefs_test_data.c \
+	tests/vdefs_test_demosaic.c \
 	tests/vdefs_test_frac.c \
+	tests/vdefs_test_frame.c \
 	tests/vdefs_test_framerate.c \
+	tests/vdefs_test_gamut.c \
 	tests/vdefs_test_json.c \
+	tests/vdefs_test_layout.c \
+	tests/vdefs_test_lut3d.c \
+	tests/vdefs_test_order.c \
+	tests/vdefs_test_plan.c \
+	tests/vdefs_test_pool.c \
 	tests/vdefs_test_resolution.c \
+	tests/vdefs_test_scale.c \
+	tests/vdefs_test_thread.c \
+	tests/vdefs_test_tile.c \
+	tests/vdefs_test_tone_map.c \
+	tests/vdefs_test_transfer.c \
 	tests/vdefs_test_utils.c \
 	tests/vdefs_test.c
 
 include $(BUILD_EXECUTABLE)
 
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := bench-libvideo-defs
+LOCAL_LIBRARIES := \
+	libvideo-defs
+LOCAL_CFLAGS := -std=gnu11
+LOCAL_SRC_FILES := \
+	tests/vdefs_bench.c
+
+include $(BUILD_EXECUTABLE)
+
 endif
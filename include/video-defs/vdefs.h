@@ -174,6 +174,31 @@ enum vdef_transfer_function {
 };
 
 
+/* Transfer function lookup table direction; linear light is normalized
+ * to [0, 1] (1.0 is 10000 cd/m2 for PQ and the nominal peak for the
+ * other transfer functions) */
+enum vdef_transfer_lut_dir {
+	/* Non-linear code values to linear light (EOTF for PQ and sRGB,
+	 * inverse OETF for the other transfer functions) */
+	VDEF_TRANSFER_LUT_DIR_TO_LINEAR = 0,
+
+	/* Linear light to non-linear code values */
+	VDEF_TRANSFER_LUT_DIR_FROM_LINEAR,
+
+	/* Non-linear code values to BT.709 display code values of the same
+	 * bit depth, for quick-look rendering (PQ is tone mapped with the
+	 * BT.2390 EETF as in vdef_tone_map()) */
+	VDEF_TRANSFER_LUT_DIR_TO_BT709,
+
+	VDEF_TRANSFER_LUT_DIR_MAX,
+};
+
+
+/* Forward declarations */
+struct vdef_transfer_lut;
+struct vdef_lut3d;
+
+
 /* Matrix coefficients */
 enum vdef_matrix_coefs {
 	/* Unknown matrix coefficients */
@@ -260,6 +285,53 @@ extern VDEF_API const float vdef_yuv_to_rgb_norm_offset[VDEF_MATRIX_COEFS_MAX]
 extern VDEF_API const float vdef_yuv_to_rgb_norm_matrix[VDEF_MATRIX_COEFS_MAX]
 						       [2][9];
 
+/* Bit depths of the fixed-point YUV <-> RGB conversion tables */
+enum vdef_fixed_depth {
+	/* 8-bit values */
+	VDEF_FIXED_DEPTH_8 = 0,
+
+	/* 10-bit values */
+	VDEF_FIXED_DEPTH_10,
+
+	/* 12-bit values */
+	VDEF_FIXED_DEPTH_12,
+
+	VDEF_FIXED_DEPTH_MAX,
+};
+
+/* Fractional bits of the fixed-point YUV to RGB conversion matrices (Q13) */
+#define VDEF_YUV_TO_RGB_FIXED_SHIFT 13
+
+/* Fractional bits of the fixed-point RGB to YUV conversion matrices (Q14) */
+#define VDEF_RGB_TO_YUV_FIXED_SHIFT 14
+
+/* RGB to YUV conversion offsets and matrices for integer values for both
+ * limited and full range and 8, 10 and 12-bit depths (RGB and YUV values
+ * have the same bit depth).
+ * The matrix is in column-major order and its coefficients have
+ * VDEF_RGB_TO_YUV_FIXED_SHIFT fractional bits.
+ * Note: the matrix multiplication must be done before applying the offset:
+ * YUV = ((RGB * mat + (1 << (VDEF_RGB_TO_YUV_FIXED_SHIFT - 1))) >>
+ *        VDEF_RGB_TO_YUV_FIXED_SHIFT) + off */
+extern VDEF_API const int32_t vdef_rgb_to_yuv_fixed_offset
+	[VDEF_MATRIX_COEFS_MAX][2][VDEF_FIXED_DEPTH_MAX][3];
+extern VDEF_API const int32_t vdef_rgb_to_yuv_fixed_matrix
+	[VDEF_MATRIX_COEFS_MAX][2][VDEF_FIXED_DEPTH_MAX][9];
+
+/* YUV to RGB conversion offsets and matrices for integer values for both
+ * limited and full range and 8, 10 and 12-bit depths (RGB and YUV values
+ * have the same bit depth).
+ * The matrix is in column-major order and its coefficients have
+ * VDEF_YUV_TO_RGB_FIXED_SHIFT fractional bits.
+ * Note: the matrix multiplication must be done after applying the offset
+ * and the result must be clamped to the bit depth range:
+ * RGB = ((YUV + off) * mat + (1 << (VDEF_YUV_TO_RGB_FIXED_SHIFT - 1))) >>
+ *       VDEF_YUV_TO_RGB_FIXED_SHIFT */
+extern VDEF_API const int32_t vdef_yuv_to_rgb_fixed_offset
+	[VDEF_MATRIX_COEFS_MAX][2][VDEF_FIXED_DEPTH_MAX][3];
+extern VDEF_API const int32_t vdef_yuv_to_rgb_fixed_matrix
+	[VDEF_MATRIX_COEFS_MAX][2][VDEF_FIXED_DEPTH_MAX][9];
+
 /* BT.709 to BT.2020 and BT.2020 to BT.709 conversion matrices for linearly
  * represented, normalized RGB values.
  * See Rec. ITU-R BT.2087 and Rep. ITU-R BT.2407.
@@ -782,6 +854,7 @@ enum vdef_raw_pix_order {
 	VDEF_RAW_PIX_ORDER_BACD,
 	VDEF_RAW_PIX_ORDER_BAC = VDEF_RAW_PIX_ORDER_BACD,
 	VDEF_RAW_PIX_ORDER_BA = VDEF_RAW_PIX_ORDER_BACD,
+	VDEF_RAW_PIX_ORDER_UYVY = VDEF_RAW_PIX_ORDER_BACD,
 	VDEF_RAW_PIX_ORDER_BADC,
 	VDEF_RAW_PIX_ORDER_GRBG = VDEF_RAW_PIX_ORDER_BADC,
 	VDEF_RAW_PIX_ORDER_BCAD,
@@ -793,6 +866,7 @@ enum vdef_raw_pix_order {
 	/* C is first pixel */
 	VDEF_RAW_PIX_ORDER_CABD,
 	VDEF_RAW_PIX_ORDER_CAB = VDEF_RAW_PIX_ORDER_CABD,
+	VDEF_RAW_PIX_ORDER_VYUY = VDEF_RAW_PIX_ORDER_CABD,
 	VDEF_RAW_PIX_ORDER_CADB,
 	VDEF_RAW_PIX_ORDER_CBAD,
 	VDEF_RAW_PIX_ORDER_CBA = VDEF_RAW_PIX_ORDER_CBAD,
@@ -828,6 +902,12 @@ enum vdef_raw_pix_layout {
 
 	/* HiSilicon tiled pixel layout (tiles of 64x16) - compressed */
 	VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16_COMPRESSED,
+
+	/* MIPI CSI-2 packed pixel layout (RAW10, RAW12 and RAW14): each group
+	 * of 4 pixels (2 for 12-bit) stores the 8 most significant bits of
+	 * each pixel in one byte, followed by the remaining least significant
+	 * bits of the pixels, first pixel in the lowest bits */
+	VDEF_RAW_PIX_LAYOUT_MIPI_CSI2,
 };
 
 
@@ -865,6 +945,11 @@ enum vdef_raw_data_layout {
 #define VDEF_RAW_MAX_PLANE_COUNT 4
 
 
+/* Default height in lines of raw frame bands (see
+ * vdef_calc_raw_frame_bands()) */
+#define VDEF_RAW_FRAME_BAND_DEFAULT_HEIGHT 64
+
+
 /* Raw format */
 struct vdef_raw_format {
 	/* Pixel format */
@@ -934,6 +1019,9 @@ extern VDEF_API const struct vdef_raw_format vdef_nv21_10_16le;
 extern VDEF_API const struct vdef_raw_format vdef_nv21_10_16be;
 extern VDEF_API const struct vdef_raw_format vdef_nv21_10_16le_high;
 extern VDEF_API const struct vdef_raw_format vdef_nv21_10_16be_high;
+/* YUV422 interleaved formats */
+extern VDEF_API const struct vdef_raw_format vdef_yuyv;
+extern VDEF_API const struct vdef_raw_format vdef_yvyu;
 /* YUV444 planar formats */
 extern VDEF_API const struct vdef_raw_format vdef_i444;
 /* RGB24 formats */
@@ -972,6 +1060,18 @@ extern VDEF_API const struct vdef_raw_format vdef_bayer_rggb_14;
 extern VDEF_API const struct vdef_raw_format vdef_bayer_bggr_14;
 extern VDEF_API const struct vdef_raw_format vdef_bayer_grbg_14;
 extern VDEF_API const struct vdef_raw_format vdef_bayer_gbrg_14;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_rggb_10_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_bggr_10_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_grbg_10_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_gbrg_10_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_rggb_12_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_bggr_12_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_grbg_12_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_gbrg_12_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_rggb_14_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_bggr_14_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_grbg_14_mipi;
+extern VDEF_API const struct vdef_raw_format vdef_bayer_gbrg_14_mipi;
 /* Hardware specific formats */
 extern VDEF_API const struct vdef_raw_format vdef_nv21_hisi_tile;
 extern VDEF_API const struct vdef_raw_format vdef_nv21_hisi_tile_compressed;
@@ -995,6 +1095,178 @@ struct vdef_raw_frame {
 };
 
 
+/* Raw frame layout for a frame stored contiguously in memory */
+struct vdef_raw_layout {
+	/* Raw format */
+	struct vdef_raw_format format;
+
+	/* Frame resolution (in pixel units) */
+	struct vdef_dim resolution;
+
+	/* Plane count */
+	unsigned int plane_count;
+
+	/* Planes stride in bytes (0 for unused planes) */
+	size_t plane_stride[VDEF_RAW_MAX_PLANE_COUNT];
+
+	/* Planes scanline in lines (0 for unused planes) */
+	size_t plane_scanline[VDEF_RAW_MAX_PLANE_COUNT];
+
+	/* Planes size in bytes (0 for unused planes) */
+	size_t plane_size[VDEF_RAW_MAX_PLANE_COUNT];
+
+	/* Planes offset in bytes from the start of the frame
+	 * (0 for unused planes) */
+	size_t plane_offset[VDEF_RAW_MAX_PLANE_COUNT];
+
+	/* Total frame size in bytes */
+	size_t size;
+};
+
+
+/* Forward declarations */
+struct vdef_raw_layout_cache;
+struct vdef_raw_frame_pool;
+struct vdef_thread_pool;
+
+
+/* Raw frame pool flags */
+enum vdef_raw_frame_pool_flag {
+	/* Back the pool memory with huge pages if possible (explicit huge
+	 * pages first, then transparent huge pages) */
+	VDEF_RAW_FRAME_POOL_FLAG_HUGE_PAGES = (1 << 0),
+
+	/* Back each frame with a sealed memfd that can be shared with other
+	 * processes (see vdef_raw_frame_pool_get_fd()); frames are page
+	 * aligned */
+	VDEF_RAW_FRAME_POOL_FLAG_MEMFD = (1 << 1),
+};
+
+
+/* Bayer demosaicing method */
+enum vdef_demosaic_method {
+	/* Bilinear interpolation */
+	VDEF_DEMOSAIC_METHOD_BILINEAR = 0,
+
+	/* Edge-aware interpolation: green is interpolated along the direction
+	 * of the smallest gradient, red and blue from the color differences
+	 * (Hamilton-Adams) */
+	VDEF_DEMOSAIC_METHOD_EDGE_AWARE,
+
+	VDEF_DEMOSAIC_METHOD_MAX,
+};
+
+
+/* Gamut clipping method */
+enum vdef_gamut_clip_method {
+	/* Out of gamut components are clamped */
+	VDEF_GAMUT_CLIP_METHOD_HARD = 0,
+
+	/* Negative components are removed by desaturating the color towards
+	 * its luminance, which keeps the hue, and the components above 90%
+	 * of the peak are compressed smoothly */
+	VDEF_GAMUT_CLIP_METHOD_SOFT,
+
+	VDEF_GAMUT_CLIP_METHOD_MAX,
+};
+
+
+/* HDR to SDR tone mapping method */
+enum vdef_tone_map_method {
+	/* Rec. ITU-R BT.2390 EETF: the luminance is unchanged up to a knee and
+	 * rolled off with a hermite spline in the PQ domain above it */
+	VDEF_TONE_MAP_METHOD_BT2390 = 0,
+
+	/* Extended Reinhard curve with the source peak as white point */
+	VDEF_TONE_MAP_METHOD_REINHARD,
+
+	/* Hable filmic curve with the source peak as white point */
+	VDEF_TONE_MAP_METHOD_HABLE,
+
+	VDEF_TONE_MAP_METHOD_MAX,
+};
+
+
+/* Peak luminance of the SDR output of tone mapping (in cd/m2) */
+#define VDEF_TONE_MAP_SDR_PEAK_LUMINANCE 100.f
+
+
+/* Raw frame scaling method */
+enum vdef_scale_method {
+	/* Nearest neighbor: copy of the input pixel under the output pixel
+	 * center */
+	VDEF_SCALE_METHOD_NEAREST = 0,
+
+	/* Bilinear interpolation (triangle filter) */
+	VDEF_SCALE_METHOD_BILINEAR,
+
+	/* Area averaging (box filter) */
+	VDEF_SCALE_METHOD_AREA,
+
+	/* Bicubic interpolation (Catmull-Rom spline) */
+	VDEF_SCALE_METHOD_BICUBIC,
+
+	VDEF_SCALE_METHOD_MAX,
+};
+
+
+/* Raw frame conversion step */
+enum vdef_convert_step {
+	/* Copy of the planes (same input and output formats) */
+	VDEF_CONVERT_STEP_COPY = 0,
+
+	/* Tiled to linear pixel layout or the reverse (see
+	 * vdef_convert_pix_layout()) */
+	VDEF_CONVERT_STEP_PIX_LAYOUT,
+
+	/* Sample storage, e.g. unpacking of 10-bit packed data (see
+	 * vdef_convert_raw_data()) */
+	VDEF_CONVERT_STEP_RAW_DATA,
+
+	/* Pixel order (see vdef_convert_pix_order()) */
+	VDEF_CONVERT_STEP_PIX_ORDER,
+
+	/* YUV chroma layout (see vdef_convert_yuv_chroma()) */
+	VDEF_CONVERT_STEP_YUV_CHROMA,
+
+	/* YUV to RGB (see vdef_convert_yuv_to_rgb()) */
+	VDEF_CONVERT_STEP_YUV_TO_RGB,
+
+	/* RGB to YUV (see vdef_convert_rgb_to_yuv()) */
+	VDEF_CONVERT_STEP_RGB_TO_YUV,
+
+	/* Color primaries and transfer function (see vdef_convert_gamut());
+	 * also used for the other changes of bit depth, YUV matrix, range or
+	 * chroma subsampling */
+	VDEF_CONVERT_STEP_GAMUT,
+
+	/* HDR to SDR tone mapping (see vdef_tone_map()) */
+	VDEF_CONVERT_STEP_TONE_MAP,
+
+	VDEF_CONVERT_STEP_MAX,
+};
+
+
+/* Step of a raw frame conversion plan */
+struct vdef_convert_plan_step {
+	/* Conversion step */
+	enum vdef_convert_step step;
+
+	/* Input and output formats of the step */
+	struct vdef_raw_format in_format;
+	struct vdef_raw_format out_format;
+
+	/* Estimated number of bytes read and written by the step for a
+	 * frame */
+	size_t bytes;
+};
+
+
+/* Forward declarations */
+struct vdef_convert_plan;
+struct vdef_scaler;
+
+
 /**
  * Coded format and frame definitions
  */
@@ -1352,6 +1624,45 @@ VDEF_API unsigned int
 vdef_get_raw_frame_component_count(enum vdef_raw_pix_format pix_format);
 
 
+/**
+ * Get the data packing group for a given raw frame format.
+ * The packing group is the smallest number of samples that fills a whole
+ * number of bytes, e.g. 4 samples in 5 bytes for 10-bit packed data, 2
+ * samples in 3 bytes for 12-bit packed data, or 1 sample in 2 bytes for
+ * 16-bit data. Plane strides calculated by vdef_calc_raw_frame_size() always
+ * hold a whole number of packing groups.
+ * @param format: raw frame format
+ * @param sample_count: pointer to the group sample count (output, optional)
+ * @param byte_count: pointer to the group byte count (output, optional)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int
+vdef_get_raw_data_packing_group(const struct vdef_raw_format *format,
+				unsigned int *sample_count,
+				unsigned int *byte_count);
+
+
+/**
+ * Get the tile dimension of a raw frame plane for a given raw frame format.
+ * For tiled pixel layouts (e.g. VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16), each
+ * plane is stored as rows of tiles, each tile being made of tile->height
+ * lines of tile->width bytes stored contiguously. The plane stride and
+ * scanline calculated by vdef_calc_raw_frame_size() are multiples of the tile
+ * dimension, and a row of tiles spans plane_stride * tile->height bytes
+ * (tile-row stride).
+ * For YUV 4:2:0 formats, the chroma planes have the same number of tile rows
+ * as the luma plane, i.e. their tiles have half the luma tile height.
+ * @param format: raw frame format
+ * @param plane: plane index
+ * @param tile: tile dimension in bytes and lines (output)
+ * @return 0 on success, -ENOTSUP if the pixel layout is not tiled, or negative
+ *         errno value in case of error
+ */
+VDEF_API int vdef_get_raw_frame_plane_tile(const struct vdef_raw_format *format,
+					   unsigned int plane,
+					   struct vdef_dim *tile);
+
+
 /**
  * Calculate the raw frame plane stride and size for a given raw frame format.
  * This function can be used to calculate the stride and / or size of raw frame
@@ -1363,6 +1674,12 @@ vdef_get_raw_frame_component_count(enum vdef_raw_pix_format pix_format);
  * If the plane_size is set to NULL, only stride calculation will be performed.
  * If the plane_size_align is not NULL and values are different from 0, the
  * plane size will be aligned.
+ * The default stride value is rounded up to a whole number of data packing
+ * groups (see vdef_get_raw_data_packing_group()).
+ * For tiled pixel layouts, the default stride and scanline values are
+ * calculated from the resolution padded to whole tiles (see
+ * vdef_get_raw_frame_plane_tile()); for compressed tiled layouts, the
+ * uncompressed size is returned.
  * @param format: raw frame format
  * @param resolution: the resolution of the frame in pixels
  * @param plane_stride: an array of VDEF_RAW_MAX_PLANE_COUNT plane strides in
@@ -1428,6 +1745,1053 @@ vdef_calc_raw_contiguous_frame_size(const struct vdef_raw_format *format,
 				    const unsigned int *plane_size_align);
 
 
+/**
+ * Get the plane pointers of a raw frame stored contiguously in memory.
+ * The planes are stored one after the other in plane order, starting at the
+ * base address; no data is copied. The plane strides, scanlines and sizes are
+ * calculated as in vdef_calc_raw_contiguous_frame_size().
+ * Pointers of unused planes are set to NULL.
+ * @param base: base address of the frame memory
+ * @param len: size of the frame memory in bytes
+ * @param format: raw frame format
+ * @param resolution: the resolution of the frame in pixels
+ * @param plane_stride: an array of VDEF_RAW_MAX_PLANE_COUNT plane strides in
+ *        bytes, can be NULL (for NULL or value of 0, default stride value is
+ *        calculated)
+ * @param plane_stride_align: an array of VDEF_RAW_MAX_PLANE_COUNT plane stride
+ *        alignment constraints, can be NULL (for NULL or value of 0, no
+ *        alignment is applied)
+ * @param plane_scanline: an array of VDEF_RAW_MAX_PLANE_COUNT plane scanlines
+ *        in lines, can be NULL (for NULL or value of 0, default scanline
+ *        value is calculated)
+ * @param plane_scanline_align: an array of VDEF_RAW_MAX_PLANE_COUNT plane
+ *        scanline alignment constraints, can be NULL (for NULL or value of 0,
+ *        no alignment is applied)
+ * @param plane_size_align: an array of VDEF_RAW_MAX_PLANE_COUNT for plane size
+ *        alignment constraints, can be NULL (for NULL or value of 0, no
+ *        alignment is applied)
+ * @param plane: an array of VDEF_RAW_MAX_PLANE_COUNT plane pointers (output,
+ *        only written on success)
+ * @param plane_size: an array of VDEF_RAW_MAX_PLANE_COUNT for plane sizes in
+ *        bytes, can be NULL (output, only written on success)
+ * @return the raw frame size in bytes, -ENOBUFS if the frame memory is too
+ *         small, or negative errno value in case of error
+ */
+VDEF_API ssize_t
+vdef_calc_raw_contiguous_frame_planes(void *base,
+				      size_t len,
+				      const struct vdef_raw_format *format,
+				      const struct vdef_dim *resolution,
+				      size_t *plane_stride,
+				      const unsigned int *plane_stride_align,
+				      size_t *plane_scanline,
+				      const unsigned int *plane_scanline_align,
+				      const unsigned int *plane_size_align,
+				      void **plane,
+				      size_t *plane_size);
+
+
+/**
+ * Calculate the layout of a raw frame stored contiguously in memory.
+ * The planes are stored one after the other in plane order; the plane
+ * strides, scanlines and sizes are calculated with default values and the
+ * given alignment constraints (see vdef_calc_raw_frame_size()).
+ * @param format: raw frame format
+ * @param resolution: the resolution of the frame in pixels
+ * @param plane_stride_align: an array of VDEF_RAW_MAX_PLANE_COUNT plane stride
+ *        alignment constraints, can be NULL (for NULL or value of 0, no
+ *        alignment is applied)
+ * @param plane_scanline_align: an array of VDEF_RAW_MAX_PLANE_COUNT plane
+ *        scanline alignment constraints, can be NULL (for NULL or value of 0,
+ *        no alignment is applied)
+ * @param plane_size_align: an array of VDEF_RAW_MAX_PLANE_COUNT for plane size
+ *        alignment constraints, can be NULL (for NULL or value of 0, no
+ *        alignment is applied)
+ * @param layout: pointer to the raw frame layout (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_calc_raw_layout(const struct vdef_raw_format *format,
+				  const struct vdef_dim *resolution,
+				  const unsigned int *plane_stride_align,
+				  const unsigned int *plane_scanline_align,
+				  const unsigned int *plane_size_align,
+				  struct vdef_raw_layout *layout);
+
+
+/**
+ * Create a raw frame layout cache.
+ * The cache stores the raw frame layouts calculated by
+ * vdef_raw_layout_cache_get() so that they are only calculated once per
+ * format, resolution and alignment constraints. The cache can be used
+ * concurrently from multiple threads.
+ * The cache must be destroyed using vdef_raw_layout_cache_destroy().
+ * @param ret_obj: pointer to the new cache (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_raw_layout_cache_new(struct vdef_raw_layout_cache **ret_obj);
+
+
+/**
+ * Destroy a raw frame layout cache.
+ * All layouts previously returned by vdef_raw_layout_cache_get() are freed
+ * and must no longer be used.
+ * @param cache: cache to destroy
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_raw_layout_cache_destroy(struct vdef_raw_layout_cache *cache);
+
+
+/**
+ * Get a raw frame layout from a cache.
+ * If no layout matching the format, resolution and alignment constraints
+ * exists in the cache, it is calculated using vdef_calc_raw_layout() and
+ * added to the cache. For a given key, the same layout is always returned;
+ * it stays valid until the cache is destroyed and must not be modified.
+ * @param cache: raw frame layout cache
+ * @param format: raw frame format
+ * @param resolution: the resolution of the frame in pixels
+ * @param plane_stride_align: an array of VDEF_RAW_MAX_PLANE_COUNT plane stride
+ *        alignment constraints, can be NULL
+ * @param plane_scanline_align: an array of VDEF_RAW_MAX_PLANE_COUNT plane
+ *        scanline alignment constraints, can be NULL
+ * @param plane_size_align: an array of VDEF_RAW_MAX_PLANE_COUNT for plane size
+ *        alignment constraints, can be NULL
+ * @param ret_layout: pointer to the cached raw frame layout (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int
+vdef_raw_layout_cache_get(struct vdef_raw_layout_cache *cache,
+			  const struct vdef_raw_format *format,
+			  const struct vdef_dim *resolution,
+			  const unsigned int *plane_stride_align,
+			  const unsigned int *plane_scanline_align,
+			  const unsigned int *plane_size_align,
+			  const struct vdef_raw_layout **ret_layout);
+
+
+/**
+ * Get the plane pointers of a raw frame from its layout.
+ * No data is copied; pointers of unused planes are set to NULL.
+ * @param layout: raw frame layout
+ * @param base: base address of the frame memory
+ * @param len: size of the frame memory in bytes
+ * @param plane: an array of VDEF_RAW_MAX_PLANE_COUNT plane pointers (output)
+ * @return 0 on success, -ENOBUFS if the frame memory is too small, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_raw_layout_get_planes(const struct vdef_raw_layout *layout,
+					void *base,
+					size_t len,
+					void **plane);
+
+
+/**
+ * Get the crop rectangle alignment constraints for a given raw frame format.
+ * A crop rectangle that satisfies the constraints (see vdef_rect_is_aligned())
+ * starts on a whole chroma sample, on a whole data packing group in every
+ * plane (see vdef_get_raw_data_packing_group()) and, for Bayer formats, keeps
+ * the same CFA pixel order.
+ * Only linear (or MIPI CSI-2) pixel layouts with packed, planar or
+ * semi-planar data layouts can be cropped.
+ * @param format: raw frame format
+ * @param align: pointer to the crop rectangle alignment constraints (output)
+ * @return 0 on success, -ENOTSUP if the format cannot be cropped, or negative
+ *         errno value in case of error
+ */
+VDEF_API int vdef_get_raw_frame_crop_align(const struct vdef_raw_format *format,
+					   struct vdef_rect *align);
+
+
+/**
+ * Calculate a crop view of a raw frame.
+ * No data is copied: the view uses the same format and plane strides as the
+ * frame, with the crop rectangle dimensions as resolution; the view planes
+ * start at the frame plane pointers plus the returned plane offsets.
+ * Negative crop rectangle offsets mean the rectangle is centered; they are
+ * replaced by the actual offsets. If the crop rectangle does not satisfy the
+ * alignment constraints returned by vdef_get_raw_frame_crop_align(), it is
+ * enlarged in place using vdef_rect_align() if align is true, otherwise
+ * -EPROTO is returned.
+ * @param frame: raw frame (the frame resolution is info.resolution)
+ * @param crop: crop rectangle in pixels (input and output)
+ * @param align: true to align the crop rectangle, false to reject a crop
+ *        rectangle that is not aligned
+ * @param view: pointer to the cropped raw frame (output)
+ * @param plane_offset: an array of VDEF_RAW_MAX_PLANE_COUNT plane offsets in
+ *        bytes relative to the frame planes (output; 0 for unused planes)
+ * @return 0 on success, -EPROTO if the crop rectangle is not aligned, -ERANGE
+ *         if the crop rectangle is outside of the frame, -ENOTSUP if the
+ *         format cannot be cropped, or negative errno value in case of error
+ */
+VDEF_API int vdef_calc_raw_frame_crop(const struct vdef_raw_frame *frame,
+				      struct vdef_rect *crop,
+				      bool align,
+				      struct vdef_raw_frame *view,
+				      size_t *plane_offset);
+
+
+/**
+ * Get the band alignment constraint for a given raw frame format.
+ * Bands are slices of whole lines of a frame; a band whose first line is a
+ * multiple of the alignment starts on a whole chroma line and, for tiled
+ * pixel layouts, on a whole row of tiles in every plane.
+ * Only linear, MIPI CSI-2 and uncompressed tiled pixel layouts with packed,
+ * planar, semi-planar or interleaved data layouts can be split in bands.
+ * @param format: raw frame format
+ * @param align: pointer to the band alignment in lines (output)
+ * @return 0 on success, -ENOTSUP if the format cannot be split in bands, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_get_raw_frame_band_align(const struct vdef_raw_format *format,
+					   unsigned int *align);
+
+
+/**
+ * Calculate the partition of a raw frame in bands of lines.
+ * The requested band height is rounded up to the band alignment returned by
+ * vdef_get_raw_frame_band_align() and limited to the frame height; all the
+ * bands have this height except the last one, which has the remaining
+ * lines. The partition only depends on the format, the resolution and the
+ * requested band height, so that a kernel run on the bands of a frame gives
+ * the same output whatever the number of threads processing the bands (see
+ * vdef_thread_pool_run()).
+ * @param format: raw frame format
+ * @param resolution: frame resolution
+ * @param band_height: pointer to the requested band height in lines, 0 to
+ *        use VDEF_RAW_FRAME_BAND_DEFAULT_HEIGHT; replaced by the actual band
+ *        height (input and output)
+ * @param band_count: pointer to the band count (output)
+ * @return 0 on success, -ENOTSUP if the format cannot be split in bands, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_calc_raw_frame_bands(const struct vdef_raw_format *format,
+				       const struct vdef_dim *resolution,
+				       unsigned int *band_height,
+				       unsigned int *band_count);
+
+
+/**
+ * Calculate a band view of a raw frame.
+ * No data is copied: the view uses the same format and plane strides as the
+ * frame, with the band height as resolution height; the view planes start
+ * at the frame plane pointers plus the returned plane offsets (see
+ * vdef_calc_raw_frame_crop()).
+ * @param frame: raw frame (the frame resolution is info.resolution)
+ * @param band_height: band height in lines, as returned by
+ *        vdef_calc_raw_frame_bands()
+ * @param index: band index
+ * @param view: pointer to the band raw frame (output)
+ * @param plane_offset: an array of VDEF_RAW_MAX_PLANE_COUNT plane offsets in
+ *        bytes relative to the frame planes (output; 0 for unused planes)
+ * @return 0 on success, -EPROTO if the band height is not aligned, -ERANGE
+ *         if the band index is outside of the frame, -ENOTSUP if the format
+ *         cannot be split in bands, or negative errno value in case of error
+ */
+VDEF_API int vdef_calc_raw_frame_band(const struct vdef_raw_frame *frame,
+				      unsigned int band_height,
+				      unsigned int index,
+				      struct vdef_raw_frame *view,
+				      size_t *plane_offset);
+
+
+/**
+ * Create a raw frame pool.
+ * The pool preallocates count contiguous raw frames of the given layout in a
+ * single memory mapping; each frame starts on a multiple of the alignment.
+ * Frames can be taken from and returned to the pool concurrently from
+ * multiple threads without locking.
+ * The pool must be destroyed using vdef_raw_frame_pool_destroy().
+ * @param layout: raw frame layout of the pool frames (see
+ *        vdef_calc_raw_layout())
+ * @param count: number of frames in the pool
+ * @param align: frame memory alignment in bytes; must be a power of 2
+ *        (0 for the default cache line alignment)
+ * @param flags: pool flags (bit-field of enum vdef_raw_frame_pool_flag)
+ * @param ret_obj: pointer to the new pool (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_raw_frame_pool_new(const struct vdef_raw_layout *layout,
+				     unsigned int count,
+				     size_t align,
+				     uint32_t flags,
+				     struct vdef_raw_frame_pool **ret_obj);
+
+
+/**
+ * Destroy a raw frame pool.
+ * All frames must have been returned to the pool.
+ * @param pool: pool to destroy
+ * @return 0 on success, -EBUSY if frames are still in use, or negative errno
+ *         value in case of error
+ */
+VDEF_API int vdef_raw_frame_pool_destroy(struct vdef_raw_frame_pool *pool);
+
+
+/**
+ * Get the raw frame layout of the frames of a raw frame pool.
+ * @param pool: raw frame pool
+ * @return the raw frame layout, or NULL in case of error
+ */
+VDEF_API const struct vdef_raw_layout *
+vdef_raw_frame_pool_get_layout(struct vdef_raw_frame_pool *pool);
+
+
+/**
+ * Take a frame from a raw frame pool.
+ * The frame memory holds layout->size bytes; the plane pointers can be
+ * retrieved using vdef_raw_layout_get_planes(). The frame must be returned
+ * to the pool using vdef_raw_frame_pool_put().
+ * @param pool: raw frame pool
+ * @param ret_frame: pointer to the frame memory (output)
+ * @return 0 on success, -EAGAIN if no frame is available, or negative errno
+ *         value in case of error
+ */
+VDEF_API int vdef_raw_frame_pool_get(struct vdef_raw_frame_pool *pool,
+				     void **ret_frame);
+
+
+/**
+ * Return a frame to a raw frame pool.
+ * The frame must have been previously taken from the same pool using
+ * vdef_raw_frame_pool_get() and must not be used afterwards.
+ * @param pool: raw frame pool
+ * @param frame: frame memory
+ * @return 0 on success, -EALREADY if the frame has already been returned,
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_raw_frame_pool_put(struct vdef_raw_frame_pool *pool,
+				     void *frame);
+
+
+/**
+ * Get the memfd of a frame of a raw frame pool.
+ * The pool must have been created with VDEF_RAW_FRAME_POOL_FLAG_MEMFD. The
+ * memfd size is sealed; it can be sent to another process (e.g. using
+ * SCM_RIGHTS) along with the pool layout and mapped there using
+ * vdef_raw_frame_map_fd(). The file descriptor is owned by the pool and
+ * must not be closed by the caller.
+ * @param pool: raw frame pool
+ * @param frame: frame memory
+ * @param ret_fd: pointer to the frame memfd (output)
+ * @return 0 on success, -ENOTSUP if the pool is not memfd-backed, or negative
+ *         errno value in case of error
+ */
+VDEF_API int vdef_raw_frame_pool_get_fd(struct vdef_raw_frame_pool *pool,
+					void *frame,
+					int *ret_fd);
+
+
+/**
+ * Map a raw frame from a file descriptor.
+ * The frame is mapped as shared memory, so no data is copied; the plane
+ * pointers can be retrieved using vdef_raw_layout_get_planes(). The frame
+ * must be unmapped using vdef_raw_frame_unmap().
+ * @param fd: frame file descriptor (e.g. from vdef_raw_frame_pool_get_fd())
+ * @param layout: raw frame layout
+ * @param ret_frame: pointer to the frame memory (output)
+ * @return 0 on success, -ENOBUFS if the file is smaller than the frame, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_raw_frame_map_fd(int fd,
+				   const struct vdef_raw_layout *layout,
+				   void **ret_frame);
+
+
+/**
+ * Unmap a raw frame mapped using vdef_raw_frame_map_fd().
+ * @param layout: raw frame layout
+ * @param frame: frame memory
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_raw_frame_unmap(const struct vdef_raw_layout *layout,
+				  void *frame);
+
+
+/**
+ * Create a thread pool.
+ * The pool runs sets of independent tasks (e.g. a kernel on the bands of a
+ * frame, see vdef_calc_raw_frame_bands()) on persistent worker threads
+ * using work stealing: the tasks are split in contiguous ranges between the
+ * threads, and a thread that runs out of tasks steals half of the remaining
+ * tasks of another thread.
+ * The pool must be destroyed using vdef_thread_pool_destroy().
+ * @param thread_count: number of threads including the calling thread of
+ *        vdef_thread_pool_run(); 0 to use one thread per online CPU
+ * @param ret_obj: pointer to the new pool (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_thread_pool_new(unsigned int thread_count,
+				  struct vdef_thread_pool **ret_obj);
+
+
+/**
+ * Destroy a thread pool.
+ * The worker threads are stopped and joined.
+ * @param pool: pool to destroy
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_thread_pool_destroy(struct vdef_thread_pool *pool);
+
+
+/**
+ * Get the number of threads of a thread pool.
+ * @param pool: thread pool
+ * @return the number of threads including the calling thread of
+ *         vdef_thread_pool_run(), or 0 if pool is NULL
+ */
+VDEF_API unsigned int
+vdef_thread_pool_get_thread_count(const struct vdef_thread_pool *pool);
+
+
+/**
+ * Run tasks on a thread pool.
+ * The task function is called once for each index in [0, task_count),
+ * concurrently from the calling thread and the pool worker threads; the
+ * function returns when all the tasks are done. The thread index passed to
+ * the task function is in [0, vdef_thread_pool_get_thread_count()) and is
+ * unique among the concurrently running tasks (e.g. to use per-thread
+ * scratch memory); 0 is the calling thread. Concurrent calls on the same
+ * pool are serialized.
+ * If a task returns an error, the tasks that are not started yet are
+ * skipped and the first error is returned.
+ * @param pool: thread pool
+ * @param task_count: number of tasks
+ * @param task: task function, returning 0 on success or a negative errno
+ *        value in case of error
+ * @param userdata: user data passed to the task function
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_thread_pool_run(struct vdef_thread_pool *pool,
+				  unsigned int task_count,
+				  int (*task)(unsigned int index,
+					      unsigned int thread_index,
+					      void *userdata),
+				  void *userdata);
+
+
+/**
+ * Convert a YUV raw frame to RGB.
+ * The conversion matrix is selected from the input frame info matrix_coefs
+ * and full_range values (see vdef_yuv_to_rgb_norm_matrix); the output is
+ * full range RGB. Chroma samples are upsampled by replication.
+ * Supported input formats are YUV 4:2:0, 4:2:2 and 4:4:4 in planar,
+ * semi-planar or interleaved data layouts (e.g. I420, YV12, NV12, NV21 and
+ * their 16-bit variants) with a linear pixel layout and 8-bit or 16-bit data
+ * sizes. Supported output formats are RGB24 and RGBA32 in packed or planar
+ * data layouts with any pixel order; the alpha component is set to its
+ * maximum value.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_yuv_to_rgb(const struct vdef_raw_frame *in_frame,
+				     const void *const *in_plane,
+				     const struct vdef_raw_frame *out_frame,
+				     void *const *out_plane);
+
+
+/**
+ * Convert a RGB raw frame to YUV.
+ * The conversion matrix is selected from the output frame info matrix_coefs
+ * and full_range values (see vdef_rgb_to_yuv_norm_matrix); the input is
+ * full range RGB. Subsampled chroma samples are the average of the
+ * covered pixels (2x2 for YUV 4:2:0 and 2x1 for YUV 4:2:2); with odd frame
+ * dimensions, the last column or line of pixels only contributes to luma.
+ * Supported input formats are RGB24 and RGBA32 in packed or planar data
+ * layouts with any pixel order; the alpha component is ignored.
+ * Supported output formats are YUV 4:2:0, 4:2:2 and 4:4:4 in planar,
+ * semi-planar or interleaved data layouts (e.g. I420, YV12, NV12, NV21 and
+ * their 16-bit variants) with a linear pixel layout and 8-bit or 16-bit data
+ * sizes.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_rgb_to_yuv(const struct vdef_raw_frame *in_frame,
+				     const void *const *in_plane,
+				     const struct vdef_raw_frame *out_frame,
+				     void *const *out_plane);
+
+
+/**
+ * Convert the chroma layout of a YUV raw frame.
+ * The input and output formats must only differ by their data layout
+ * (planar or semi-planar) and chroma order, e.g. conversions between I420,
+ * YV12, NV12 and NV21, or between their 10-bit variants with the same data
+ * storage (16-bit little or big endian, low or high padding). The luma plane
+ * is copied unless the input and output luma planes are the same.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers (the chroma planes must not
+ *                   overlap the input chroma planes)
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_yuv_chroma(const struct vdef_raw_frame *in_frame,
+				     const void *const *in_plane,
+				     const struct vdef_raw_frame *out_frame,
+				     void *const *out_plane);
+
+
+/**
+ * Convert the chroma layout of a YUV raw frame in place.
+ * See vdef_convert_yuv_chroma() for the supported formats. The frame format,
+ * plane strides and plane pointers are updated:
+ * - between planar formats (e.g. I420 and YV12), the chroma plane pointers
+ *   and strides are swapped, without copying;
+ * - between semi-planar formats (e.g. NV12 and NV21), the chroma samples are
+ *   swapped in place, keeping the strides.
+ * Conversions between planar and semi-planar formats cannot be done in place
+ * and are not supported; use vdef_convert_yuv_chroma() with another output
+ * buffer. The luma plane is left untouched.
+ * @param frame: raw frame (input and output)
+ * @param plane: frame plane pointers (input and output)
+ * @param format: output raw format
+ * @return 0 on success, -ENOTSUP if the formats are not supported or if the
+ *         conversion cannot be done in place, or negative errno value in case
+ *         of error
+ */
+VDEF_API int
+vdef_convert_yuv_chroma_in_place(struct vdef_raw_frame *frame,
+				 void **plane,
+				 const struct vdef_raw_format *format);
+
+
+/**
+ * Convert the sample storage of a raw frame.
+ * The input and output formats must only differ by their data size, padding
+ * and endianness (see struct vdef_raw_format); the conversion is selected
+ * from both formats. Supported conversions are:
+ * - between 8-bit, 16-bit or 32-bit data of the same size with any padding
+ *   and endianness (e.g. between vdef_i420_10_16le and
+ *   vdef_i420_10_16be_high, or between vdef_raw32 and vdef_raw32_be);
+ * - from 10-bit, 12-bit or 14-bit packed data (e.g. vdef_nv12_10_packed,
+ *   vdef_raw12_packed or vdef_bayer_rggb_14_packed) to 16-bit data with low
+ *   or high padding and any endianness (e.g. vdef_nv12_10_16le,
+ *   vdef_raw12 or vdef_bayer_rggb_14), and the reverse;
+ * - from MIPI CSI-2 RAW10, RAW12 or RAW14 data (e.g.
+ *   vdef_bayer_rggb_10_mipi) to 16-bit data with a linear pixel layout (e.g.
+ *   vdef_bayer_rggb_10), and the reverse.
+ * Apart from MIPI CSI-2 packed data, the pixel layout must be linear. Packed
+ * lines are padded with zero bits to a whole number of bytes (or of packing
+ * groups for MIPI CSI-2 data).
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_raw_data(const struct vdef_raw_frame *in_frame,
+				   const void *const *in_plane,
+				   const struct vdef_raw_frame *out_frame,
+				   void *const *out_plane);
+
+
+/**
+ * Convert the sample storage of a raw frame in place.
+ * The input and output formats must have the same data size and only differ
+ * by their padding and endianness (see vdef_convert_raw_data()). The frame
+ * format is updated; the strides and plane pointers are unchanged.
+ * @param frame: raw frame (input and output)
+ * @param plane: frame plane pointers
+ * @param format: output raw format
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int
+vdef_convert_raw_data_in_place(struct vdef_raw_frame *frame,
+			       void *const *plane,
+			       const struct vdef_raw_format *format);
+
+
+/**
+ * Convert the pixel order of a raw frame.
+ * The input and output formats must only differ by their pixel order (see
+ * enum vdef_raw_pix_order). Supported formats are RGB24 and RGBA32 packed
+ * formats (e.g. between vdef_rgba, vdef_bgra and vdef_abgr) and YUV422
+ * interleaved formats (e.g. between vdef_yuyv and vdef_yvyu, or with the
+ * VDEF_RAW_PIX_ORDER_UYVY and VDEF_RAW_PIX_ORDER_VYUY orders) with a linear
+ * pixel layout and 8-bit or 16-bit data sizes. Any pixel order
+ * can be converted to any other one. For interleaved formats, the last pixel
+ * of odd width lines is copied unchanged.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers (can be the same as the
+ *                   input frame plane pointers)
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_pix_order(const struct vdef_raw_frame *in_frame,
+				    const void *const *in_plane,
+				    const struct vdef_raw_frame *out_frame,
+				    void *const *out_plane);
+
+
+/**
+ * Convert the pixel order of a raw frame in place.
+ * See vdef_convert_pix_order() for the supported formats. The frame format
+ * is updated; the strides and plane pointers are unchanged.
+ * @param frame: raw frame (input and output)
+ * @param plane: frame plane pointers
+ * @param format: output raw format
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int
+vdef_convert_pix_order_in_place(struct vdef_raw_frame *frame,
+				void *const *plane,
+				const struct vdef_raw_format *format);
+
+
+/**
+ * Convert the pixel layout of a raw frame between tiled and linear.
+ * Supported conversions are from the VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16
+ * pixel layout to the linear pixel layout (e.g. from vdef_nv21_hisi_tile to
+ * vdef_nv21, or from vdef_nv21_hisi_tile_10_packed to vdef_nv21_10_packed)
+ * and the reverse. The input and output formats must otherwise be the same,
+ * except for the chroma order of semi-planar YUV formats with 8-bit or
+ * 16-bit data sizes (e.g. from vdef_nv21_hisi_tile to vdef_nv12). Compressed
+ * tiled layouts are not supported.
+ * The tiled planes are stored as described in vdef_get_raw_frame_plane_tile()
+ * and their strides must hold whole tiles; when tiling, the tile padding
+ * beyond the frame resolution is left untouched. The frame is processed in
+ * bands of tile rows (see vdef_calc_raw_frame_bands()) by the threads of the
+ * pool.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_pix_layout(const struct vdef_raw_frame *in_frame,
+				     const void *const *in_plane,
+				     const struct vdef_raw_frame *out_frame,
+				     void *const *out_plane,
+				     struct vdef_thread_pool *pool);
+
+
+/**
+ * Demosaic a Bayer raw frame to RGB.
+ * Supported input formats are Bayer formats of any CFA order (from the pixel
+ * order) with 8-bit or 16-bit data sizes and a linear pixel layout (e.g.
+ * vdef_bayer_rggb or vdef_bayer_gbrg_12); packed data formats (e.g.
+ * vdef_bayer_rggb_10_packed) can first be unpacked using
+ * vdef_convert_raw_data(). Supported output formats are RGB24 and RGBA32 in
+ * packed or planar data layouts with any pixel order and 8-bit or 16-bit
+ * data sizes (e.g. vdef_rgb or vdef_rgba); the samples are rescaled to the
+ * output bit depth and the alpha component is set to its maximum value.
+ * The frame borders are handled by mirroring. The frame is processed in
+ * bands of lines (see vdef_calc_raw_frame_bands()) by the threads of the
+ * pool.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame, at least 3x3 pixels)
+ * @param out_plane: output frame plane pointers
+ * @param method: demosaicing method
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_demosaic(const struct vdef_raw_frame *in_frame,
+			   const void *const *in_plane,
+			   const struct vdef_raw_frame *out_frame,
+			   void *const *out_plane,
+			   enum vdef_demosaic_method method,
+			   struct vdef_thread_pool *pool);
+
+
+/**
+ * Convert the color primaries and transfer function of a raw frame.
+ * The conversion is driven by the input and output frame info
+ * color_primaries, transfer_function, matrix_coefs and full_range values
+ * (frames with the VDEF_TONE_MAPPING_P_LOG tone mapping are not supported);
+ * each pixel is converted to non-linear RGB, linearized using the transfer
+ * function lookup tables (see vdef_transfer_lut_get()), converted to the
+ * output primaries in linear light (see vdef_bt709_to_bt2020_matrix and
+ * vdef_bt2020_to_bt709_matrix), clipped to the output gamut, and converted
+ * back to the output transfer function and format. Only conversions between
+ * the BT.709 and BT.2020 color primaries, or keeping the same primaries,
+ * are supported; PQ can only be converted to PQ (HDR to SDR conversion
+ * needs tone mapping, see vdef_tone_map()).
+ * Supported formats are YUV 4:2:0, 4:2:2 and 4:4:4 formats as in
+ * vdef_convert_rgb_to_yuv() and RGB24 and RGBA32 formats with any pixel
+ * order, with 8-bit or 16-bit data sizes; subsampled output chroma samples
+ * are the average of the covered pixels. The frame is processed in bands of
+ * lines (see vdef_calc_raw_frame_bands()) by the threads of the pool.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame)
+ * @param out_plane: output frame plane pointers
+ * @param clip: gamut clipping method
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, -ENOTSUP if the formats or the conversion are not
+ *         supported, or negative errno value in case of error
+ */
+VDEF_API int vdef_convert_gamut(const struct vdef_raw_frame *in_frame,
+				const void *const *in_plane,
+				const struct vdef_raw_frame *out_frame,
+				void *const *out_plane,
+				enum vdef_gamut_clip_method clip,
+				struct vdef_thread_pool *pool);
+
+
+/**
+ * Get the format info of the SDR frames produced by tone mapping HDR frames.
+ * The SDR format info is a copy of the HDR format info with 8-bit depth,
+ * BT.709 color primaries, transfer function and matrix coefficients,
+ * standard dynamic range and tone mapping, and without mastering display
+ * colour volume and content light level metadata.
+ * @param hdr_info: HDR format info
+ * @param sdr_info: SDR format info (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_tone_map_get_sdr_info(const struct vdef_format_info *hdr_info,
+					struct vdef_format_info *sdr_info);
+
+
+/**
+ * Tone map a PQ (e.g. HDR10) raw frame to SDR.
+ * The source peak luminance is the mastering display maximum luminance
+ * limited by the maximum content light level when they are known
+ * (1000 cd/m2 otherwise) and the source black level is the mastering display
+ * minimum luminance; the output peak luminance is
+ * VDEF_TONE_MAP_SDR_PEAK_LUMINANCE. P-log content is not supported yet.
+ * The tone curve is applied to the maximum of the linear light RGB
+ * components, which keeps the hue and saturation of the colors, through a
+ * lookup table; the rest of the conversion is done as in
+ * vdef_convert_gamut(). The output frame info color parameters must be set
+ * (e.g. from vdef_tone_map_get_sdr_info()).
+ * @param in_frame: input raw frame (with the PQ transfer function)
+ * @param in_plane: input frame plane pointers
+ * @param hdr_info: input format info used for the mdcv and cll metadata
+ *                  (can be NULL to use the default values)
+ * @param out_frame: output raw frame (must have the same resolution as the
+ *                   input frame and neither the PQ nor the HLG transfer
+ *                   function)
+ * @param out_plane: output frame plane pointers
+ * @param method: tone mapping method
+ * @param clip: gamut clipping method
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, -ENOTSUP if the formats or the conversion are not
+ *         supported, or negative errno value in case of error
+ */
+VDEF_API int vdef_tone_map(const struct vdef_raw_frame *in_frame,
+			   const void *const *in_plane,
+			   const struct vdef_format_info *hdr_info,
+			   const struct vdef_raw_frame *out_frame,
+			   void *const *out_plane,
+			   enum vdef_tone_map_method method,
+			   enum vdef_gamut_clip_method clip,
+			   struct vdef_thread_pool *pool);
+
+
+/**
+ * Get a 3D lookup table of the conversion between two formats.
+ * The table maps the normalized source code values to the normalized
+ * destination code values on a size x size x size grid; it is baked by
+ * running the conversion of vdef_tone_map() (from PQ to an SDR transfer
+ * function) or vdef_convert_gamut() (otherwise) on the grid
+ * points, so a frame can then be converted in a single lookup per pixel
+ * with vdef_lut3d_apply(). The components are RGB if the matrix
+ * coefficients are VDEF_MATRIX_COEFS_IDENTITY and YUV otherwise; the
+ * color_primaries, transfer_function, matrix_coefs, full_range,
+ * dynamic_range and tone_mapping values of the formats describe the
+ * conversion (the mdcv and cll metadata of the source are used for tone
+ * mapping; the bit depth, resolution and framerate are ignored).
+ * Tables are cached by descriptor: this function can be called
+ * concurrently from multiple threads and always returns the same table for
+ * the same conversion, so reconfiguring a pipeline only costs a lookup.
+ * The table stays valid until the library is unloaded.
+ * @param src_info: source format info
+ * @param dst_info: destination format info
+ * @param size: number of grid points per dimension (17, 33 or 65)
+ * @param method: tone mapping method (ignored if not tone mapping)
+ * @param clip: gamut clipping method
+ * @param ret_lut: pointer to the lookup table (output)
+ * @return 0 on success, -ENOTSUP if the conversion is not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_lut3d_get(const struct vdef_format_info *src_info,
+			    const struct vdef_format_info *dst_info,
+			    unsigned int size,
+			    enum vdef_tone_map_method method,
+			    enum vdef_gamut_clip_method clip,
+			    const struct vdef_lut3d **ret_lut);
+
+
+/**
+ * Convert a raw frame with a 3D lookup table.
+ * The samples are interpolated between the 4 grid points of the
+ * tetrahedron that contains them; the output chroma of subsampled formats
+ * is the average of the covered pixels. The frames info color parameters
+ * are not used: the conversion is fully described by the table.
+ * @param lut: 3D lookup table (see vdef_lut3d_get())
+ * @param in_frame: input raw frame (YUV or RGB, matching the table source
+ *                  components)
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (YUV or RGB, matching the table
+ *                   destination components; must have the same resolution
+ *                   as the input frame)
+ * @param out_plane: output frame plane pointers
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, -ENOTSUP if the formats are not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_lut3d_apply(const struct vdef_lut3d *lut,
+			      const struct vdef_raw_frame *in_frame,
+			      const void *const *in_plane,
+			      const struct vdef_raw_frame *out_frame,
+			      void *const *out_plane,
+			      struct vdef_thread_pool *pool);
+
+
+/**
+ * Create a raw frame conversion plan.
+ * The plan is the shortest chain of conversion steps from the input format
+ * and info to the output format and info (see enum vdef_convert_step):
+ * tiled and packed data formats are converted to linear 8-bit or 16-bit
+ * samples first and back last, and all the other changes are done in a
+ * single step when possible, e.g. the pixel order and chroma layout changes
+ * are part of the color conversion step instead of separate passes. The
+ * color steps are prepared once for all frames (e.g. the tone mapping
+ * gains). The frames are converted in bands of lines: each band goes
+ * through all the steps before the next one, so that the intermediate data
+ * of a band stays in the CPU cache (see
+ * vdef_convert_plan_get_band_height()).
+ * The input and output info give the resolution (which must be the same),
+ * the color parameters of the frames and the tone mapping metadata.
+ * The plan must be destroyed using vdef_convert_plan_destroy().
+ * @param in_format: input raw format
+ * @param in_info: input format info
+ * @param out_format: output raw format
+ * @param out_info: output format info
+ * @param method: tone mapping method (ignored if not tone mapping)
+ * @param clip: gamut clipping method
+ * @param ret_obj: pointer to the new plan (output)
+ * @return 0 on success, -ENOTSUP if the conversion is not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_convert_plan_new(const struct vdef_raw_format *in_format,
+				   const struct vdef_format_info *in_info,
+				   const struct vdef_raw_format *out_format,
+				   const struct vdef_format_info *out_info,
+				   enum vdef_tone_map_method method,
+				   enum vdef_gamut_clip_method clip,
+				   struct vdef_convert_plan **ret_obj);
+
+
+/**
+ * Destroy a raw frame conversion plan.
+ * @param plan: plan to destroy
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_convert_plan_destroy(struct vdef_convert_plan *plan);
+
+
+/**
+ * Get the number of steps of a raw frame conversion plan.
+ * @param plan: conversion plan
+ * @return the number of steps, or 0 if plan is NULL
+ */
+VDEF_API unsigned int
+vdef_convert_plan_get_step_count(const struct vdef_convert_plan *plan);
+
+
+/**
+ * Get a step of a raw frame conversion plan.
+ * @param plan: conversion plan
+ * @param index: step index
+ * @param step: pointer to the step (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_convert_plan_get_step(const struct vdef_convert_plan *plan,
+					unsigned int index,
+					struct vdef_convert_plan_step *step);
+
+
+/**
+ * Get the estimated number of bytes read and written by all the steps of a
+ * raw frame conversion plan for a frame.
+ * @param plan: conversion plan
+ * @return the number of bytes on success, negative errno value in case of
+ *         error
+ */
+VDEF_API ssize_t
+vdef_convert_plan_get_bytes(const struct vdef_convert_plan *plan);
+
+
+/**
+ * Get the height of the bands of lines of a raw frame conversion plan.
+ * The height is chosen so that the intermediate frames of a band fit in
+ * a typical L2 cache; the last band of a frame can be lower (see
+ * vdef_calc_raw_frame_bands()).
+ * @param plan: conversion plan
+ * @return the band height in lines, or 0 if plan is NULL
+ */
+VDEF_API unsigned int
+vdef_convert_plan_get_band_height(const struct vdef_convert_plan *plan);
+
+
+/**
+ * Convert a raw frame with a conversion plan.
+ * The frames must have the formats and resolution of the plan; their info
+ * color parameters are not used. The bands of lines are processed by the
+ * threads of the pool, each with its own intermediate frames.
+ * @param plan: conversion plan
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame
+ * @param out_plane: output frame plane pointers
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_convert_plan_run(const struct vdef_convert_plan *plan,
+				   const struct vdef_raw_frame *in_frame,
+				   const void *const *in_plane,
+				   const struct vdef_raw_frame *out_frame,
+				   void *const *out_plane,
+				   struct vdef_thread_pool *pool);
+
+
+/**
+ * Get a string from an enum vdef_convert_step value.
+ * @param step: conversion step to convert
+ * @return a string description of the conversion step
+ */
+VDEF_API const char *vdef_convert_step_to_str(enum vdef_convert_step step);
+
+
+/**
+ * Scale a raw frame.
+ * The input and output frames must have the same format; only the linear
+ * GRAY, RGB24, RGBA32 (packed or planar) and YUV420, YUV422 and YUV444
+ * (planar or semi-planar) formats with 8-bit or 16-bit samples are
+ * supported: the interleaved YUV422 formats (e.g. vdef_yuyv) are not. The
+ * resolutions must be multiples of the chroma subsampling.
+ * When downscaling, the filters are stretched so that all the input pixels
+ * contribute to the output (no aliasing). The bands of output lines are
+ * processed by the threads of the pool.
+ * The filters are computed for each call: to scale multiple frames, use a
+ * scaler (see vdef_scaler_new()) instead.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame
+ * @param out_plane: output frame plane pointers
+ * @param method: scaling method
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, -ENOTSUP if the format is not supported, or negative
+ *         errno value in case of error
+ */
+VDEF_API int vdef_scale(const struct vdef_raw_frame *in_frame,
+			const void *const *in_plane,
+			const struct vdef_raw_frame *out_frame,
+			void *const *out_plane,
+			enum vdef_scale_method method,
+			struct vdef_thread_pool *pool);
+
+
+/**
+ * Scale a raw frame to a resolution preset.
+ * The output frame resolution is set from the preset (see
+ * vdef_resolution_to_dim()); its format and plane strides must already be
+ * set. See vdef_scale() for the supported formats.
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param resolution: output resolution preset
+ * @param out_frame: output raw frame (resolution set on success)
+ * @param out_plane: output frame plane pointers
+ * @param method: scaling method
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_scale_to_resolution(const struct vdef_raw_frame *in_frame,
+				      const void *const *in_plane,
+				      enum vdef_resolution resolution,
+				      struct vdef_raw_frame *out_frame,
+				      void *const *out_plane,
+				      enum vdef_scale_method method,
+				      struct vdef_thread_pool *pool);
+
+
+/**
+ * Create a raw frame scaler.
+ * The scaler computes the filters of a format and of input and output
+ * resolutions, and allocates the per-thread rows of the pool, once for
+ * all the frames scaled with vdef_scaler_run(). See vdef_scale() for the
+ * supported formats and resolutions.
+ * The scaler must be destroyed using vdef_scaler_destroy(); the pool must
+ * not be destroyed before the scaler.
+ * @param format: raw format of the input and output frames
+ * @param in_res: input frame resolution
+ * @param out_res: output frame resolution
+ * @param method: scaling method
+ * @param pool: thread pool processing the bands (see vdef_thread_pool_new()),
+ *              or NULL to process them in the calling thread
+ * @param ret_obj: pointer to the new scaler (output)
+ * @return 0 on success, -ENOTSUP if the format is not supported, or
+ *         negative errno value in case of error
+ */
+VDEF_API int vdef_scaler_new(const struct vdef_raw_format *format,
+			     const struct vdef_dim *in_res,
+			     const struct vdef_dim *out_res,
+			     enum vdef_scale_method method,
+			     struct vdef_thread_pool *pool,
+			     struct vdef_scaler **ret_obj);
+
+
+/**
+ * Destroy a raw frame scaler.
+ * @param scaler: scaler to destroy
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_scaler_destroy(struct vdef_scaler *scaler);
+
+
+/**
+ * Scale a raw frame with a scaler.
+ * The frames must have the format and resolutions of the scaler. A scaler
+ * cannot be run concurrently from multiple threads.
+ * @param scaler: raw frame scaler
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame
+ * @param out_plane: output frame plane pointers
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_scaler_run(struct vdef_scaler *scaler,
+			     const struct vdef_raw_frame *in_frame,
+			     const void *const *in_plane,
+			     const struct vdef_raw_frame *out_frame,
+			     void *const *out_plane);
+
+
 /**
  * Get an enum vdef_encoding value from a string.
  * Valid strings are only the suffix of the encoding name (eg. 'H264').
@@ -1668,6 +3032,150 @@ VDEF_API const char *
 vdef_transfer_function_to_str(enum vdef_transfer_function transfer);
 
 
+/**
+ * Convert a non-linear value to linear light.
+ * This evaluates the transfer function directly; see vdef_transfer_lut_get()
+ * for converting many values. The value is clamped to [0, 1].
+ * @param transfer: transfer function
+ * @param value: normalized non-linear value
+ * @return the normalized linear light value, or NAN if the transfer
+ *         function is unknown
+ */
+VDEF_API float
+vdef_transfer_function_to_linear(enum vdef_transfer_function transfer,
+				 float value);
+
+
+/**
+ * Convert a linear light value to a non-linear value.
+ * This is the inverse of vdef_transfer_function_to_linear(). The value is
+ * clamped to [0, 1].
+ * @param transfer: transfer function
+ * @param value: normalized linear light value
+ * @return the normalized non-linear value, or NAN if the transfer function
+ *         is unknown
+ */
+VDEF_API float
+vdef_transfer_function_from_linear(enum vdef_transfer_function transfer,
+				   float value);
+
+
+/**
+ * Get a transfer function lookup table.
+ * Non-linear values are full range integer code values of the given bit
+ * depth; linear light values are either 16-bit integers (0 to 65535) or
+ * floats (0.0 to 1.0). Tables are built on first use and shared by all
+ * callers; this function can be called concurrently from multiple threads
+ * and always returns the same table for the same parameters. The table
+ * stays valid until the library is unloaded.
+ * @param transfer: transfer function
+ * @param dir: conversion direction
+ * @param bit_depth: bit depth of the code values (1 to 16)
+ * @param ret_lut: pointer to the lookup table (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_transfer_lut_get(enum vdef_transfer_function transfer,
+				   enum vdef_transfer_lut_dir dir,
+				   unsigned int bit_depth,
+				   const struct vdef_transfer_lut **ret_lut);
+
+
+/**
+ * Apply a transfer function lookup table to 16-bit values.
+ * For a VDEF_TRANSFER_LUT_DIR_TO_LINEAR table, the source values are code
+ * values (clamped to the table bit depth) and the destination values are
+ * 16-bit linear light values; for a VDEF_TRANSFER_LUT_DIR_FROM_LINEAR table,
+ * this is the opposite; for a VDEF_TRANSFER_LUT_DIR_TO_BT709 table, both
+ * are code values of the table bit depth. Note that 16-bit linear light
+ * lacks precision in the dark tones of PQ; use the float functions for HDR
+ * content.
+ * The source and destination arrays can be the same.
+ * @param lut: transfer function lookup table
+ * @param src: source values
+ * @param dst: destination values (output)
+ * @param count: number of values
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int vdef_transfer_lut_apply(const struct vdef_transfer_lut *lut,
+				     const uint16_t *src,
+				     uint16_t *dst,
+				     size_t count);
+
+
+/**
+ * Apply a transfer function lookup table to get float linear light values.
+ * The table must be a VDEF_TRANSFER_LUT_DIR_TO_LINEAR table; the source code
+ * values are clamped to the table bit depth.
+ * @param lut: transfer function lookup table
+ * @param src: source code values
+ * @param dst: destination linear light values (output)
+ * @param count: number of values
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int
+vdef_transfer_lut_apply_to_float(const struct vdef_transfer_lut *lut,
+				 const uint16_t *src,
+				 float *dst,
+				 size_t count);
+
+
+/**
+ * Apply a transfer function lookup table to float linear light values.
+ * The table must be a VDEF_TRANSFER_LUT_DIR_FROM_LINEAR table; the source
+ * values are clamped to [0, 1] (NAN gives 0, values below 2^-24 are rounded
+ * down to 0). The table is indexed by the float exponent and the upper
+ * mantissa bits, so that the precision is relative to the value: the error
+ * is within 1 code value up to 12 bits and within a few code values for
+ * 16 bits.
+ * @param lut: transfer function lookup table
+ * @param src: source linear light values
+ * @param dst: destination code values (output)
+ * @param count: number of values
+ * @return 0 on success, negative errno value in case of error
+ */
+VDEF_API int
+vdef_transfer_lut_apply_from_float(const struct vdef_transfer_lut *lut,
+				   const float *src,
+				   uint16_t *dst,
+				   size_t count);
+
+
+/**
+ * Get a tone mapping curve lookup table.
+ * Tone mapping curves replace the transfer function of the content. Tables
+ * would be built on first use and shared as in vdef_transfer_lut_get(), and
+ * applied with the vdef_transfer_lut_apply*() functions; no curve is
+ * currently supported (the P-log curve is not defined yet).
+ * @param tone_mapping: tone mapping
+ * @param dir: conversion direction
+ * @param bit_depth: bit depth of the code values (1 to 16)
+ * @param ret_lut: pointer to the lookup table (output)
+ * @return 0 on success, -ENOTSUP if the tone mapping curve is not supported,
+ *         or negative errno value in case of error
+ */
+VDEF_API int
+vdef_tone_mapping_lut_get(enum vdef_tone_mapping tone_mapping,
+			  enum vdef_transfer_lut_dir dir,
+			  unsigned int bit_depth,
+			  const struct vdef_transfer_lut **ret_lut);
+
+
+/**
+ * Get the lookup table matching a format info: the tone mapping curve
+ * table for VDEF_TONE_MAPPING_P_LOG content (see
+ * vdef_tone_mapping_lut_get()), the transfer function table otherwise, for
+ * the format bit depth.
+ * @param info: format info
+ * @param dir: conversion direction
+ * @param ret_lut: pointer to the lookup table (output)
+ * @return 0 on success, -ENOTSUP if the tone mapping curve is not supported,
+ *         or negative errno value in case of error
+ */
+VDEF_API int vdef_format_info_lut_get(const struct vdef_format_info *info,
+				      enum vdef_transfer_lut_dir dir,
+				      const struct vdef_transfer_lut **ret_lut);
+
+
 /**
  * Get an enum vdef_matrix_coefs value from an H.264 VUI matrix_coefficients
  * value (Rec. ITU-T H.264 E.1.1, also defined in Rec. ITU-T H.273).
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <strings.h>
 
+#include "vdefs_priv.h"
 #include <video-defs/vdefs.h>
 
 #define ULOG_TAG vdef
@@ -76,7 +77,14 @@ bool vdef_is_raw_format_valid(const struct vdef_raw_format *format)
 	/* Check enumerator bounds */
 	if (pix_order > VDEF_RAW_PIX_ORDER_DCBA ||
 	    data_layout > VDEF_RAW_DATA_LAYOUT_OPAQUE ||
-	    pix_layout > VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16_COMPRESSED)
+	    pix_layout > VDEF_RAW_PIX_LAYOUT_MIPI_CSI2)
+		return false;
+
+	/* MIPI CSI-2 packing only applies to 10, 12 and 14-bit packed data */
+	if (pix_layout == VDEF_RAW_PIX_LAYOUT_MIPI_CSI2 &&
+	    (format->data_size != format->pix_size ||
+	     (format->data_size != 10 && format->data_size != 12 &&
+	      format->data_size != 14)))
 		return false;
 
 	/* Check data size */
@@ -92,11 +100,15 @@ bool vdef_is_raw_format_valid(const struct vdef_raw_format *format)
 	case VDEF_RAW_PIX_FORMAT_YUV420:
 	case VDEF_RAW_PIX_FORMAT_YUV422:
 	case VDEF_RAW_PIX_FORMAT_YUV444:
-		/* Y pixel always first */
+		/* Y pixel always first, except for interleaved YUV422 */
 		if (pix_order != VDEF_RAW_PIX_ORDER_YUYV &&
 		    pix_order != VDEF_RAW_PIX_ORDER_YVYU &&
 		    pix_order != VDEF_RAW_PIX_ORDER_YUV &&
-		    pix_order != VDEF_RAW_PIX_ORDER_YVU)
+		    pix_order != VDEF_RAW_PIX_ORDER_YVU &&
+		    (format->pix_format != VDEF_RAW_PIX_FORMAT_YUV422 ||
+		     data_layout != VDEF_RAW_DATA_LAYOUT_INTERLEAVED ||
+		     (pix_order != VDEF_RAW_PIX_ORDER_UYVY &&
+		      pix_order != VDEF_RAW_PIX_ORDER_VYUY)))
 			return false;
 
 		/* Allow interleaved, planar and semi-planar */
@@ -128,8 +140,9 @@ bool vdef_is_raw_format_valid(const struct vdef_raw_format *format)
 		    data_layout != VDEF_RAW_DATA_LAYOUT_PLANAR)
 			return false;
 
-		/* Pixel size is only 8 */
-		if (format->pix_size != 8)
+		/* Pixel size is 8, or up to 16 in 16-bit data */
+		if (format->pix_size != 8 &&
+		    (format->data_size != 16 || format->pix_size > 16))
 			return false;
 
 		break;
@@ -145,8 +158,9 @@ bool vdef_is_raw_format_valid(const struct vdef_raw_format *format)
 		    data_layout != VDEF_RAW_DATA_LAYOUT_PLANAR)
 			return false;
 
-		/* Pixel size is only 8 */
-		if (format->pix_size != 8)
+		/* Pixel size is 8, or up to 16 in 16-bit data */
+		if (format->pix_size != 8 &&
+		    (format->data_size != 16 || format->pix_size > 16))
 			return false;
 
 		break;
@@ -423,6 +437,60 @@ const char *vdef_raw_pix_order_to_str(enum vdef_raw_pix_order order)
 }
 
 
+/* The pixel order values enumerate the 24 permutations of ABCD in
+ * lexicographic order starting from 1, so the component at each position is
+ * decoded from the value (its rank is written in the factorial number
+ * system, each digit selecting one of the remaining components) */
+static_assert(VDEF_RAW_PIX_ORDER_ABCD == 1 && VDEF_RAW_PIX_ORDER_DCBA == 24,
+	      "unexpected enum vdef_raw_pix_order values");
+
+#define PERM_SKIP(_x, _c) ((_x) + ((_x) >= (_c)))
+#define PERM_MIN(_a, _b) ((_a) < (_b) ? (_a) : (_b))
+#define PERM_MAX(_a, _b) ((_a) < (_b) ? (_b) : (_a))
+#define PERM_0(_o) (((_o)-1) / 6)
+#define PERM_1(_o) PERM_SKIP(((_o)-1) % 6 / 2, PERM_0(_o))
+#define PERM_2(_o)                                                             \
+	PERM_SKIP(PERM_SKIP(((_o)-1) % 2,                                      \
+			    PERM_MIN(PERM_0(_o), PERM_1(_o))),                 \
+		  PERM_MAX(PERM_0(_o), PERM_1(_o)))
+#define PERM_3(_o) (6 - PERM_0(_o) - PERM_1(_o) - PERM_2(_o))
+#define PERM(_o) [_o] = {PERM_0(_o), PERM_1(_o), PERM_2(_o), PERM_3(_o)}
+#define PERM6(_o)                                                              \
+	PERM(_o), PERM(_o + 1), PERM(_o + 2), PERM(_o + 3), PERM(_o + 4),      \
+		PERM(_o + 5)
+
+static const uint8_t pix_order_perm[VDEF_RAW_PIX_ORDER_DCBA + 1][4] = {
+	PERM6(1),
+	PERM6(7),
+	PERM6(13),
+	PERM6(19),
+};
+
+static_assert(PERM_0(VDEF_RAW_PIX_ORDER_BGRA) == 2 &&
+		      PERM_1(VDEF_RAW_PIX_ORDER_BGRA) == 1 &&
+		      PERM_2(VDEF_RAW_PIX_ORDER_BGRA) == 0 &&
+		      PERM_3(VDEF_RAW_PIX_ORDER_BGRA) == 3,
+	      "invalid pixel order permutation");
+static_assert(PERM_0(VDEF_RAW_PIX_ORDER_BDAC) == 1 &&
+		      PERM_1(VDEF_RAW_PIX_ORDER_BDAC) == 3 &&
+		      PERM_2(VDEF_RAW_PIX_ORDER_BDAC) == 0 &&
+		      PERM_3(VDEF_RAW_PIX_ORDER_BDAC) == 2,
+	      "invalid pixel order permutation");
+
+
+int vdef_priv_get_pix_order_perm(enum vdef_raw_pix_order order,
+				 unsigned int perm[4])
+{
+	if (order < VDEF_RAW_PIX_ORDER_ABCD || order > VDEF_RAW_PIX_ORDER_DCBA)
+		return -EINVAL;
+
+	for (unsigned int i = 0; i < 4; i++)
+		perm[i] = pix_order_perm[order][i];
+
+	return 0;
+}
+
+
 static const struct {
 	enum vdef_raw_pix_layout layout;
 	const char *str;
@@ -431,6 +499,7 @@ static const struct {
 	{VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16, "HISI_TILE_64x16"},
 	{VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16_COMPRESSED,
 	 "HISI_TILE_64x16_COMPRESSED"},
+	{VDEF_RAW_PIX_LAYOUT_MIPI_CSI2, "MIPI_CSI2"},
 };
 
 
@@ -541,6 +610,9 @@ static const struct {
 	{"nv21_10_16be", &vdef_nv21_10_16be},
 	{"nv21_10_16le_high", &vdef_nv21_10_16le_high},
 	{"nv21_10_16be_high", &vdef_nv21_10_16be_high},
+	/* YUV422 interleaved formats */
+	{"yuyv", &vdef_yuyv},
+	{"yvyu", &vdef_yvyu},
 	/* YUV444 planar formats */
 	{"i444", &vdef_i444},
 	/* RGB24 formats */
@@ -579,6 +651,18 @@ static const struct {
 	{"bayer_bggr_14", &vdef_bayer_bggr_14},
 	{"bayer_grbg_14", &vdef_bayer_grbg_14},
 	{"bayer_gbrg_14", &vdef_bayer_gbrg_14},
+	{"bayer_rggb_10_mipi", &vdef_bayer_rggb_10_mipi},
+	{"bayer_bggr_10_mipi", &vdef_bayer_bggr_10_mipi},
+	{"bayer_grbg_10_mipi", &vdef_bayer_grbg_10_mipi},
+	{"bayer_gbrg_10_mipi", &vdef_bayer_gbrg_10_mipi},
+	{"bayer_rggb_12_mipi", &vdef_bayer_rggb_12_mipi},
+	{"bayer_bggr_12_mipi", &vdef_bayer_bggr_12_mipi},
+	{"bayer_grbg_12_mipi", &vdef_bayer_grbg_12_mipi},
+	{"bayer_gbrg_12_mipi", &vdef_bayer_gbrg_12_mipi},
+	{"bayer_rggb_14_mipi", &vdef_bayer_rggb_14_mipi},
+	{"bayer_bggr_14_mipi", &vdef_bayer_bggr_14_mipi},
+	{"bayer_grbg_14_mipi", &vdef_bayer_grbg_14_mipi},
+	{"bayer_gbrg_14_mipi", &vdef_bayer_gbrg_14_mipi},
 	{"nv21_hisi_tiled", &vdef_nv21_hisi_tile},
 	{"nv21_hisi_tiled_compressed", &vdef_nv21_hisi_tile_compressed},
 	{"nv21_hisi_tiled_10_packed", &vdef_nv21_hisi_tile_10_packed},
@@ -753,6 +837,160 @@ vdef_get_raw_frame_component_count(enum vdef_raw_pix_format pix_format)
 }
 
 
+/* Tile dimension of the tiled pixel layouts (in pixels and lines) */
+#define VDEF_HISI_TILE_WIDTH 64
+#define VDEF_HISI_TILE_HEIGHT 16
+
+
+static bool get_pix_layout_tile(enum vdef_raw_pix_layout layout,
+				unsigned int *width,
+				unsigned int *height)
+{
+	switch (layout) {
+	case VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16:
+	case VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16_COMPRESSED:
+		*width = VDEF_HISI_TILE_WIDTH;
+		*height = VDEF_HISI_TILE_HEIGHT;
+		return true;
+	default:
+		*width = 1;
+		*height = 1;
+		return false;
+	}
+}
+
+
+static unsigned int gcd(unsigned int a, unsigned int b)
+{
+	while (b != 0) {
+		unsigned int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+
+/* Get the plane stride and height ratios relative to the first plane */
+static void get_plane_ratios(const struct vdef_raw_format *format,
+			     unsigned int plane_count,
+			     unsigned char *stride_mul,
+			     unsigned char *stride_div,
+			     unsigned char *height_mul,
+			     unsigned char *height_div)
+{
+	unsigned int component_count;
+
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++)
+		stride_mul[i] = stride_div[i] = height_mul[i] =
+			height_div[i] = 1;
+
+	component_count =
+		vdef_get_raw_frame_component_count(format->pix_format);
+
+	/* Set plane multiplier / divisor */
+	if (format->pix_format == VDEF_RAW_PIX_FORMAT_YUV420) {
+		height_div[1] = height_div[2] = 2;
+		stride_div[1] = stride_div[2] = plane_count - 1;
+	} else if (format->pix_format == VDEF_RAW_PIX_FORMAT_YUV422) {
+		if (plane_count == 1)
+			/* Interleaved: 2 samples per pixel */
+			stride_mul[0] = 2;
+		else
+			stride_div[1] = stride_div[2] = plane_count - 1;
+	} else if (format->pix_format == VDEF_RAW_PIX_FORMAT_YUV444) {
+		stride_mul[1] = 4 - plane_count;
+	} else if (plane_count == 1) {
+		stride_mul[0] = component_count;
+	}
+}
+
+
+int vdef_get_raw_frame_plane_tile(const struct vdef_raw_format *format,
+				  unsigned int plane,
+				  struct vdef_dim *tile)
+{
+	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_count;
+	unsigned int tile_width, tile_height;
+
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(tile == NULL, EINVAL);
+
+	plane_count = vdef_get_raw_frame_plane_count(format);
+	ULOG_ERRNO_RETURN_ERR_IF(plane >= plane_count, EINVAL);
+
+	if (!get_pix_layout_tile(format->pix_layout, &tile_width, &tile_height))
+		return -ENOTSUP;
+
+	get_plane_ratios(format,
+			 plane_count,
+			 stride_mul,
+			 stride_div,
+			 height_mul,
+			 height_div);
+	tile->width = tile_width * format->data_size / 8 * stride_mul[plane] /
+		      stride_div[plane];
+	tile->height = tile_height * height_mul[plane] / height_div[plane];
+
+	return 0;
+}
+
+
+int vdef_priv_get_plane_samples(const struct vdef_raw_format *format,
+				const struct vdef_dim *resolution,
+				unsigned int plane,
+				unsigned int *samples,
+				unsigned int *lines)
+{
+	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_count;
+
+	plane_count = vdef_get_raw_frame_plane_count(format);
+	if (plane >= plane_count)
+		return -EINVAL;
+
+	get_plane_ratios(format,
+			 plane_count,
+			 stride_mul,
+			 stride_div,
+			 height_mul,
+			 height_div);
+	*samples = resolution->width * stride_mul[plane] / stride_div[plane];
+	*lines = resolution->height * height_mul[plane] / height_div[plane];
+
+	return 0;
+}
+
+
+int vdef_get_raw_data_packing_group(const struct vdef_raw_format *format,
+				    unsigned int *sample_count,
+				    unsigned int *byte_count)
+{
+	unsigned int bits;
+
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format->data_size == 0, EINVAL);
+
+	/* The smallest group of samples ending on a byte boundary is
+	 * lcm(data_size, 8) bits long */
+	bits = format->data_size / gcd(format->data_size, 8) * 8;
+
+	if (sample_count)
+		*sample_count = bits / format->data_size;
+	if (byte_count)
+		*byte_count = bits / 8;
+
+	return 0;
+}
+
+
 int vdef_calc_raw_frame_size(const struct vdef_raw_format *format,
 			     const struct vdef_dim *resolution,
 			     size_t *plane_stride,
@@ -762,14 +1000,17 @@ int vdef_calc_raw_frame_size(const struct vdef_raw_format *format,
 			     size_t *plane_size,
 			     const unsigned int *plane_size_align)
 {
-	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT] = {1, 1, 1, 1};
-	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT] = {1, 1, 1, 1};
-	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT] = {1, 1, 1, 1};
-	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT] = {1, 1, 1, 1};
+	int ret;
+	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT];
 	unsigned int plane_count;
-	unsigned int component_count;
+	unsigned int width, height;
+	unsigned int tile_width, tile_height;
+	unsigned int group_samples, group_bytes;
 
-	if (!format || !resolution)
+	if (!format || !resolution || !format->data_size)
 		return -EINVAL;
 
 	if (!plane_stride && !plane_size)
@@ -777,20 +1018,27 @@ int vdef_calc_raw_frame_size(const struct vdef_raw_format *format,
 
 	/* Get plane count */
 	plane_count = vdef_get_raw_frame_plane_count(format);
-	component_count =
-		vdef_get_raw_frame_component_count(format->pix_format);
 
 	/* Set plane multiplier / divisor */
-	if (format->pix_format == VDEF_RAW_PIX_FORMAT_YUV420) {
-		height_div[1] = height_div[2] = 2;
-		stride_div[1] = stride_div[2] = plane_count - 1;
-	} else if (format->pix_format == VDEF_RAW_PIX_FORMAT_YUV422) {
-		stride_div[1] = stride_div[2] = plane_count - 1;
-	} else if (format->pix_format == VDEF_RAW_PIX_FORMAT_YUV444) {
-		stride_mul[1] = 4 - plane_count;
-	} else if (plane_count == 1) {
-		stride_mul[0] = component_count;
-	}
+	get_plane_ratios(format,
+			 plane_count,
+			 stride_mul,
+			 stride_div,
+			 height_mul,
+			 height_div);
+
+	/* Pad the resolution to whole tiles for tiled pixel layouts; the
+	 * chroma planes use the same number of tile rows as the luma plane */
+	get_pix_layout_tile(format->pix_layout, &tile_width, &tile_height);
+	width = VDEF_ROUND_UP(resolution->width, tile_width) * tile_width;
+	height = VDEF_ROUND_UP(resolution->height, tile_height) * tile_height;
+
+	/* Get the packing group, so that the stride of packed data formats
+	 * (e.g. 4 pixels in 5 bytes for 10-bit) is never truncated */
+	ret = vdef_get_raw_data_packing_group(
+		format, &group_samples, &group_bytes);
+	if (ret < 0)
+		return ret;
 
 	/* Calculate size for each plane */
 	for (unsigned int i = 0; i < plane_count; i++) {
@@ -798,8 +1046,8 @@ int vdef_calc_raw_frame_size(const struct vdef_raw_format *format,
 		size_t scanline;
 
 		/* Calculate stride */
-		stride = resolution->width * format->data_size / 8 *
-			 stride_mul[i] / stride_div[i];
+		stride = (size_t)width * stride_mul[i] / stride_div[i];
+		stride = VDEF_ROUND_UP(stride, group_samples) * group_bytes;
 		if (plane_stride && plane_stride[i] != 0) {
 			if (plane_stride[i] < stride)
 				return -EPROTO;
@@ -815,7 +1063,7 @@ int vdef_calc_raw_frame_size(const struct vdef_raw_format *format,
 			plane_stride[i] = stride;
 
 		/* Calculate scanline */
-		scanline = resolution->height * height_mul[i] / height_div[i];
+		scanline = (size_t)height * height_mul[i] / height_div[i];
 		if (plane_scanline && plane_scanline[i] != 0) {
 			if (plane_scanline[i] < scanline)
 				return -EPROTO;
@@ -873,6 +1121,302 @@ vdef_calc_raw_contiguous_frame_size(const struct vdef_raw_format *format,
 }
 
 
+/* Get the chroma subsampling factors (or CFA pattern size for Bayer) */
+static void get_subsampling(const struct vdef_raw_format *format,
+			    unsigned int *h_sub,
+			    unsigned int *v_sub)
+{
+	switch (format->pix_format) {
+	case VDEF_RAW_PIX_FORMAT_YUV420:
+	case VDEF_RAW_PIX_FORMAT_BAYER:
+		*h_sub = 2;
+		*v_sub = 2;
+		break;
+	case VDEF_RAW_PIX_FORMAT_YUV422:
+		*h_sub = 2;
+		*v_sub = 1;
+		break;
+	default:
+		*h_sub = 1;
+		*v_sub = 1;
+		break;
+	}
+}
+
+
+int vdef_get_raw_frame_crop_align(const struct vdef_raw_format *format,
+				  struct vdef_rect *align)
+{
+	int ret;
+	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_count;
+	unsigned int h_sub, v_sub;
+	unsigned int group_samples;
+	unsigned int left;
+
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format->data_size == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(align == NULL, EINVAL);
+
+	/* Only linear pixel layouts where each plane is a 2D array of
+	 * samples (or of MIPI CSI-2 packing groups) can be cropped in place */
+	if (format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR &&
+	    format->pix_layout != VDEF_RAW_PIX_LAYOUT_MIPI_CSI2)
+		return -ENOTSUP;
+	if (format->data_layout != VDEF_RAW_DATA_LAYOUT_PACKED &&
+	    format->data_layout != VDEF_RAW_DATA_LAYOUT_PLANAR &&
+	    format->data_layout != VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR)
+		return -ENOTSUP;
+
+	plane_count = vdef_get_raw_frame_plane_count(format);
+	if (plane_count == 0 || plane_count > VDEF_RAW_MAX_PLANE_COUNT)
+		return -EINVAL;
+
+	get_plane_ratios(format,
+			 plane_count,
+			 stride_mul,
+			 stride_div,
+			 height_mul,
+			 height_div);
+	get_subsampling(format, &h_sub, &v_sub);
+	ret = vdef_get_raw_data_packing_group(format, &group_samples, NULL);
+	if (ret < 0)
+		return ret;
+
+	/* The horizontal offset must fall on a whole chroma sample and on a
+	 * whole data packing group in every plane */
+	left = h_sub;
+	for (unsigned int i = 0; i < plane_count; i++) {
+		unsigned int plane_left =
+			stride_div[i] * group_samples /
+			gcd(group_samples, stride_mul[i]);
+		left = left / gcd(left, plane_left) * plane_left;
+	}
+
+	align->left = left;
+	align->top = v_sub;
+	align->width = h_sub;
+	align->height = v_sub;
+
+	return 0;
+}
+
+
+int vdef_calc_raw_frame_crop(const struct vdef_raw_frame *frame,
+			     struct vdef_rect *crop,
+			     bool align,
+			     struct vdef_raw_frame *view,
+			     size_t *plane_offset)
+{
+	int ret;
+	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_count;
+	unsigned int group_samples, group_bytes;
+	struct vdef_rect crop_align;
+	const struct vdef_dim *res;
+
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(crop == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(view == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane_offset == NULL, EINVAL);
+
+	res = &frame->info.resolution;
+	if (crop->width == 0 || crop->height == 0 ||
+	    crop->width > res->width || crop->height > res->height)
+		return -ERANGE;
+
+	ret = vdef_get_raw_frame_crop_align(&frame->format, &crop_align);
+	if (ret < 0)
+		return ret;
+
+	/* Negative offsets mean the rectangle is centered */
+	if (crop->left < 0)
+		crop->left = (res->width - crop->width) / 2;
+	if (crop->top < 0)
+		crop->top = (res->height - crop->height) / 2;
+
+	if (!vdef_rect_is_aligned(crop, &crop_align)) {
+		if (!align)
+			return -EPROTO;
+		vdef_rect_align(crop, &crop_align, true, true);
+	}
+
+	if ((unsigned int)crop->left + crop->width > res->width ||
+	    (unsigned int)crop->top + crop->height > res->height)
+		return -ERANGE;
+
+	plane_count = vdef_get_raw_frame_plane_count(&frame->format);
+	get_plane_ratios(&frame->format,
+			 plane_count,
+			 stride_mul,
+			 stride_div,
+			 height_mul,
+			 height_div);
+	ret = vdef_get_raw_data_packing_group(
+		&frame->format, &group_samples, &group_bytes);
+	if (ret < 0)
+		return ret;
+
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		size_t x, y;
+
+		if (i >= plane_count) {
+			plane_offset[i] = 0;
+			continue;
+		}
+
+		/* The alignment guarantees that both values are exact */
+		x = (size_t)crop->left / stride_div[i] * stride_mul[i] /
+		    group_samples * group_bytes;
+		y = (size_t)crop->top * height_mul[i] / height_div[i];
+		plane_offset[i] = y * frame->plane_stride[i] + x;
+	}
+
+	*view = *frame;
+	view->info.resolution.width = crop->width;
+	view->info.resolution.height = crop->height;
+
+	return 0;
+}
+
+
+int vdef_get_raw_frame_band_align(const struct vdef_raw_format *format,
+				  unsigned int *align)
+{
+	unsigned int plane_count;
+	unsigned int h_sub, v_sub;
+	unsigned int tile_width, tile_height;
+
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(align == NULL, EINVAL);
+
+	/* Each plane must be a 2D array of lines (or rows of tiles) */
+	if (format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR &&
+	    format->pix_layout != VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16 &&
+	    format->pix_layout != VDEF_RAW_PIX_LAYOUT_MIPI_CSI2)
+		return -ENOTSUP;
+	if (format->data_layout != VDEF_RAW_DATA_LAYOUT_PACKED &&
+	    format->data_layout != VDEF_RAW_DATA_LAYOUT_PLANAR &&
+	    format->data_layout != VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR &&
+	    format->data_layout != VDEF_RAW_DATA_LAYOUT_INTERLEAVED)
+		return -ENOTSUP;
+
+	plane_count = vdef_get_raw_frame_plane_count(format);
+	if (plane_count == 0 || plane_count > VDEF_RAW_MAX_PLANE_COUNT)
+		return -EINVAL;
+
+	/* A band starts on a whole chroma line and on a whole row of tiles
+	 * in every plane */
+	get_subsampling(format, &h_sub, &v_sub);
+	get_pix_layout_tile(format->pix_layout, &tile_width, &tile_height);
+	*align = v_sub / gcd(v_sub, tile_height) * tile_height;
+
+	return 0;
+}
+
+
+int vdef_calc_raw_frame_bands(const struct vdef_raw_format *format,
+			      const struct vdef_dim *resolution,
+			      unsigned int *band_height,
+			      unsigned int *band_count)
+{
+	int ret;
+	unsigned int align, height;
+
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(resolution == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(vdef_dim_is_null(resolution), EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(band_height == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(band_count == NULL, EINVAL);
+
+	ret = vdef_get_raw_frame_band_align(format, &align);
+	if (ret < 0)
+		return ret;
+
+	height = *band_height;
+	if (height == 0)
+		height = VDEF_RAW_FRAME_BAND_DEFAULT_HEIGHT;
+	height = VDEF_ROUND_UP(height, align) * align;
+	if (height > resolution->height)
+		height = resolution->height;
+
+	*band_height = height;
+	*band_count = VDEF_ROUND_UP(resolution->height, height);
+
+	return 0;
+}
+
+
+int vdef_calc_raw_frame_band(const struct vdef_raw_frame *frame,
+			     unsigned int band_height,
+			     unsigned int index,
+			     struct vdef_raw_frame *view,
+			     size_t *plane_offset)
+{
+	int ret;
+	unsigned char stride_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char stride_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_mul[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned char height_div[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_count;
+	unsigned int align, top, height;
+
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(band_height == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(view == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane_offset == NULL, EINVAL);
+
+	ret = vdef_get_raw_frame_band_align(&frame->format, &align);
+	if (ret < 0)
+		return ret;
+	if (band_height % align != 0 &&
+	    band_height != frame->info.resolution.height)
+		return -EPROTO;
+
+	height = frame->info.resolution.height;
+	if (index >= VDEF_ROUND_UP(height, band_height))
+		return -ERANGE;
+	top = index * band_height;
+	if (height - top > band_height)
+		height = band_height;
+	else
+		height -= top;
+
+	plane_count = vdef_get_raw_frame_plane_count(&frame->format);
+	get_plane_ratios(&frame->format,
+			 plane_count,
+			 stride_mul,
+			 stride_div,
+			 height_mul,
+			 height_div);
+
+	/* The alignment guarantees that the band starts on a whole line (or
+	 * row of tiles) in every plane */
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		size_t y;
+
+		if (i >= plane_count) {
+			plane_offset[i] = 0;
+			continue;
+		}
+
+		y = (size_t)top * height_mul[i] / height_div[i];
+		plane_offset[i] = y * frame->plane_stride[i];
+	}
+
+	*view = *frame;
+	view->info.resolution.height = height;
+
+	return 0;
+}
+
+
 enum vdef_encoding vdef_encoding_from_str(const char *str)
 {
 	if (str == NULL) {
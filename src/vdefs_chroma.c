@@ -0,0 +1,452 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+#define SWAP(_a, _b)                                                           \
+	do {                                                                   \
+		__typeof__(_a) _t = (_a);                                      \
+		(_a) = (_b);                                                   \
+		(_b) = _t;                                                     \
+	} while (0)
+
+
+/* Split interleaved 8-bit sample pairs */
+static void deinterleave8(const uint8_t *src,
+			  uint8_t *a,
+			  uint8_t *b,
+			  unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		vdef_priv_v16u8 s0, s1, va, vb;
+		memcpy(&s0, src + 2 * i, sizeof(s0));
+		memcpy(&s1, src + 2 * i + 16, sizeof(s1));
+		va = VDEF_PRIV_SHUFFLE2(s0, s1, 0, 2, 4, 6, 8, 10, 12, 14,
+					16, 18, 20, 22, 24, 26, 28, 30);
+		vb = VDEF_PRIV_SHUFFLE2(s0, s1, 1, 3, 5, 7, 9, 11, 13, 15,
+					17, 19, 21, 23, 25, 27, 29, 31);
+		memcpy(a + i, &va, sizeof(va));
+		memcpy(b + i, &vb, sizeof(vb));
+	}
+	for (; i < count; i++) {
+		a[i] = src[2 * i];
+		b[i] = src[2 * i + 1];
+	}
+}
+
+
+/* Split interleaved 16-bit sample pairs (the byte order is kept) */
+static void deinterleave16(const uint8_t *src,
+			   uint8_t *a,
+			   uint8_t *b,
+			   unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		vdef_priv_v8u16 s0, s1, va, vb;
+		memcpy(&s0, src + 4 * i, sizeof(s0));
+		memcpy(&s1, src + 4 * i + 16, sizeof(s1));
+		va = VDEF_PRIV_SHUFFLE2(s0, s1, 0, 2, 4, 6, 8, 10, 12, 14);
+		vb = VDEF_PRIV_SHUFFLE2(s0, s1, 1, 3, 5, 7, 9, 11, 13, 15);
+		memcpy(a + 2 * i, &va, sizeof(va));
+		memcpy(b + 2 * i, &vb, sizeof(vb));
+	}
+	for (; i < count; i++) {
+		memcpy(a + 2 * i, src + 4 * i, 2);
+		memcpy(b + 2 * i, src + 4 * i + 2, 2);
+	}
+}
+
+
+/* Interleave 8-bit samples into pairs */
+static void interleave8(const uint8_t *a,
+			const uint8_t *b,
+			uint8_t *dst,
+			unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		vdef_priv_v16u8 va, vb, d0, d1;
+		memcpy(&va, a + i, sizeof(va));
+		memcpy(&vb, b + i, sizeof(vb));
+		d0 = VDEF_PRIV_SHUFFLE2(va, vb, 0, 16, 1, 17, 2, 18, 3, 19,
+					4, 20, 5, 21, 6, 22, 7, 23);
+		d1 = VDEF_PRIV_SHUFFLE2(va, vb, 8, 24, 9, 25, 10, 26, 11, 27,
+					12, 28, 13, 29, 14, 30, 15, 31);
+		memcpy(dst + 2 * i, &d0, sizeof(d0));
+		memcpy(dst + 2 * i + 16, &d1, sizeof(d1));
+	}
+	for (; i < count; i++) {
+		dst[2 * i] = a[i];
+		dst[2 * i + 1] = b[i];
+	}
+}
+
+
+/* Interleave 16-bit samples into pairs (the byte order is kept) */
+static void interleave16(const uint8_t *a,
+			 const uint8_t *b,
+			 uint8_t *dst,
+			 unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		vdef_priv_v8u16 va, vb, d0, d1;
+		memcpy(&va, a + 2 * i, sizeof(va));
+		memcpy(&vb, b + 2 * i, sizeof(vb));
+		d0 = VDEF_PRIV_SHUFFLE2(va, vb, 0, 8, 1, 9, 2, 10, 3, 11);
+		d1 = VDEF_PRIV_SHUFFLE2(va, vb, 4, 12, 5, 13, 6, 14, 7, 15);
+		memcpy(dst + 4 * i, &d0, sizeof(d0));
+		memcpy(dst + 4 * i + 16, &d1, sizeof(d1));
+	}
+	for (; i < count; i++) {
+		memcpy(dst + 4 * i, a + 2 * i, 2);
+		memcpy(dst + 4 * i + 2, b + 2 * i, 2);
+	}
+}
+
+
+/* Swap the samples of 8-bit pairs; src and dst can be the same */
+static void swap8(const uint8_t *src, uint8_t *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		vdef_priv_v16u8 s;
+		memcpy(&s, src + 2 * i, sizeof(s));
+		s = VDEF_PRIV_SHUFFLE2(s, s, 1, 0, 3, 2, 5, 4, 7, 6,
+				       9, 8, 11, 10, 13, 12, 15, 14);
+		memcpy(dst + 2 * i, &s, sizeof(s));
+	}
+	for (; i < count; i++) {
+		uint8_t t = src[2 * i];
+		dst[2 * i] = src[2 * i + 1];
+		dst[2 * i + 1] = t;
+	}
+}
+
+
+/* Swap the samples of 16-bit pairs; src and dst can be the same */
+static void swap16(const uint8_t *src, uint8_t *dst, unsigned int count)
+{
+	unsigned int i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		vdef_priv_v8u16 s;
+		memcpy(&s, src + 4 * i, sizeof(s));
+		s = VDEF_PRIV_SHUFFLE2(s, s, 1, 0, 3, 2, 5, 4, 7, 6);
+		memcpy(dst + 4 * i, &s, sizeof(s));
+	}
+	for (; i < count; i++) {
+		uint8_t t[2];
+		memcpy(t, src + 4 * i, 2);
+		memmove(dst + 4 * i, src + 4 * i + 2, 2);
+		memcpy(dst + 4 * i + 2, t, 2);
+	}
+}
+
+
+/* Chroma layout of a YUV frame */
+struct chroma_layout {
+	/* Component locations */
+	struct vdef_priv_comp comp[4];
+
+	/* Sample size in bytes */
+	unsigned int bytes;
+
+	/* Chroma planes dimensions (in samples) */
+	unsigned int width;
+	unsigned int height;
+};
+
+
+/* Get the component locations and sample size of a format */
+static int get_chroma_comp(const struct vdef_raw_format *format,
+			   struct chroma_layout *layout)
+{
+	unsigned int count;
+
+	if (format->pix_format != VDEF_RAW_PIX_FORMAT_YUV420 &&
+	    format->pix_format != VDEF_RAW_PIX_FORMAT_YUV422 &&
+	    format->pix_format != VDEF_RAW_PIX_FORMAT_YUV444)
+		return -ENOTSUP;
+	if (format->data_layout != VDEF_RAW_DATA_LAYOUT_PLANAR &&
+	    format->data_layout != VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR)
+		return -ENOTSUP;
+	if (format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR ||
+	    (format->data_size != 8 && format->data_size != 16))
+		return -ENOTSUP;
+
+	layout->bytes = format->data_size / 8;
+	return vdef_priv_get_comp_layout(format, layout->comp, &count);
+}
+
+
+static int get_chroma_layout(const struct vdef_raw_format *format,
+			     const struct vdef_dim *resolution,
+			     struct chroma_layout *layout)
+{
+	int ret;
+
+	ret = get_chroma_comp(format, layout);
+	if (ret < 0)
+		return ret;
+
+	/* The chroma plane dimensions are rounded down */
+	layout->width = resolution->width / layout->comp[1].h_sub;
+	layout->height = resolution->height / layout->comp[1].v_sub;
+	if (layout->width == 0 || layout->height == 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+
+/* Check that only the chroma layout differs between two formats */
+static bool is_chroma_compatible(const struct vdef_raw_format *f1,
+				 const struct vdef_raw_format *f2)
+{
+	return f1->pix_format == f2->pix_format &&
+	       f1->pix_layout == f2->pix_layout &&
+	       f1->pix_size == f2->pix_size &&
+	       f1->data_size == f2->data_size &&
+	       (f1->data_size == 8 ||
+		(f1->data_pad_low == f2->data_pad_low &&
+		 f1->data_little_endian == f2->data_little_endian));
+}
+
+
+/* Convert a line of chroma samples; the input and output lines must not
+ * overlap, except for semi-planar to semi-planar conversions */
+static void convert_chroma_line(const uint8_t *in_u,
+				const uint8_t *in_v,
+				unsigned int in_step,
+				uint8_t *out_u,
+				uint8_t *out_v,
+				unsigned int out_step,
+				unsigned int bytes,
+				unsigned int count)
+{
+	if (in_step == 1 && out_step == 1) {
+		memcpy(out_u, in_u, (size_t)count * bytes);
+		memcpy(out_v, in_v, (size_t)count * bytes);
+	} else if (in_step == 2 && out_step == 1) {
+		if (in_v < in_u) {
+			SWAP(in_u, in_v);
+			SWAP(out_u, out_v);
+		}
+		if (bytes == 1)
+			deinterleave8(in_u, out_u, out_v, count);
+		else
+			deinterleave16(in_u, out_u, out_v, count);
+	} else if (in_step == 1 && out_step == 2) {
+		if (out_v < out_u) {
+			SWAP(in_u, in_v);
+			SWAP(out_u, out_v);
+		}
+		if (bytes == 1)
+			interleave8(in_u, in_v, out_u, count);
+		else
+			interleave16(in_u, in_v, out_u, count);
+	} else if ((in_u < in_v) == (out_u < out_v)) {
+		memmove(out_u < out_v ? out_u : out_v,
+			in_u < in_v ? in_u : in_v,
+			(size_t)count * bytes * 2);
+	} else {
+		const uint8_t *in = in_u < in_v ? in_u : in_v;
+		uint8_t *out = out_u < out_v ? out_u : out_v;
+		vdef_priv_swap_pairs(in, out, count, bytes);
+	}
+}
+
+
+void vdef_priv_swap_pairs(const uint8_t *src,
+			  uint8_t *dst,
+			  unsigned int count,
+			  unsigned int bytes)
+{
+	if (bytes == 1)
+		swap8(src, dst, count);
+	else
+		swap16(src, dst, count);
+}
+
+
+int vdef_priv_yuv_chroma_check(const struct vdef_raw_format *in_format,
+			       const struct vdef_raw_format *out_format)
+{
+	int ret;
+	struct chroma_layout layout;
+
+	if (!is_chroma_compatible(in_format, out_format))
+		return -ENOTSUP;
+	ret = get_chroma_comp(in_format, &layout);
+	if (ret < 0)
+		return ret;
+	return get_chroma_comp(out_format, &layout);
+}
+
+
+int vdef_convert_yuv_chroma(const struct vdef_raw_frame *in_frame,
+			    const void *const *in_plane,
+			    const struct vdef_raw_frame *out_frame,
+			    void *const *out_plane)
+{
+	int ret;
+	struct chroma_layout in, out;
+	const struct vdef_dim *res;
+	size_t luma_len;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	if (!is_chroma_compatible(&in_frame->format, &out_frame->format))
+		return -ENOTSUP;
+	res = &in_frame->info.resolution;
+	ret = get_chroma_layout(&in_frame->format, res, &in);
+	if (ret < 0)
+		return ret;
+	ret = get_chroma_layout(&out_frame->format, res, &out);
+	if (ret < 0)
+		return ret;
+
+	/* Luma */
+	luma_len = (size_t)res->width * in.bytes;
+	if (in_plane[0] != out_plane[0]) {
+		for (unsigned int y = 0; y < res->height; y++) {
+			memcpy((uint8_t *)out_plane[0] +
+				       y * out_frame->plane_stride[0],
+			       (const uint8_t *)in_plane[0] +
+				       y * in_frame->plane_stride[0],
+			       luma_len);
+		}
+	}
+
+	/* Chroma */
+	for (unsigned int y = 0; y < in.height; y++) {
+		unsigned int py = y * in.comp[1].v_sub;
+		convert_chroma_line(
+			vdef_priv_comp_ptr(in_plane,
+					   in_frame->plane_stride,
+					   &in.comp[1],
+					   in.bytes,
+					   0,
+					   py),
+			vdef_priv_comp_ptr(in_plane,
+					   in_frame->plane_stride,
+					   &in.comp[2],
+					   in.bytes,
+					   0,
+					   py),
+			in.comp[1].step,
+			vdef_priv_comp_ptr((const void *const *)out_plane,
+					   out_frame->plane_stride,
+					   &out.comp[1],
+					   out.bytes,
+					   0,
+					   py),
+			vdef_priv_comp_ptr((const void *const *)out_plane,
+					   out_frame->plane_stride,
+					   &out.comp[2],
+					   out.bytes,
+					   0,
+					   py),
+			out.comp[1].step,
+			in.bytes,
+			in.width);
+	}
+
+	return 0;
+}
+
+
+int vdef_convert_yuv_chroma_in_place(struct vdef_raw_frame *frame,
+				     void **plane,
+				     const struct vdef_raw_format *format)
+{
+	int ret;
+	struct chroma_layout in, out;
+	const struct vdef_dim *res;
+
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+
+	if (!is_chroma_compatible(&frame->format, format))
+		return -ENOTSUP;
+	res = &frame->info.resolution;
+	ret = get_chroma_layout(&frame->format, res, &in);
+	if (ret < 0)
+		return ret;
+	ret = get_chroma_layout(format, res, &out);
+	if (ret < 0)
+		return ret;
+
+	if (vdef_raw_format_cmp(&frame->format, format)) {
+		return 0;
+	} else if (in.comp[1].step == 1 && out.comp[1].step == 1) {
+		/* Planar chroma order change: the chroma plane pointers and
+		 * strides are swapped, without copying */
+		SWAP(plane[1], plane[2]);
+		SWAP(frame->plane_stride[1], frame->plane_stride[2]);
+		frame->format = *format;
+		return 0;
+	} else if (in.comp[1].step == 2 && out.comp[1].step == 2) {
+		/* Semi-planar chroma order change: the samples are swapped in
+		 * place, keeping the strides */
+		struct vdef_raw_frame out_frame = *frame;
+		out_frame.format = *format;
+		ret = vdef_convert_yuv_chroma(
+			frame, (const void *const *)plane, &out_frame, plane);
+		if (ret < 0)
+			return ret;
+		*frame = out_frame;
+		return 0;
+	}
+
+	/* Between planar and semi-planar chroma, the samples of each output
+	 * line come from input lines that are overwritten before they are
+	 * read, whatever the line order: this cannot be done in place */
+	return -ENOTSUP;
+}
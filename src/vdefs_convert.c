@@ -0,0 +1,1061 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* True if the host is little-endian */
+#define HOST_LE (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+
+/* Default fractional bits of the fixed-point matrix coefficients */
+#define MAT3_FRAC_BITS 13
+
+/* Maximum absolute value of a fixed-point matrix product sum */
+#define MAT3_SUM_MAX (1 << 30)
+
+
+int vdef_priv_get_sample_fmt(const struct vdef_raw_format *format,
+			     struct vdef_priv_sample_fmt *fmt)
+{
+	if (format->pix_size < 8 || format->pix_size > format->data_size)
+		return -ENOTSUP;
+
+	switch (format->data_size) {
+	case 8:
+		fmt->type = VDEF_PRIV_SAMPLE_U8;
+		break;
+	case 16:
+		fmt->type = format->data_little_endian
+				    ? VDEF_PRIV_SAMPLE_U16LE
+				    : VDEF_PRIV_SAMPLE_U16BE;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+	fmt->depth = format->pix_size;
+	fmt->shift =
+		format->data_pad_low ? format->data_size - format->pix_size : 0;
+
+	return 0;
+}
+
+
+void vdef_priv_read_samples(const void *src,
+			    unsigned int step,
+			    unsigned int count,
+			    const struct vdef_priv_sample_fmt *fmt,
+			    int32_t *dst)
+{
+	const uint8_t *s = src;
+	unsigned int shift = fmt->shift;
+	int32_t mask = (1 << fmt->depth) - 1;
+
+	switch (fmt->type) {
+	case VDEF_PRIV_SAMPLE_U8:
+		if (step == 1) {
+			for (unsigned int i = 0; i < count; i++)
+				dst[i] = s[i];
+		} else {
+			for (unsigned int i = 0; i < count; i++)
+				dst[i] = s[i * step];
+		}
+		break;
+	case VDEF_PRIV_SAMPLE_U16LE:
+		for (unsigned int i = 0; i < count; i++) {
+			const uint8_t *p = s + 2 * i * step;
+			dst[i] = ((p[0] | (p[1] << 8)) >> shift) & mask;
+		}
+		break;
+	case VDEF_PRIV_SAMPLE_U16BE:
+		for (unsigned int i = 0; i < count; i++) {
+			const uint8_t *p = s + 2 * i * step;
+			dst[i] = (((p[0] << 8) | p[1]) >> shift) & mask;
+		}
+		break;
+	}
+}
+
+
+void vdef_priv_write_samples(void *dst,
+			     unsigned int step,
+			     unsigned int count,
+			     const struct vdef_priv_sample_fmt *fmt,
+			     const int32_t *src)
+{
+	uint8_t *d = dst;
+	unsigned int shift = fmt->shift;
+
+	switch (fmt->type) {
+	case VDEF_PRIV_SAMPLE_U8:
+		if (step == 1) {
+			for (unsigned int i = 0; i < count; i++)
+				d[i] = src[i];
+		} else {
+			for (unsigned int i = 0; i < count; i++)
+				d[i * step] = src[i];
+		}
+		break;
+	case VDEF_PRIV_SAMPLE_U16LE:
+		for (unsigned int i = 0; i < count; i++) {
+			uint8_t *p = d + 2 * i * step;
+			uint32_t v = (uint32_t)src[i] << shift;
+			p[0] = v & 0xff;
+			p[1] = (v >> 8) & 0xff;
+		}
+		break;
+	case VDEF_PRIV_SAMPLE_U16BE:
+		for (unsigned int i = 0; i < count; i++) {
+			uint8_t *p = d + 2 * i * step;
+			uint32_t v = (uint32_t)src[i] << shift;
+			p[0] = (v >> 8) & 0xff;
+			p[1] = v & 0xff;
+		}
+		break;
+	}
+}
+
+
+int vdef_priv_get_comp_layout(const struct vdef_raw_format *format,
+			      struct vdef_priv_comp comp[4],
+			      unsigned int *count)
+{
+	int ret;
+	unsigned int perm[4];
+	unsigned int n, h_sub = 1, v_sub = 1;
+	bool yuv = false, u_first;
+
+	if (format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR)
+		return -ENOTSUP;
+	if (format->data_size != 8 && format->data_size != 16)
+		return -ENOTSUP;
+	ret = vdef_priv_get_pix_order_perm(format->pix_order, perm);
+	if (ret < 0)
+		return -ENOTSUP;
+
+	switch (format->pix_format) {
+	case VDEF_RAW_PIX_FORMAT_YUV420:
+		v_sub = 2;
+		/* Fall through */
+	case VDEF_RAW_PIX_FORMAT_YUV422:
+		h_sub = 2;
+		/* Fall through */
+	case VDEF_RAW_PIX_FORMAT_YUV444:
+		yuv = true;
+		n = 3;
+		break;
+	case VDEF_RAW_PIX_FORMAT_GRAY:
+		n = 1;
+		break;
+	case VDEF_RAW_PIX_FORMAT_RGB24:
+		n = 3;
+		break;
+	case VDEF_RAW_PIX_FORMAT_RGBA32:
+		n = 4;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	memset(comp, 0, 4 * sizeof(*comp));
+	for (unsigned int i = 0; i < n; i++) {
+		comp[i].step = 1;
+		comp[i].h_sub = 1;
+		comp[i].v_sub = 1;
+	}
+
+	if (yuv) {
+		/* Luma first, then the chroma order is given by the
+		 * relative positions of B (U) and C (V) */
+		if (perm[0] != 0)
+			return -ENOTSUP;
+		u_first = perm[1] < perm[2];
+		for (unsigned int i = 1; i < 3; i++) {
+			comp[i].h_sub = h_sub;
+			comp[i].v_sub = v_sub;
+		}
+		switch (format->data_layout) {
+		case VDEF_RAW_DATA_LAYOUT_PLANAR:
+			comp[1].plane = u_first ? 1 : 2;
+			comp[2].plane = u_first ? 2 : 1;
+			break;
+		case VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR:
+			comp[1].plane = comp[2].plane = 1;
+			comp[1].offset = u_first ? 0 : 1;
+			comp[2].offset = u_first ? 1 : 0;
+			comp[1].step = comp[2].step = 2;
+			break;
+		case VDEF_RAW_DATA_LAYOUT_INTERLEAVED:
+			if (h_sub != 2 || v_sub != 1)
+				return -ENOTSUP;
+			comp[0].step = 2;
+			comp[1].offset = u_first ? 1 : 3;
+			comp[2].offset = u_first ? 3 : 1;
+			comp[1].step = comp[2].step = 4;
+			break;
+		default:
+			return -ENOTSUP;
+		}
+	} else {
+		for (unsigned int i = 0; i < n; i++) {
+			if (perm[i] >= n)
+				return -ENOTSUP;
+		}
+		switch (format->data_layout) {
+		case VDEF_RAW_DATA_LAYOUT_PACKED:
+			for (unsigned int i = 0; i < n; i++) {
+				comp[perm[i]].offset = i;
+				comp[perm[i]].step = n;
+			}
+			break;
+		case VDEF_RAW_DATA_LAYOUT_PLANAR:
+			for (unsigned int i = 0; i < n; i++)
+				comp[perm[i]].plane = i;
+			break;
+		default:
+			return -ENOTSUP;
+		}
+	}
+
+	*count = n;
+	return 0;
+}
+
+
+void vdef_priv_mat3_init(struct vdef_priv_mat3 *mat,
+			 const float *fmat,
+			 const int32_t *in_off,
+			 float in_scale,
+			 int32_t in_max,
+			 const int32_t *out_off,
+			 float out_scale,
+			 int32_t out_max)
+{
+	double sum, sum_max = 0.;
+	float scale = out_scale / in_scale;
+
+	/* Reduce the precision if needed so that the products sums can never
+	 * overflow (e.g. 8-bit to 16-bit conversions) */
+	for (unsigned int c = 0; c < 3; c++) {
+		sum = 0.;
+		for (unsigned int k = 0; k < 3; k++)
+			sum += fabs(fmat[k * 3 + c] * scale) * in_max;
+		sum += out_max;
+		if (sum > sum_max)
+			sum_max = sum;
+	}
+	mat->frac_bits = MAT3_FRAC_BITS;
+	while (mat->frac_bits > 0 &&
+	       sum_max * (1 << mat->frac_bits) >= MAT3_SUM_MAX)
+		mat->frac_bits--;
+
+	for (unsigned int i = 0; i < 9; i++)
+		mat->coef[i] = lrintf(fmat[i] * scale * (1 << mat->frac_bits));
+	for (unsigned int i = 0; i < 3; i++) {
+		mat->in_off[i] = in_off[i];
+		mat->out_off[i] = out_off[i];
+	}
+	mat->out_max = out_max;
+}
+
+
+void vdef_priv_mat3_init_fixed(struct vdef_priv_mat3 *mat,
+			       const int32_t *imat,
+			       unsigned int frac_bits,
+			       const int32_t *in_off,
+			       const int32_t *out_off,
+			       int32_t out_max)
+{
+	mat->frac_bits = frac_bits;
+	memcpy(mat->coef, imat, sizeof(mat->coef));
+	for (unsigned int i = 0; i < 3; i++) {
+		mat->in_off[i] = in_off[i];
+		mat->out_off[i] = out_off[i];
+	}
+	mat->out_max = out_max;
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+void vdef_priv_mat3_apply(const struct vdef_priv_mat3 *mat,
+			  int32_t in[3][VDEF_PRIV_CHUNK],
+			  int32_t out[3][VDEF_PRIV_CHUNK])
+{
+	unsigned int shift = mat->frac_bits;
+	int32_t round = (1 << shift) >> 1;
+	int32_t max = mat->out_max;
+
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i += VDEF_PRIV_VEC_LEN) {
+		vdef_priv_v8i32 a0, a1, a2, v, m;
+
+		/* Separate vector variables (rather than an array) so that the
+		 * loads are not spilled to the stack */
+		memcpy(&a0, &in[0][i], sizeof(a0));
+		memcpy(&a1, &in[1][i], sizeof(a1));
+		memcpy(&a2, &in[2][i], sizeof(a2));
+		a0 -= mat->in_off[0];
+		a1 -= mat->in_off[1];
+		a2 -= mat->in_off[2];
+		for (unsigned int c = 0; c < 3; c++) {
+			v = a0 * mat->coef[c] + a1 * mat->coef[3 + c] +
+			    a2 * mat->coef[6 + c];
+			v = (v + ((mat->out_off[c] << shift) + round)) >> shift;
+			/* Clamp to [0..max] (comparisons give masks) */
+			v &= (v > 0);
+			m = (v > max);
+			v = (v & ~m) | (max & m);
+			memcpy(&out[c][i], &v, sizeof(v));
+		}
+	}
+}
+
+
+static bool is_yuv(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_YUV420 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_YUV422 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_YUV444;
+}
+
+
+static bool is_rgb(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_RGB24 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_RGBA32;
+}
+
+
+/* Get the fixed-point tables index of a bit depth, or -1 if the tables
+ * do not cover the bit depth */
+static int get_fixed_depth(unsigned int depth)
+{
+	switch (depth) {
+	case 8:
+		return VDEF_FIXED_DEPTH_8;
+	case 10:
+		return VDEF_FIXED_DEPTH_10;
+	case 12:
+		return VDEF_FIXED_DEPTH_12;
+	default:
+		return -1;
+	}
+}
+
+
+void vdef_priv_get_yuv_range(unsigned int depth,
+			     bool full_range,
+			     int32_t off[3],
+			     float *scale)
+{
+	off[0] = full_range ? 0 : 16 << (depth - 8);
+	off[1] = off[2] = 1 << (depth - 1);
+	*scale = full_range ? (1 << depth) - 1 : 255 << (depth - 8);
+}
+
+
+/* With odd frame dimensions, the last pixels of a line or the last line
+ * of a frame have no chroma samples of their own (the chroma plane
+ * dimensions are rounded down), so the last available chroma samples are
+ * replicated */
+void vdef_priv_read_comp(const void *const *plane,
+			 const size_t *stride,
+			 const struct vdef_priv_comp *comp,
+			 const struct vdef_priv_sample_fmt *fmt,
+			 const struct vdef_dim *res,
+			 unsigned int x,
+			 unsigned int y,
+			 unsigned int count,
+			 int32_t *dst)
+{
+	unsigned int bytes = fmt->type == VDEF_PRIV_SAMPLE_U8 ? 1 : 2;
+	unsigned int last_x = res->width / comp->h_sub - 1;
+	unsigned int last_y = res->height / comp->v_sub - 1;
+	unsigned int start, n;
+	const uint8_t *src;
+
+	if (comp->h_sub == 1 && comp->v_sub == 1) {
+		src = vdef_priv_comp_ptr(plane, stride, comp, bytes, x, y);
+		vdef_priv_read_samples(src, comp->step, count, fmt, dst);
+		return;
+	}
+
+	start = x / comp->h_sub;
+	if (start > last_x)
+		start = last_x;
+	if (y / comp->v_sub > last_y)
+		y = last_y * comp->v_sub;
+	n = (count + comp->h_sub - 1) / comp->h_sub;
+	if (n > last_x - start + 1)
+		n = last_x - start + 1;
+	src = vdef_priv_comp_ptr(
+		plane, stride, comp, bytes, start * comp->h_sub, y);
+	vdef_priv_read_samples(src, comp->step, n, fmt, dst);
+	if (comp->h_sub == 1)
+		return;
+	for (unsigned int i = count; i-- > 0;) {
+		unsigned int j = i / comp->h_sub;
+		dst[i] = dst[j < n ? j : n - 1];
+	}
+}
+
+
+void vdef_priv_write_comp(void *const *plane,
+			  const size_t *stride,
+			  const struct vdef_priv_comp *comp,
+			  const struct vdef_priv_sample_fmt *fmt,
+			  unsigned int x,
+			  unsigned int y,
+			  unsigned int count,
+			  const int32_t *src)
+{
+	unsigned int bytes = fmt->type == VDEF_PRIV_SAMPLE_U8 ? 1 : 2;
+	uint8_t *dst = vdef_priv_comp_ptr(
+		(const void *const *)plane, stride, comp, bytes, x, y);
+
+	vdef_priv_write_samples(dst, comp->step, count, fmt, src);
+}
+
+
+/* Fast path of the YUV to RGB conversion: planar or semi-planar YUV to
+ * packed RGB, with 8-bit or 16-bit samples in host byte order on both
+ * sides; the chunk loads and stores are fixed-size loops specialized on
+ * the storage so that the compiler vectorizes the deinterleaving, the
+ * chroma upsampling and the interleaving */
+struct yuv_to_rgb_fast {
+	/* Sample size in bytes */
+	unsigned int bytes;
+
+	/* Chroma samples interleaved in a single plane */
+	bool semi_planar;
+
+	/* Chroma horizontal subsampling (1 or 2) */
+	unsigned int h_sub;
+
+	/* Output components per pixel (3 or 4) */
+	unsigned int out_count;
+
+	/* Canonical component (R, G, B, A) of each output sample of a
+	 * pixel */
+	unsigned int out_comp[4];
+};
+
+
+static bool yuv_to_rgb_fast_init(struct yuv_to_rgb_fast *fast,
+				 const struct vdef_priv_comp *in_comp,
+				 const struct vdef_priv_sample_fmt *in_fmt,
+				 const struct vdef_priv_comp *out_comp,
+				 unsigned int out_count,
+				 const struct vdef_priv_sample_fmt *out_fmt)
+{
+	enum vdef_priv_sample_type host_u16 =
+		HOST_LE ? VDEF_PRIV_SAMPLE_U16LE : VDEF_PRIV_SAMPLE_U16BE;
+
+	if (in_fmt->type != out_fmt->type)
+		return false;
+	if (in_fmt->type != VDEF_PRIV_SAMPLE_U8 && in_fmt->type != host_u16)
+		return false;
+	fast->bytes = in_fmt->type == VDEF_PRIV_SAMPLE_U8 ? 1 : 2;
+
+	/* Luma plane, then chroma planes or interleaved chroma plane */
+	if (in_comp[0].step != 1 || in_comp[1].h_sub > 2)
+		return false;
+	fast->h_sub = in_comp[1].h_sub;
+	fast->semi_planar = in_comp[1].plane == in_comp[2].plane;
+	if (in_comp[1].step != (fast->semi_planar ? 2 : 1))
+		return false;
+
+	/* Packed output */
+	if (out_count < 3)
+		return false;
+	fast->out_count = out_count;
+	for (unsigned int c = 0; c < out_count; c++) {
+		if (out_comp[c].plane != 0 || out_comp[c].step != out_count)
+			return false;
+		fast->out_comp[out_comp[c].offset] = c;
+	}
+
+	return true;
+}
+
+
+static inline __attribute__((always_inline)) void
+fast_load(const uint8_t *restrict src,
+	  unsigned int bytes,
+	  unsigned int shift,
+	  int32_t mask,
+	  int32_t *restrict dst)
+{
+	const uint16_t *src16 = (const uint16_t *)src;
+
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++) {
+		int32_t v = bytes == 1 ? src[i] : src16[i];
+		dst[i] = (v >> shift) & mask;
+	}
+}
+
+
+/* Load the chroma samples of a chunk of pixels; interleaved samples are
+ * deinterleaved and subsampled samples are replicated */
+static inline __attribute__((always_inline)) void
+fast_load_chroma(const uint8_t *restrict src0,
+		 const uint8_t *restrict src1,
+		 unsigned int bytes,
+		 bool interleaved,
+		 unsigned int h_sub,
+		 unsigned int shift,
+		 int32_t mask,
+		 int32_t *restrict dst0,
+		 int32_t *restrict dst1)
+{
+	const uint16_t *src0_16 = (const uint16_t *)src0;
+	const uint16_t *src1_16 = (const uint16_t *)src1;
+	unsigned int step = interleaved ? 2 : 1;
+
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK / h_sub; i++) {
+		int32_t v0, v1;
+
+		if (interleaved) {
+			v0 = bytes == 1 ? src0[i * step] : src0_16[i * step];
+			v1 = bytes == 1 ? src0[i * step + 1]
+					: src0_16[i * step + 1];
+		} else {
+			v0 = bytes == 1 ? src0[i] : src0_16[i];
+			v1 = bytes == 1 ? src1[i] : src1_16[i];
+		}
+		v0 = (v0 >> shift) & mask;
+		v1 = (v1 >> shift) & mask;
+		for (unsigned int h = 0; h < h_sub; h++) {
+			dst0[i * h_sub + h] = v0;
+			dst1[i * h_sub + h] = v1;
+		}
+	}
+}
+
+
+static inline __attribute__((always_inline)) void
+fast_store(uint8_t *restrict dst,
+	   unsigned int bytes,
+	   unsigned int n,
+	   unsigned int shift,
+	   const int32_t *restrict src0,
+	   const int32_t *restrict src1,
+	   const int32_t *restrict src2,
+	   const int32_t *restrict src3)
+{
+	uint16_t *dst16 = (uint16_t *)dst;
+
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++) {
+		if (bytes == 1) {
+			dst[i * n] = src0[i];
+			dst[i * n + 1] = src1[i];
+			dst[i * n + 2] = src2[i];
+			if (n == 4)
+				dst[i * n + 3] = src3[i];
+		} else {
+			dst16[i * n] = src0[i] << shift;
+			dst16[i * n + 1] = src1[i] << shift;
+			dst16[i * n + 2] = src2[i] << shift;
+			if (n == 4)
+				dst16[i * n + 3] = src3[i] << shift;
+		}
+	}
+}
+
+
+/* Convert the whole chunks of a line; src[0] is the luma line and src[1]
+ * and src[2] the U and V lines, swapped if swap_uv is set (for interleaved
+ * samples, src[1] is the first sample in memory and src[2] is not used) */
+static inline __attribute__((always_inline)) void
+fast_line(const struct yuv_to_rgb_fast *fast,
+	  const struct vdef_priv_mat3 *mat,
+	  const struct vdef_priv_sample_fmt *in_fmt,
+	  const struct vdef_priv_sample_fmt *out_fmt,
+	  const uint8_t *const src[3],
+	  bool swap_uv,
+	  uint8_t *dst,
+	  unsigned int chunks,
+	  unsigned int bytes,
+	  bool interleaved,
+	  unsigned int h_sub,
+	  unsigned int n)
+{
+	int32_t in[3][VDEF_PRIV_CHUNK], out[4][VDEF_PRIV_CHUNK];
+	int32_t mask = (1 << in_fmt->depth) - 1;
+	size_t chroma_size = VDEF_PRIV_CHUNK / h_sub * (interleaved ? 2 : 1);
+	int32_t *c0 = swap_uv ? in[2] : in[1];
+	int32_t *c1 = swap_uv ? in[1] : in[2];
+	const int32_t *s[4];
+
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++)
+		out[3][i] = mat->out_max;
+	for (unsigned int k = 0; k < n; k++)
+		s[k] = out[fast->out_comp[k]];
+
+	for (unsigned int x = 0; x < chunks; x++) {
+		size_t chroma_off = x * chroma_size * bytes;
+
+		fast_load(src[0] + (size_t)x * VDEF_PRIV_CHUNK * bytes,
+			  bytes,
+			  in_fmt->shift,
+			  mask,
+			  in[0]);
+		fast_load_chroma(src[1] + chroma_off,
+				 interleaved ? NULL : src[2] + chroma_off,
+				 bytes,
+				 interleaved,
+				 h_sub,
+				 in_fmt->shift,
+				 mask,
+				 c0,
+				 c1);
+		vdef_priv_mat3_apply(mat, in, out);
+		fast_store(dst + (size_t)x * VDEF_PRIV_CHUNK * n * bytes,
+			   bytes,
+			   n,
+			   out_fmt->shift,
+			   s[0],
+			   s[1],
+			   s[2],
+			   s[n - 1]);
+	}
+}
+
+
+#define FAST_LINE_CASE(_bytes, _interleaved, _h_sub, _n)                       \
+	case (_bytes) | ((_interleaved) << 2) | ((_h_sub) << 3) | ((_n) << 5): \
+		fast_line(fast,                                                \
+			  mat,                                                 \
+			  in_fmt,                                              \
+			  out_fmt,                                             \
+			  src,                                                 \
+			  swap_uv,                                             \
+			  dst,                                                 \
+			  chunks,                                              \
+			  _bytes,                                              \
+			  _interleaved,                                        \
+			  _h_sub,                                              \
+			  _n);                                                 \
+		break
+
+
+#define FAST_LINE_CASES(_bytes, _interleaved, _h_sub)                          \
+	FAST_LINE_CASE(_bytes, _interleaved, _h_sub, 3);                       \
+	FAST_LINE_CASE(_bytes, _interleaved, _h_sub, 4)
+
+
+static VDEF_PRIV_TARGET_CLONES void
+yuv_to_rgb_fast_line(const struct yuv_to_rgb_fast *fast,
+		     const struct vdef_priv_mat3 *mat,
+		     const struct vdef_priv_sample_fmt *in_fmt,
+		     const struct vdef_priv_sample_fmt *out_fmt,
+		     const uint8_t *const src[3],
+		     bool swap_uv,
+		     uint8_t *dst,
+		     unsigned int chunks)
+{
+	switch (fast->bytes | (fast->semi_planar << 2) | (fast->h_sub << 3) |
+		(fast->out_count << 5)) {
+		FAST_LINE_CASES(1, 0, 1);
+		FAST_LINE_CASES(1, 0, 2);
+		FAST_LINE_CASES(1, 1, 1);
+		FAST_LINE_CASES(1, 1, 2);
+		FAST_LINE_CASES(2, 0, 1);
+		FAST_LINE_CASES(2, 0, 2);
+		FAST_LINE_CASES(2, 1, 1);
+		FAST_LINE_CASES(2, 1, 2);
+	default:
+		break;
+	}
+}
+
+
+int vdef_convert_yuv_to_rgb(const struct vdef_raw_frame *in_frame,
+			    const void *const *in_plane,
+			    const struct vdef_raw_frame *out_frame,
+			    void *const *out_plane)
+{
+	int ret;
+	struct vdef_priv_comp in_comp[4], out_comp[4];
+	unsigned int in_count, out_count;
+	struct vdef_priv_sample_fmt in_fmt, out_fmt;
+	struct vdef_priv_mat3 mat;
+	int32_t in_off[3], out_off[3] = {0, 0, 0};
+	float in_scale;
+	enum vdef_matrix_coefs matrix;
+	bool full_range;
+	int depth;
+	unsigned int width, height;
+	int32_t in[3][VDEF_PRIV_CHUNK], out[3][VDEF_PRIV_CHUNK];
+	int32_t alpha[VDEF_PRIV_CHUNK];
+	struct yuv_to_rgb_fast fast;
+	unsigned int chunks = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	matrix = in_frame->info.matrix_coefs;
+	full_range = in_frame->info.full_range;
+	ULOG_ERRNO_RETURN_ERR_IF(matrix == VDEF_MATRIX_COEFS_UNKNOWN, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(matrix >= VDEF_MATRIX_COEFS_MAX, EINVAL);
+
+	if (!is_yuv(&in_frame->format) || !is_rgb(&out_frame->format))
+		return -ENOTSUP;
+
+	ret = vdef_priv_get_comp_layout(&in_frame->format, in_comp, &in_count);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&in_frame->format, &in_fmt);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_comp_layout(
+		&out_frame->format, out_comp, &out_count);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&out_frame->format, &out_fmt);
+	if (ret < 0)
+		return ret;
+
+	depth = get_fixed_depth(in_fmt.depth);
+	if (in_fmt.depth == out_fmt.depth && depth >= 0) {
+		/* Same bit depth: use the precomputed integer tables */
+		const int32_t *off =
+			vdef_yuv_to_rgb_fixed_offset[matrix][full_range][depth];
+		for (unsigned int i = 0; i < 3; i++)
+			in_off[i] = -off[i];
+		vdef_priv_mat3_init_fixed(
+			&mat,
+			vdef_yuv_to_rgb_fixed_matrix[matrix][full_range][depth],
+			VDEF_YUV_TO_RGB_FIXED_SHIFT,
+			in_off,
+			out_off,
+			(1 << out_fmt.depth) - 1);
+	} else {
+		vdef_priv_get_yuv_range(
+			in_fmt.depth, full_range, in_off, &in_scale);
+		vdef_priv_mat3_init(
+			&mat,
+			vdef_yuv_to_rgb_norm_matrix[matrix][full_range],
+			in_off,
+			in_scale,
+			(1 << in_fmt.depth) - 1,
+			out_off,
+			(1 << out_fmt.depth) - 1,
+			(1 << out_fmt.depth) - 1);
+	}
+	/* The whole chunks are processed even for the last pixels of a line */
+	memset(in, 0, sizeof(in));
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++)
+		alpha[i] = mat.out_max;
+
+	width = in_frame->info.resolution.width;
+	height = in_frame->info.resolution.height;
+	if (width < in_comp[1].h_sub || height < in_comp[1].v_sub)
+		return -EINVAL;
+
+	/* Whole chunks of pixels with chroma samples of their own use the
+	 * fast path, the remaining pixels of each line the generic one */
+	if (yuv_to_rgb_fast_init(
+		    &fast, in_comp, &in_fmt, out_comp, out_count, &out_fmt))
+		chunks = width / in_comp[1].h_sub * in_comp[1].h_sub /
+			 VDEF_PRIV_CHUNK;
+
+	for (unsigned int y = 0; y < height; y++) {
+		if (chunks > 0) {
+			const uint8_t *src[3];
+			uint8_t *dst = (uint8_t *)out_plane[0] +
+				       y * out_frame->plane_stride[0];
+			unsigned int last_y = height / in_comp[1].v_sub - 1;
+			unsigned int cy = y;
+			bool swap_uv = false;
+
+			if (y / in_comp[1].v_sub > last_y)
+				cy = last_y * in_comp[1].v_sub;
+			for (unsigned int k = 0; k < 3; k++) {
+				src[k] = vdef_priv_comp_ptr(
+					in_plane,
+					in_frame->plane_stride,
+					&in_comp[k],
+					fast.bytes,
+					0,
+					k == 0 ? y : cy);
+			}
+			if (fast.semi_planar && src[2] < src[1]) {
+				src[1] = src[2];
+				swap_uv = true;
+			}
+			yuv_to_rgb_fast_line(&fast,
+					     &mat,
+					     &in_fmt,
+					     &out_fmt,
+					     src,
+					     swap_uv,
+					     dst,
+					     chunks);
+		}
+		for (unsigned int x = chunks * VDEF_PRIV_CHUNK; x < width;
+		     x += VDEF_PRIV_CHUNK) {
+			unsigned int n = width - x;
+			if (n > VDEF_PRIV_CHUNK)
+				n = VDEF_PRIV_CHUNK;
+			for (unsigned int k = 0; k < 3; k++) {
+				vdef_priv_read_comp(in_plane,
+						    in_frame->plane_stride,
+						    &in_comp[k],
+						    &in_fmt,
+						    &in_frame->info.resolution,
+						    x,
+						    y,
+						    n,
+						    in[k]);
+			}
+			vdef_priv_mat3_apply(&mat, in, out);
+			for (unsigned int c = 0; c < out_count; c++) {
+				vdef_priv_write_comp(out_plane,
+						     out_frame->plane_stride,
+						     &out_comp[c],
+						     &out_fmt,
+						     x,
+						     y,
+						     n,
+						     c < 3 ? out[c] : alpha);
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+/* Sum the values of the pixels covered by each subsampled chroma sample */
+static void sum_chroma(int32_t in[2][3][VDEF_PRIV_CHUNK],
+		       unsigned int h_sub,
+		       unsigned int v_sub,
+		       unsigned int count,
+		       int32_t sum[3][VDEF_PRIV_CHUNK])
+{
+	for (unsigned int k = 0; k < 3; k++) {
+		for (unsigned int i = 0; i < count; i++) {
+			int32_t s = 0;
+			for (unsigned int r = 0; r < v_sub; r++) {
+				for (unsigned int h = 0; h < h_sub; h++)
+					s += in[r][k][i * h_sub + h];
+			}
+			sum[k][i] = s;
+		}
+	}
+}
+
+
+int vdef_convert_rgb_to_yuv(const struct vdef_raw_frame *in_frame,
+			    const void *const *in_plane,
+			    const struct vdef_raw_frame *out_frame,
+			    void *const *out_plane)
+{
+	int ret;
+	struct vdef_priv_comp in_comp[4], out_comp[4];
+	unsigned int in_count, out_count;
+	struct vdef_priv_sample_fmt in_fmt, out_fmt;
+	struct vdef_priv_mat3 mat, mat_avg;
+	int32_t in_off[3] = {0, 0, 0}, out_off[3];
+	float in_scale, out_scale;
+	int32_t in_max, out_max;
+	enum vdef_matrix_coefs matrix;
+	bool full_range;
+	unsigned int width, height, h_sub, v_sub, avg, c_width, c_height;
+	unsigned int out_comps;
+	int depth;
+	const struct vdef_dim *res;
+	int32_t in[2][3][VDEF_PRIV_CHUNK], out[3][VDEF_PRIV_CHUNK];
+	int32_t sum[3][VDEF_PRIV_CHUNK];
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	matrix = out_frame->info.matrix_coefs;
+	full_range = out_frame->info.full_range;
+	ULOG_ERRNO_RETURN_ERR_IF(matrix == VDEF_MATRIX_COEFS_UNKNOWN, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(matrix >= VDEF_MATRIX_COEFS_MAX, EINVAL);
+
+	if (!is_rgb(&in_frame->format) || !is_yuv(&out_frame->format))
+		return -ENOTSUP;
+
+	ret = vdef_priv_get_comp_layout(&in_frame->format, in_comp, &in_count);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&in_frame->format, &in_fmt);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_comp_layout(
+		&out_frame->format, out_comp, &out_count);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&out_frame->format, &out_fmt);
+	if (ret < 0)
+		return ret;
+
+	res = &in_frame->info.resolution;
+	width = res->width;
+	height = res->height;
+	h_sub = out_comp[1].h_sub;
+	v_sub = out_comp[1].v_sub;
+	if (width < h_sub || height < v_sub)
+		return -EINVAL;
+	/* The chroma plane dimensions are rounded down */
+	c_width = width / h_sub;
+	c_height = height / v_sub;
+	avg = h_sub * v_sub;
+	out_comps = avg > 1 ? 1 : 3;
+
+	in_max = (1 << in_fmt.depth) - 1;
+	in_scale = in_max;
+	out_max = (1 << out_fmt.depth) - 1;
+	/* Subsampled chroma is computed from the sums of the RGB values of
+	 * the subsampled pixels (mat_avg), which is the same as averaging the
+	 * unrounded chroma values since the conversion is linear */
+	depth = get_fixed_depth(out_fmt.depth);
+	if (in_fmt.depth == out_fmt.depth && depth >= 0) {
+		/* Same bit depth: use the precomputed integer tables */
+		const int32_t *imat =
+			vdef_rgb_to_yuv_fixed_matrix[matrix][full_range][depth];
+		const int32_t *off =
+			vdef_rgb_to_yuv_fixed_offset[matrix][full_range][depth];
+		vdef_priv_mat3_init_fixed(&mat,
+					  imat,
+					  VDEF_RGB_TO_YUV_FIXED_SHIFT,
+					  in_off,
+					  off,
+					  out_max);
+		/* avg is 1, 2 or 4 */
+		vdef_priv_mat3_init_fixed(&mat_avg,
+					  imat,
+					  VDEF_RGB_TO_YUV_FIXED_SHIFT + avg / 2,
+					  in_off,
+					  off,
+					  out_max);
+	} else {
+		vdef_priv_get_yuv_range(
+			out_fmt.depth, full_range, out_off, &out_scale);
+		vdef_priv_mat3_init(
+			&mat,
+			vdef_rgb_to_yuv_norm_matrix[matrix][full_range],
+			in_off,
+			in_scale,
+			in_max,
+			out_off,
+			out_scale,
+			out_max);
+		vdef_priv_mat3_init(
+			&mat_avg,
+			vdef_rgb_to_yuv_norm_matrix[matrix][full_range],
+			in_off,
+			in_scale * avg,
+			in_max * avg,
+			out_off,
+			out_scale,
+			out_max);
+	}
+	/* The whole chunks are processed even for the last pixels of a line */
+	memset(in, 0, sizeof(in));
+	memset(sum, 0, sizeof(sum));
+
+	for (unsigned int y = 0; y < height; y += v_sub) {
+		unsigned int rows = (y + 1 < height) ? v_sub : 1;
+		for (unsigned int x = 0; x < width; x += VDEF_PRIV_CHUNK) {
+			unsigned int n = width - x;
+			unsigned int cx = x / h_sub, cn;
+			if (n > VDEF_PRIV_CHUNK)
+				n = VDEF_PRIV_CHUNK;
+
+			/* Luma (and full resolution chroma) */
+			for (unsigned int r = 0; r < rows; r++) {
+				for (unsigned int k = 0; k < 3; k++) {
+					vdef_priv_read_comp(
+						in_plane,
+						in_frame->plane_stride,
+						&in_comp[k],
+						&in_fmt,
+						res,
+						x,
+						y + r,
+						n,
+						in[r][k]);
+				}
+				vdef_priv_mat3_apply(&mat, in[r], out);
+				for (unsigned int c = 0; c < out_comps; c++) {
+					vdef_priv_write_comp(
+						out_plane,
+						out_frame->plane_stride,
+						&out_comp[c],
+						&out_fmt,
+						x,
+						y + r,
+						n,
+						out[c]);
+				}
+			}
+			if (avg == 1 || y / v_sub >= c_height || cx >= c_width)
+				continue;
+
+			/* Subsampled chroma */
+			cn = (n + h_sub - 1) / h_sub;
+			if (cn > c_width - cx)
+				cn = c_width - cx;
+			sum_chroma(in, h_sub, v_sub, cn, sum);
+			vdef_priv_mat3_apply(&mat_avg, sum, out);
+			for (unsigned int c = 1; c < 3; c++) {
+				vdef_priv_write_comp(out_plane,
+						     out_frame->plane_stride,
+						     &out_comp[c],
+						     &out_fmt,
+						     x,
+						     y,
+						     cn,
+						     out[c]);
+			}
+		}
+	}
+
+	return 0;
+}
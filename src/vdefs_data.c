@@ -0,0 +1,812 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+#define VDEF_ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+/* Number of samples processed at once by the vector kernels */
+#define BLOCK 16
+
+/* True if the host is little-endian */
+#define HOST_LE (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+/* Swap the bytes of 16-bit and 32-bit vector elements */
+#define BSWAP16(_v) (((_v) << 8) | ((_v) >> 8))
+#define BSWAP32(_v)                                                            \
+	(((_v) << 24) | (((_v) << 8) & 0xff0000) | (((_v) >> 8) & 0xff00) |    \
+	 ((_v) >> 24))
+
+
+/* Sample storage of a raw format */
+struct data_fmt {
+	/* Sample size in bits, including padding */
+	unsigned int size;
+
+	/* Significant bits */
+	unsigned int depth;
+
+	/* Value shift in the sample (padding in lower bits) */
+	unsigned int shift;
+
+	/* Little-endian samples or bitstream */
+	bool le;
+
+	/* MIPI CSI-2 packed samples (see mipi_unpack_line()) */
+	bool mipi;
+};
+
+
+/* Line conversion kernel; for kernels that do not change the sample size,
+ * src and dst can be the same */
+typedef void (*line_fn)(const uint8_t *src,
+			uint8_t *dst,
+			unsigned int count,
+			const struct data_fmt *in,
+			const struct data_fmt *out);
+
+
+static void get_data_fmt(const struct vdef_raw_format *format,
+			 struct data_fmt *fmt)
+{
+	fmt->size = format->data_size;
+	fmt->depth = format->pix_size;
+	fmt->shift = format->data_pad_low ? fmt->size - fmt->depth : 0;
+	fmt->le = format->data_little_endian;
+	fmt->mipi = format->pix_layout == VDEF_RAW_PIX_LAYOUT_MIPI_CSI2;
+}
+
+
+static inline bool is_packed(const struct data_fmt *fmt)
+{
+	return fmt->size % 8 != 0 && fmt->size == fmt->depth;
+}
+
+
+/* Read the sample of index i in a packed bitstream, reading only the bytes
+ * that hold the sample */
+static inline uint32_t
+read_packed(const uint8_t *src, unsigned int i, unsigned int depth, bool le)
+{
+	unsigned int bit = i * depth;
+	unsigned int first = bit % 8;
+	unsigned int n = (first + depth + 7) / 8;
+	const uint8_t *p = src + bit / 8;
+	uint32_t v = 0;
+
+	if (le) {
+		for (unsigned int k = 0; k < n; k++)
+			v |= (uint32_t)p[k] << (8 * k);
+		v >>= first;
+	} else {
+		for (unsigned int k = 0; k < n; k++)
+			v = (v << 8) | p[k];
+		v >>= 8 * n - depth - first;
+	}
+
+	return v & ((1u << depth) - 1);
+}
+
+
+/* Packed bitstream writer */
+struct bit_writer {
+	uint8_t *p;
+	uint64_t acc;
+	unsigned int bits;
+};
+
+
+static inline void
+write_packed(struct bit_writer *w, uint32_t v, unsigned int depth, bool le)
+{
+	if (le) {
+		w->acc |= (uint64_t)v << w->bits;
+		w->bits += depth;
+		while (w->bits >= 8) {
+			*w->p++ = w->acc;
+			w->acc >>= 8;
+			w->bits -= 8;
+		}
+	} else {
+		w->acc = (w->acc << depth) | v;
+		w->bits += depth;
+		while (w->bits >= 8) {
+			w->bits -= 8;
+			*w->p++ = w->acc >> w->bits;
+		}
+	}
+}
+
+
+/* Write the last incomplete byte, padded with zero bits */
+static inline void flush_packed(struct bit_writer *w, bool le)
+{
+	if (w->bits == 0)
+		return;
+	*w->p++ = le ? w->acc : w->acc << (8 - w->bits);
+	w->acc = 0;
+	w->bits = 0;
+}
+
+
+/* Unpack a line of packed samples to 16-bit samples; the packed sample depth
+ * is a constant in the callers so that the lane offsets and shifts are
+ * resolved at compile time */
+static inline __attribute__((always_inline)) void
+unpack_line(const uint8_t *src,
+	    uint8_t *dst,
+	    unsigned int count,
+	    unsigned int depth,
+	    const struct data_fmt *in,
+	    const struct data_fmt *out)
+{
+	unsigned int i = 0;
+	const uint32_t mask = (1u << depth) - 1;
+
+	/* The vector loop reads up to 3 bytes past the last sample of the
+	 * block, which always belong to the next samples */
+	for (; i + BLOCK + 4 <= count; i += BLOCK) {
+		const uint8_t *b = src + i * depth / 8;
+		vdef_priv_v16u32 w, r;
+		vdef_priv_v16u16 v;
+		for (unsigned int s = 0; s < BLOCK; s++) {
+			const uint8_t *p = b + s * depth / 8;
+			unsigned int first = s * depth % 8;
+			if (in->le) {
+				w[s] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+				       ((uint32_t)p[2] << 16) |
+				       ((uint32_t)p[3] << 24);
+				r[s] = first;
+			} else {
+				w[s] = ((uint32_t)p[0] << 24) |
+				       ((uint32_t)p[1] << 16) |
+				       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+				r[s] = 32 - depth - first;
+			}
+		}
+		w = ((w >> r) & mask) << out->shift;
+		v = __builtin_convertvector(w, vdef_priv_v16u16);
+		if (out->le != HOST_LE)
+			v = BSWAP16(v);
+		memcpy(dst + 2 * i, &v, sizeof(v));
+	}
+
+	for (; i < count; i++) {
+		uint16_t v = read_packed(src, i, depth, in->le) << out->shift;
+		dst[2 * i + (out->le ? 0 : 1)] = v & 0xff;
+		dst[2 * i + (out->le ? 1 : 0)] = v >> 8;
+	}
+}
+
+
+/* Pack a line of 16-bit samples; the packed sample depth is a constant in
+ * the callers (see unpack_line()) */
+static inline __attribute__((always_inline)) void
+pack_line(const uint8_t *src,
+	  uint8_t *dst,
+	  unsigned int count,
+	  unsigned int depth,
+	  const struct data_fmt *in,
+	  const struct data_fmt *out)
+{
+	unsigned int i = 0;
+	const uint32_t mask = (1u << depth) - 1;
+	struct bit_writer w = {.p = dst};
+
+	for (; i + BLOCK <= count; i += BLOCK) {
+		vdef_priv_v16u16 v;
+		vdef_priv_v16u32 x;
+		memcpy(&v, src + 2 * i, sizeof(v));
+		if (in->le != HOST_LE)
+			v = BSWAP16(v);
+		x = __builtin_convertvector(v, vdef_priv_v16u32);
+		x = (x >> in->shift) & mask;
+		for (unsigned int s = 0; s < BLOCK; s++)
+			write_packed(&w, x[s], depth, out->le);
+	}
+
+	for (; i < count; i++) {
+		const uint8_t *p = src + 2 * i;
+		uint32_t v = in->le ? (p[0] | (p[1] << 8))
+				    : ((p[0] << 8) | p[1]);
+		write_packed(&w, (v >> in->shift) & mask, depth, out->le);
+	}
+	flush_packed(&w, out->le);
+}
+
+
+/* MIPI CSI-2 packing groups: 4 samples (2 for 12-bit) stored as one byte of
+ * the 8 most significant bits of each sample, followed by the remaining
+ * least significant bits of the samples as a little-endian bitstream (e.g.
+ * for RAW10, the 2 LSBs of the samples 0 to 3 are the bits 1:0 to 7:6 of the
+ * fifth byte) */
+static inline unsigned int mipi_group_samples(unsigned int depth)
+{
+	return depth == 12 ? 2 : 4;
+}
+
+
+/* Read the sample of index i in a MIPI CSI-2 packed line */
+static inline uint32_t
+read_mipi(const uint8_t *src, unsigned int i, unsigned int depth)
+{
+	unsigned int n = mipi_group_samples(depth);
+	unsigned int low = depth - 8;
+	unsigned int k = i % n;
+	const uint8_t *p = src + i / n * (n * depth / 8);
+	uint32_t lsb = 0;
+
+	for (unsigned int b = 0; b < n * low / 8; b++)
+		lsb |= (uint32_t)p[n + b] << (8 * b);
+	lsb = (lsb >> (k * low)) & ((1u << low) - 1);
+
+	return ((uint32_t)p[k] << low) | lsb;
+}
+
+
+/* Unpack a line of MIPI CSI-2 packed samples to 16-bit samples; the packed
+ * sample depth is a constant in the callers (see unpack_line()) */
+static inline __attribute__((always_inline)) void
+mipi_unpack_line(const uint8_t *src,
+		 uint8_t *dst,
+		 unsigned int count,
+		 unsigned int depth,
+		 const struct data_fmt *out)
+{
+	unsigned int i = 0;
+	const unsigned int n = mipi_group_samples(depth);
+	const unsigned int low = depth - 8;
+
+	/* A block is a whole number of packing groups */
+	for (; i + BLOCK <= count; i += BLOCK) {
+		const uint8_t *b = src + i / n * (n * depth / 8);
+		vdef_priv_v16u32 msb, lsb, r;
+		vdef_priv_v16u16 v;
+		for (unsigned int s = 0; s < BLOCK; s++) {
+			const uint8_t *p = b + s / n * (n * depth / 8);
+			msb[s] = p[s % n];
+			lsb[s] = p[n];
+			if (n * low > 8)
+				lsb[s] |= ((uint32_t)p[n + 1] << 8) |
+					  ((uint32_t)p[n + 2] << 16);
+			r[s] = s % n * low;
+		}
+		msb = (msb << low) | ((lsb >> r) & ((1u << low) - 1));
+		msb <<= out->shift;
+		v = __builtin_convertvector(msb, vdef_priv_v16u16);
+		if (out->le != HOST_LE)
+			v = BSWAP16(v);
+		memcpy(dst + 2 * i, &v, sizeof(v));
+	}
+
+	for (; i < count; i++) {
+		uint16_t v = read_mipi(src, i, depth) << out->shift;
+		dst[2 * i + (out->le ? 0 : 1)] = v & 0xff;
+		dst[2 * i + (out->le ? 1 : 0)] = v >> 8;
+	}
+}
+
+
+/* Pack a line of 16-bit samples with the MIPI CSI-2 packing; the samples
+ * of the last incomplete group are padded with zeros */
+static inline __attribute__((always_inline)) void
+mipi_pack_line(const uint8_t *src,
+	       uint8_t *dst,
+	       unsigned int count,
+	       unsigned int depth,
+	       const struct data_fmt *in)
+{
+	unsigned int i = 0;
+	const unsigned int n = mipi_group_samples(depth);
+	const unsigned int low = depth - 8;
+	const uint32_t mask = (1u << depth) - 1;
+
+	for (; i + BLOCK <= count; i += BLOCK) {
+		uint8_t *b = dst + i / n * (n * depth / 8);
+		vdef_priv_v16u16 v;
+		vdef_priv_v16u32 x, msb, lsb;
+		memcpy(&v, src + 2 * i, sizeof(v));
+		if (in->le != HOST_LE)
+			v = BSWAP16(v);
+		x = __builtin_convertvector(v, vdef_priv_v16u32);
+		x = (x >> in->shift) & mask;
+		msb = x >> low;
+		lsb = x & ((1u << low) - 1);
+		for (unsigned int g = 0; g < BLOCK; g += n) {
+			uint8_t *p = b + g / n * (n * depth / 8);
+			uint32_t l = 0;
+			for (unsigned int k = 0; k < n; k++) {
+				p[k] = msb[g + k];
+				l |= lsb[g + k] << (k * low);
+			}
+			for (unsigned int k = 0; k < n * low / 8; k++)
+				p[n + k] = l >> (8 * k);
+		}
+	}
+
+	for (; i < count; i += n) {
+		uint8_t *p = dst + i / n * (n * depth / 8);
+		uint32_t l = 0;
+		for (unsigned int k = 0; k < n; k++) {
+			const uint8_t *q = src + 2 * (i + k);
+			uint32_t v = 0;
+			if (i + k < count) {
+				v = in->le ? (q[0] | (q[1] << 8))
+					   : ((q[0] << 8) | q[1]);
+				v = (v >> in->shift) & mask;
+			}
+			p[k] = v >> low;
+			l |= (v & ((1u << low) - 1)) << (k * low);
+		}
+		for (unsigned int k = 0; k < n * low / 8; k++)
+			p[n + k] = l >> (8 * k);
+	}
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void unpack10(const uint8_t *src,
+		     uint8_t *dst,
+		     unsigned int count,
+		     const struct data_fmt *in,
+		     const struct data_fmt *out)
+{
+	unpack_line(src, dst, count, 10, in, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void pack10(const uint8_t *src,
+		   uint8_t *dst,
+		   unsigned int count,
+		   const struct data_fmt *in,
+		   const struct data_fmt *out)
+{
+	pack_line(src, dst, count, 10, in, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void unpack12(const uint8_t *src,
+		     uint8_t *dst,
+		     unsigned int count,
+		     const struct data_fmt *in,
+		     const struct data_fmt *out)
+{
+	unpack_line(src, dst, count, 12, in, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void pack12(const uint8_t *src,
+		   uint8_t *dst,
+		   unsigned int count,
+		   const struct data_fmt *in,
+		   const struct data_fmt *out)
+{
+	pack_line(src, dst, count, 12, in, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void unpack14(const uint8_t *src,
+		     uint8_t *dst,
+		     unsigned int count,
+		     const struct data_fmt *in,
+		     const struct data_fmt *out)
+{
+	unpack_line(src, dst, count, 14, in, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void pack14(const uint8_t *src,
+		   uint8_t *dst,
+		   unsigned int count,
+		   const struct data_fmt *in,
+		   const struct data_fmt *out)
+{
+	pack_line(src, dst, count, 14, in, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void mipi_unpack10(const uint8_t *src,
+			  uint8_t *dst,
+			  unsigned int count,
+			  const struct data_fmt *in,
+			  const struct data_fmt *out)
+{
+	(void)in;
+
+	mipi_unpack_line(src, dst, count, 10, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void mipi_pack10(const uint8_t *src,
+			uint8_t *dst,
+			unsigned int count,
+			const struct data_fmt *in,
+			const struct data_fmt *out)
+{
+	(void)out;
+
+	mipi_pack_line(src, dst, count, 10, in);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void mipi_unpack12(const uint8_t *src,
+			  uint8_t *dst,
+			  unsigned int count,
+			  const struct data_fmt *in,
+			  const struct data_fmt *out)
+{
+	(void)in;
+
+	mipi_unpack_line(src, dst, count, 12, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void mipi_pack12(const uint8_t *src,
+			uint8_t *dst,
+			unsigned int count,
+			const struct data_fmt *in,
+			const struct data_fmt *out)
+{
+	(void)out;
+
+	mipi_pack_line(src, dst, count, 12, in);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void mipi_unpack14(const uint8_t *src,
+			  uint8_t *dst,
+			  unsigned int count,
+			  const struct data_fmt *in,
+			  const struct data_fmt *out)
+{
+	(void)in;
+
+	mipi_unpack_line(src, dst, count, 14, out);
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void mipi_pack14(const uint8_t *src,
+			uint8_t *dst,
+			unsigned int count,
+			const struct data_fmt *in,
+			const struct data_fmt *out)
+{
+	(void)out;
+
+	mipi_pack_line(src, dst, count, 14, in);
+}
+
+
+/* Packed sample kernels, by packed sample depth */
+static const struct {
+	unsigned int depth;
+	line_fn unpack;
+	line_fn pack;
+	line_fn mipi_unpack;
+	line_fn mipi_pack;
+} packed_kernels[] = {
+	{10, &unpack10, &pack10, &mipi_unpack10, &mipi_pack10},
+	{12, &unpack12, &pack12, &mipi_unpack12, &mipi_pack12},
+	{14, &unpack14, &pack14, &mipi_unpack14, &mipi_pack14},
+};
+
+
+static inline uint32_t get_mask(unsigned int depth)
+{
+	return depth >= 32 ? UINT32_MAX : (1u << depth) - 1;
+}
+
+
+/* Change the endianness and padding of 16-bit samples */
+VDEF_PRIV_TARGET_CLONES
+static void convert16(const uint8_t *src,
+		      uint8_t *dst,
+		      unsigned int count,
+		      const struct data_fmt *in,
+		      const struct data_fmt *out)
+{
+	unsigned int i = 0;
+	const uint16_t mask = get_mask(in->depth);
+
+	for (; i + BLOCK <= count; i += BLOCK) {
+		vdef_priv_v16u16 v;
+		memcpy(&v, src + 2 * i, sizeof(v));
+		if (in->le != HOST_LE)
+			v = BSWAP16(v);
+		v = ((v >> in->shift) & mask) << out->shift;
+		if (out->le != HOST_LE)
+			v = BSWAP16(v);
+		memcpy(dst + 2 * i, &v, sizeof(v));
+	}
+
+	for (; i < count; i++) {
+		const uint8_t *p = src + 2 * i;
+		uint16_t v = in->le ? (p[0] | (p[1] << 8))
+				    : ((p[0] << 8) | p[1]);
+		v = ((v >> in->shift) & mask) << out->shift;
+		dst[2 * i + (out->le ? 0 : 1)] = v & 0xff;
+		dst[2 * i + (out->le ? 1 : 0)] = v >> 8;
+	}
+}
+
+
+/* Change the endianness and padding of 32-bit samples */
+VDEF_PRIV_TARGET_CLONES
+static void convert32(const uint8_t *src,
+		      uint8_t *dst,
+		      unsigned int count,
+		      const struct data_fmt *in,
+		      const struct data_fmt *out)
+{
+	unsigned int i = 0;
+	const uint32_t mask = get_mask(in->depth);
+
+	for (; i + BLOCK <= count; i += BLOCK) {
+		vdef_priv_v16u32 v;
+		memcpy(&v, src + 4 * i, sizeof(v));
+		if (in->le != HOST_LE)
+			v = BSWAP32(v);
+		v = ((v >> in->shift) & mask) << out->shift;
+		if (out->le != HOST_LE)
+			v = BSWAP32(v);
+		memcpy(dst + 4 * i, &v, sizeof(v));
+	}
+
+	for (; i < count; i++) {
+		const uint8_t *p = src + 4 * i;
+		uint32_t v = 0;
+		for (unsigned int k = 0; k < 4; k++)
+			v |= (uint32_t)p[k] << (in->le ? 8 * k : 24 - 8 * k);
+		v = ((v >> in->shift) & mask) << out->shift;
+		for (unsigned int k = 0; k < 4; k++)
+			dst[4 * i + k] = v >> (out->le ? 8 * k : 24 - 8 * k);
+	}
+}
+
+
+/* Copy 8-bit samples */
+static void convert8(const uint8_t *src,
+		     uint8_t *dst,
+		     unsigned int count,
+		     const struct data_fmt *in,
+		     const struct data_fmt *out)
+{
+	/* 8-bit samples have no byte order nor shift */
+	(void)in;
+	(void)out;
+
+	if (src != dst)
+		memcpy(dst, src, count);
+}
+
+
+/* Select the line kernel for a conversion */
+static line_fn get_kernel(const struct data_fmt *in,
+			  const struct data_fmt *out)
+{
+	const struct data_fmt *packed;
+
+	/* MIPI CSI-2 packing only applies to packed samples, and is only
+	 * converted from or to 16-bit samples */
+	if ((in->mipi && !is_packed(in)) || (out->mipi && !is_packed(out)))
+		return NULL;
+
+	if (in->size == out->size) {
+		switch (in->size) {
+		case 8:
+			return &convert8;
+		case 16:
+			return &convert16;
+		case 32:
+			return &convert32;
+		default:
+			return NULL;
+		}
+	}
+
+	if (is_packed(in) && out->size == 16)
+		packed = in;
+	else if (in->size == 16 && is_packed(out))
+		packed = out;
+	else
+		return NULL;
+	for (size_t i = 0; i < VDEF_ARRAY_SIZE(packed_kernels); i++) {
+		if (packed_kernels[i].depth != packed->depth)
+			continue;
+		if (packed->mipi)
+			return (packed == in) ? packed_kernels[i].mipi_unpack
+					      : packed_kernels[i].mipi_pack;
+		return (packed == in) ? packed_kernels[i].unpack
+				      : packed_kernels[i].pack;
+	}
+
+	return NULL;
+}
+
+
+/* Apply a line kernel to all lines of all planes */
+static int convert_planes(const struct vdef_raw_frame *in_frame,
+			  const void *const *in_plane,
+			  const struct vdef_raw_frame *out_frame,
+			  void *const *out_plane,
+			  line_fn kernel,
+			  const struct data_fmt *in,
+			  const struct data_fmt *out)
+{
+	const struct vdef_dim *res = &in_frame->info.resolution;
+	unsigned int plane_count;
+
+	plane_count = vdef_get_raw_frame_plane_count(&in_frame->format);
+	for (unsigned int p = 0; p < plane_count; p++) {
+		int ret;
+		unsigned int samples, lines;
+
+		ret = vdef_priv_get_plane_samples(
+			&in_frame->format, res, p, &samples, &lines);
+		if (ret < 0)
+			return ret;
+		for (unsigned int y = 0; y < lines; y++) {
+			kernel((const uint8_t *)in_plane[p] +
+				       y * in_frame->plane_stride[p],
+			       (uint8_t *)out_plane[p] +
+				       y * out_frame->plane_stride[p],
+			       samples,
+			       in,
+			       out);
+		}
+	}
+
+	return 0;
+}
+
+
+/* Linear or MIPI CSI-2 packed pixel layout */
+static inline bool is_line_layout(const struct vdef_raw_format *format)
+{
+	return format->pix_layout == VDEF_RAW_PIX_LAYOUT_LINEAR ||
+	       format->pix_layout == VDEF_RAW_PIX_LAYOUT_MIPI_CSI2;
+}
+
+
+/* Check that two formats only differ by their sample storage */
+static bool is_data_compatible(const struct vdef_raw_format *f1,
+			       const struct vdef_raw_format *f2)
+{
+	struct vdef_raw_format f = *f2;
+
+	if (!is_line_layout(f1) || !is_line_layout(f2))
+		return false;
+
+	f.pix_layout = f1->pix_layout;
+	f.data_size = f1->data_size;
+	f.data_pad_low = f1->data_pad_low;
+	f.data_little_endian = f1->data_little_endian;
+
+	return vdef_raw_format_cmp(f1, &f);
+}
+
+
+int vdef_priv_raw_data_check(const struct vdef_raw_format *in_format,
+			     const struct vdef_raw_format *out_format)
+{
+	struct data_fmt in, out;
+
+	if (!is_data_compatible(in_format, out_format))
+		return -ENOTSUP;
+
+	get_data_fmt(in_format, &in);
+	get_data_fmt(out_format, &out);
+	return get_kernel(&in, &out) != NULL ? 0 : -ENOTSUP;
+}
+
+
+int vdef_convert_raw_data(const struct vdef_raw_frame *in_frame,
+			  const void *const *in_plane,
+			  const struct vdef_raw_frame *out_frame,
+			  void *const *out_plane)
+{
+	int ret;
+	struct data_fmt in, out;
+	line_fn kernel;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	ret = vdef_priv_raw_data_check(&in_frame->format, &out_frame->format);
+	if (ret < 0)
+		return ret;
+
+	get_data_fmt(&in_frame->format, &in);
+	get_data_fmt(&out_frame->format, &out);
+	kernel = get_kernel(&in, &out);
+
+	return convert_planes(
+		in_frame, in_plane, out_frame, out_plane, kernel, &in, &out);
+}
+
+
+int vdef_convert_raw_data_in_place(struct vdef_raw_frame *frame,
+				   void *const *plane,
+				   const struct vdef_raw_format *format)
+{
+	int ret;
+	struct data_fmt in, out;
+	line_fn kernel;
+
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+
+	if (!is_data_compatible(&frame->format, format) ||
+	    frame->format.pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR ||
+	    frame->format.data_size != format->data_size)
+		return -ENOTSUP;
+	if (vdef_raw_format_cmp(&frame->format, format))
+		return 0;
+
+	get_data_fmt(&frame->format, &in);
+	get_data_fmt(format, &out);
+	kernel = get_kernel(&in, &out);
+	if (kernel == NULL)
+		return -ENOTSUP;
+
+	ret = convert_planes(frame,
+			     (const void *const *)plane,
+			     frame,
+			     plane,
+			     kernel,
+			     &in,
+			     &out);
+	if (ret < 0)
+		return ret;
+	frame->format = *format;
+
+	return 0;
+}
@@ -0,0 +1,455 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Number of mirrored columns and lines needed around a pixel: 2 for the
+ * edge-aware green interpolation, plus 1 for the red and blue
+ * interpolations, which use the green values of the neighbors */
+#define BORDER 3
+
+/* CFA colors */
+#define R 0
+#define G 1
+#define B 2
+
+
+struct demosaic {
+	const struct vdef_raw_frame *in_frame;
+	const void *const *in_plane;
+	const struct vdef_raw_frame *out_frame;
+	void *const *out_plane;
+	enum vdef_demosaic_method method;
+	struct vdef_priv_sample_fmt in_fmt;
+	struct vdef_priv_sample_fmt out_fmt;
+	struct vdef_priv_comp out_comp[4];
+	unsigned int out_count;
+	unsigned int width;
+	unsigned int height;
+
+	/* Colors of the 2x2 CFA pattern (line-major) */
+	unsigned int cfa[4];
+
+	/* Input maximum value */
+	int32_t in_max;
+
+	/* Output maximum value */
+	int32_t out_max;
+
+	/* Bands of lines (see vdef_calc_raw_frame_bands()) */
+	unsigned int band_height;
+	unsigned int band_count;
+
+	/* Per-thread line buffers */
+	int32_t *buf;
+	size_t buf_len;
+};
+
+
+static int get_cfa(enum vdef_raw_pix_order order, unsigned int cfa[4])
+{
+	static const struct {
+		enum vdef_raw_pix_order order;
+		unsigned int cfa[4];
+	} cfa_map[] = {
+		{VDEF_RAW_PIX_ORDER_RGGB, {R, G, G, B}},
+		{VDEF_RAW_PIX_ORDER_GRBG, {G, R, B, G}},
+		{VDEF_RAW_PIX_ORDER_GBRG, {G, B, R, G}},
+		{VDEF_RAW_PIX_ORDER_BGGR, {B, G, G, R}},
+	};
+
+	for (size_t i = 0; i < sizeof(cfa_map) / sizeof(cfa_map[0]); i++) {
+		if (cfa_map[i].order == order) {
+			memcpy(cfa, cfa_map[i].cfa, sizeof(cfa_map[i].cfa));
+			return 0;
+		}
+	}
+
+	return -ENOTSUP;
+}
+
+
+/* Mirror a coordinate in [0, size - 1] without repeating the border
+ * (reflect-101), which keeps the CFA phase; size must be at least 2 */
+static inline unsigned int mirror(int i, unsigned int size)
+{
+	int period = 2 * ((int)size - 1);
+
+	if (i < 0)
+		i = -i;
+	i %= period;
+	return (i >= (int)size) ? (unsigned int)(period - i) : (unsigned int)i;
+}
+
+
+static inline int32_t clamp(int32_t v, int32_t max)
+{
+	return v < 0 ? 0 : (v > max ? max : v);
+}
+
+
+static inline int32_t abs32(int32_t v)
+{
+	return v < 0 ? -v : v;
+}
+
+
+/* Read an input line with mirrored borders; dst holds width + 2 * BORDER
+ * samples */
+static void read_line(const struct demosaic *dm, int y, int32_t *dst)
+{
+	unsigned int width = dm->width;
+	size_t stride = dm->in_frame->plane_stride[0];
+	const uint8_t *src = (const uint8_t *)dm->in_plane[0] +
+			     mirror(y, dm->height) * stride;
+
+	vdef_priv_read_samples(src, 1, width, &dm->in_fmt, dst + BORDER);
+	for (int i = 1; i <= BORDER; i++) {
+		dst[BORDER - i] = dst[BORDER + mirror(-i, width)];
+		dst[BORDER + width - 1 + i] =
+			dst[BORDER + mirror(width - 1 + i, width)];
+	}
+}
+
+
+/* Interpolate the green line of index k of the band buffers, from the raw
+ * lines k - 2 to k + 2; y is the frame line */
+VDEF_PRIV_TARGET_CLONES
+static void interp_green(const struct demosaic *dm,
+			 int y,
+			 const int32_t *const raw[5],
+			 int32_t *g)
+{
+	unsigned int n = dm->width + 2 * BORDER;
+	const unsigned int *cfa = &dm->cfa[(y & 1) * 2];
+	const int32_t *r0 = raw[0], *r1 = raw[1], *r2 = raw[2], *r3 = raw[3],
+		      *r4 = raw[4];
+
+	/* Same phase as the first real column for even indexes */
+	for (unsigned int c = 2; c < n - 2; c++) {
+		int32_t v = r2[c];
+		if (cfa[(c - BORDER) & 1] == G) {
+			g[c] = v;
+		} else if (dm->method == VDEF_DEMOSAIC_METHOD_BILINEAR) {
+			g[c] = (r2[c - 1] + r2[c + 1] + r1[c] + r3[c] + 2) >>
+			       2;
+		} else {
+			int32_t lh = 2 * v - r2[c - 2] - r2[c + 2];
+			int32_t lv = 2 * v - r0[c] - r4[c];
+			int32_t dh = abs32(r2[c - 1] - r2[c + 1]) + abs32(lh);
+			int32_t dv = abs32(r1[c] - r3[c]) + abs32(lv);
+			int32_t gh = 2 * (r2[c - 1] + r2[c + 1]) + lh;
+			int32_t gv = 2 * (r1[c] + r3[c]) + lv;
+			int32_t s;
+			if (dh < dv)
+				s = 2 * gh;
+			else if (dv < dh)
+				s = 2 * gv;
+			else
+				s = gh + gv;
+			g[c] = clamp((s + 4) >> 3, dm->in_max);
+		}
+	}
+}
+
+
+/* Interpolate the red and blue components of a line from the raw and green
+ * lines k - 1 to k + 1 */
+VDEF_PRIV_TARGET_CLONES
+static void interp_red_blue(const struct demosaic *dm,
+			    int y,
+			    const int32_t *const raw[3],
+			    const int32_t *const g[3],
+			    int32_t *out[3])
+{
+	unsigned int width = dm->width;
+	const unsigned int *cfa = &dm->cfa[(y & 1) * 2];
+	const unsigned int *cfa_next = &dm->cfa[((y + 1) & 1) * 2];
+	bool edge = dm->method == VDEF_DEMOSAIC_METHOD_EDGE_AWARE;
+	const int32_t *r0 = raw[0], *r1 = raw[1], *r2 = raw[2];
+	const int32_t *g0 = g[0], *g1 = g[1], *g2 = g[2];
+
+	for (unsigned int x = 0; x < width; x++) {
+		unsigned int c = x + BORDER;
+		unsigned int col = cfa[x & 1];
+		int32_t v = r1[c];
+		int32_t h, d, vert;
+
+		out[G][x] = g1[c];
+		if (col == G) {
+			/* Horizontal neighbors have the other color of the
+			 * line, vertical neighbors the color of the next
+			 * lines */
+			unsigned int hcol = cfa[(x + 1) & 1];
+			unsigned int vcol = cfa_next[x & 1];
+			if (edge) {
+				h = g1[c] + ((r1[c - 1] - g1[c - 1] +
+					      r1[c + 1] - g1[c + 1]) >>
+					     1);
+				vert = g1[c] + ((r0[c] - g0[c] + r2[c] -
+						 g2[c]) >>
+						1);
+			} else {
+				h = (r1[c - 1] + r1[c + 1] + 1) >> 1;
+				vert = (r0[c] + r2[c] + 1) >> 1;
+			}
+			out[hcol][x] = clamp(h, dm->in_max);
+			out[vcol][x] = clamp(vert, dm->in_max);
+		} else {
+			/* The diagonal neighbors have the other color */
+			if (edge) {
+				d = g1[c] + ((r0[c - 1] - g0[c - 1] +
+					      r0[c + 1] - g0[c + 1] +
+					      r2[c - 1] - g2[c - 1] +
+					      r2[c + 1] - g2[c + 1]) >>
+					     2);
+			} else {
+				d = (r0[c - 1] + r0[c + 1] + r2[c - 1] +
+				     r2[c + 1] + 2) >>
+				    2;
+			}
+			out[col][x] = v;
+			out[B - col][x] = clamp(d, dm->in_max);
+		}
+	}
+}
+
+
+/* Rescale and write an output line */
+static void write_line(const struct demosaic *dm,
+		       unsigned int y,
+		       int32_t *out[3],
+		       const int32_t *alpha)
+{
+	unsigned int width = dm->width;
+	unsigned int bytes = dm->out_fmt.type == VDEF_PRIV_SAMPLE_U8 ? 1 : 2;
+
+	if (dm->out_max != dm->in_max) {
+		int64_t half = dm->in_max / 2;
+		for (unsigned int k = 0; k < 3; k++) {
+			int32_t *o = out[k];
+			for (unsigned int x = 0; x < width; x++) {
+				o[x] = ((int64_t)o[x] * dm->out_max + half) /
+				       dm->in_max;
+			}
+		}
+	}
+
+	for (unsigned int k = 0; k < dm->out_count; k++) {
+		uint8_t *dst = vdef_priv_comp_ptr(
+			(const void *const *)dm->out_plane,
+			dm->out_frame->plane_stride,
+			&dm->out_comp[k],
+			bytes,
+			0,
+			y);
+		vdef_priv_write_samples(dst,
+					dm->out_comp[k].step,
+					width,
+					&dm->out_fmt,
+					k < 3 ? out[k] : alpha);
+	}
+}
+
+
+/* Number of lines of the rolling line buffers (must be a power of 2) */
+#define RING 8
+
+/* Rolling line buffer slot of a frame line (y >= -BORDER) */
+#define SLOT(_y) ((unsigned int)((_y) + RING) & (RING - 1))
+
+
+static void process_green(const struct demosaic *dm,
+			  int y,
+			  int32_t *const raw[RING],
+			  int32_t *const g[RING])
+{
+	const int32_t *const r[5] = {
+		raw[SLOT(y - 2)],
+		raw[SLOT(y - 1)],
+		raw[SLOT(y)],
+		raw[SLOT(y + 1)],
+		raw[SLOT(y + 2)],
+	};
+
+	interp_green(dm, y, r, g[SLOT(y)]);
+}
+
+
+/* Process the lines [y0, y1) of the frame; the raw and green lines are kept
+ * in rolling buffers indexed by frame line: the output line y needs the
+ * green lines y - 1 to y + 1, and the green line y + 1 needs the raw lines
+ * y - 1 to y + 3 */
+static void process_band(const struct demosaic *dm,
+			 unsigned int y0,
+			 unsigned int y1,
+			 int32_t *buf)
+{
+	unsigned int n = dm->width + 2 * BORDER;
+	int32_t *raw[RING], *g[RING], *out[3], *alpha;
+
+	for (unsigned int i = 0; i < RING; i++) {
+		raw[i] = buf + i * n;
+		g[i] = buf + (RING + i) * n;
+	}
+	for (unsigned int i = 0; i < 3; i++)
+		out[i] = buf + 2 * RING * n + i * dm->width;
+	alpha = buf + 2 * RING * n + 3 * dm->width;
+	for (unsigned int x = 0; x < dm->width; x++)
+		alpha[x] = dm->out_max;
+
+	/* Prime the raw lines y0 - 3 to y0 + 2 and the green lines y0 - 1
+	 * and y0 */
+	for (int y = (int)y0 - BORDER; y <= (int)y0 + 2; y++)
+		read_line(dm, y, raw[SLOT(y)]);
+	process_green(dm, (int)y0 - 1, raw, g);
+	process_green(dm, (int)y0, raw, g);
+
+	for (int y = y0; y < (int)y1; y++) {
+		const int32_t *const r[3] = {
+			raw[SLOT(y - 1)],
+			raw[SLOT(y)],
+			raw[SLOT(y + 1)],
+		};
+		const int32_t *const gl[3] = {
+			g[SLOT(y - 1)],
+			g[SLOT(y)],
+			g[SLOT(y + 1)],
+		};
+		read_line(dm, y + 3, raw[SLOT(y + 3)]);
+		process_green(dm, y + 1, raw, g);
+		interp_red_blue(dm, y, r, gl, out);
+		write_line(dm, y, out, alpha);
+	}
+}
+
+
+static int process_task(unsigned int index,
+			unsigned int thread_index,
+			void *userdata)
+{
+	const struct demosaic *dm = userdata;
+	unsigned int y0 = index * dm->band_height;
+	unsigned int y1 = y0 + dm->band_height;
+
+	if (y1 > dm->height)
+		y1 = dm->height;
+	process_band(dm, y0, y1, dm->buf + thread_index * dm->buf_len);
+
+	return 0;
+}
+
+
+static bool is_rgb(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_RGB24 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_RGBA32;
+}
+
+
+int vdef_demosaic(const struct vdef_raw_frame *in_frame,
+		  const void *const *in_plane,
+		  const struct vdef_raw_frame *out_frame,
+		  void *const *out_plane,
+		  enum vdef_demosaic_method method,
+		  struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct demosaic dm;
+	unsigned int thread_count;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(method >= VDEF_DEMOSAIC_METHOD_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame->info.resolution.width < 3, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame->info.resolution.height < 3, EINVAL);
+
+	if (in_frame->format.pix_format != VDEF_RAW_PIX_FORMAT_BAYER ||
+	    in_frame->format.pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR ||
+	    !is_rgb(&out_frame->format))
+		return -ENOTSUP;
+
+	memset(&dm, 0, sizeof(dm));
+	dm.in_frame = in_frame;
+	dm.in_plane = in_plane;
+	dm.out_frame = out_frame;
+	dm.out_plane = out_plane;
+	dm.method = method;
+	dm.width = in_frame->info.resolution.width;
+	dm.height = in_frame->info.resolution.height;
+	ret = get_cfa(in_frame->format.pix_order, dm.cfa);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&in_frame->format, &dm.in_fmt);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&out_frame->format, &dm.out_fmt);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_comp_layout(
+		&out_frame->format, dm.out_comp, &dm.out_count);
+	if (ret < 0)
+		return ret;
+	dm.in_max = (1 << dm.in_fmt.depth) - 1;
+	dm.out_max = (1 << dm.out_fmt.depth) - 1;
+
+	/* Split the frame in bands of lines */
+	ret = vdef_calc_raw_frame_bands(&in_frame->format,
+					&in_frame->info.resolution,
+					&dm.band_height,
+					&dm.band_count);
+	if (ret < 0)
+		return ret;
+
+	thread_count = vdef_priv_thread_pool_get_thread_count(pool);
+	dm.buf_len = 2 * RING * (dm.width + 2 * BORDER) + 4 * dm.width;
+	dm.buf = malloc(thread_count * dm.buf_len * sizeof(*dm.buf));
+	if (dm.buf == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("malloc", -ret);
+		return ret;
+	}
+
+	ret = vdef_priv_thread_pool_run(
+		pool, dm.band_count, &process_task, &dm);
+
+	free(dm.buf);
+	return ret;
+}
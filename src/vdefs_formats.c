@@ -314,6 +314,27 @@ VDEF_MAKE_RAW_FORMAT(vdef_nv21_10_16be_high,
 		     16);
 
 
+/* YUV422 interleaved (YUYV, YVYU) */
+VDEF_MAKE_RAW_FORMAT(vdef_yuyv,
+		     YUV422,
+		     YUYV,
+		     LINEAR,
+		     8,
+		     INTERLEAVED,
+		     false,
+		     false,
+		     8);
+VDEF_MAKE_RAW_FORMAT(vdef_yvyu,
+		     YUV422,
+		     YVYU,
+		     LINEAR,
+		     8,
+		     INTERLEAVED,
+		     false,
+		     false,
+		     8);
+
+
 /* YUV444 planar (I444) */
 VDEF_MAKE_RAW_FORMAT(vdef_i444,
 		     YUV444,
@@ -634,6 +655,123 @@ VDEF_MAKE_RAW_FORMAT(vdef_bayer_gbrg_14,
 		     16);
 
 
+/* Bayer 10-bits MIPI CSI-2 packed */
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_rggb_10_mipi,
+		     BAYER,
+		     RGGB,
+		     MIPI_CSI2,
+		     10,
+		     PACKED,
+		     false,
+		     true,
+		     10);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_bggr_10_mipi,
+		     BAYER,
+		     BGGR,
+		     MIPI_CSI2,
+		     10,
+		     PACKED,
+		     false,
+		     true,
+		     10);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_grbg_10_mipi,
+		     BAYER,
+		     GRBG,
+		     MIPI_CSI2,
+		     10,
+		     PACKED,
+		     false,
+		     true,
+		     10);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_gbrg_10_mipi,
+		     BAYER,
+		     GBRG,
+		     MIPI_CSI2,
+		     10,
+		     PACKED,
+		     false,
+		     true,
+		     10);
+
+
+/* Bayer 12-bits MIPI CSI-2 packed */
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_rggb_12_mipi,
+		     BAYER,
+		     RGGB,
+		     MIPI_CSI2,
+		     12,
+		     PACKED,
+		     false,
+		     true,
+		     12);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_bggr_12_mipi,
+		     BAYER,
+		     BGGR,
+		     MIPI_CSI2,
+		     12,
+		     PACKED,
+		     false,
+		     true,
+		     12);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_grbg_12_mipi,
+		     BAYER,
+		     GRBG,
+		     MIPI_CSI2,
+		     12,
+		     PACKED,
+		     false,
+		     true,
+		     12);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_gbrg_12_mipi,
+		     BAYER,
+		     GBRG,
+		     MIPI_CSI2,
+		     12,
+		     PACKED,
+		     false,
+		     true,
+		     12);
+
+
+/* Bayer 14-bits MIPI CSI-2 packed */
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_rggb_14_mipi,
+		     BAYER,
+		     RGGB,
+		     MIPI_CSI2,
+		     14,
+		     PACKED,
+		     false,
+		     true,
+		     14);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_bggr_14_mipi,
+		     BAYER,
+		     BGGR,
+		     MIPI_CSI2,
+		     14,
+		     PACKED,
+		     false,
+		     true,
+		     14);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_grbg_14_mipi,
+		     BAYER,
+		     GRBG,
+		     MIPI_CSI2,
+		     14,
+		     PACKED,
+		     false,
+		     true,
+		     14);
+VDEF_MAKE_RAW_FORMAT(vdef_bayer_gbrg_14_mipi,
+		     BAYER,
+		     GBRG,
+		     MIPI_CSI2,
+		     14,
+		     PACKED,
+		     false,
+		     true,
+		     14);
+
+
 /* Hardware specific formats */
 VDEF_MAKE_RAW_FORMAT(vdef_nv21_hisi_tile,
 		     YUV420,
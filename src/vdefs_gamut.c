@@ -0,0 +1,912 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Soft clipping knee in linear light */
+#define SOFT_CLIP_KNEE 0.9f
+
+/* Minimum bit depth of the transfer function lookup tables; the tables are
+ * 2 bits deeper than the samples so that the non-linear RGB values coming
+ * out of the YUV to RGB matrix keep some fractional precision */
+#define MIN_LUT_DEPTH 12
+#define LUT_EXTRA_DEPTH 2
+
+
+/* 3x3 float color matrix: out[c] = sum_k(in[k] * coef[k * 3 + c]) + off[c]
+ * (the coefficient layout matches the column-major float tables) */
+struct mat3f {
+	float coef[9];
+	float off[3];
+};
+
+
+struct gamut {
+	const struct vdef_raw_frame *in_frame;
+	const void *const *in_plane;
+	const struct vdef_raw_frame *out_frame;
+	void *const *out_plane;
+	struct vdef_priv_comp in_comp[4];
+	struct vdef_priv_comp out_comp[4];
+	unsigned int out_count;
+	struct vdef_priv_sample_fmt in_fmt;
+	struct vdef_priv_sample_fmt out_fmt;
+	unsigned int width;
+	unsigned int height;
+
+	/* Output chroma subsampling factors (1 for RGB) */
+	unsigned int h_sub;
+	unsigned int v_sub;
+
+	/* Input samples to normalized non-linear RGB */
+	struct mat3f in_mat;
+
+	/* Input and output transfer function lookup tables */
+	const struct vdef_transfer_lut *to_linear;
+	const struct vdef_transfer_lut *from_linear;
+
+	/* Tone mapping gains indexed by the maximum of the linearization
+	 * table indexes of the RGB components (NULL if not tone mapping) */
+	float *tone_gain;
+
+	/* Linear light RGB conversion matrix */
+	struct mat3f gamut_mat;
+
+	/* Gamut clipping */
+	enum vdef_gamut_clip_method clip;
+
+	/* Luminance weights of the output primaries */
+	float luma[3];
+
+	/* Normalized non-linear RGB to output samples */
+	struct mat3f out_mat;
+
+	/* Output maximum value */
+	int32_t out_max;
+
+	/* 3D lookup table replacing the color conversion (NULL if not
+	 * using one) */
+	const struct vdef_lut3d *lut3d;
+};
+
+
+/* Conversion prepared once for multiple frames of the same formats */
+struct vdef_priv_gamut {
+	struct gamut gm;
+};
+
+
+/* Conversion of a frame in bands of lines */
+struct gamut_run {
+	const struct gamut *gm;
+	unsigned int band_height;
+};
+
+
+/* Initialize a float matrix applied on normalized values:
+ * out = (in - in_off) / in_scale * fmat * out_scale + out_off; the identity
+ * matrix is used if fmat is NULL and the offsets can be NULL */
+static void mat3f_init(struct mat3f *mat,
+		       const float *fmat,
+		       const int32_t *in_off,
+		       float in_scale,
+		       const int32_t *out_off,
+		       float out_scale)
+{
+	for (unsigned int i = 0; i < 9; i++) {
+		float v = fmat ? fmat[i] : (i % 4 == 0 ? 1.f : 0.f);
+		mat->coef[i] = v * out_scale / in_scale;
+	}
+	for (unsigned int c = 0; c < 3; c++) {
+		mat->off[c] = out_off ? out_off[c] : 0.f;
+		for (unsigned int k = 0; in_off && k < 3; k++)
+			mat->off[c] -= in_off[k] * mat->coef[k * 3 + c];
+	}
+}
+
+
+/* The vector helpers take pointers, vectors are not passed by value to
+ * avoid ABI differences between the target clones */
+
+/* Clamp to [0..max] (comparisons give masks; NAN gives 0) */
+static inline void clamp_v(vdef_priv_v8f32 *v, float max)
+{
+	vdef_priv_v8f32 vmax = (vdef_priv_v8f32){0} + max;
+	vdef_priv_v8i32 m, vi;
+
+	vi = (vdef_priv_v8i32)*v & (*v > 0.f);
+	m = ((vdef_priv_v8f32)vi > vmax);
+	vi = (vi & ~m) | ((vdef_priv_v8i32)vmax & m);
+	*v = (vdef_priv_v8f32)vi;
+}
+
+
+/* Replace the elements of v by the elements of a where the mask is set */
+static inline void
+select_v(vdef_priv_v8f32 *v, const vdef_priv_v8i32 *m, const vdef_priv_v8f32 *a)
+{
+	*v = (vdef_priv_v8f32)(((vdef_priv_v8i32)*a & *m) |
+			       ((vdef_priv_v8i32)*v & ~*m));
+}
+
+
+static inline void mat3f_apply(const struct mat3f *m,
+			       const vdef_priv_v8f32 a[3],
+			       vdef_priv_v8f32 v[3])
+{
+	for (unsigned int c = 0; c < 3; c++) {
+		v[c] = a[0] * m->coef[c] + a[1] * m->coef[3 + c] +
+		       a[2] * m->coef[6 + c] + m->off[c];
+	}
+}
+
+
+/* Soft clipping: desaturate towards the luminance to remove the negative
+ * components, then compress the components above the knee */
+static inline void soft_clip(const struct gamut *gm, vdef_priv_v8f32 v[3])
+{
+	vdef_priv_v8f32 y, mn, t, k, d;
+	vdef_priv_v8i32 m;
+
+	y = v[0] * gm->luma[0] + v[1] * gm->luma[1] + v[2] * gm->luma[2];
+	mn = v[0];
+	m = (v[1] < mn);
+	select_v(&mn, &m, &v[1]);
+	m = (v[2] < mn);
+	select_v(&mn, &m, &v[2]);
+	t = (vdef_priv_v8f32){0} + 1.f;
+	k = (vdef_priv_v8f32)((vdef_priv_v8i32)(y / (y - mn)) & (y > 0.f));
+	m = (mn < 0.f);
+	select_v(&t, &m, &k);
+	for (unsigned int c = 0; c < 3; c++) {
+		v[c] = y + (v[c] - y) * t;
+		d = v[c] - SOFT_CLIP_KNEE;
+		k = SOFT_CLIP_KNEE + d / (1.f + d / (1.f - SOFT_CLIP_KNEE));
+		m = (d > 0.f);
+		select_v(&v[c], &m, &k);
+	}
+}
+
+
+/* Convert a chunk of input samples to output normalized non-linear RGB */
+VDEF_PRIV_TARGET_CLONES
+static void convert_chunk(const struct gamut *gm,
+			  int32_t in[3][VDEF_PRIV_CHUNK],
+			  float rgb[3][VDEF_PRIV_CHUNK])
+{
+	const struct vdef_transfer_lut *tl = gm->to_linear;
+	const struct vdef_transfer_lut *fl = gm->from_linear;
+	const int32_t lo = (127 - VDEF_PRIV_TRANSFER_FLOAT_OCTAVES) << 23;
+	int32_t bias = lo - (1 << fl->float_shift);
+	unsigned int shift = fl->float_shift;
+	float scale = tl->max;
+	float inv = 1.f / ((1 << fl->bit_depth) - 1);
+	bool soft = gm->clip == VDEF_GAMUT_CLIP_METHOD_SOFT;
+	int32_t idx[3][VDEF_PRIV_CHUNK], top[VDEF_PRIV_CHUNK];
+	float gain[VDEF_PRIV_CHUNK];
+
+	/* Non-linear RGB to linearization table indexes */
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i += VDEF_PRIV_VEC_LEN) {
+		vdef_priv_v8i32 a[3], m;
+		vdef_priv_v8f32 f[3], v[3];
+
+		for (unsigned int k = 0; k < 3; k++) {
+			memcpy(&a[k], &in[k][i], sizeof(a[k]));
+			f[k] = __builtin_convertvector(a[k], vdef_priv_v8f32);
+		}
+		mat3f_apply(&gm->in_mat, f, v);
+		for (unsigned int c = 0; c < 3; c++) {
+			clamp_v(&v[c], 1.f);
+			a[c] = __builtin_convertvector(v[c] * scale + 0.5f,
+						       vdef_priv_v8i32);
+			memcpy(&idx[c][i], &a[c], sizeof(a[c]));
+		}
+
+		/* Tone mapping: the transfer functions are monotonic so the
+		 * maximum index is the index of the maximum linear light
+		 * component */
+		m = (a[0] > a[1]);
+		a[0] = (a[0] & m) | (a[1] & ~m);
+		m = (a[0] > a[2]);
+		a[0] = (a[0] & m) | (a[2] & ~m);
+		memcpy(&top[i], &a[0], sizeof(a[0]));
+	}
+	for (unsigned int c = 0; c < 3; c++) {
+		for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++)
+			rgb[c][i] = tl->f32[idx[c][i]];
+	}
+	for (unsigned int i = 0; gm->tone_gain && i < VDEF_PRIV_CHUNK; i++)
+		gain[i] = gm->tone_gain[top[i]];
+
+	/* Gamut conversion in linear light; the hard clipping is done by the
+	 * table index computation, which clamps to [0, 1] */
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i += VDEF_PRIV_VEC_LEN) {
+		vdef_priv_v8f32 f[3], v[3], g;
+		vdef_priv_v8i32 b;
+
+		for (unsigned int k = 0; k < 3; k++)
+			memcpy(&f[k], &rgb[k][i], sizeof(f[k]));
+		if (gm->tone_gain != NULL) {
+			memcpy(&g, &gain[i], sizeof(g));
+			for (unsigned int k = 0; k < 3; k++)
+				f[k] *= g;
+		}
+		mat3f_apply(&gm->gamut_mat, f, v);
+		if (soft)
+			soft_clip(gm, v);
+
+		/* Linear light to float input table indexes (see
+		 * vdef_priv_transfer_float_index()) */
+		for (unsigned int c = 0; c < 3; c++) {
+			clamp_v(&v[c], 1.f);
+			b = (vdef_priv_v8i32)v[c] - bias;
+			b &= (b > 0);
+			b >>= shift;
+			memcpy(&idx[c][i], &b, sizeof(b));
+		}
+	}
+
+	/* Linear light to non-linear RGB */
+	for (unsigned int c = 0; c < 3; c++) {
+		for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++)
+			rgb[c][i] = fl->from_f32[idx[c][i]] * inv;
+	}
+}
+
+
+/* Convert normalized non-linear RGB to output samples */
+VDEF_PRIV_TARGET_CLONES
+static void output_chunk(const struct mat3f *m,
+			 float max,
+			 float rgb[3][VDEF_PRIV_CHUNK],
+			 int32_t out[3][VDEF_PRIV_CHUNK])
+{
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i += VDEF_PRIV_VEC_LEN) {
+		vdef_priv_v8f32 f[3], v[3];
+		vdef_priv_v8i32 a;
+
+		for (unsigned int k = 0; k < 3; k++)
+			memcpy(&f[k], &rgb[k][i], sizeof(f[k]));
+		mat3f_apply(m, f, v);
+		for (unsigned int c = 0; c < 3; c++) {
+			clamp_v(&v[c], max);
+			a = __builtin_convertvector(v[c] + 0.5f,
+						    vdef_priv_v8i32);
+			memcpy(&out[c][i], &a, sizeof(a));
+		}
+	}
+}
+
+
+/* Average the values of the pixels covered by each subsampled chroma
+ * sample */
+static void avg_chroma(float rgb[2][3][VDEF_PRIV_CHUNK],
+		       unsigned int h_sub,
+		       unsigned int v_sub,
+		       unsigned int count,
+		       float avg[3][VDEF_PRIV_CHUNK])
+{
+	float norm = 1.f / (h_sub * v_sub);
+
+	for (unsigned int k = 0; k < 3; k++) {
+		for (unsigned int i = 0; i < count; i++) {
+			float s = 0.f;
+			for (unsigned int r = 0; r < v_sub; r++) {
+				for (unsigned int h = 0; h < h_sub; h++)
+					s += rgb[r][k][i * h_sub + h];
+			}
+			avg[k][i] = s * norm;
+		}
+	}
+}
+
+
+/* Process the lines [y0, y1) of the frame; y0 must be a multiple of the
+ * output vertical chroma subsampling */
+static void process_band(const struct gamut *gm,
+			 unsigned int y0,
+			 unsigned int y1)
+{
+	unsigned int h_sub = gm->h_sub, v_sub = gm->v_sub;
+	unsigned int c_width = gm->width / h_sub;
+	unsigned int c_height = gm->height / v_sub;
+	unsigned int out_comps = h_sub * v_sub > 1 ? 1 : gm->out_count;
+	float max = gm->out_max;
+	int32_t in[3][VDEF_PRIV_CHUNK], out[3][VDEF_PRIV_CHUNK];
+	int32_t alpha[VDEF_PRIV_CHUNK];
+	float rgb[2][3][VDEF_PRIV_CHUNK], avg[3][VDEF_PRIV_CHUNK];
+
+	/* The whole chunks are processed even for the last pixels of a line */
+	memset(in, 0, sizeof(in));
+	memset(rgb, 0, sizeof(rgb));
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++)
+		alpha[i] = gm->out_max;
+
+	for (unsigned int y = y0; y < y1; y += v_sub) {
+		unsigned int rows = (y + 1 < gm->height) ? v_sub : 1;
+		for (unsigned int x = 0; x < gm->width; x += VDEF_PRIV_CHUNK) {
+			unsigned int n = gm->width - x;
+			unsigned int cx = x / h_sub, cn;
+			if (n > VDEF_PRIV_CHUNK)
+				n = VDEF_PRIV_CHUNK;
+
+			/* Luma (and full resolution chroma or RGB) */
+			for (unsigned int r = 0; r < rows; r++) {
+				for (unsigned int k = 0; k < 3; k++) {
+					vdef_priv_read_comp(
+						gm->in_plane,
+						gm->in_frame->plane_stride,
+						&gm->in_comp[k],
+						&gm->in_fmt,
+						&gm->in_frame->info.resolution,
+						x,
+						y + r,
+						n,
+						in[k]);
+				}
+				if (gm->lut3d != NULL) {
+					vdef_priv_lut3d_apply_chunk(
+						gm->lut3d,
+						(1 << gm->in_fmt.depth) - 1,
+						in,
+						rgb[r]);
+				} else {
+					convert_chunk(gm, in, rgb[r]);
+				}
+				output_chunk(&gm->out_mat, max, rgb[r], out);
+				for (unsigned int c = 0; c < out_comps; c++) {
+					vdef_priv_write_comp(
+						gm->out_plane,
+						gm->out_frame->plane_stride,
+						&gm->out_comp[c],
+						&gm->out_fmt,
+						x,
+						y + r,
+						n,
+						c < 3 ? out[c] : alpha);
+				}
+			}
+			if (out_comps > 1 || y / v_sub >= c_height ||
+			    cx >= c_width)
+				continue;
+
+			/* Subsampled chroma */
+			cn = (n + h_sub - 1) / h_sub;
+			if (cn > c_width - cx)
+				cn = c_width - cx;
+			avg_chroma(rgb, h_sub, v_sub, cn, avg);
+			output_chunk(&gm->out_mat, max, avg, out);
+			for (unsigned int c = 1; c < 3; c++) {
+				vdef_priv_write_comp(
+					gm->out_plane,
+					gm->out_frame->plane_stride,
+					&gm->out_comp[c],
+					&gm->out_fmt,
+					x,
+					y,
+					cn,
+					out[c]);
+			}
+		}
+	}
+}
+
+
+static int process_task(unsigned int index,
+			unsigned int thread_index,
+			void *userdata)
+{
+	const struct gamut_run *run = userdata;
+	unsigned int y0 = index * run->band_height;
+	unsigned int y1 = y0 + run->band_height;
+
+	(void)thread_index;
+
+	if (y1 > run->gm->height)
+		y1 = run->gm->height;
+	process_band(run->gm, y0, y1);
+
+	return 0;
+}
+
+
+static bool is_yuv(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_YUV420 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_YUV422 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_YUV444;
+}
+
+
+static bool is_rgb(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_RGB24 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_RGBA32;
+}
+
+
+static int get_gamut_matrix(enum vdef_color_primaries in,
+			    enum vdef_color_primaries out,
+			    const float **mat)
+{
+	if (in == out)
+		*mat = NULL;
+	else if (in == VDEF_COLOR_PRIMARIES_BT709 &&
+		 out == VDEF_COLOR_PRIMARIES_BT2020)
+		*mat = vdef_bt709_to_bt2020_matrix;
+	else if (in == VDEF_COLOR_PRIMARIES_BT2020 &&
+		 out == VDEF_COLOR_PRIMARIES_BT709)
+		*mat = vdef_bt2020_to_bt709_matrix;
+	else
+		return -ENOTSUP;
+
+	return 0;
+}
+
+
+/* Get the luminance weights of color primaries from the matching RGB to YUV
+ * matrix (BT.709 weights are used for the primaries without one) */
+static void get_luma(enum vdef_color_primaries primaries, float luma[3])
+{
+	enum vdef_matrix_coefs matrix;
+	const float *mat;
+
+	switch (primaries) {
+	case VDEF_COLOR_PRIMARIES_BT601_525:
+		matrix = VDEF_MATRIX_COEFS_BT601_525;
+		break;
+	case VDEF_COLOR_PRIMARIES_BT601_625:
+		matrix = VDEF_MATRIX_COEFS_BT601_625;
+		break;
+	case VDEF_COLOR_PRIMARIES_BT2020:
+		matrix = VDEF_MATRIX_COEFS_BT2020_NON_CST;
+		break;
+	default:
+		matrix = VDEF_MATRIX_COEFS_BT709;
+		break;
+	}
+	mat = vdef_rgb_to_yuv_norm_matrix[matrix][1];
+	for (unsigned int k = 0; k < 3; k++)
+		luma[k] = mat[k * 3];
+}
+
+
+static unsigned int get_lut_depth(unsigned int depth)
+{
+	depth += LUT_EXTRA_DEPTH;
+	if (depth < MIN_LUT_DEPTH)
+		return MIN_LUT_DEPTH;
+	return depth > 16 ? 16 : depth;
+}
+
+
+static bool is_pq(const struct vdef_frame_info *info)
+{
+	return info->tone_mapping != VDEF_TONE_MAPPING_P_LOG &&
+	       info->transfer_function == VDEF_TRANSFER_FUNCTION_PQ;
+}
+
+
+/* Get the lookup table of a frame (P-log curve or transfer function) */
+static int get_lut(const struct vdef_frame_info *info,
+		   enum vdef_transfer_lut_dir dir,
+		   unsigned int depth,
+		   const struct vdef_transfer_lut **ret_lut)
+{
+	if (info->tone_mapping == VDEF_TONE_MAPPING_P_LOG) {
+		return vdef_tone_mapping_lut_get(
+			info->tone_mapping, dir, depth, ret_lut);
+	}
+	return vdef_transfer_lut_get(
+		info->transfer_function, dir, depth, ret_lut);
+}
+
+
+/* Check the color parameters of a frame */
+static int check_info(const struct vdef_raw_frame *frame)
+{
+	const struct vdef_frame_info *info = &frame->info;
+
+	ULOG_ERRNO_RETURN_ERR_IF(info->color_primaries ==
+					 VDEF_COLOR_PRIMARIES_UNKNOWN,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(info->color_primaries >=
+					 VDEF_COLOR_PRIMARIES_MAX,
+				 EINVAL);
+	/* The P-log curve replaces the transfer function */
+	if (info->tone_mapping != VDEF_TONE_MAPPING_P_LOG) {
+		ULOG_ERRNO_RETURN_ERR_IF(info->transfer_function ==
+						 VDEF_TRANSFER_FUNCTION_UNKNOWN,
+					 EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(info->transfer_function >=
+						 VDEF_TRANSFER_FUNCTION_MAX,
+					 EINVAL);
+	}
+
+	if (is_yuv(&frame->format)) {
+		ULOG_ERRNO_RETURN_ERR_IF(info->matrix_coefs ==
+						 VDEF_MATRIX_COEFS_UNKNOWN,
+					 EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(info->matrix_coefs >=
+						 VDEF_MATRIX_COEFS_MAX,
+					 EINVAL);
+	}
+
+	return 0;
+}
+
+
+/* Get the input or output side of the conversion */
+static int init_side(const struct vdef_raw_frame *frame,
+		     struct vdef_priv_comp comp[4],
+		     unsigned int *count,
+		     struct vdef_priv_sample_fmt *fmt)
+{
+	int ret;
+
+	if (!is_yuv(&frame->format) && !is_rgb(&frame->format))
+		return -ENOTSUP;
+
+	ret = vdef_priv_get_comp_layout(&frame->format, comp, count);
+	if (ret < 0)
+		return ret;
+	return vdef_priv_get_sample_fmt(&frame->format, fmt);
+}
+
+
+/* Initialize the frames access (the plane pointers are set by the
+ * caller) */
+static int frames_init(struct gamut *gm,
+		       const struct vdef_raw_frame *in_frame,
+		       const struct vdef_raw_frame *out_frame)
+{
+	int ret;
+	unsigned int in_count;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	memset(gm, 0, sizeof(*gm));
+	gm->in_frame = in_frame;
+	gm->out_frame = out_frame;
+	gm->width = in_frame->info.resolution.width;
+	gm->height = in_frame->info.resolution.height;
+
+	ret = init_side(in_frame, gm->in_comp, &in_count, &gm->in_fmt);
+	if (ret < 0)
+		return ret;
+	ret = init_side(out_frame, gm->out_comp, &gm->out_count, &gm->out_fmt);
+	if (ret < 0)
+		return ret;
+
+	gm->h_sub = gm->out_comp[1].h_sub;
+	gm->v_sub = gm->out_comp[1].v_sub;
+	if (gm->width < gm->h_sub || gm->height < gm->v_sub ||
+	    gm->width < gm->in_comp[1].h_sub ||
+	    gm->height < gm->in_comp[1].v_sub)
+		return -EINVAL;
+	gm->out_max = (1 << gm->out_fmt.depth) - 1;
+
+	return 0;
+}
+
+
+/* Initialize the conversion from the frames info */
+static int gamut_init(struct gamut *gm,
+		      const struct vdef_raw_frame *in_frame,
+		      const struct vdef_raw_frame *out_frame,
+		      enum vdef_gamut_clip_method clip)
+{
+	int ret;
+	const struct vdef_frame_info *in_info, *out_info;
+	const float *mat;
+	int32_t off[3];
+	float scale;
+
+	ULOG_ERRNO_RETURN_ERR_IF(clip >= VDEF_GAMUT_CLIP_METHOD_MAX, EINVAL);
+
+	ret = frames_init(gm, in_frame, out_frame);
+	if (ret < 0)
+		return ret;
+	ret = check_info(in_frame);
+	if (ret < 0)
+		return ret;
+	ret = check_info(out_frame);
+	if (ret < 0)
+		return ret;
+	gm->clip = clip;
+	in_info = &in_frame->info;
+	out_info = &out_frame->info;
+
+	ret = get_gamut_matrix(
+		in_info->color_primaries, out_info->color_primaries, &mat);
+	if (ret < 0)
+		return ret;
+	mat3f_init(&gm->gamut_mat, mat, NULL, 1.f, NULL, 1.f);
+	get_luma(out_info->color_primaries, gm->luma);
+
+	/* Input and output matrices */
+	if (is_yuv(&in_frame->format)) {
+		vdef_priv_get_yuv_range(
+			gm->in_fmt.depth, in_info->full_range, off, &scale);
+		mat = vdef_yuv_to_rgb_norm_matrix[in_info->matrix_coefs]
+						 [in_info->full_range];
+		mat3f_init(&gm->in_mat, mat, off, scale, NULL, 1.f);
+	} else {
+		mat3f_init(&gm->in_mat,
+			   NULL,
+			   NULL,
+			   (1 << gm->in_fmt.depth) - 1,
+			   NULL,
+			   1.f);
+	}
+	if (is_yuv(&out_frame->format)) {
+		vdef_priv_get_yuv_range(
+			gm->out_fmt.depth, out_info->full_range, off, &scale);
+		mat = vdef_rgb_to_yuv_norm_matrix[out_info->matrix_coefs]
+						 [out_info->full_range];
+		mat3f_init(&gm->out_mat, mat, NULL, 1.f, off, scale);
+	} else {
+		mat3f_init(&gm->out_mat, NULL, NULL, 1.f, NULL, gm->out_max);
+	}
+
+	ret = get_lut(in_info,
+		      VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+		      get_lut_depth(gm->in_fmt.depth),
+		      &gm->to_linear);
+	if (ret < 0)
+		return ret;
+	return get_lut(out_info,
+		       VDEF_TRANSFER_LUT_DIR_FROM_LINEAR,
+		       get_lut_depth(gm->out_fmt.depth),
+		       &gm->from_linear);
+}
+
+
+/* Process the frame in bands of lines; the bands start on whole output
+ * chroma lines */
+static int gamut_process(const struct gamut *gm,
+			 struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct gamut_run run = {.gm = gm};
+	unsigned int band_count;
+
+	ret = vdef_calc_raw_frame_bands(&gm->out_frame->format,
+					&gm->out_frame->info.resolution,
+					&run.band_height,
+					&band_count);
+	if (ret < 0)
+		return ret;
+
+	return vdef_priv_thread_pool_run(
+		pool, band_count, &process_task, &run);
+}
+
+
+/* Initialize the tone mapping gains; the conversion must already be
+ * initialized by gamut_init() */
+static int tone_map_init(struct gamut *gm,
+			 const struct vdef_format_info *hdr_info,
+			 enum vdef_tone_map_method method)
+{
+	int ret;
+	struct vdef_priv_tone_curve curve;
+	const struct vdef_frame_info *out_info = &gm->out_frame->info;
+	const float *lin;
+	float v;
+
+	ULOG_ERRNO_RETURN_ERR_IF(method >= VDEF_TONE_MAP_METHOD_MAX, EINVAL);
+
+	if (out_info->tone_mapping == VDEF_TONE_MAPPING_P_LOG ||
+	    out_info->transfer_function == VDEF_TRANSFER_FUNCTION_PQ ||
+	    out_info->transfer_function == VDEF_TRANSFER_FUNCTION_HLG)
+		return -ENOTSUP;
+	if (!is_pq(&gm->in_frame->info))
+		return -ENOTSUP;
+	ret = vdef_priv_tone_curve_init(&curve, method, hdr_info);
+	if (ret < 0)
+		return ret;
+
+	/* Tone mapping gains, indexed like the linearization table */
+	gm->tone_gain = malloc((gm->to_linear->max + 1) * sizeof(float));
+	if (gm->tone_gain == NULL)
+		return -ENOMEM;
+	lin = gm->to_linear->f32;
+	for (unsigned int i = 0; i <= gm->to_linear->max; i++) {
+		v = vdef_priv_tone_curve_apply(&curve, lin[i]);
+		gm->tone_gain[i] = lin[i] > 0.f ? v / lin[i] : 0.f;
+	}
+
+	return 0;
+}
+
+
+int vdef_convert_gamut(const struct vdef_raw_frame *in_frame,
+		       const void *const *in_plane,
+		       const struct vdef_raw_frame *out_frame,
+		       void *const *out_plane,
+		       enum vdef_gamut_clip_method clip,
+		       struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct gamut gm;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+
+	ret = gamut_init(&gm, in_frame, out_frame, clip);
+	if (ret < 0)
+		return ret;
+	if (is_pq(&in_frame->info) != is_pq(&out_frame->info))
+		return -ENOTSUP;
+	gm.in_plane = in_plane;
+	gm.out_plane = out_plane;
+
+	return gamut_process(&gm, pool);
+}
+
+
+int vdef_tone_map(const struct vdef_raw_frame *in_frame,
+		  const void *const *in_plane,
+		  const struct vdef_format_info *hdr_info,
+		  const struct vdef_raw_frame *out_frame,
+		  void *const *out_plane,
+		  enum vdef_tone_map_method method,
+		  enum vdef_gamut_clip_method clip,
+		  struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct gamut gm;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+
+	ret = gamut_init(&gm, in_frame, out_frame, clip);
+	if (ret < 0)
+		return ret;
+	ret = tone_map_init(&gm, hdr_info, method);
+	if (ret < 0)
+		return ret;
+	gm.in_plane = in_plane;
+	gm.out_plane = out_plane;
+
+	ret = gamut_process(&gm, pool);
+
+	free(gm.tone_gain);
+	return ret;
+}
+
+
+int vdef_lut3d_apply(const struct vdef_lut3d *lut,
+		     const struct vdef_raw_frame *in_frame,
+		     const void *const *in_plane,
+		     const struct vdef_raw_frame *out_frame,
+		     void *const *out_plane,
+		     struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct gamut gm;
+
+	ULOG_ERRNO_RETURN_ERR_IF(lut == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+
+	ret = frames_init(&gm, in_frame, out_frame);
+	if (ret < 0)
+		return ret;
+	ULOG_ERRNO_RETURN_ERR_IF(is_yuv(&in_frame->format) != lut->key.src.yuv,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		is_yuv(&out_frame->format) != lut->key.dst.yuv, EINVAL);
+
+	/* The table gives normalized output samples */
+	mat3f_init(&gm.out_mat, NULL, NULL, 1.f, NULL, gm.out_max);
+	gm.lut3d = lut;
+	gm.in_plane = in_plane;
+	gm.out_plane = out_plane;
+
+	return gamut_process(&gm, pool);
+}
+
+
+int vdef_priv_gamut_new(const struct vdef_raw_frame *in_frame,
+			const struct vdef_raw_frame *out_frame,
+			bool tone_map,
+			const struct vdef_format_info *hdr_info,
+			enum vdef_tone_map_method method,
+			enum vdef_gamut_clip_method clip,
+			struct vdef_priv_gamut **ret_obj)
+{
+	int ret;
+	struct vdef_priv_gamut *self;
+
+	self = calloc(1, sizeof(*self));
+	if (self == NULL)
+		return -ENOMEM;
+
+	ret = gamut_init(&self->gm, in_frame, out_frame, clip);
+	if (ret < 0)
+		goto error;
+	if (tone_map) {
+		ret = tone_map_init(&self->gm, hdr_info, method);
+		if (ret < 0)
+			goto error;
+	} else if (is_pq(&in_frame->info) != is_pq(&out_frame->info)) {
+		ret = -ENOTSUP;
+		goto error;
+	}
+	/* The frames are only valid during this call */
+	self->gm.in_frame = NULL;
+	self->gm.out_frame = NULL;
+
+	*ret_obj = self;
+	return 0;
+
+error:
+	free(self);
+	return ret;
+}
+
+
+void vdef_priv_gamut_destroy(struct vdef_priv_gamut *self)
+{
+	if (self == NULL)
+		return;
+	free(self->gm.tone_gain);
+	free(self);
+}
+
+
+void vdef_priv_gamut_run(const struct vdef_priv_gamut *self,
+			 const struct vdef_raw_frame *in_frame,
+			 const void *const *in_plane,
+			 const struct vdef_raw_frame *out_frame,
+			 void *const *out_plane)
+{
+	struct gamut gm = self->gm;
+
+	gm.in_frame = in_frame;
+	gm.in_plane = in_plane;
+	gm.out_frame = out_frame;
+	gm.out_plane = out_plane;
+	gm.width = in_frame->info.resolution.width;
+	gm.height = in_frame->info.resolution.height;
+
+	process_band(&gm, 0, gm.height);
+}
@@ -0,0 +1,359 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Raw frame layout cache entry */
+struct vdef_raw_layout_cache_entry {
+	/* Alignment constraints (the format and resolution part of the key
+	 * are stored in the layout) */
+	unsigned int plane_stride_align[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_scanline_align[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int plane_size_align[VDEF_RAW_MAX_PLANE_COUNT];
+
+	/* Cached layout */
+	struct vdef_raw_layout layout;
+
+	/* Next entry in the list */
+	struct vdef_raw_layout_cache_entry *next;
+};
+
+
+struct vdef_raw_layout_cache {
+	/* Entry list head; entries are only ever prepended and never removed
+	 * before the cache is destroyed, so lookups can walk the list without
+	 * holding the mutex */
+	_Atomic(struct vdef_raw_layout_cache_entry *) head;
+
+	/* Insertion mutex */
+	pthread_mutex_t mutex;
+};
+
+
+static void copy_align(unsigned int *dst, const unsigned int *src)
+{
+	if (src)
+		memcpy(dst, src, VDEF_RAW_MAX_PLANE_COUNT * sizeof(*dst));
+	else
+		memset(dst, 0, VDEF_RAW_MAX_PLANE_COUNT * sizeof(*dst));
+}
+
+
+static bool cmp_align(const unsigned int *a1, const unsigned int *a2)
+{
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		if (a1[i] != (a2 ? a2[i] : 0))
+			return false;
+	}
+	return true;
+}
+
+
+/* Look up a key in the entries from entry (inclusive) to end (exclusive) */
+static const struct vdef_raw_layout_cache_entry *
+cache_lookup(const struct vdef_raw_layout_cache_entry *entry,
+	     const struct vdef_raw_layout_cache_entry *end,
+	     const struct vdef_raw_format *format,
+	     const struct vdef_dim *resolution,
+	     const unsigned int *plane_stride_align,
+	     const unsigned int *plane_scanline_align,
+	     const unsigned int *plane_size_align)
+{
+	for (; entry != end; entry = entry->next) {
+		if (vdef_dim_cmp(&entry->layout.resolution, resolution) &&
+		    vdef_raw_format_cmp(&entry->layout.format, format) &&
+		    cmp_align(entry->plane_stride_align, plane_stride_align) &&
+		    cmp_align(entry->plane_scanline_align,
+			      plane_scanline_align) &&
+		    cmp_align(entry->plane_size_align, plane_size_align))
+			return entry;
+	}
+	return NULL;
+}
+
+
+ssize_t
+vdef_calc_raw_contiguous_frame_planes(void *base,
+				      size_t len,
+				      const struct vdef_raw_format *format,
+				      const struct vdef_dim *resolution,
+				      size_t *plane_stride,
+				      const unsigned int *plane_stride_align,
+				      size_t *plane_scanline,
+				      const unsigned int *plane_scanline_align,
+				      const unsigned int *plane_size_align,
+				      void **plane,
+				      size_t *plane_size)
+{
+	int ret;
+	unsigned int plane_count;
+	size_t size[VDEF_RAW_MAX_PLANE_COUNT] = {0};
+	size_t offset = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(base == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane == NULL, EINVAL);
+
+	plane_count = vdef_get_raw_frame_plane_count(format);
+	if (plane_count == 0 || plane_count > VDEF_RAW_MAX_PLANE_COUNT)
+		return -EINVAL;
+
+	ret = vdef_calc_raw_frame_size(format,
+				       resolution,
+				       plane_stride,
+				       plane_stride_align,
+				       plane_scanline,
+				       plane_scanline_align,
+				       size,
+				       plane_size_align);
+	if (ret < 0)
+		return ret;
+
+	for (unsigned int i = 0; i < plane_count; i++)
+		offset += size[i];
+	if (offset > len)
+		return -ENOBUFS;
+
+	offset = 0;
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		if (i < plane_count) {
+			plane[i] = (uint8_t *)base + offset;
+			offset += size[i];
+		} else {
+			plane[i] = NULL;
+		}
+		if (plane_size)
+			plane_size[i] = size[i];
+	}
+
+	return offset;
+}
+
+
+int vdef_calc_raw_layout(const struct vdef_raw_format *format,
+			 const struct vdef_dim *resolution,
+			 const unsigned int *plane_stride_align,
+			 const unsigned int *plane_scanline_align,
+			 const unsigned int *plane_size_align,
+			 struct vdef_raw_layout *layout)
+{
+	int ret;
+	size_t offset = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_is_raw_format_valid(format), EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(vdef_dim_is_null(resolution), EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(layout == NULL, EINVAL);
+
+	memset(layout, 0, sizeof(*layout));
+	layout->format = *format;
+	layout->resolution = *resolution;
+	layout->plane_count = vdef_get_raw_frame_plane_count(format);
+	if (layout->plane_count == 0 ||
+	    layout->plane_count > VDEF_RAW_MAX_PLANE_COUNT)
+		return -EINVAL;
+
+	ret = vdef_calc_raw_frame_size(format,
+				       resolution,
+				       layout->plane_stride,
+				       plane_stride_align,
+				       layout->plane_scanline,
+				       plane_scanline_align,
+				       layout->plane_size,
+				       plane_size_align);
+	if (ret < 0) {
+		ULOG_ERRNO("vdef_calc_raw_frame_size", -ret);
+		return ret;
+	}
+
+	for (unsigned int i = 0; i < layout->plane_count; i++) {
+		layout->plane_offset[i] = offset;
+		offset += layout->plane_size[i];
+	}
+	layout->size = offset;
+
+	return 0;
+}
+
+
+int vdef_raw_layout_cache_new(struct vdef_raw_layout_cache **ret_obj)
+{
+	int ret;
+	struct vdef_raw_layout_cache *cache;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	atomic_init(&cache->head, NULL);
+
+	ret = pthread_mutex_init(&cache->mutex, NULL);
+	if (ret != 0) {
+		ULOG_ERRNO("pthread_mutex_init", ret);
+		free(cache);
+		return -ret;
+	}
+
+	*ret_obj = cache;
+	return 0;
+}
+
+
+int vdef_raw_layout_cache_destroy(struct vdef_raw_layout_cache *cache)
+{
+	struct vdef_raw_layout_cache_entry *entry, *next;
+
+	if (cache == NULL)
+		return 0;
+
+	entry = atomic_load_explicit(&cache->head, memory_order_acquire);
+	while (entry != NULL) {
+		next = entry->next;
+		free(entry);
+		entry = next;
+	}
+
+	pthread_mutex_destroy(&cache->mutex);
+	free(cache);
+
+	return 0;
+}
+
+
+int vdef_raw_layout_cache_get(struct vdef_raw_layout_cache *cache,
+			      const struct vdef_raw_format *format,
+			      const struct vdef_dim *resolution,
+			      const unsigned int *plane_stride_align,
+			      const unsigned int *plane_scanline_align,
+			      const unsigned int *plane_size_align,
+			      const struct vdef_raw_layout **ret_layout)
+{
+	int ret;
+	struct vdef_raw_layout_cache_entry *head, *entry;
+	const struct vdef_raw_layout_cache_entry *found;
+
+	ULOG_ERRNO_RETURN_ERR_IF(cache == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(resolution == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_layout == NULL, EINVAL);
+
+	/* Lock-free lookup */
+	head = atomic_load_explicit(&cache->head, memory_order_acquire);
+	found = cache_lookup(head,
+			     NULL,
+			     format,
+			     resolution,
+			     plane_stride_align,
+			     plane_scanline_align,
+			     plane_size_align);
+	if (found != NULL) {
+		*ret_layout = &found->layout;
+		return 0;
+	}
+
+	/* Calculate the new layout outside of the lock */
+	entry = calloc(1, sizeof(*entry));
+	if (entry == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	copy_align(entry->plane_stride_align, plane_stride_align);
+	copy_align(entry->plane_scanline_align, plane_scanline_align);
+	copy_align(entry->plane_size_align, plane_size_align);
+	ret = vdef_calc_raw_layout(format,
+				   resolution,
+				   plane_stride_align,
+				   plane_scanline_align,
+				   plane_size_align,
+				   &entry->layout);
+	if (ret < 0) {
+		free(entry);
+		return ret;
+	}
+
+	pthread_mutex_lock(&cache->mutex);
+
+	/* Only the entries inserted since the first lookup need to be
+	 * checked again */
+	entry->next = atomic_load_explicit(&cache->head, memory_order_relaxed);
+	found = cache_lookup(entry->next,
+			     head,
+			     format,
+			     resolution,
+			     plane_stride_align,
+			     plane_scanline_align,
+			     plane_size_align);
+	if (found == NULL) {
+		atomic_store_explicit(
+			&cache->head, entry, memory_order_release);
+		found = entry;
+		entry = NULL;
+	}
+
+	pthread_mutex_unlock(&cache->mutex);
+
+	/* Another thread has inserted the same key in the meantime */
+	free(entry);
+
+	*ret_layout = &found->layout;
+	return 0;
+}
+
+
+int vdef_raw_layout_get_planes(const struct vdef_raw_layout *layout,
+			       void *base,
+			       size_t len,
+			       void **plane)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(layout == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(base == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane == NULL, EINVAL);
+
+	if (layout->size > len)
+		return -ENOBUFS;
+
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		plane[i] = (i < layout->plane_count)
+				   ? (uint8_t *)base + layout->plane_offset[i]
+				   : NULL;
+	}
+
+	return 0;
+}
@@ -0,0 +1,517 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Number of buckets of the table cache (the tables are keyed by hash) */
+#define CACHE_BUCKETS 64
+
+/* FNV-1a hash constants */
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+
+/* Baked tables; the bucket lists only grow, so lookups only need an atomic
+ * load of the bucket head */
+static _Atomic(struct vdef_lut3d *) s_cache[CACHE_BUCKETS];
+
+
+/* 16-bit formats of the grid frames used for baking */
+static const struct vdef_raw_format s_yuv444_16 = {
+	.pix_format = VDEF_RAW_PIX_FORMAT_YUV444,
+	.pix_order = VDEF_RAW_PIX_ORDER_YUV,
+	.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+	.pix_size = 16,
+	.data_layout = VDEF_RAW_DATA_LAYOUT_PLANAR,
+	.data_little_endian = true,
+	.data_size = 16,
+};
+
+static const struct vdef_raw_format s_rgb48 = {
+	.pix_format = VDEF_RAW_PIX_FORMAT_RGB24,
+	.pix_order = VDEF_RAW_PIX_ORDER_RGB,
+	.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+	.pix_size = 16,
+	.data_layout = VDEF_RAW_DATA_LAYOUT_PACKED,
+	.data_little_endian = true,
+	.data_size = 16,
+};
+
+
+struct grid_frame {
+	struct vdef_raw_frame frame;
+	struct vdef_raw_layout layout;
+	struct vdef_priv_comp comp[4];
+	struct vdef_priv_sample_fmt fmt;
+	uint8_t *data;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+};
+
+
+static bool is_hdr(const struct vdef_priv_lut3d_side *side)
+{
+	return side->tone_mapping == VDEF_TONE_MAPPING_P_LOG ||
+	       side->transfer_function == VDEF_TRANSFER_FUNCTION_PQ;
+}
+
+
+/* Tone mapping from PQ or P-log to an SDR transfer function (see
+ * vdef_tone_map()) */
+static bool is_tone_map(const struct vdef_priv_lut3d_key *key)
+{
+	return is_hdr(&key->src) && !is_hdr(&key->dst) &&
+	       key->dst.transfer_function != VDEF_TRANSFER_FUNCTION_HLG;
+}
+
+
+static void key_side_init(struct vdef_priv_lut3d_side *side,
+			  const struct vdef_format_info *info)
+{
+	side->yuv = info->matrix_coefs != VDEF_MATRIX_COEFS_IDENTITY;
+	side->color_primaries = info->color_primaries;
+	side->dynamic_range = info->dynamic_range;
+	side->tone_mapping = info->tone_mapping;
+	/* The P-log curve replaces the transfer function */
+	if (info->tone_mapping != VDEF_TONE_MAPPING_P_LOG)
+		side->transfer_function = info->transfer_function;
+	/* The RGB components do not depend on the YUV parameters */
+	if (side->yuv) {
+		side->full_range = info->full_range;
+		side->matrix_coefs = info->matrix_coefs;
+	}
+}
+
+
+/* Build the descriptor of a conversion; the values that do not change the
+ * conversion are left to 0 so that equivalent descriptors share a table */
+static void key_init(struct vdef_priv_lut3d_key *key,
+		     const struct vdef_format_info *src_info,
+		     const struct vdef_format_info *dst_info,
+		     unsigned int size,
+		     enum vdef_tone_map_method method,
+		     enum vdef_gamut_clip_method clip)
+{
+	memset(key, 0, sizeof(*key));
+	key_side_init(&key->src, src_info);
+	key_side_init(&key->dst, dst_info);
+	key->size = size;
+	key->clip = clip;
+	if (!is_tone_map(key))
+		return;
+	key->method = method;
+	key->src.max_luminance = src_info->mdcv.max_display_mastering_luminance;
+	key->src.min_luminance = src_info->mdcv.min_display_mastering_luminance;
+	key->src.max_cll = src_info->cll.max_cll;
+}
+
+
+static uint32_t key_hash(const struct vdef_priv_lut3d_key *key)
+{
+	const uint8_t *p = (const uint8_t *)key;
+	uint32_t hash = FNV_OFFSET;
+
+	for (size_t i = 0; i < sizeof(*key); i++) {
+		hash ^= p[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+
+/* Find a table in a bucket list, from first up to last (excluded) */
+static struct vdef_lut3d *cache_find(struct vdef_lut3d *first,
+				     const struct vdef_lut3d *last,
+				     const struct vdef_priv_lut3d_key *key,
+				     uint32_t hash)
+{
+	for (struct vdef_lut3d *lut = first; lut != last; lut = lut->next) {
+		if (lut->hash == hash &&
+		    memcmp(&lut->key, key, sizeof(*key)) == 0)
+			return lut;
+	}
+
+	return NULL;
+}
+
+
+static void lut3d_destroy(struct vdef_lut3d *lut)
+{
+	if (lut == NULL)
+		return;
+	free(lut->table);
+	free(lut);
+}
+
+
+__attribute__((destructor)) static void lut3d_cleanup(void)
+{
+	struct vdef_lut3d *lut, *next;
+
+	for (unsigned int i = 0; i < CACHE_BUCKETS; i++) {
+		lut = atomic_exchange(&s_cache[i], NULL);
+		for (; lut != NULL; lut = next) {
+			next = lut->next;
+			lut3d_destroy(lut);
+		}
+	}
+}
+
+
+/* Allocate a 16-bit frame whose pixels are the size^3 grid points: the
+ * frame is size^2 x size pixels and the grid index of a pixel is
+ * y * size^2 + x */
+static int grid_frame_init(struct grid_frame *f,
+			   const struct vdef_priv_lut3d_side *side,
+			   const struct vdef_format_info *info,
+			   unsigned int size)
+{
+	int ret;
+	unsigned int count;
+	struct vdef_frame_info *fi = &f->frame.info;
+
+	memset(f, 0, sizeof(*f));
+	f->frame.format = side->yuv ? s_yuv444_16 : s_rgb48;
+	fi->bit_depth = 16;
+	fi->full_range = info->full_range;
+	fi->color_primaries = info->color_primaries;
+	fi->transfer_function = info->transfer_function;
+	fi->matrix_coefs = info->matrix_coefs;
+	fi->dynamic_range = info->dynamic_range;
+	fi->tone_mapping = info->tone_mapping;
+	fi->resolution.width = size * size;
+	fi->resolution.height = size;
+
+	ret = vdef_calc_raw_layout(&f->frame.format,
+				   &fi->resolution,
+				   NULL,
+				   NULL,
+				   NULL,
+				   &f->layout);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_comp_layout(&f->frame.format, f->comp, &count);
+	if (ret < 0)
+		return ret;
+	ret = vdef_priv_get_sample_fmt(&f->frame.format, &f->fmt);
+	if (ret < 0)
+		return ret;
+	f->data = calloc(1, f->layout.size);
+	if (f->data == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	memcpy(f->frame.plane_stride,
+	       f->layout.plane_stride,
+	       sizeof(f->frame.plane_stride));
+	return vdef_raw_layout_get_planes(
+		&f->layout, f->data, f->layout.size, f->plane);
+}
+
+
+/* Run the reference conversion on the grid points */
+static int lut3d_bake(struct vdef_lut3d *lut,
+		      const struct vdef_format_info *src_info,
+		      const struct vdef_format_info *dst_info)
+{
+	int ret;
+	struct grid_frame in = {0}, out = {0};
+	unsigned int n = lut->size, width = n * n;
+	int32_t grid[65], val[VDEF_PRIV_CHUNK];
+
+	for (unsigned int i = 0; i < n; i++)
+		grid[i] = (UINT16_MAX * i + (n - 1) / 2) / (n - 1);
+
+	ret = grid_frame_init(&in, &lut->key.src, src_info, n);
+	if (ret < 0)
+		goto out;
+	ret = grid_frame_init(&out, &lut->key.dst, dst_info, n);
+	if (ret < 0)
+		goto out;
+
+	for (unsigned int y = 0; y < n; y++) {
+		for (unsigned int x = 0; x < width; x += VDEF_PRIV_CHUNK) {
+			unsigned int cnt = width - x < VDEF_PRIV_CHUNK
+						   ? width - x
+						   : VDEF_PRIV_CHUNK;
+			for (unsigned int k = 0; k < 3; k++) {
+				for (unsigned int i = 0; i < cnt; i++) {
+					unsigned int g = x + i;
+					if (k == 2)
+						g = y;
+					else
+						g = k == 0 ? g % n : g / n;
+					val[i] = grid[g];
+				}
+				vdef_priv_write_comp(in.plane,
+						     in.frame.plane_stride,
+						     &in.comp[k],
+						     &in.fmt,
+						     x,
+						     y,
+						     cnt,
+						     val);
+			}
+		}
+	}
+
+	if (is_tone_map(&lut->key)) {
+		ret = vdef_tone_map(&in.frame,
+				    (const void *const *)in.plane,
+				    src_info,
+				    &out.frame,
+				    out.plane,
+				    lut->key.method,
+				    lut->key.clip,
+				    NULL);
+	} else {
+		ret = vdef_convert_gamut(&in.frame,
+					 (const void *const *)in.plane,
+					 &out.frame,
+					 out.plane,
+					 lut->key.clip,
+					 NULL);
+	}
+	if (ret < 0)
+		goto out;
+
+	for (unsigned int y = 0; y < n; y++) {
+		for (unsigned int x = 0; x < width; x += VDEF_PRIV_CHUNK) {
+			unsigned int cnt = width - x < VDEF_PRIV_CHUNK
+						   ? width - x
+						   : VDEF_PRIV_CHUNK;
+			float norm = 1.f / UINT16_MAX;
+			float *t = &lut->table[((size_t)y * width + x) * 3];
+			for (unsigned int k = 0; k < 3; k++) {
+				vdef_priv_read_comp(
+					(const void *const *)out.plane,
+					out.frame.plane_stride,
+					&out.comp[k],
+					&out.fmt,
+					&out.frame.info.resolution,
+					x,
+					y,
+					cnt,
+					val);
+				for (unsigned int i = 0; i < cnt; i++)
+					t[i * 3 + k] = val[i] * norm;
+			}
+		}
+	}
+
+out:
+	free(in.data);
+	free(out.data);
+	return ret;
+}
+
+
+/* The vector helpers take pointers, vectors are not passed by value to
+ * avoid ABI differences between the target clones */
+
+/* Order 2 (fraction, stride) pairs by decreasing fraction */
+static inline void sort_pair(vdef_priv_v8f32 *fa,
+			     vdef_priv_v8i32 *sa,
+			     vdef_priv_v8f32 *fb,
+			     vdef_priv_v8i32 *sb)
+{
+	vdef_priv_v8i32 m = (*fa < *fb);
+	vdef_priv_v8i32 a = (vdef_priv_v8i32)*fa, b = (vdef_priv_v8i32)*fb;
+	vdef_priv_v8i32 s = *sa;
+
+	*fa = (vdef_priv_v8f32)((b & m) | (a & ~m));
+	*fb = (vdef_priv_v8f32)((a & m) | (b & ~m));
+	*sa = (*sb & m) | (s & ~m);
+	*sb = (s & m) | (*sb & ~m);
+}
+
+
+/* Tetrahedral interpolation: the unit cube is split along its diagonal in
+ * 6 tetrahedra, selected by the order of the fractional parts; the
+ * weights are the differences of the sorted fractional parts */
+VDEF_PRIV_TARGET_CLONES
+void vdef_priv_lut3d_apply_chunk(const struct vdef_lut3d *lut,
+				 unsigned int in_max,
+				 int32_t in[3][VDEF_PRIV_CHUNK],
+				 float out[3][VDEF_PRIV_CHUNK])
+{
+	const float *t = lut->table;
+	int32_t n = lut->size;
+	float scale = (float)(n - 1) / in_max;
+	int32_t idx[4][VDEF_PRIV_CHUNK];
+	float w[4][VDEF_PRIV_CHUNK], v[4][VDEF_PRIV_CHUNK];
+	/* Offsets of the next grid point along each axis */
+	const vdef_priv_v8i32 stride[3] = {
+		(vdef_priv_v8i32){0} + 3,
+		(vdef_priv_v8i32){0} + 3 * n,
+		(vdef_priv_v8i32){0} + 3 * n * n,
+	};
+
+	/* Grid cells, tetrahedra vertices and weights */
+	for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i += VDEF_PRIV_VEC_LEN) {
+		vdef_priv_v8i32 a, m, b[3], s[3], vi[4];
+		vdef_priv_v8f32 f[3], vw[4];
+
+		for (unsigned int k = 0; k < 3; k++) {
+			memcpy(&a, &in[k][i], sizeof(a));
+			a &= (a > 0);
+			m = (a > (int32_t)in_max);
+			a = (a & ~m) | ((int32_t)in_max & m);
+			f[k] = __builtin_convertvector(a, vdef_priv_v8f32) *
+			       scale;
+			/* The last cell also covers the last grid point */
+			b[k] = __builtin_convertvector(f[k], vdef_priv_v8i32);
+			m = (b[k] > n - 2);
+			b[k] = (b[k] & ~m) | ((n - 2) & m);
+			f[k] -= __builtin_convertvector(b[k], vdef_priv_v8f32);
+		}
+		memcpy(s, stride, sizeof(s));
+		vi[0] = (b[0] + b[1] * n + b[2] * (n * n)) * 3;
+		vi[3] = vi[0] + s[0] + s[1] + s[2];
+		sort_pair(&f[0], &s[0], &f[1], &s[1]);
+		sort_pair(&f[1], &s[1], &f[2], &s[2]);
+		sort_pair(&f[0], &s[0], &f[1], &s[1]);
+		vi[1] = vi[0] + s[0];
+		vi[2] = vi[1] + s[1];
+		vw[0] = 1.f - f[0];
+		vw[1] = f[0] - f[1];
+		vw[2] = f[1] - f[2];
+		vw[3] = f[2];
+		for (unsigned int j = 0; j < 4; j++) {
+			memcpy(&idx[j][i], &vi[j], sizeof(vi[j]));
+			memcpy(&w[j][i], &vw[j], sizeof(vw[j]));
+		}
+	}
+
+	for (unsigned int c = 0; c < 3; c++) {
+		/* Vertex values (plain loads, see apply_u16()) */
+		for (unsigned int j = 0; j < 4; j++) {
+			for (unsigned int i = 0; i < VDEF_PRIV_CHUNK; i++)
+				v[j][i] = t[idx[j][i] + c];
+		}
+
+		/* Weighted sum */
+		for (unsigned int i = 0; i < VDEF_PRIV_CHUNK;
+		     i += VDEF_PRIV_VEC_LEN) {
+			vdef_priv_v8f32 sum = {0}, a, b;
+			for (unsigned int j = 0; j < 4; j++) {
+				memcpy(&a, &v[j][i], sizeof(a));
+				memcpy(&b, &w[j][i], sizeof(b));
+				sum += a * b;
+			}
+			memcpy(&out[c][i], &sum, sizeof(sum));
+		}
+	}
+}
+
+
+int vdef_lut3d_get(const struct vdef_format_info *src_info,
+		   const struct vdef_format_info *dst_info,
+		   unsigned int size,
+		   enum vdef_tone_map_method method,
+		   enum vdef_gamut_clip_method clip,
+		   const struct vdef_lut3d **ret_lut)
+{
+	int ret;
+	struct vdef_priv_lut3d_key key;
+	_Atomic(struct vdef_lut3d *) *bucket;
+	struct vdef_lut3d *lut, *head, *other;
+	uint32_t hash;
+
+	ULOG_ERRNO_RETURN_ERR_IF(src_info == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(dst_info == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(size != 17 && size != 33 && size != 65,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(method >= VDEF_TONE_MAP_METHOD_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(clip >= VDEF_GAMUT_CLIP_METHOD_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_lut == NULL, EINVAL);
+
+	key_init(&key, src_info, dst_info, size, method, clip);
+	hash = key_hash(&key);
+	bucket = &s_cache[hash % CACHE_BUCKETS];
+	head = atomic_load_explicit(bucket, memory_order_acquire);
+	lut = cache_find(head, NULL, &key, hash);
+	if (lut != NULL) {
+		*ret_lut = lut;
+		return 0;
+	}
+
+	lut = calloc(1, sizeof(*lut));
+	if (lut == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	lut->key = key;
+	lut->hash = hash;
+	lut->size = size;
+	lut->table = malloc((size_t)size * size * size * 3 *
+			    sizeof(*lut->table));
+	if (lut->table == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("malloc", -ret);
+		goto error;
+	}
+	ret = lut3d_bake(lut, src_info, dst_info);
+	if (ret < 0)
+		goto error;
+
+	/* Publish the table, unless another thread has published the same
+	 * table in the meantime (the tables inserted concurrently are between
+	 * the new bucket head and the previous one) */
+	lut->next = head;
+	while (!atomic_compare_exchange_weak_explicit(bucket,
+						      &lut->next,
+						      lut,
+						      memory_order_acq_rel,
+						      memory_order_acquire)) {
+		other = cache_find(lut->next, head, &key, hash);
+		if (other != NULL) {
+			lut3d_destroy(lut);
+			lut = other;
+			break;
+		}
+		head = lut->next;
+	}
+
+	*ret_lut = lut;
+	return 0;
+
+error:
+	lut3d_destroy(lut);
+	return ret;
+}
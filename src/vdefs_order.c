@@ -0,0 +1,326 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+#if defined(__clang__) && defined(__SSSE3__)
+#	include <tmmintrin.h>
+#elif defined(__clang__) && defined(__ARM_NEON) && defined(__aarch64__)
+#	include <arm_neon.h>
+#endif
+
+
+/* Vector size in bytes */
+#define BLOCK 16
+
+/* Maximum group size in bytes (4 components of 16-bit samples) */
+#define MAX_GROUP 8
+
+
+/* Position of the components in a group of samples; components are in
+ * canonical order: R, G, B, A for packed RGB formats and Y0, U, Y1, V for
+ * interleaved YUV 4:2:2 formats (a group is then a pair of pixels) */
+struct order_layout {
+	/* Number of samples in a group */
+	unsigned int count;
+
+	/* Position of each component in the group */
+	unsigned int pos[4];
+};
+
+
+/* Byte permutation between two layouts */
+struct order_map {
+	/* Group size in bytes */
+	unsigned int size;
+
+	/* Source byte of each byte of a group */
+	uint8_t idx[MAX_GROUP];
+
+	/* Bytes processed per vector (whole groups only) */
+	unsigned int block;
+
+	/* Source byte of each byte of a vector; bytes past the last whole
+	 * group are left in place */
+	vdef_priv_v16u8 mask;
+};
+
+
+/* Shuffle the bytes of a vector with a variable mask (pshufb on x86 and
+ * tbl on ARM; GCC selects the instruction from the target) */
+static inline __attribute__((always_inline)) vdef_priv_v16u8
+shuffle_bytes(vdef_priv_v16u8 v, vdef_priv_v16u8 mask)
+{
+#if !defined(__clang__)
+	return __builtin_shuffle(v, mask);
+#elif defined(__SSSE3__)
+	return (vdef_priv_v16u8)_mm_shuffle_epi8((__m128i)v, (__m128i)mask);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	return (vdef_priv_v16u8)vqtbl1q_u8((uint8x16_t)v, (uint8x16_t)mask);
+#else
+	vdef_priv_v16u8 r;
+	for (unsigned int i = 0; i < BLOCK; i++)
+		r[i] = v[mask[i] & (BLOCK - 1)];
+	return r;
+#endif
+}
+
+
+/* Permute the samples of a line; src and dst can be the same */
+VDEF_PRIV_TARGET_CLONES
+static void permute_line(const uint8_t *src,
+			 uint8_t *dst,
+			 size_t len,
+			 const struct order_map *map)
+{
+	size_t i = 0;
+
+	for (; i + BLOCK <= len; i += map->block) {
+		vdef_priv_v16u8 v;
+		memcpy(&v, src + i, sizeof(v));
+		v = shuffle_bytes(v, map->mask);
+		memcpy(dst + i, &v, sizeof(v));
+	}
+
+	for (; i + map->size <= len; i += map->size) {
+		uint8_t tmp[MAX_GROUP];
+		for (unsigned int j = 0; j < map->size; j++)
+			tmp[j] = src[i + map->idx[j]];
+		memcpy(dst + i, tmp, map->size);
+	}
+
+	/* Incomplete group (e.g. the last pixel of an odd width line of an
+	 * interleaved YUV 4:2:2 format) */
+	if (i < len && src != dst)
+		memcpy(dst + i, src + i, len - i);
+}
+
+
+/* Get the layout of the samples of a raw format; the pixel order is
+ * decoded from its value, so that any order is supported */
+static int get_order_layout(const struct vdef_raw_format *format,
+			    struct order_layout *layout)
+{
+	int ret;
+	unsigned int perm[4];
+	unsigned int luma, u_pos, v_pos;
+
+	if (format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR)
+		return -ENOTSUP;
+	if (format->data_size != 8 && format->data_size != 16)
+		return -ENOTSUP;
+	ret = vdef_priv_get_pix_order_perm(format->pix_order, perm);
+	if (ret < 0)
+		return -ENOTSUP;
+
+	switch (format->data_layout) {
+	case VDEF_RAW_DATA_LAYOUT_PACKED:
+		if (format->pix_format == VDEF_RAW_PIX_FORMAT_RGB24)
+			layout->count = 3;
+		else if (format->pix_format == VDEF_RAW_PIX_FORMAT_RGBA32)
+			layout->count = 4;
+		else
+			return -ENOTSUP;
+		for (unsigned int i = 0; i < layout->count; i++) {
+			if (perm[i] >= layout->count)
+				return -ENOTSUP;
+			layout->pos[perm[i]] = i;
+		}
+		return 0;
+
+	case VDEF_RAW_DATA_LAYOUT_INTERLEAVED:
+		if (format->pix_format != VDEF_RAW_PIX_FORMAT_YUV422)
+			return -ENOTSUP;
+		/* The first 3 positions give the Y, U and V order (e.g. YVU
+		 * for YVYU or UYV for UYVY); the luma samples alternate with
+		 * the chroma samples, so Y must be first or second */
+		luma = 3;
+		u_pos = v_pos = 0;
+		for (unsigned int i = 0; i < 3; i++) {
+			if (perm[i] == 0)
+				luma = i;
+			else if (perm[i] == 1)
+				u_pos = i;
+			else if (perm[i] == 2)
+				v_pos = i;
+			else
+				return -ENOTSUP;
+		}
+		if (luma > 1)
+			return -ENOTSUP;
+		layout->count = 4;
+		layout->pos[0] = luma;
+		layout->pos[2] = luma + 2;
+		layout->pos[1] = (1 - luma) + (u_pos < v_pos ? 0 : 2);
+		layout->pos[3] = (1 - luma) + (u_pos < v_pos ? 2 : 0);
+		return 0;
+
+	default:
+		return -ENOTSUP;
+	}
+}
+
+
+/* Build the byte permutation from the input to the output layout */
+static void init_order_map(const struct order_layout *in,
+			   const struct order_layout *out,
+			   unsigned int bytes,
+			   struct order_map *map)
+{
+	map->size = in->count * bytes;
+	map->block = BLOCK / map->size * map->size;
+
+	for (unsigned int c = 0; c < out->count; c++) {
+		for (unsigned int b = 0; b < bytes; b++) {
+			map->idx[out->pos[c] * bytes + b] =
+				in->pos[c] * bytes + b;
+		}
+	}
+
+	for (unsigned int i = 0; i < BLOCK; i++) {
+		if (i < map->block) {
+			map->mask[i] = i / map->size * map->size +
+				       map->idx[i % map->size];
+		} else {
+			map->mask[i] = i;
+		}
+	}
+}
+
+
+/* Formats must only differ by their pixel order */
+static bool is_order_compatible(const struct vdef_raw_format *f1,
+				const struct vdef_raw_format *f2)
+{
+	struct vdef_raw_format f = *f2;
+
+	f.pix_order = f1->pix_order;
+
+	return vdef_raw_format_cmp(f1, &f);
+}
+
+
+int vdef_priv_pix_order_check(const struct vdef_raw_format *in_format,
+			      const struct vdef_raw_format *out_format)
+{
+	int ret;
+	struct order_layout layout;
+
+	if (!is_order_compatible(in_format, out_format))
+		return -ENOTSUP;
+	ret = get_order_layout(in_format, &layout);
+	if (ret < 0)
+		return ret;
+	return get_order_layout(out_format, &layout);
+}
+
+
+static int permute_frame(const struct vdef_raw_frame *in_frame,
+			 const void *const *in_plane,
+			 const struct vdef_raw_frame *out_frame,
+			 void *const *out_plane,
+			 const struct vdef_raw_format *out_format)
+{
+	int ret;
+	struct order_layout in, out;
+	struct order_map map;
+	unsigned int samples, lines, bytes;
+
+	ret = vdef_priv_pix_order_check(&in_frame->format, out_format);
+	if (ret < 0)
+		return ret;
+	get_order_layout(&in_frame->format, &in);
+	get_order_layout(out_format, &out);
+
+	ret = vdef_priv_get_plane_samples(&in_frame->format,
+					  &in_frame->info.resolution,
+					  0,
+					  &samples,
+					  &lines);
+	if (ret < 0)
+		return ret;
+
+	bytes = in_frame->format.data_size / 8;
+	init_order_map(&in, &out, bytes, &map);
+	for (unsigned int y = 0; y < lines; y++) {
+		permute_line((const uint8_t *)in_plane[0] +
+				     y * in_frame->plane_stride[0],
+			     (uint8_t *)out_plane[0] +
+				     y * out_frame->plane_stride[0],
+			     (size_t)samples * bytes,
+			     &map);
+	}
+
+	return 0;
+}
+
+
+int vdef_convert_pix_order(const struct vdef_raw_frame *in_frame,
+			   const void *const *in_plane,
+			   const struct vdef_raw_frame *out_frame,
+			   void *const *out_plane)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	return permute_frame(
+		in_frame, in_plane, out_frame, out_plane, &out_frame->format);
+}
+
+
+int vdef_convert_pix_order_in_place(struct vdef_raw_frame *frame,
+				    void *const *plane,
+				    const struct vdef_raw_format *format)
+{
+	int ret;
+
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+
+	if (vdef_raw_format_cmp(&frame->format, format))
+		return 0;
+
+	ret = permute_frame(
+		frame, (const void *const *)plane, frame, plane, format);
+	if (ret < 0)
+		return ret;
+	frame->format = *format;
+
+	return 0;
+}
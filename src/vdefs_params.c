@@ -1092,6 +1092,245 @@ const float vdef_yuv_to_rgb_norm_matrix[VDEF_MATRIX_COEFS_MAX][2][9] = {
 /* clang-format on */
 
 
+/**
+ * Fixed-point representation (for 8, 10 and 12-bit values)
+ */
+
+/* Bit depth of an enum vdef_fixed_depth value */
+#define VDEF_FIXED_DEPTH(_d) (8 + 2 * (_d))
+
+/* Convert a float value to fixed-point, rounded to nearest */
+#define VDEF_FIXED(_x, _shift)                                                 \
+	((int32_t)((_x) * (float)(1 << (_shift)) + ((_x) < 0.f ? -0.5f : 0.5f)))
+
+/* Ratio between the n-bit full scale and the n-bit scale of normalized
+ * 8-bit limited range values (i.e. (2^n - 1) / (255 * 2^(n - 8))) */
+#define VDEF_FIXED_LIMITED_SCALE(_d)                                           \
+	((float)((1 << VDEF_FIXED_DEPTH(_d)) - 1) /                            \
+	 (float)(255 << (VDEF_FIXED_DEPTH(_d) - 8)))
+
+/* Offsets: luma minimum (or 0 for full range) and chroma zero values
+ * shifted to the bit depth */
+#define VDEF_FIXED_OFFSET(_sign, _luma_min, _chroma_zero, _d)                  \
+	{                                                                      \
+		_sign((_luma_min) << (VDEF_FIXED_DEPTH(_d) - 8)),              \
+		_sign((_chroma_zero) << (VDEF_FIXED_DEPTH(_d) - 8)),           \
+		_sign((_chroma_zero) << (VDEF_FIXED_DEPTH(_d) - 8)),           \
+	}
+
+#define VDEF_FIXED_OFFSETS(_sign, _std)                                        \
+	{                                                                      \
+		{                                                              \
+			/* Limited range */                                    \
+			VDEF_FIXED_OFFSET(_sign, _std##_LUMA_MIN, _std##_CHROMA_ZERO, VDEF_FIXED_DEPTH_8), \
+			VDEF_FIXED_OFFSET(_sign, _std##_LUMA_MIN, _std##_CHROMA_ZERO, VDEF_FIXED_DEPTH_10), \
+			VDEF_FIXED_OFFSET(_sign, _std##_LUMA_MIN, _std##_CHROMA_ZERO, VDEF_FIXED_DEPTH_12), \
+		},                                                             \
+		{                                                              \
+			/* Full range */                                       \
+			VDEF_FIXED_OFFSET(_sign, 0, _std##_CHROMA_ZERO, VDEF_FIXED_DEPTH_8), \
+			VDEF_FIXED_OFFSET(_sign, 0, _std##_CHROMA_ZERO, VDEF_FIXED_DEPTH_10), \
+			VDEF_FIXED_OFFSET(_sign, 0, _std##_CHROMA_ZERO, VDEF_FIXED_DEPTH_12), \
+		},                                                             \
+	}
+
+/* Identity matrix with a scale applied */
+#define VDEF_FIXED_IDENTITY(_scale, _shift)                                    \
+	{                                                                      \
+		VDEF_FIXED(_scale, _shift), 0, 0,                              \
+		0, VDEF_FIXED(_scale, _shift), 0,                              \
+		0, 0, VDEF_FIXED(_scale, _shift),                              \
+	}
+
+/* Identity matrices; like the normalized values tables, no range conversion
+ * is done, so limited range values are only scaled to the bit depth */
+#define VDEF_FIXED_IDENTITIES(_op, _shift)                                     \
+	{                                                                      \
+		{                                                              \
+			/* Limited range */                                    \
+			VDEF_FIXED_IDENTITY(1.f _op VDEF_FIXED_LIMITED_SCALE(VDEF_FIXED_DEPTH_8), _shift), \
+			VDEF_FIXED_IDENTITY(1.f _op VDEF_FIXED_LIMITED_SCALE(VDEF_FIXED_DEPTH_10), _shift), \
+			VDEF_FIXED_IDENTITY(1.f _op VDEF_FIXED_LIMITED_SCALE(VDEF_FIXED_DEPTH_12), _shift), \
+		},                                                             \
+		{                                                              \
+			/* Full range */                                       \
+			VDEF_FIXED_IDENTITY(1.f, _shift),                      \
+			VDEF_FIXED_IDENTITY(1.f, _shift),                      \
+			VDEF_FIXED_IDENTITY(1.f, _shift),                      \
+		},                                                             \
+	}
+
+/* YUV to RGB matrix with scales applied on the luma (_ls) and chroma (_cs)
+ * input columns */
+#define VDEF_YUV2RGB_FIXED_MAT(_std, _ls, _cs)                                 \
+	{                                                                      \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_11(_std##_MAT_KR, _std##_MAT_KB) * (_ls), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_21(_std##_MAT_KR, _std##_MAT_KB) * (_ls), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_31(_std##_MAT_KR, _std##_MAT_KB) * (_ls), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_12(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_22(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_32(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_13(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_23(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_YUV2RGB_MAT_33(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_YUV_TO_RGB_FIXED_SHIFT), \
+	}
+
+#define VDEF_YUV2RGB_FIXED_MAT_LIMITED(_std, _d)                               \
+	VDEF_YUV2RGB_FIXED_MAT(_std,                                           \
+			       255.f / (float)_std##_LUMA_RANGE *              \
+				       VDEF_FIXED_LIMITED_SCALE(_d),           \
+			       255.f / (float)_std##_CHROMA_RANGE *            \
+				       VDEF_FIXED_LIMITED_SCALE(_d))
+
+#define VDEF_YUV2RGB_FIXED_MATS(_std)                                          \
+	{                                                                      \
+		{                                                              \
+			/* Limited range */                                    \
+			VDEF_YUV2RGB_FIXED_MAT_LIMITED(_std, VDEF_FIXED_DEPTH_8), \
+			VDEF_YUV2RGB_FIXED_MAT_LIMITED(_std, VDEF_FIXED_DEPTH_10), \
+			VDEF_YUV2RGB_FIXED_MAT_LIMITED(_std, VDEF_FIXED_DEPTH_12), \
+		},                                                             \
+		{                                                              \
+			/* Full range */                                       \
+			VDEF_YUV2RGB_FIXED_MAT(_std, 1.f, 1.f),                \
+			VDEF_YUV2RGB_FIXED_MAT(_std, 1.f, 1.f),                \
+			VDEF_YUV2RGB_FIXED_MAT(_std, 1.f, 1.f),                \
+		},                                                             \
+	}
+
+/* RGB to YUV matrix with scales applied on the luma (_ls) and chroma (_cs)
+ * output rows */
+#define VDEF_RGB2YUV_FIXED_MAT(_std, _ls, _cs)                                 \
+	{                                                                      \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_11(_std##_MAT_KR, _std##_MAT_KB) * (_ls), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_21(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_31(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_12(_std##_MAT_KR, _std##_MAT_KB) * (_ls), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_22(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_32(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_13(_std##_MAT_KR, _std##_MAT_KB) * (_ls), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_23(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+		VDEF_FIXED(VDEF_RGB2YUV_MAT_33(_std##_MAT_KR, _std##_MAT_KB) * (_cs), VDEF_RGB_TO_YUV_FIXED_SHIFT), \
+	}
+
+#define VDEF_RGB2YUV_FIXED_MAT_LIMITED(_std, _d)                               \
+	VDEF_RGB2YUV_FIXED_MAT(_std,                                           \
+			       (float)_std##_LUMA_RANGE / 255.f /              \
+				       VDEF_FIXED_LIMITED_SCALE(_d),           \
+			       (float)_std##_CHROMA_RANGE / 255.f /            \
+				       VDEF_FIXED_LIMITED_SCALE(_d))
+
+#define VDEF_RGB2YUV_FIXED_MATS(_std)                                          \
+	{                                                                      \
+		{                                                              \
+			/* Limited range */                                    \
+			VDEF_RGB2YUV_FIXED_MAT_LIMITED(_std, VDEF_FIXED_DEPTH_8), \
+			VDEF_RGB2YUV_FIXED_MAT_LIMITED(_std, VDEF_FIXED_DEPTH_10), \
+			VDEF_RGB2YUV_FIXED_MAT_LIMITED(_std, VDEF_FIXED_DEPTH_12), \
+		},                                                             \
+		{                                                              \
+			/* Full range */                                       \
+			VDEF_RGB2YUV_FIXED_MAT(_std, 1.f, 1.f),                \
+			VDEF_RGB2YUV_FIXED_MAT(_std, 1.f, 1.f),                \
+			VDEF_RGB2YUV_FIXED_MAT(_std, 1.f, 1.f),                \
+		},                                                             \
+	}
+
+
+/**
+ * RGB to YUV conversion offsets for integer values for both limited and
+ * full range and 8, 10 and 12-bit depths (RGB and YUV values have the same
+ * bit depth).
+ * Note: the matrix multiplication must be done before applying the offset:
+ * YUV = ((RGB * mat + (1 << (VDEF_RGB_TO_YUV_FIXED_SHIFT - 1))) >>
+ *        VDEF_RGB_TO_YUV_FIXED_SHIFT) + off
+ * so that for example in 10-bit limited range the values of luminance are in
+ * the range [64 .. 940] and the values of chrominance are in the range
+ * [64 .. 960].
+ * Note: this table is a negative of vdef_yuv_to_rgb_fixed_offset.
+ */
+/* clang-format off */
+const int32_t vdef_rgb_to_yuv_fixed_offset[VDEF_MATRIX_COEFS_MAX][2]
+					  [VDEF_FIXED_DEPTH_MAX][3] = {
+	/* VDEF_MATRIX_COEFS_UNKNOWN and VDEF_MATRIX_COEFS_SRGB
+	 * (same as VDEF_MATRIX_COEFS_IDENTITY) have null offsets */
+	[VDEF_MATRIX_COEFS_BT601_525] = VDEF_FIXED_OFFSETS(+, VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT601_625] = VDEF_FIXED_OFFSETS(+, VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT709] = VDEF_FIXED_OFFSETS(+, VDEF_BT709),
+	[VDEF_MATRIX_COEFS_BT2020_NON_CST] = VDEF_FIXED_OFFSETS(+, VDEF_BT2020),
+	[VDEF_MATRIX_COEFS_BT2020_CST] = VDEF_FIXED_OFFSETS(+, VDEF_BT2020),
+};
+/* clang-format on */
+
+
+/**
+ * RGB to YUV conversion matrix for integer values for both limited and
+ * full range and 8, 10 and 12-bit depths (RGB and YUV values have the same
+ * bit depth).
+ * The coefficients have VDEF_RGB_TO_YUV_FIXED_SHIFT fractional bits and the
+ * matrix is in column-major order, like vdef_rgb_to_yuv_norm_matrix.
+ */
+/* clang-format off */
+const int32_t vdef_rgb_to_yuv_fixed_matrix[VDEF_MATRIX_COEFS_MAX][2]
+					  [VDEF_FIXED_DEPTH_MAX][9] = {
+	/* VDEF_MATRIX_COEFS_UNKNOWN has a null matrix */
+	[VDEF_MATRIX_COEFS_SRGB] =
+		VDEF_FIXED_IDENTITIES(/, VDEF_RGB_TO_YUV_FIXED_SHIFT),
+	[VDEF_MATRIX_COEFS_BT601_525] = VDEF_RGB2YUV_FIXED_MATS(VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT601_625] = VDEF_RGB2YUV_FIXED_MATS(VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT709] = VDEF_RGB2YUV_FIXED_MATS(VDEF_BT709),
+	[VDEF_MATRIX_COEFS_BT2020_NON_CST] = VDEF_RGB2YUV_FIXED_MATS(VDEF_BT2020),
+	[VDEF_MATRIX_COEFS_BT2020_CST] = VDEF_RGB2YUV_FIXED_MATS(VDEF_BT2020),
+};
+/* clang-format on */
+
+
+/**
+ * YUV to RGB conversion offsets for integer values for both limited and
+ * full range and 8, 10 and 12-bit depths (RGB and YUV values have the same
+ * bit depth).
+ * Note: the matrix multiplication must be done after applying the offset:
+ * RGB = ((YUV + off) * mat + (1 << (VDEF_YUV_TO_RGB_FIXED_SHIFT - 1))) >>
+ *       VDEF_YUV_TO_RGB_FIXED_SHIFT
+ * and the result must be clamped to the bit depth range.
+ * Note: this table is a negative of vdef_rgb_to_yuv_fixed_offset.
+ */
+/* clang-format off */
+const int32_t vdef_yuv_to_rgb_fixed_offset[VDEF_MATRIX_COEFS_MAX][2]
+					  [VDEF_FIXED_DEPTH_MAX][3] = {
+	/* VDEF_MATRIX_COEFS_UNKNOWN and VDEF_MATRIX_COEFS_SRGB
+	 * (same as VDEF_MATRIX_COEFS_IDENTITY) have null offsets */
+	[VDEF_MATRIX_COEFS_BT601_525] = VDEF_FIXED_OFFSETS(-, VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT601_625] = VDEF_FIXED_OFFSETS(-, VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT709] = VDEF_FIXED_OFFSETS(-, VDEF_BT709),
+	[VDEF_MATRIX_COEFS_BT2020_NON_CST] = VDEF_FIXED_OFFSETS(-, VDEF_BT2020),
+	[VDEF_MATRIX_COEFS_BT2020_CST] = VDEF_FIXED_OFFSETS(-, VDEF_BT2020),
+};
+/* clang-format on */
+
+
+/**
+ * YUV to RGB conversion matrix for integer values for both limited and
+ * full range and 8, 10 and 12-bit depths (RGB and YUV values have the same
+ * bit depth).
+ * The coefficients have VDEF_YUV_TO_RGB_FIXED_SHIFT fractional bits and the
+ * matrix is in column-major order, like vdef_yuv_to_rgb_norm_matrix.
+ */
+/* clang-format off */
+const int32_t vdef_yuv_to_rgb_fixed_matrix[VDEF_MATRIX_COEFS_MAX][2]
+					  [VDEF_FIXED_DEPTH_MAX][9] = {
+	/* VDEF_MATRIX_COEFS_UNKNOWN has a null matrix */
+	[VDEF_MATRIX_COEFS_SRGB] =
+		VDEF_FIXED_IDENTITIES(*, VDEF_YUV_TO_RGB_FIXED_SHIFT),
+	[VDEF_MATRIX_COEFS_BT601_525] = VDEF_YUV2RGB_FIXED_MATS(VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT601_625] = VDEF_YUV2RGB_FIXED_MATS(VDEF_BT601),
+	[VDEF_MATRIX_COEFS_BT709] = VDEF_YUV2RGB_FIXED_MATS(VDEF_BT709),
+	[VDEF_MATRIX_COEFS_BT2020_NON_CST] = VDEF_YUV2RGB_FIXED_MATS(VDEF_BT2020),
+	[VDEF_MATRIX_COEFS_BT2020_CST] = VDEF_YUV2RGB_FIXED_MATS(VDEF_BT2020),
+};
+/* clang-format on */
+
+
 /**
  * BT.709 to BT.2020 conversion matrix for linearly represented, normalized
  * RGB values.
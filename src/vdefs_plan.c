@@ -0,0 +1,904 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Maximum number of steps: detiling and unpacking of the input, two
+ * conversion steps, and packing and tiling of the output */
+#define MAX_STEPS 6
+
+/* Size budget of the intermediate frames of a band, so that they stay in a
+ * typical L2 cache while the band goes through all the steps */
+#define BAND_BUFFER_SIZE (256 * 1024)
+
+/* Band height limits (in lines) */
+#define MIN_BAND_HEIGHT 16
+#define MAX_BAND_HEIGHT 64
+
+/* Plane stride and size alignment of the intermediate frames (cache
+ * line) */
+#define BUFFER_ALIGN 64
+
+
+struct plan_step {
+	enum vdef_convert_step step;
+
+	/* Input and output frames format and info (the resolution is the
+	 * full frame resolution) */
+	struct vdef_raw_frame in;
+	struct vdef_raw_frame out;
+
+	/* Prepared color conversion (VDEF_CONVERT_STEP_GAMUT and
+	 * VDEF_CONVERT_STEP_TONE_MAP only) */
+	struct vdef_priv_gamut *gamut;
+
+	/* Layout of the output intermediate frame of a band and offset in
+	 * the band buffer (all steps but the last one) */
+	struct vdef_raw_layout layout;
+	size_t offset;
+
+	/* Estimated bytes read and written for a frame */
+	size_t bytes;
+};
+
+
+struct vdef_convert_plan {
+	/* Input and output frames format and info */
+	struct vdef_raw_frame in;
+	struct vdef_raw_frame out;
+
+	unsigned int step_count;
+	struct plan_step steps[MAX_STEPS];
+
+	/* Bands of lines (see vdef_calc_raw_frame_bands()) */
+	unsigned int band_height;
+	unsigned int band_count;
+
+	/* Size of the intermediate frames of a band */
+	size_t buffer_size;
+};
+
+
+/* Conversion of a frame */
+struct plan_run {
+	const struct vdef_convert_plan *plan;
+	const struct vdef_raw_frame *in_frame;
+	const void *const *in_plane;
+	const struct vdef_raw_frame *out_frame;
+	void *const *out_plane;
+
+	/* Per-thread intermediate frames */
+	uint8_t *buffers;
+};
+
+
+static bool is_yuv(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_YUV420 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_YUV422 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_YUV444;
+}
+
+
+static bool is_rgb(const struct vdef_raw_format *format)
+{
+	return format->pix_format == VDEF_RAW_PIX_FORMAT_RGB24 ||
+	       format->pix_format == VDEF_RAW_PIX_FORMAT_RGBA32;
+}
+
+
+/* Linear 8-bit or 16-bit samples, as read and written by the color
+ * conversion steps */
+static bool is_sample_data(const struct vdef_raw_format *format)
+{
+	return format->pix_layout == VDEF_RAW_PIX_LAYOUT_LINEAR &&
+	       (format->data_size == 8 || format->data_size == 16);
+}
+
+
+static bool is_hdr(const struct vdef_frame_info *info)
+{
+	return info->tone_mapping == VDEF_TONE_MAPPING_P_LOG ||
+	       info->transfer_function == VDEF_TRANSFER_FUNCTION_PQ;
+}
+
+
+/* Tone mapping from PQ or P-log to an SDR transfer function (see
+ * vdef_tone_map()) */
+static bool is_tone_map(const struct vdef_frame_info *in,
+			const struct vdef_frame_info *out)
+{
+	return is_hdr(in) && !is_hdr(out) &&
+	       out->transfer_function != VDEF_TRANSFER_FUNCTION_HLG;
+}
+
+
+/* Same color primaries and transfer function (the P-log curve replaces the
+ * transfer function) */
+static bool is_same_transfer(const struct vdef_frame_info *in,
+			     const struct vdef_frame_info *out)
+{
+	bool p_log = in->tone_mapping == VDEF_TONE_MAPPING_P_LOG;
+
+	if (in->color_primaries != out->color_primaries ||
+	    p_log != (out->tone_mapping == VDEF_TONE_MAPPING_P_LOG))
+		return false;
+	return p_log || in->transfer_function == out->transfer_function;
+}
+
+
+/* Same colors for a format, so that only the sample storage and layout can
+ * change */
+static bool is_same_color(const struct vdef_raw_format *format,
+			  const struct vdef_frame_info *in,
+			  const struct vdef_frame_info *out)
+{
+	if (!is_same_transfer(in, out))
+		return false;
+	return !is_yuv(format) || (in->matrix_coefs == out->matrix_coefs &&
+				   in->full_range == out->full_range);
+}
+
+
+/* Tiled pixel layout, converted by the PIX_LAYOUT step (the MIPI CSI-2
+ * packing is a sample storage, converted by the RAW_DATA step) */
+static bool is_tiled(const struct vdef_raw_format *format)
+{
+	return format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR &&
+	       format->pix_layout != VDEF_RAW_PIX_LAYOUT_MIPI_CSI2;
+}
+
+
+/* Get the 16-bit samples format of a packed data format, with the storage
+ * of another 16-bit format if possible (to avoid a storage conversion) */
+static void get_unpacked(const struct vdef_raw_format *format,
+			 const struct vdef_raw_format *other,
+			 struct vdef_raw_format *unpacked)
+{
+	*unpacked = *format;
+	if (unpacked->pix_layout == VDEF_RAW_PIX_LAYOUT_MIPI_CSI2)
+		unpacked->pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR;
+	unpacked->data_size = 16;
+	unpacked->data_pad_low = false;
+	unpacked->data_little_endian = true;
+	if (other->data_size == 16 && other->pix_size == format->pix_size) {
+		unpacked->data_pad_low = other->data_pad_low;
+		unpacked->data_little_endian = other->data_little_endian;
+	}
+}
+
+
+/* Get the single step converting between two formats that only differ by
+ * their sample storage or layout */
+static int get_direct_step(const struct vdef_raw_format *in,
+			   const struct vdef_raw_format *out,
+			   enum vdef_convert_step *step)
+{
+	if (vdef_priv_pix_layout_check(in, out) == 0)
+		*step = VDEF_CONVERT_STEP_PIX_LAYOUT;
+	else if (vdef_priv_raw_data_check(in, out) == 0)
+		*step = VDEF_CONVERT_STEP_RAW_DATA;
+	else if (vdef_priv_pix_order_check(in, out) == 0)
+		*step = VDEF_CONVERT_STEP_PIX_ORDER;
+	else if (vdef_priv_yuv_chroma_check(in, out) == 0)
+		*step = VDEF_CONVERT_STEP_YUV_CHROMA;
+	else
+		return -ENOTSUP;
+
+	return 0;
+}
+
+
+static const struct vdef_raw_frame *
+last_frame(const struct vdef_convert_plan *plan)
+{
+	if (plan->step_count == 0)
+		return &plan->in;
+	return &plan->steps[plan->step_count - 1].out;
+}
+
+
+/* Append a step converting the last frame of the plan to a format; the
+ * output info is the last frame info if info is NULL */
+static struct plan_step *add_step(struct vdef_convert_plan *plan,
+				  enum vdef_convert_step step,
+				  const struct vdef_raw_format *format,
+				  const struct vdef_frame_info *info)
+{
+	struct plan_step *s = &plan->steps[plan->step_count];
+
+	s->step = step;
+	s->in = *last_frame(plan);
+	s->out = s->in;
+	s->out.format = *format;
+	if (info != NULL)
+		s->out.info = *info;
+	plan->step_count++;
+
+	return s;
+}
+
+
+/* Append the steps (at most 2) converting the last frame of the plan to a
+ * format that only differs by its sample storage or layout; nothing is
+ * appended on error */
+static int add_layout_steps(struct vdef_convert_plan *plan,
+			    const struct vdef_raw_format *format)
+{
+	const struct vdef_raw_format *cur = &last_frame(plan)->format;
+	struct vdef_raw_format f;
+	enum vdef_convert_step step;
+
+	if (vdef_raw_format_cmp(cur, format))
+		return 0;
+	if (get_direct_step(cur, format, &step) == 0) {
+		add_step(plan, step, format, NULL);
+		return 0;
+	}
+
+	/* Sample storage conversion first */
+	f = *cur;
+	f.data_size = format->data_size;
+	f.data_pad_low = format->data_pad_low;
+	f.data_little_endian = format->data_little_endian;
+	if (vdef_priv_raw_data_check(cur, &f) == 0 &&
+	    get_direct_step(&f, format, &step) == 0) {
+		add_step(plan, VDEF_CONVERT_STEP_RAW_DATA, &f, NULL);
+		add_step(plan, step, format, NULL);
+		return 0;
+	}
+
+	/* Sample storage conversion last */
+	f = *format;
+	f.data_size = cur->data_size;
+	f.data_pad_low = cur->data_pad_low;
+	f.data_little_endian = cur->data_little_endian;
+	if (get_direct_step(cur, &f, &step) == 0 &&
+	    vdef_priv_raw_data_check(&f, format) == 0) {
+		add_step(plan, step, &f, NULL);
+		add_step(plan, VDEF_CONVERT_STEP_RAW_DATA, format, NULL);
+		return 0;
+	}
+
+	return -ENOTSUP;
+}
+
+
+/* Check that a format can be read and written by the YUV to RGB and RGB to
+ * YUV conversion steps */
+static int check_comp_layout(const struct vdef_raw_format *format)
+{
+	int ret;
+	struct vdef_priv_comp comp[4];
+	struct vdef_priv_sample_fmt fmt;
+	unsigned int count;
+
+	ret = vdef_priv_get_comp_layout(format, comp, &count);
+	if (ret < 0)
+		return ret;
+	return vdef_priv_get_sample_fmt(format, &fmt);
+}
+
+
+/* Append the color conversion step from the last frame of the plan to the
+ * output info and a format of linear samples */
+static int add_color_step(struct vdef_convert_plan *plan,
+			  const struct vdef_raw_format *format,
+			  const struct vdef_format_info *hdr_info,
+			  enum vdef_tone_map_method method,
+			  enum vdef_gamut_clip_method clip)
+{
+	int ret;
+	const struct vdef_raw_frame *in = last_frame(plan);
+	const struct vdef_frame_info *out_info = &plan->out.info;
+	struct vdef_raw_frame out = plan->out;
+	struct vdef_priv_gamut *gamut = NULL;
+	enum vdef_convert_step step = VDEF_CONVERT_STEP_GAMUT;
+	enum vdef_matrix_coefs matrix;
+	bool tone_map;
+
+	if ((!is_yuv(&in->format) && !is_rgb(&in->format)) ||
+	    (!is_yuv(format) && !is_rgb(format)))
+		return -ENOTSUP;
+	out.format = *format;
+
+	/* Without color change, YUV to RGB and RGB to YUV conversions only
+	 * need the matrix */
+	tone_map = is_tone_map(&in->info, out_info);
+	if (tone_map) {
+		step = VDEF_CONVERT_STEP_TONE_MAP;
+	} else if (is_same_transfer(&in->info, out_info) &&
+		   is_yuv(&in->format) != is_yuv(format)) {
+		step = is_yuv(format) ? VDEF_CONVERT_STEP_RGB_TO_YUV
+				      : VDEF_CONVERT_STEP_YUV_TO_RGB;
+	}
+
+	if (step == VDEF_CONVERT_STEP_GAMUT ||
+	    step == VDEF_CONVERT_STEP_TONE_MAP) {
+		ret = vdef_priv_gamut_new(
+			in, &out, tone_map, hdr_info, method, clip, &gamut);
+		if (ret < 0)
+			return ret;
+	} else {
+		matrix = is_yuv(format) ? out_info->matrix_coefs
+					: in->info.matrix_coefs;
+		ULOG_ERRNO_RETURN_ERR_IF(matrix == VDEF_MATRIX_COEFS_UNKNOWN,
+					 EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(matrix >= VDEF_MATRIX_COEFS_MAX,
+					 EINVAL);
+		ret = check_comp_layout(&in->format);
+		if (ret < 0)
+			return ret;
+		ret = check_comp_layout(format);
+		if (ret < 0)
+			return ret;
+	}
+
+	add_step(plan, step, format, out_info)->gamut = gamut;
+	return 0;
+}
+
+
+/* Build the shortest chain of steps from the input to the output */
+static int plan_compile(struct vdef_convert_plan *plan,
+			const struct vdef_format_info *hdr_info,
+			enum vdef_tone_map_method method,
+			enum vdef_gamut_clip_method clip)
+{
+	int ret;
+	const struct vdef_raw_format *in = &plan->in.format;
+	const struct vdef_raw_format *out = &plan->out.format;
+	const struct vdef_raw_format *cur;
+	struct vdef_raw_format linear, dst, mid, f;
+	bool same_color = is_same_color(in, &plan->in.info, &plan->out.info);
+
+	/* Storage or layout change only */
+	if (same_color && add_layout_steps(plan, out) == 0)
+		goto out;
+
+	/* Linear input and output */
+	if (is_tiled(in)) {
+		linear = *in;
+		linear.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR;
+		ret = vdef_priv_pix_layout_check(in, &linear);
+		if (ret < 0)
+			return ret;
+		add_step(plan, VDEF_CONVERT_STEP_PIX_LAYOUT, &linear, NULL);
+	}
+	dst = *out;
+	if (is_tiled(out)) {
+		dst.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR;
+		ret = vdef_priv_pix_layout_check(&dst, out);
+		if (ret < 0)
+			return ret;
+	}
+	if (same_color && add_layout_steps(plan, &dst) == 0)
+		goto output;
+
+	/* Unpacked input and output samples */
+	cur = &last_frame(plan)->format;
+	if (!is_sample_data(cur)) {
+		get_unpacked(cur, &dst, &f);
+		ret = vdef_priv_raw_data_check(cur, &f);
+		if (ret < 0)
+			return ret;
+		add_step(plan, VDEF_CONVERT_STEP_RAW_DATA, &f, NULL);
+		cur = &last_frame(plan)->format;
+	}
+	mid = dst;
+	if (!is_sample_data(&dst)) {
+		get_unpacked(&dst, cur, &mid);
+		ret = vdef_priv_raw_data_check(&mid, &dst);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* Conversion */
+	if (!same_color || add_layout_steps(plan, &mid) < 0) {
+		ret = add_color_step(plan, &mid, hdr_info, method, clip);
+		if (ret < 0)
+			return ret;
+	}
+	if (!vdef_raw_format_cmp(&mid, &dst))
+		add_step(plan, VDEF_CONVERT_STEP_RAW_DATA, &dst, NULL);
+
+output:
+	if (!vdef_raw_format_cmp(&dst, out))
+		add_step(plan, VDEF_CONVERT_STEP_PIX_LAYOUT, out, NULL);
+
+out:
+	if (plan->step_count == 0) {
+		/* Only linear frames are copied line by line */
+		if (is_tiled(in))
+			return -ENOTSUP;
+		add_step(plan, VDEF_CONVERT_STEP_COPY, out, NULL);
+	}
+	plan->steps[plan->step_count - 1].out = plan->out;
+
+	return 0;
+}
+
+
+/* Choose the bands height and lay out the intermediate frames of a band */
+static int plan_init_bands(struct vdef_convert_plan *plan)
+{
+	int ret;
+	const unsigned int align[VDEF_RAW_MAX_PLANE_COUNT] = {
+		BUFFER_ALIGN, BUFFER_ALIGN, BUFFER_ALIGN, BUFFER_ALIGN};
+	struct vdef_dim res = plan->in.info.resolution;
+	unsigned int band_align, height;
+	size_t line_size = 0;
+	struct vdef_raw_layout layout;
+
+	/* The bands start on a whole line (or row of tiles) of every plane
+	 * of all the steps */
+	ret = vdef_get_raw_frame_band_align(&plan->in.format, &band_align);
+	if (ret < 0)
+		return ret;
+	for (unsigned int i = 0; i < plan->step_count; i++) {
+		struct plan_step *s = &plan->steps[i];
+		unsigned int a;
+
+		ret = vdef_get_raw_frame_band_align(&s->out.format, &a);
+		if (ret < 0)
+			return ret;
+		if (a > band_align)
+			band_align = a;
+
+		ret = vdef_calc_raw_layout(
+			&s->in.format, &res, NULL, NULL, NULL, &layout);
+		if (ret < 0)
+			return ret;
+		s->bytes = layout.size;
+		ret = vdef_calc_raw_layout(
+			&s->out.format, &res, NULL, NULL, NULL, &layout);
+		if (ret < 0)
+			return ret;
+		s->bytes += layout.size;
+
+		if (i + 1 == plan->step_count)
+			continue;
+		ret = vdef_calc_raw_layout(&s->out.format,
+					   &(struct vdef_dim){res.width,
+							      MIN_BAND_HEIGHT},
+					   align,
+					   NULL,
+					   NULL,
+					   &layout);
+		if (ret < 0)
+			return ret;
+		line_size += layout.size / MIN_BAND_HEIGHT;
+	}
+
+	height = line_size > 0 ? BAND_BUFFER_SIZE / line_size : MAX_BAND_HEIGHT;
+	if (height < MIN_BAND_HEIGHT)
+		height = MIN_BAND_HEIGHT;
+	else if (height > MAX_BAND_HEIGHT)
+		height = MAX_BAND_HEIGHT;
+	height = height / band_align * band_align;
+	if (height == 0)
+		height = band_align;
+	ret = vdef_calc_raw_frame_bands(
+		&plan->in.format, &res, &height, &plan->band_count);
+	if (ret < 0)
+		return ret;
+	plan->band_height = height;
+
+	/* The intermediate frames are sized for a whole band */
+	res.height = height;
+	plan->buffer_size = 0;
+	for (unsigned int i = 0; i + 1 < plan->step_count; i++) {
+		struct plan_step *s = &plan->steps[i];
+		ret = vdef_calc_raw_layout(
+			&s->out.format, &res, align, NULL, align, &s->layout);
+		if (ret < 0)
+			return ret;
+		s->offset = plan->buffer_size;
+		plan->buffer_size += s->layout.size;
+	}
+
+	return 0;
+}
+
+
+int vdef_convert_plan_new(const struct vdef_raw_format *in_format,
+			  const struct vdef_format_info *in_info,
+			  const struct vdef_raw_format *out_format,
+			  const struct vdef_format_info *out_info,
+			  enum vdef_tone_map_method method,
+			  enum vdef_gamut_clip_method clip,
+			  struct vdef_convert_plan **ret_obj)
+{
+	int ret;
+	struct vdef_convert_plan *plan;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_info == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_info == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(method >= VDEF_TONE_MAP_METHOD_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(clip >= VDEF_GAMUT_CLIP_METHOD_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(vdef_dim_is_null(&in_info->resolution),
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_dim_cmp(&in_info->resolution, &out_info->resolution),
+		EINVAL);
+
+	plan = calloc(1, sizeof(*plan));
+	if (plan == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	plan->in.format = *in_format;
+	vdef_format_to_frame_info(in_info, &plan->in.info);
+	plan->out.format = *out_format;
+	vdef_format_to_frame_info(out_info, &plan->out.info);
+
+	ret = plan_compile(plan, in_info, method, clip);
+	if (ret < 0)
+		goto error;
+	ret = plan_init_bands(plan);
+	if (ret < 0)
+		goto error;
+
+	*ret_obj = plan;
+	return 0;
+
+error:
+	vdef_convert_plan_destroy(plan);
+	return ret;
+}
+
+
+int vdef_convert_plan_destroy(struct vdef_convert_plan *plan)
+{
+	if (plan == NULL)
+		return 0;
+
+	for (unsigned int i = 0; i < plan->step_count; i++)
+		vdef_priv_gamut_destroy(plan->steps[i].gamut);
+	free(plan);
+
+	return 0;
+}
+
+
+unsigned int
+vdef_convert_plan_get_step_count(const struct vdef_convert_plan *plan)
+{
+	return plan != NULL ? plan->step_count : 0;
+}
+
+
+int vdef_convert_plan_get_step(const struct vdef_convert_plan *plan,
+			       unsigned int index,
+			       struct vdef_convert_plan_step *step)
+{
+	const struct plan_step *s;
+
+	ULOG_ERRNO_RETURN_ERR_IF(plan == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(index >= plan->step_count, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(step == NULL, EINVAL);
+
+	s = &plan->steps[index];
+	step->step = s->step;
+	step->in_format = s->in.format;
+	step->out_format = s->out.format;
+	step->bytes = s->bytes;
+
+	return 0;
+}
+
+
+ssize_t vdef_convert_plan_get_bytes(const struct vdef_convert_plan *plan)
+{
+	size_t bytes = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(plan == NULL, EINVAL);
+
+	for (unsigned int i = 0; i < plan->step_count; i++)
+		bytes += plan->steps[i].bytes;
+
+	return bytes;
+}
+
+
+unsigned int
+vdef_convert_plan_get_band_height(const struct vdef_convert_plan *plan)
+{
+	return plan != NULL ? plan->band_height : 0;
+}
+
+
+/* Get a view of a band of lines of a frame, with the format and info of
+ * a step frame */
+static void band_view(const struct vdef_raw_frame *step_frame,
+		      const size_t *stride,
+		      const void *const *plane,
+		      unsigned int y,
+		      unsigned int height,
+		      struct vdef_raw_frame *view,
+		      void **view_plane)
+{
+	const struct vdef_raw_format *format = &step_frame->format;
+	struct vdef_dim top = {step_frame->info.resolution.width, y};
+	unsigned int count = vdef_get_raw_frame_plane_count(format);
+
+	*view = *step_frame;
+	view->info.resolution.height = height;
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		unsigned int samples, lines = 0;
+		view->plane_stride[i] = i < count ? stride[i] : 0;
+		view_plane[i] = NULL;
+		if (i >= count)
+			continue;
+		/* The band start is aligned on a whole line in every plane */
+		vdef_priv_get_plane_samples(format, &top, i, &samples, &lines);
+		view_plane[i] = (uint8_t *)(uintptr_t)plane[i] +
+				(size_t)lines * stride[i];
+	}
+}
+
+
+/* Copy the planes of a linear frame */
+static int copy_frame(const struct vdef_raw_frame *in_frame,
+		      const void *const *in_plane,
+		      const struct vdef_raw_frame *out_frame,
+		      void *const *out_plane)
+{
+	int ret;
+	const struct vdef_raw_format *format = &in_frame->format;
+	unsigned int group_samples, group_bytes, count;
+
+	ret = vdef_get_raw_data_packing_group(
+		format, &group_samples, &group_bytes);
+	if (ret < 0)
+		return ret;
+
+	count = vdef_get_raw_frame_plane_count(format);
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int samples, lines;
+		size_t len;
+
+		ret = vdef_priv_get_plane_samples(format,
+						  &in_frame->info.resolution,
+						  i,
+						  &samples,
+						  &lines);
+		if (ret < 0)
+			return ret;
+		len = (size_t)VDEF_ROUND_UP(samples, group_samples) *
+		      group_bytes;
+		for (unsigned int y = 0; y < lines; y++) {
+			memcpy((uint8_t *)out_plane[i] +
+				       y * out_frame->plane_stride[i],
+			       (const uint8_t *)in_plane[i] +
+				       y * in_frame->plane_stride[i],
+			       len);
+		}
+	}
+
+	return 0;
+}
+
+
+static int run_step(const struct plan_step *s,
+		    const struct vdef_raw_frame *in_frame,
+		    const void *const *in_plane,
+		    const struct vdef_raw_frame *out_frame,
+		    void *const *out_plane)
+{
+	switch (s->step) {
+	case VDEF_CONVERT_STEP_COPY:
+		return copy_frame(in_frame, in_plane, out_frame, out_plane);
+	case VDEF_CONVERT_STEP_PIX_LAYOUT:
+		return vdef_convert_pix_layout(
+			in_frame, in_plane, out_frame, out_plane, NULL);
+	case VDEF_CONVERT_STEP_RAW_DATA:
+		return vdef_convert_raw_data(
+			in_frame, in_plane, out_frame, out_plane);
+	case VDEF_CONVERT_STEP_PIX_ORDER:
+		return vdef_convert_pix_order(
+			in_frame, in_plane, out_frame, out_plane);
+	case VDEF_CONVERT_STEP_YUV_CHROMA:
+		return vdef_convert_yuv_chroma(
+			in_frame, in_plane, out_frame, out_plane);
+	case VDEF_CONVERT_STEP_YUV_TO_RGB:
+		return vdef_convert_yuv_to_rgb(
+			in_frame, in_plane, out_frame, out_plane);
+	case VDEF_CONVERT_STEP_RGB_TO_YUV:
+		return vdef_convert_rgb_to_yuv(
+			in_frame, in_plane, out_frame, out_plane);
+	case VDEF_CONVERT_STEP_GAMUT:
+	case VDEF_CONVERT_STEP_TONE_MAP:
+		vdef_priv_gamut_run(
+			s->gamut, in_frame, in_plane, out_frame, out_plane);
+		return 0;
+	default:
+		return -EPROTO;
+	}
+}
+
+
+/* Run all the steps on a band of lines; the intermediate frames of the
+ * band are stored in the buffer of the thread */
+static int process_band(unsigned int band,
+			unsigned int thread_index,
+			void *userdata)
+{
+	int ret;
+	const struct plan_run *run = userdata;
+	const struct vdef_convert_plan *plan = run->plan;
+	uint8_t *buffer = run->buffers + thread_index * plan->buffer_size;
+	unsigned int y = band * plan->band_height;
+	unsigned int height = plan->band_height;
+	struct vdef_raw_frame in, out;
+	void *in_plane[VDEF_RAW_MAX_PLANE_COUNT];
+	void *out_plane[VDEF_RAW_MAX_PLANE_COUNT];
+
+	if (height > plan->in.info.resolution.height - y)
+		height = plan->in.info.resolution.height - y;
+
+	band_view(&plan->steps[0].in,
+		  run->in_frame->plane_stride,
+		  run->in_plane,
+		  y,
+		  height,
+		  &in,
+		  in_plane);
+	for (unsigned int i = 0; i < plan->step_count; i++) {
+		const struct plan_step *s = &plan->steps[i];
+
+		if (i + 1 == plan->step_count) {
+			band_view(&s->out,
+				  run->out_frame->plane_stride,
+				  (const void *const *)run->out_plane,
+				  y,
+				  height,
+				  &out,
+				  out_plane);
+		} else {
+			void *base[VDEF_RAW_MAX_PLANE_COUNT];
+			vdef_raw_layout_get_planes(&s->layout,
+						   buffer + s->offset,
+						   s->layout.size,
+						   base);
+			band_view(&s->out,
+				  s->layout.plane_stride,
+				  (const void *const *)base,
+				  0,
+				  height,
+				  &out,
+				  out_plane);
+		}
+
+		ret = run_step(s,
+			       &in,
+			       (const void *const *)in_plane,
+			       &out,
+			       out_plane);
+		if (ret < 0)
+			return ret;
+
+		/* The output of a step is the input of the next one */
+		in = out;
+		memcpy(in_plane, out_plane, sizeof(in_plane));
+	}
+
+	return 0;
+}
+
+
+int vdef_convert_plan_run(const struct vdef_convert_plan *plan,
+			  const struct vdef_raw_frame *in_frame,
+			  const void *const *in_plane,
+			  const struct vdef_raw_frame *out_frame,
+			  void *const *out_plane,
+			  struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct plan_run run;
+	size_t size;
+
+	ULOG_ERRNO_RETURN_ERR_IF(plan == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_raw_format_cmp(&in_frame->format, &plan->in.format),
+		EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_raw_format_cmp(&out_frame->format, &plan->out.format),
+		EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &plan->in.info.resolution),
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&out_frame->info.resolution,
+					       &plan->in.info.resolution),
+				 EINVAL);
+
+	run.plan = plan;
+	run.in_frame = in_frame;
+	run.in_plane = in_plane;
+	run.out_frame = out_frame;
+	run.out_plane = out_plane;
+	run.buffers = NULL;
+
+	size = vdef_priv_thread_pool_get_thread_count(pool) * plan->buffer_size;
+	if (size > 0) {
+		run.buffers = aligned_alloc(BUFFER_ALIGN, size);
+		if (run.buffers == NULL) {
+			ret = -ENOMEM;
+			ULOG_ERRNO("aligned_alloc", -ret);
+			return ret;
+		}
+	}
+
+	ret = vdef_priv_thread_pool_run(
+		pool, plan->band_count, &process_band, &run);
+
+	free(run.buffers);
+	return ret;
+}
+
+
+const char *vdef_convert_step_to_str(enum vdef_convert_step step)
+{
+	switch (step) {
+	case VDEF_CONVERT_STEP_COPY:
+		return "COPY";
+	case VDEF_CONVERT_STEP_PIX_LAYOUT:
+		return "PIX_LAYOUT";
+	case VDEF_CONVERT_STEP_RAW_DATA:
+		return "RAW_DATA";
+	case VDEF_CONVERT_STEP_PIX_ORDER:
+		return "PIX_ORDER";
+	case VDEF_CONVERT_STEP_YUV_CHROMA:
+		return "YUV_CHROMA";
+	case VDEF_CONVERT_STEP_YUV_TO_RGB:
+		return "YUV_TO_RGB";
+	case VDEF_CONVERT_STEP_RGB_TO_YUV:
+		return "RGB_TO_YUV";
+	case VDEF_CONVERT_STEP_GAMUT:
+		return "GAMUT";
+	case VDEF_CONVERT_STEP_TONE_MAP:
+		return "TONE_MAP";
+	default:
+		return "UNKNOWN";
+	}
+}
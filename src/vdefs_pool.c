@@ -0,0 +1,479 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Default frame alignment (cache line size) */
+#define VDEF_RAW_FRAME_POOL_DEFAULT_ALIGN 64
+
+/* Huge page size used to round explicit huge page mappings */
+#define VDEF_RAW_FRAME_POOL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* The free list head packs a modification tag in the upper 32 bits (to avoid
+ * ABA issues) and the index + 1 of the first free frame in the lower 32 bits
+ * (0 means the list is empty) */
+#define FREE_HEAD_INDEX(_head) ((uint32_t)((_head) & UINT32_MAX))
+#define FREE_HEAD_TAG(_head) ((uint32_t)((_head) >> 32))
+#define FREE_HEAD(_tag, _index) (((uint64_t)(_tag) << 32) | (_index))
+
+
+struct vdef_raw_frame_pool {
+	/* Frame layout */
+	struct vdef_raw_layout layout;
+
+	/* Frame count */
+	unsigned int count;
+
+	/* Distance in bytes between two consecutive frames */
+	size_t frame_stride;
+
+	/* Memory mapping (in memfd mode, the frame memfds are mapped over
+	 * this address range reservation) */
+	void *map;
+	size_t map_size;
+
+	/* Frame memfds (memfd mode only, NULL otherwise) */
+	int *fds;
+
+	/* First frame address */
+	uint8_t *base;
+
+	/* Free list head (see FREE_HEAD()) */
+	_Atomic uint64_t free_head;
+
+	/* Free list links: index + 1 of the next free frame for each frame
+	 * (0 for the last one) */
+	_Atomic uint32_t *free_next;
+
+	/* Per-frame flag set while the frame is taken from the pool (to
+	 * detect frames returned twice) */
+	atomic_bool *in_use;
+
+	/* Number of frames currently taken from the pool */
+	atomic_uint used;
+};
+
+
+static int pool_map_memfd(struct vdef_raw_frame_pool *pool)
+{
+#ifdef MFD_ALLOW_SEALING
+	int ret;
+
+	pool->fds = malloc(pool->count * sizeof(*pool->fds));
+	if (pool->fds == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("malloc", -ret);
+		return ret;
+	}
+	for (unsigned int i = 0; i < pool->count; i++)
+		pool->fds[i] = -1;
+
+	for (unsigned int i = 0; i < pool->count; i++) {
+		void *frame = pool->base + (size_t)i * pool->frame_stride;
+
+		pool->fds[i] = memfd_create("vdef_raw_frame",
+					    MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		if (pool->fds[i] < 0) {
+			ret = -errno;
+			ULOG_ERRNO("memfd_create", -ret);
+			return ret;
+		}
+		if (ftruncate(pool->fds[i], pool->frame_stride) < 0) {
+			ret = -errno;
+			ULOG_ERRNO("ftruncate", -ret);
+			return ret;
+		}
+
+		/* Seal the size so that receivers can safely map the frame */
+		if (fcntl(pool->fds[i],
+			  F_ADD_SEALS,
+			  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+			ret = -errno;
+			ULOG_ERRNO("fcntl", -ret);
+			return ret;
+		}
+
+		/* Map the frame over its slot in the reservation */
+		if (mmap(frame,
+			 pool->frame_stride,
+			 PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_FIXED,
+			 pool->fds[i],
+			 0) == MAP_FAILED) {
+			ret = -errno;
+			ULOG_ERRNO("mmap", -ret);
+			return ret;
+		}
+	}
+
+	return 0;
+#else /* !MFD_ALLOW_SEALING */
+	ULOGE("memfd is not supported on this platform");
+	return -ENOSYS;
+#endif /* !MFD_ALLOW_SEALING */
+}
+
+
+static int pool_map(struct vdef_raw_frame_pool *pool,
+		    size_t align,
+		    bool huge,
+		    bool memfd)
+{
+	size_t size;
+	bool huge_map = false;
+
+	/* Allow room to align the first frame if the alignment is larger
+	 * than the page size */
+	size = pool->frame_stride * pool->count;
+	if (align > (size_t)sysconf(_SC_PAGESIZE))
+		size += align;
+
+#ifdef MAP_HUGETLB
+	if (huge && !memfd) {
+		pool->map_size =
+			VDEF_ALIGN(size, VDEF_RAW_FRAME_POOL_HUGE_PAGE_SIZE);
+		pool->map = mmap(NULL,
+				 pool->map_size,
+				 PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+				 -1,
+				 0);
+		if (pool->map != MAP_FAILED) {
+			huge_map = true;
+			goto out;
+		}
+		ULOGI("no explicit huge pages available, "
+		      "falling back to regular pages");
+	}
+#endif /* MAP_HUGETLB */
+
+	pool->map_size = size;
+	pool->map = mmap(NULL,
+			 pool->map_size,
+			 memfd ? PROT_NONE : (PROT_READ | PROT_WRITE),
+			 MAP_PRIVATE | MAP_ANONYMOUS,
+			 -1,
+			 0);
+	if (pool->map == MAP_FAILED) {
+		int ret = -errno;
+		pool->map = NULL;
+		ULOG_ERRNO("mmap", -ret);
+		return ret;
+	}
+
+#ifdef MAP_HUGETLB
+out:
+#endif /* MAP_HUGETLB */
+	pool->base = (uint8_t *)VDEF_ALIGN((uintptr_t)pool->map, align);
+
+	if (memfd) {
+		int ret = pool_map_memfd(pool);
+		if (ret < 0)
+			return ret;
+	}
+
+#ifdef MADV_HUGEPAGE
+	/* Ask for transparent huge pages when explicit huge pages are not
+	 * available */
+	if (huge && !huge_map &&
+	    madvise(pool->map, pool->map_size, MADV_HUGEPAGE) < 0)
+		ULOG_ERRNO("madvise", errno);
+#endif /* MADV_HUGEPAGE */
+
+	return 0;
+}
+
+
+int vdef_raw_frame_pool_new(const struct vdef_raw_layout *layout,
+			    unsigned int count,
+			    size_t align,
+			    uint32_t flags,
+			    struct vdef_raw_frame_pool **ret_obj)
+{
+	int ret;
+	struct vdef_raw_frame_pool *pool;
+
+	ULOG_ERRNO_RETURN_ERR_IF(layout == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(layout->size == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(count == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(count == UINT32_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF((align & (align - 1)) != 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	if (align == 0)
+		align = VDEF_RAW_FRAME_POOL_DEFAULT_ALIGN;
+
+	pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	pool->layout = *layout;
+	pool->count = count;
+
+	/* In memfd mode, each frame is a separate mapping and must start on
+	 * a page boundary */
+	if ((flags & VDEF_RAW_FRAME_POOL_FLAG_MEMFD) &&
+	    align < (size_t)sysconf(_SC_PAGESIZE))
+		align = sysconf(_SC_PAGESIZE);
+	pool->frame_stride = VDEF_ALIGN(layout->size, align);
+	atomic_init(&pool->used, 0);
+
+	pool->free_next = calloc(count, sizeof(*pool->free_next));
+	pool->in_use = calloc(count, sizeof(*pool->in_use));
+	if (pool->free_next == NULL || pool->in_use == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		goto error;
+	}
+
+	ret = pool_map(pool,
+		       align,
+		       flags & VDEF_RAW_FRAME_POOL_FLAG_HUGE_PAGES,
+		       flags & VDEF_RAW_FRAME_POOL_FLAG_MEMFD);
+	if (ret < 0)
+		goto error;
+
+	/* Initially all frames are free, in address order */
+	for (unsigned int i = 0; i < count; i++) {
+		atomic_init(&pool->free_next[i], (i + 1 < count) ? i + 2 : 0);
+		atomic_init(&pool->in_use[i], false);
+	}
+	atomic_init(&pool->free_head, FREE_HEAD(0, 1));
+
+	*ret_obj = pool;
+	return 0;
+
+error:
+	vdef_raw_frame_pool_destroy(pool);
+	return ret;
+}
+
+
+int vdef_raw_frame_pool_destroy(struct vdef_raw_frame_pool *pool)
+{
+	if (pool == NULL)
+		return 0;
+
+	if (atomic_load(&pool->used) != 0)
+		return -EBUSY;
+
+	if (pool->map != NULL && munmap(pool->map, pool->map_size) < 0)
+		ULOG_ERRNO("munmap", errno);
+	if (pool->fds != NULL) {
+		for (unsigned int i = 0; i < pool->count; i++) {
+			if (pool->fds[i] >= 0)
+				close(pool->fds[i]);
+		}
+		free(pool->fds);
+	}
+	free(pool->free_next);
+	free(pool->in_use);
+	free(pool);
+
+	return 0;
+}
+
+
+/* Get the index + 1 of a frame of the pool, or 0 if the frame does not
+ * belong to the pool */
+static uint32_t get_frame_index(struct vdef_raw_frame_pool *pool, void *frame)
+{
+	size_t offset;
+
+	if ((uint8_t *)frame < pool->base)
+		return 0;
+	offset = (uint8_t *)frame - pool->base;
+	if (offset % pool->frame_stride != 0 ||
+	    offset / pool->frame_stride >= pool->count)
+		return 0;
+	return offset / pool->frame_stride + 1;
+}
+
+
+const struct vdef_raw_layout *
+vdef_raw_frame_pool_get_layout(struct vdef_raw_frame_pool *pool)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(pool == NULL, EINVAL, NULL);
+
+	return &pool->layout;
+}
+
+
+int vdef_raw_frame_pool_get(struct vdef_raw_frame_pool *pool, void **ret_frame)
+{
+	uint64_t head, next;
+	uint32_t index;
+
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_frame == NULL, EINVAL);
+
+	head = atomic_load_explicit(&pool->free_head, memory_order_acquire);
+	do {
+		index = FREE_HEAD_INDEX(head);
+		if (index == 0)
+			return -EAGAIN;
+		next = FREE_HEAD(FREE_HEAD_TAG(head) + 1,
+				 atomic_load_explicit(&pool->free_next[index - 1],
+						      memory_order_relaxed));
+	} while (!atomic_compare_exchange_weak_explicit(&pool->free_head,
+							&head,
+							next,
+							memory_order_acquire,
+							memory_order_acquire));
+
+	atomic_store_explicit(
+		&pool->in_use[index - 1], true, memory_order_relaxed);
+	atomic_fetch_add_explicit(&pool->used, 1, memory_order_relaxed);
+	*ret_frame = pool->base + (size_t)(index - 1) * pool->frame_stride;
+	return 0;
+}
+
+
+int vdef_raw_frame_pool_put(struct vdef_raw_frame_pool *pool, void *frame)
+{
+	uint64_t head, next;
+	uint32_t index;
+
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+
+	index = get_frame_index(pool, frame);
+	if (index == 0)
+		return -EINVAL;
+
+	/* Only the first put of a taken frame pushes it to the free list */
+	if (!atomic_exchange_explicit(
+		    &pool->in_use[index - 1], false, memory_order_relaxed))
+		return -EALREADY;
+
+	atomic_fetch_sub_explicit(&pool->used, 1, memory_order_relaxed);
+
+	head = atomic_load_explicit(&pool->free_head, memory_order_relaxed);
+	do {
+		atomic_store_explicit(&pool->free_next[index - 1],
+				      FREE_HEAD_INDEX(head),
+				      memory_order_relaxed);
+		next = FREE_HEAD(FREE_HEAD_TAG(head) + 1, index);
+	} while (!atomic_compare_exchange_weak_explicit(&pool->free_head,
+							&head,
+							next,
+							memory_order_release,
+							memory_order_relaxed));
+
+	return 0;
+}
+
+
+int vdef_raw_frame_pool_get_fd(struct vdef_raw_frame_pool *pool,
+			       void *frame,
+			       int *ret_fd)
+{
+	uint32_t index;
+
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_fd == NULL, EINVAL);
+
+	if (pool->fds == NULL)
+		return -ENOTSUP;
+
+	index = get_frame_index(pool, frame);
+	if (index == 0)
+		return -EINVAL;
+
+	*ret_fd = pool->fds[index - 1];
+	return 0;
+}
+
+
+int vdef_raw_frame_map_fd(int fd,
+			  const struct vdef_raw_layout *layout,
+			  void **ret_frame)
+{
+	int ret;
+	struct stat st;
+	void *frame;
+
+	ULOG_ERRNO_RETURN_ERR_IF(fd < 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(layout == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(layout->size == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_frame == NULL, EINVAL);
+
+	if (fstat(fd, &st) < 0) {
+		ret = -errno;
+		ULOG_ERRNO("fstat", -ret);
+		return ret;
+	}
+	if ((size_t)st.st_size < layout->size)
+		return -ENOBUFS;
+
+	frame = mmap(NULL,
+		     layout->size,
+		     PROT_READ | PROT_WRITE,
+		     MAP_SHARED,
+		     fd,
+		     0);
+	if (frame == MAP_FAILED) {
+		ret = -errno;
+		ULOG_ERRNO("mmap", -ret);
+		return ret;
+	}
+
+	*ret_frame = frame;
+	return 0;
+}
+
+
+int vdef_raw_frame_unmap(const struct vdef_raw_layout *layout, void *frame)
+{
+	int ret;
+
+	ULOG_ERRNO_RETURN_ERR_IF(layout == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(frame == NULL, EINVAL);
+
+	if (munmap(frame, layout->size) < 0) {
+		ret = -errno;
+		ULOG_ERRNO("munmap", -ret);
+		return ret;
+	}
+
+	return 0;
+}
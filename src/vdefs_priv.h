@@ -0,0 +1,670 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VDEFS_PRIV_H_
+#define _VDEFS_PRIV_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <video-defs/vdefs.h>
+
+
+/* Number of pixels processed at once by the row kernels; the kernels work
+ * on fixed-size chunks so that the compiler can fully vectorize them */
+#define VDEF_PRIV_CHUNK 64
+
+
+/* Vector types (GCC and Clang vector extensions are lowered to SSE/AVX on
+ * x86 and to NEON on ARM) */
+#define VDEF_PRIV_VEC_LEN 8
+typedef int32_t vdef_priv_v8i32
+	__attribute__((vector_size(VDEF_PRIV_VEC_LEN * sizeof(int32_t))));
+typedef float vdef_priv_v8f32
+	__attribute__((vector_size(VDEF_PRIV_VEC_LEN * sizeof(float))));
+typedef uint8_t vdef_priv_v16u8 __attribute__((vector_size(16)));
+typedef uint16_t vdef_priv_v8u16 __attribute__((vector_size(16)));
+typedef uint16_t vdef_priv_v16u16 __attribute__((vector_size(32)));
+typedef uint32_t vdef_priv_v16u32 __attribute__((vector_size(64)));
+
+
+/* Shuffle the elements of two vectors of the same type; the indexes select
+ * elements in the concatenation of both vectors */
+#if defined(__clang__)
+#	define VDEF_PRIV_SHUFFLE2(_a, _b, ...)                                \
+		__builtin_shufflevector(_a, _b, __VA_ARGS__)
+#else
+#	define VDEF_PRIV_SHUFFLE2(_a, _b, ...)                                \
+		__builtin_shuffle(_a, _b, (__typeof__(_a)){__VA_ARGS__})
+#endif
+
+
+/* Build additional variants of a hot function for wider instruction sets,
+ * selected at load time depending on the CPU (x86 ELF targets only) */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__ELF__) &&           \
+	(defined(__x86_64__) || defined(__i386__))
+#	define VDEF_PRIV_TARGET_CLONES                                        \
+		__attribute__((target_clones("avx2", "default")))
+#else
+#	define VDEF_PRIV_TARGET_CLONES
+#endif
+
+
+/* Sample storage types */
+enum vdef_priv_sample_type {
+	/* 8-bit samples */
+	VDEF_PRIV_SAMPLE_U8 = 0,
+
+	/* 16-bit little-endian samples */
+	VDEF_PRIV_SAMPLE_U16LE,
+
+	/* 16-bit big-endian samples */
+	VDEF_PRIV_SAMPLE_U16BE,
+};
+
+
+/* Sample storage of a raw format */
+struct vdef_priv_sample_fmt {
+	/* Storage type */
+	enum vdef_priv_sample_type type;
+
+	/* Left shift of the value in the storage (padding in lower bits) */
+	unsigned int shift;
+
+	/* Value bit depth */
+	unsigned int depth;
+};
+
+
+/**
+ * Get the sample storage of a raw format.
+ * Only byte-aligned 8-bit and 16-bit data sizes are supported.
+ * @param format: raw format
+ * @param fmt: pointer to the sample storage (output)
+ * @return 0 on success, -ENOTSUP if the data size is not supported
+ */
+int vdef_priv_get_sample_fmt(const struct vdef_raw_format *format,
+			     struct vdef_priv_sample_fmt *fmt);
+
+
+/**
+ * Read samples into a 32-bit array.
+ * @param src: first sample address
+ * @param step: distance between two samples (in samples)
+ * @param count: number of samples to read (at most VDEF_PRIV_CHUNK)
+ * @param fmt: sample storage
+ * @param dst: destination array of VDEF_PRIV_CHUNK values
+ */
+void vdef_priv_read_samples(const void *src,
+			    unsigned int step,
+			    unsigned int count,
+			    const struct vdef_priv_sample_fmt *fmt,
+			    int32_t *dst);
+
+
+/**
+ * Write samples from a 32-bit array.
+ * Values must already be clamped to the sample bit depth.
+ * @param dst: first sample address
+ * @param step: distance between two samples (in samples)
+ * @param count: number of samples to write (at most VDEF_PRIV_CHUNK)
+ * @param fmt: sample storage
+ * @param src: source array of VDEF_PRIV_CHUNK values
+ */
+void vdef_priv_write_samples(void *dst,
+			     unsigned int step,
+			     unsigned int count,
+			     const struct vdef_priv_sample_fmt *fmt,
+			     const int32_t *src);
+
+
+/* Location of a color component in the planes of a raw frame */
+struct vdef_priv_comp {
+	/* Plane index */
+	unsigned int plane;
+
+	/* Offset of the first sample in a plane line (in samples) */
+	unsigned int offset;
+
+	/* Distance between two consecutive samples (in samples) */
+	unsigned int step;
+
+	/* Horizontal and vertical subsampling factors */
+	unsigned int h_sub;
+	unsigned int v_sub;
+};
+
+
+/**
+ * Get the location of the color components of a raw format.
+ * Components are returned in canonical order (Y, U, V for YUV formats and
+ * R, G, B, A for RGB formats) whatever the pixel order.
+ * Only linear pixel layouts with 8-bit or 16-bit samples are supported.
+ * @param format: raw format
+ * @param comp: array of 4 component locations (output)
+ * @param count: pointer to the component count (output)
+ * @return 0 on success, -ENOTSUP if the format is not supported, or negative
+ *         errno value in case of error
+ */
+int vdef_priv_get_comp_layout(const struct vdef_raw_format *format,
+			      struct vdef_priv_comp comp[4],
+			      unsigned int *count);
+
+
+/**
+ * Get the address of a sample of a component in a raw frame.
+ * The plane pointers constness is not propagated to the returned address.
+ * @param plane: frame plane pointers
+ * @param stride: frame plane strides
+ * @param comp: component location
+ * @param bytes: sample size in bytes
+ * @param x: horizontal position (in pixels)
+ * @param y: vertical position (in pixels)
+ * @return the sample address
+ */
+static inline uint8_t *vdef_priv_comp_ptr(const void *const *plane,
+					  const size_t *stride,
+					  const struct vdef_priv_comp *comp,
+					  unsigned int bytes,
+					  unsigned int x,
+					  unsigned int y)
+{
+	return (uint8_t *)(uintptr_t)plane[comp->plane] +
+	       (size_t)(y / comp->v_sub) * stride[comp->plane] +
+	       ((size_t)comp->offset + (size_t)(x / comp->h_sub) * comp->step) *
+		       bytes;
+}
+
+
+/**
+ * Get the YUV offsets and normalization scale of a bit depth and range.
+ * @param depth: bit depth
+ * @param full_range: full range flag
+ * @param off: Y, U and V offsets (output)
+ * @param scale: normalization scale (output)
+ */
+void vdef_priv_get_yuv_range(unsigned int depth,
+			     bool full_range,
+			     int32_t off[3],
+			     float *scale);
+
+
+/**
+ * Read a chunk of component samples.
+ * Horizontally subsampled components are upsampled by sample replication.
+ * @param plane: frame plane pointers
+ * @param stride: frame plane strides
+ * @param comp: component location
+ * @param fmt: sample storage
+ * @param res: frame resolution
+ * @param x: horizontal position (multiple of the horizontal subsampling)
+ * @param y: vertical position (in pixels)
+ * @param count: number of pixels (at most VDEF_PRIV_CHUNK)
+ * @param dst: destination array of VDEF_PRIV_CHUNK values
+ */
+void vdef_priv_read_comp(const void *const *plane,
+			 const size_t *stride,
+			 const struct vdef_priv_comp *comp,
+			 const struct vdef_priv_sample_fmt *fmt,
+			 const struct vdef_dim *res,
+			 unsigned int x,
+			 unsigned int y,
+			 unsigned int count,
+			 int32_t *dst);
+
+
+/**
+ * Write a chunk of component samples.
+ * @param plane: frame plane pointers
+ * @param stride: frame plane strides
+ * @param comp: component location
+ * @param fmt: sample storage
+ * @param x: horizontal position (multiple of the horizontal subsampling)
+ * @param y: vertical position (in pixels)
+ * @param count: number of samples to write (i.e. subsampled samples for
+ *        subsampled components)
+ * @param src: source array of VDEF_PRIV_CHUNK values
+ */
+void vdef_priv_write_comp(void *const *plane,
+			  const size_t *stride,
+			  const struct vdef_priv_comp *comp,
+			  const struct vdef_priv_sample_fmt *fmt,
+			  unsigned int x,
+			  unsigned int y,
+			  unsigned int count,
+			  const int32_t *src);
+
+
+/* 3x3 color matrix in fixed point:
+ * out[c] = clamp(sum_k((in[k] - in_off[k]) * coef[k * 3 + c]) + out_off[c])
+ * (the coefficient layout matches the column-major float tables) */
+struct vdef_priv_mat3 {
+	/* Input offsets */
+	int32_t in_off[3];
+
+	/* Coefficients (with frac_bits fractional bits) */
+	int32_t coef[9];
+
+	/* Output offsets */
+	int32_t out_off[3];
+
+	/* Coefficients fractional bits */
+	unsigned int frac_bits;
+
+	/* Output maximum value */
+	int32_t out_max;
+};
+
+
+/**
+ * Initialize a fixed-point 3x3 color matrix from a float matrix.
+ * The float matrix is applied on normalized values:
+ * out_norm = (in - in_off) / in_scale * mat
+ * out = out_norm * out_scale + out_off
+ * @param mat: fixed-point matrix (output)
+ * @param fmat: column-major float matrix
+ * @param in_off: input offsets
+ * @param in_scale: input normalization scale
+ * @param in_max: input maximum value
+ * @param out_off: output offsets
+ * @param out_scale: output normalization scale
+ * @param out_max: output maximum value
+ */
+void vdef_priv_mat3_init(struct vdef_priv_mat3 *mat,
+			 const float *fmat,
+			 const int32_t *in_off,
+			 float in_scale,
+			 int32_t in_max,
+			 const int32_t *out_off,
+			 float out_scale,
+			 int32_t out_max);
+
+
+/**
+ * Initialize a fixed-point 3x3 color matrix from an integer matrix
+ * (e.g. vdef_yuv_to_rgb_fixed_matrix).
+ * @param mat: fixed-point matrix (output)
+ * @param imat: column-major integer matrix
+ * @param frac_bits: integer matrix coefficients fractional bits
+ * @param in_off: input offsets
+ * @param out_off: output offsets
+ * @param out_max: output maximum value
+ */
+void vdef_priv_mat3_init_fixed(struct vdef_priv_mat3 *mat,
+			       const int32_t *imat,
+			       unsigned int frac_bits,
+			       const int32_t *in_off,
+			       const int32_t *out_off,
+			       int32_t out_max);
+
+
+/**
+ * Apply a fixed-point 3x3 color matrix on VDEF_PRIV_CHUNK values.
+ * @param mat: fixed-point matrix
+ * @param in: 3 input arrays of VDEF_PRIV_CHUNK values
+ * @param out: 3 output arrays of VDEF_PRIV_CHUNK values
+ */
+void vdef_priv_mat3_apply(const struct vdef_priv_mat3 *mat,
+			  int32_t in[3][VDEF_PRIV_CHUNK],
+			  int32_t out[3][VDEF_PRIV_CHUNK]);
+
+
+/**
+ * Get the component index at each position of a pixel order.
+ * For example, for VDEF_RAW_PIX_ORDER_BGRA (i.e. CBAD), the output is
+ * {2, 1, 0, 3}.
+ * @param order: pixel order
+ * @param perm: array of 4 component indexes (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+int vdef_priv_get_pix_order_perm(enum vdef_raw_pix_order order,
+				 unsigned int perm[4]);
+
+
+/**
+ * Get the number of samples per line and the number of lines of a raw frame
+ * plane, as used for the default plane strides and scanlines (see
+ * vdef_calc_raw_frame_size()).
+ * @param format: raw frame format
+ * @param resolution: frame resolution
+ * @param plane: plane index
+ * @param samples: samples per line (output)
+ * @param lines: line count (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+int vdef_priv_get_plane_samples(const struct vdef_raw_format *format,
+				const struct vdef_dim *resolution,
+				unsigned int plane,
+				unsigned int *samples,
+				unsigned int *lines);
+
+
+/**
+ * Swap the samples of interleaved pairs (e.g. UV to VU chroma samples).
+ * @param src: first pair address
+ * @param dst: first output pair address (can be the same as src)
+ * @param count: number of pairs
+ * @param bytes: sample size in bytes (1 or 2)
+ */
+void vdef_priv_swap_pairs(const uint8_t *src,
+			  uint8_t *dst,
+			  unsigned int count,
+			  unsigned int bytes);
+
+
+/**
+ * Check that a conversion between two raw formats is supported by
+ * vdef_convert_raw_data().
+ * @param in_format: input raw format
+ * @param out_format: output raw format
+ * @return 0 if the conversion is supported, -ENOTSUP otherwise
+ */
+int vdef_priv_raw_data_check(const struct vdef_raw_format *in_format,
+			     const struct vdef_raw_format *out_format);
+
+
+/**
+ * Check that a conversion between two raw formats is supported by
+ * vdef_convert_yuv_chroma().
+ * @param in_format: input raw format
+ * @param out_format: output raw format
+ * @return 0 if the conversion is supported, -ENOTSUP otherwise
+ */
+int vdef_priv_yuv_chroma_check(const struct vdef_raw_format *in_format,
+			       const struct vdef_raw_format *out_format);
+
+
+/**
+ * Check that a conversion between two raw formats is supported by
+ * vdef_convert_pix_order().
+ * @param in_format: input raw format
+ * @param out_format: output raw format
+ * @return 0 if the conversion is supported, -ENOTSUP otherwise
+ */
+int vdef_priv_pix_order_check(const struct vdef_raw_format *in_format,
+			      const struct vdef_raw_format *out_format);
+
+
+/**
+ * Check that a conversion between two raw formats is supported by
+ * vdef_convert_pix_layout().
+ * @param in_format: input raw format
+ * @param out_format: output raw format
+ * @return 0 if the conversion is supported, -ENOTSUP otherwise
+ */
+int vdef_priv_pix_layout_check(const struct vdef_raw_format *in_format,
+			       const struct vdef_raw_format *out_format);
+
+
+
+/* Float linear light index of the transfer function lookup tables: the
+ * table is indexed by the exponent and the upper mantissa bits of the float
+ * value, from 2^-VDEF_PRIV_TRANSFER_FLOAT_OCTAVES to 1.0; index 0 is 0.0 */
+#define VDEF_PRIV_TRANSFER_FLOAT_OCTAVES 24
+
+
+/* Transfer function lookup table */
+struct vdef_transfer_lut {
+	/* Transfer function */
+	enum vdef_transfer_function transfer;
+
+	/* Conversion direction */
+	enum vdef_transfer_lut_dir dir;
+
+	/* Code values bit depth */
+	unsigned int bit_depth;
+
+	/* Maximum index of the 16-bit input tables (65535 for
+	 * VDEF_TRANSFER_LUT_DIR_FROM_LINEAR, maximum code value otherwise) */
+	unsigned int max;
+
+	/* 16-bit output table (max + 1 entries) */
+	uint16_t *u16;
+
+	/* Float linear light table (max + 1 entries, only for
+	 * VDEF_TRANSFER_LUT_DIR_TO_LINEAR) */
+	float *f32;
+
+	/* Float input table (float_max + 1 entries, only for
+	 * VDEF_TRANSFER_LUT_DIR_FROM_LINEAR) */
+	uint16_t *from_f32;
+
+	/* Float input table mantissa shift and maximum index */
+	unsigned int float_shift;
+	unsigned int float_max;
+};
+
+
+/**
+ * Get the float input table index of a linear light value.
+ * @param lut: VDEF_TRANSFER_LUT_DIR_FROM_LINEAR lookup table
+ * @param value: linear light value (clamped to [0, 1], NAN gives 0)
+ * @return the table index
+ */
+static inline uint32_t
+vdef_priv_transfer_float_index(const struct vdef_transfer_lut *lut,
+			       float value)
+{
+	const int32_t lo = (127 - VDEF_PRIV_TRANSFER_FLOAT_OCTAVES) << 23;
+	int32_t bits;
+
+	value = value > 0.f ? value : 0.f;
+	value = value < 1.f ? value : 1.f;
+	memcpy(&bits, &value, sizeof(bits));
+	bits -= lo - (1 << lut->float_shift);
+	bits = bits > 0 ? bits : 0;
+
+	return (uint32_t)bits >> lut->float_shift;
+}
+
+
+/* HDR to SDR tone curve */
+struct vdef_priv_tone_curve {
+	/* Tone mapping method */
+	enum vdef_tone_map_method method;
+
+	/* Source peak and black luminance (in cd/m2) */
+	float src_peak;
+	float src_black;
+
+	/* BT.2390: PQ encoded source black level and range, and target
+	 * black level, peak and knee normalized to the source range */
+	float pq_black;
+	float pq_range;
+	float min_lum;
+	float max_lum;
+	float knee;
+
+	/* Reinhard and Hable: source peak relative to the SDR peak and output
+	 * normalization factor */
+	float white;
+	float norm;
+};
+
+
+/**
+ * Initialize a tone curve from HDR format info metadata.
+ * @param curve: tone curve to initialize
+ * @param method: tone mapping method
+ * @param hdr_info: HDR format info (can be NULL to use the default values)
+ * @return 0 on success, negative errno value in case of error
+ */
+int vdef_priv_tone_curve_init(struct vdef_priv_tone_curve *curve,
+			      enum vdef_tone_map_method method,
+			      const struct vdef_format_info *hdr_info);
+
+
+/**
+ * Apply a tone curve.
+ * @param curve: tone curve
+ * @param value: PQ linear light value (1.0 is 10000 cd/m2)
+ * @return the SDR linear light value in [0, 1] (1.0 is
+ *         VDEF_TONE_MAP_SDR_PEAK_LUMINANCE)
+ */
+float vdef_priv_tone_curve_apply(const struct vdef_priv_tone_curve *curve,
+				 float value);
+
+
+/* 3D lookup table side descriptor (only the values that change the
+ * conversion; all fields are 32-bit so that there is no padding) */
+struct vdef_priv_lut3d_side {
+	uint32_t yuv;
+	uint32_t full_range;
+	uint32_t color_primaries;
+	uint32_t transfer_function;
+	uint32_t matrix_coefs;
+	uint32_t dynamic_range;
+	uint32_t tone_mapping;
+	float max_luminance;
+	float min_luminance;
+	uint32_t max_cll;
+};
+
+
+/* 3D lookup table descriptor (compared and hashed as raw bytes) */
+struct vdef_priv_lut3d_key {
+	struct vdef_priv_lut3d_side src;
+	struct vdef_priv_lut3d_side dst;
+	uint32_t size;
+	uint32_t method;
+	uint32_t clip;
+};
+
+
+struct vdef_lut3d {
+	/* Next table of the cache bucket */
+	struct vdef_lut3d *next;
+
+	/* Descriptor and hash */
+	struct vdef_priv_lut3d_key key;
+	uint32_t hash;
+
+	/* Number of grid points per dimension */
+	unsigned int size;
+
+	/* Normalized destination components, 3 per grid point; the first
+	 * source component is the fastest varying index */
+	float *table;
+};
+
+
+/**
+ * Apply a 3D lookup table to a chunk of samples (tetrahedral
+ * interpolation).
+ * @param lut: 3D lookup table
+ * @param in_max: maximum value of the input samples
+ * @param in: input samples
+ * @param out: normalized output components
+ */
+void vdef_priv_lut3d_apply_chunk(const struct vdef_lut3d *lut,
+				 unsigned int in_max,
+				 int32_t in[3][VDEF_PRIV_CHUNK],
+				 float out[3][VDEF_PRIV_CHUNK]);
+
+
+/* Color conversion of vdef_convert_gamut() or vdef_tone_map() prepared for
+ * multiple frames of the same formats and color parameters */
+struct vdef_priv_gamut;
+
+
+/**
+ * Prepare a color conversion.
+ * Only the formats and frame info of the frames are used; the resolution
+ * must be at least the chroma subsampling of both formats.
+ * @param in_frame: input raw frame
+ * @param out_frame: output raw frame
+ * @param tone_map: true to tone map (see vdef_tone_map()), false to convert
+ *                  the gamut (see vdef_convert_gamut())
+ * @param hdr_info: format info used for the tone mapping metadata (can be
+ *                  NULL to use the default values)
+ * @param method: tone mapping method (ignored if not tone mapping)
+ * @param clip: gamut clipping method
+ * @param ret_obj: pointer to the prepared conversion (output)
+ * @return 0 on success, -ENOTSUP if the formats or the conversion are not
+ *         supported, or negative errno value in case of error
+ */
+int vdef_priv_gamut_new(const struct vdef_raw_frame *in_frame,
+			const struct vdef_raw_frame *out_frame,
+			bool tone_map,
+			const struct vdef_format_info *hdr_info,
+			enum vdef_tone_map_method method,
+			enum vdef_gamut_clip_method clip,
+			struct vdef_priv_gamut **ret_obj);
+
+
+/**
+ * Destroy a prepared color conversion.
+ * @param self: prepared conversion (can be NULL)
+ */
+void vdef_priv_gamut_destroy(struct vdef_priv_gamut *self);
+
+
+/**
+ * Convert a raw frame in the calling thread with a prepared color
+ * conversion. The frames must have the formats of the frames given to
+ * vdef_priv_gamut_new() and any resolution (e.g. a band of lines of a
+ * larger frame starting on a chroma line).
+ * @param self: prepared conversion
+ * @param in_frame: input raw frame
+ * @param in_plane: input frame plane pointers
+ * @param out_frame: output raw frame (same resolution as the input frame)
+ * @param out_plane: output frame plane pointers
+ */
+void vdef_priv_gamut_run(const struct vdef_priv_gamut *self,
+			 const struct vdef_raw_frame *in_frame,
+			 const void *const *in_plane,
+			 const struct vdef_raw_frame *out_frame,
+			 void *const *out_plane);
+
+
+/**
+ * Run tasks on a thread pool (see vdef_thread_pool_run()), or in the
+ * calling thread with the thread index 0 if the pool is NULL.
+ * @param pool: thread pool (can be NULL)
+ * @param task_count: number of tasks
+ * @param task: task function
+ * @param userdata: user data passed to the task function
+ * @return 0 on success, negative errno value in case of error
+ */
+int vdef_priv_thread_pool_run(struct vdef_thread_pool *pool,
+			      unsigned int task_count,
+			      int (*task)(unsigned int index,
+					  unsigned int thread_index,
+					  void *userdata),
+			      void *userdata);
+
+
+/**
+ * Get the number of threads running the tasks of
+ * vdef_priv_thread_pool_run(), e.g. to allocate per-thread scratch memory.
+ * @param pool: thread pool (can be NULL)
+ * @return the number of threads of the pool, or 1 if pool is NULL
+ */
+unsigned int
+vdef_priv_thread_pool_get_thread_count(const struct vdef_thread_pool *pool);
+
+
+#endif /* _VDEFS_PRIV_H_ */
@@ -0,0 +1,848 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* True if the host is little-endian */
+#define HOST_LE (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+/* Output lines of a plane processed by a task */
+#define BAND_HEIGHT 32
+
+/* Bicubic filter parameter (Catmull-Rom spline) */
+#define BICUBIC_A -0.5f
+
+
+/* Resampling filter of one dimension */
+struct scale_filter {
+	/* Input samples per output sample */
+	unsigned int taps;
+
+	/* First input sample of each output sample */
+	unsigned int *start;
+
+	/* Weights of the input samples of each output sample (taps weights
+	 * per output sample, with a sum of 1) */
+	float *weight;
+};
+
+
+struct scale_plane {
+	const uint8_t *in;
+	size_t in_stride;
+	uint8_t *out;
+	size_t out_stride;
+
+	/* Interleaved components per pixel */
+	unsigned int channels;
+
+	/* Plane dimensions in pixels */
+	struct vdef_dim in_dim;
+	struct vdef_dim out_dim;
+
+	struct scale_filter h;
+	struct scale_filter v;
+
+	/* Index of the first band of the plane among all the bands */
+	unsigned int first_band;
+};
+
+
+struct scale {
+	enum vdef_scale_method method;
+
+	/* Sample storage */
+	struct vdef_priv_sample_fmt fmt;
+	unsigned int bytes;
+	bool swap;
+
+	unsigned int plane_count;
+	struct scale_plane planes[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int band_count;
+
+	/* Per-thread row of vertically filtered samples (not used for the
+	 * nearest neighbor method) */
+	float **rows;
+	unsigned int row_count;
+};
+
+
+struct vdef_scaler {
+	/* Format and resolutions of the frames */
+	struct vdef_raw_format format;
+	struct vdef_dim in_res;
+	struct vdef_dim out_res;
+
+	/* Thread pool processing the bands (can be NULL) */
+	struct vdef_thread_pool *pool;
+
+	struct scale s;
+};
+
+
+static float filter_box(float x)
+{
+	return (x > -0.5f && x <= 0.5f) ? 1.f : 0.f;
+}
+
+
+static float filter_triangle(float x)
+{
+	x = fabsf(x);
+	return x < 1.f ? 1.f - x : 0.f;
+}
+
+
+static float filter_bicubic(float x)
+{
+	const float a = BICUBIC_A;
+
+	x = fabsf(x);
+	if (x < 1.f)
+		return ((a + 2.f) * x - (a + 3.f)) * x * x + 1.f;
+	if (x < 2.f)
+		return ((a * x - 5.f * a) * x + 8.f * a) * x - 4.f * a;
+	return 0.f;
+}
+
+
+/* Get the input samples [xmin, xmax) within the support of a filter
+ * centered on an output sample */
+static void get_window(unsigned int i,
+		       double scale,
+		       double support,
+		       unsigned int in,
+		       int *xmin,
+		       int *xmax)
+{
+	double center = (i + 0.5) * scale;
+
+	*xmin = (int)floor(center - support + 0.5);
+	if (*xmin < 0)
+		*xmin = 0;
+	*xmax = (int)floor(center + support + 0.5);
+	if (*xmax > (int)in)
+		*xmax = in;
+}
+
+
+static void filter_clear(struct scale_filter *f)
+{
+	free(f->start);
+	free(f->weight);
+	memset(f, 0, sizeof(*f));
+}
+
+
+/* Calculate the filter from in to out samples; the filter is stretched by
+ * the downscaling factor so that all the input samples contribute to the
+ * output (anti-aliasing) */
+static int filter_init(struct scale_filter *f,
+		       unsigned int in,
+		       unsigned int out,
+		       enum vdef_scale_method method)
+{
+	float (*fn)(float x);
+	double scale = (double)in / out, fscale, support;
+	int xmin, xmax;
+
+	switch (method) {
+	case VDEF_SCALE_METHOD_AREA:
+		fn = &filter_box;
+		support = 0.5;
+		break;
+	case VDEF_SCALE_METHOD_BILINEAR:
+		fn = &filter_triangle;
+		support = 1.;
+		break;
+	case VDEF_SCALE_METHOD_BICUBIC:
+		fn = &filter_bicubic;
+		support = 2.;
+		break;
+	default:
+		fn = NULL;
+		support = 0.;
+		break;
+	}
+	fscale = scale > 1. ? scale : 1.;
+	support *= fscale;
+
+	/* Widest window of input samples */
+	f->taps = 1;
+	for (unsigned int i = 0; fn != NULL && i < out; i++) {
+		get_window(i, scale, support, in, &xmin, &xmax);
+		if (xmax - xmin > (int)f->taps)
+			f->taps = xmax - xmin;
+	}
+	f->start = calloc(out, sizeof(*f->start));
+	f->weight = calloc((size_t)out * f->taps, sizeof(*f->weight));
+	if (f->start == NULL || f->weight == NULL) {
+		filter_clear(f);
+		ULOG_ERRNO("calloc", ENOMEM);
+		return -ENOMEM;
+	}
+
+	for (unsigned int i = 0; i < out; i++) {
+		float *w = &f->weight[(size_t)i * f->taps];
+		unsigned int shift = 0;
+		float sum = 0.f;
+
+		if (fn == NULL) {
+			/* Nearest neighbor: input sample under the output
+			 * sample center */
+			f->start[i] = ((2 * (uint64_t)i + 1) * in) / (2 * out);
+			w[0] = 1.f;
+			continue;
+		}
+
+		get_window(i, scale, support, in, &xmin, &xmax);
+
+		/* Keep the taps inside the input, with zero weights for the
+		 * samples outside of the filter support */
+		if (xmin + f->taps > in)
+			shift = xmin + f->taps - in;
+		f->start[i] = xmin - shift;
+		for (int x = xmin; x < xmax; x++) {
+			double d = x - (i + 0.5) * scale + 0.5;
+			w[shift + x - xmin] = fn(d / fscale);
+			sum += w[shift + x - xmin];
+		}
+		if (sum == 0.f)
+			continue;
+		for (unsigned int t = 0; t < f->taps; t++)
+			w[t] /= sum;
+	}
+
+	return 0;
+}
+
+
+/* Get the planes of a format: number of interleaved components and
+ * subsampling factors of each plane */
+static int get_planes(const struct vdef_raw_format *format,
+		      unsigned int *count,
+		      unsigned int *channels,
+		      unsigned int *h_sub,
+		      unsigned int *v_sub)
+{
+	unsigned int comps, hs = 1, vs = 1;
+	bool yuv = false;
+
+	if (format->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR)
+		return -ENOTSUP;
+
+	switch (format->pix_format) {
+	case VDEF_RAW_PIX_FORMAT_YUV420:
+		vs = 2;
+		/* Fall through */
+	case VDEF_RAW_PIX_FORMAT_YUV422:
+		hs = 2;
+		/* Fall through */
+	case VDEF_RAW_PIX_FORMAT_YUV444:
+		yuv = true;
+		comps = 3;
+		break;
+	case VDEF_RAW_PIX_FORMAT_GRAY:
+		comps = 1;
+		break;
+	case VDEF_RAW_PIX_FORMAT_RGB24:
+		comps = 3;
+		break;
+	case VDEF_RAW_PIX_FORMAT_RGBA32:
+		comps = 4;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	switch (format->data_layout) {
+	case VDEF_RAW_DATA_LAYOUT_PACKED:
+		if (yuv)
+			return -ENOTSUP;
+		*count = 1;
+		channels[0] = comps;
+		break;
+	case VDEF_RAW_DATA_LAYOUT_PLANAR:
+		*count = comps;
+		for (unsigned int i = 0; i < comps; i++)
+			channels[i] = 1;
+		break;
+	case VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR:
+		if (!yuv)
+			return -ENOTSUP;
+		*count = 2;
+		channels[0] = 1;
+		channels[1] = 2;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+	if (*count != vdef_get_raw_frame_plane_count(format))
+		return -ENOTSUP;
+
+	/* Only the chroma planes are subsampled */
+	for (unsigned int i = 0; i < *count; i++) {
+		h_sub[i] = i > 0 ? hs : 1;
+		v_sub[i] = i > 0 ? vs : 1;
+	}
+
+	return 0;
+}
+
+
+/* Vertical filtering of 8-bit samples into a row of input width */
+static VDEF_PRIV_TARGET_CLONES void vfilter_u8(const uint8_t *in,
+					       size_t stride,
+					       unsigned int len,
+					       const float *w,
+					       unsigned int taps,
+					       float *row)
+{
+	for (unsigned int k = 0; k < len; k++)
+		row[k] = w[0] * in[k];
+	for (unsigned int t = 1; t < taps; t++) {
+		const uint8_t *src = in + t * stride;
+		float wt = w[t];
+		if (wt == 0.f)
+			continue;
+		for (unsigned int k = 0; k < len; k++)
+			row[k] += wt * src[k];
+	}
+}
+
+
+/* Vertical filtering of 16-bit samples in host byte order */
+static VDEF_PRIV_TARGET_CLONES void vfilter_u16(const uint8_t *in,
+						size_t stride,
+						unsigned int len,
+						const float *w,
+						unsigned int taps,
+						float *row)
+{
+	const uint16_t *src = (const uint16_t *)in;
+
+	for (unsigned int k = 0; k < len; k++)
+		row[k] = w[0] * src[k];
+	for (unsigned int t = 1; t < taps; t++) {
+		float wt = w[t];
+		src = (const uint16_t *)(in + t * stride);
+		if (wt == 0.f)
+			continue;
+		for (unsigned int k = 0; k < len; k++)
+			row[k] += wt * src[k];
+	}
+}
+
+
+/* Vertical filtering of 16-bit samples in swapped byte order */
+static VDEF_PRIV_TARGET_CLONES void vfilter_u16_swap(const uint8_t *in,
+						     size_t stride,
+						     unsigned int len,
+						     const float *w,
+						     unsigned int taps,
+						     float *row)
+{
+	const uint16_t *src = (const uint16_t *)in;
+
+	for (unsigned int k = 0; k < len; k++)
+		row[k] = w[0] * (uint16_t)((src[k] << 8) | (src[k] >> 8));
+	for (unsigned int t = 1; t < taps; t++) {
+		float wt = w[t];
+		src = (const uint16_t *)(in + t * stride);
+		if (wt == 0.f)
+			continue;
+		for (unsigned int k = 0; k < len; k++) {
+			row[k] += wt *
+				  (uint16_t)((src[k] << 8) | (src[k] >> 8));
+		}
+	}
+}
+
+
+/* Horizontal filtering of a vertically filtered row into an output line;
+ * inlined with constant channels and storage for each combination */
+static inline __attribute__((always_inline)) void
+hfilter(const float *row,
+	const struct scale_filter *h,
+	unsigned int width,
+	unsigned int channels,
+	unsigned int bytes,
+	bool swap,
+	unsigned int shift,
+	float max,
+	uint8_t *out)
+{
+	/* Storage values are the sample values shifted left */
+	const float scale = 1.f / (1 << shift);
+
+	for (unsigned int x = 0; x < width; x++) {
+		const float *src = row + (size_t)h->start[x] * channels;
+		const float *w = h->weight + (size_t)x * h->taps;
+
+		for (unsigned int c = 0; c < channels; c++) {
+			float acc = 0.f;
+			unsigned int v;
+
+			for (unsigned int t = 0; t < h->taps; t++)
+				acc += w[t] * src[t * channels + c];
+			acc = acc * scale + 0.5f;
+			acc = acc < 0.f ? 0.f : (acc > max ? max : acc);
+			v = (unsigned int)acc << shift;
+			if (bytes == 1) {
+				out[x * channels + c] = v;
+			} else {
+				if (swap)
+					v = ((v << 8) | (v >> 8)) & 0xffff;
+				((uint16_t *)out)[x * channels + c] = v;
+			}
+		}
+	}
+}
+
+
+#define HFILTER_CASE(_channels, _bytes, _swap)                                 \
+	case (_channels) | ((_bytes) << 4) | ((_swap) << 8):                   \
+		hfilter(row,                                                   \
+			&p->h,                                                 \
+			p->out_dim.width,                                      \
+			_channels,                                             \
+			_bytes,                                                \
+			_swap,                                                 \
+			s->fmt.shift,                                          \
+			max,                                                   \
+			out);                                                  \
+		break
+
+
+static VDEF_PRIV_TARGET_CLONES void hfilter_line(const struct scale *s,
+						 const struct scale_plane *p,
+						 const float *row,
+						 uint8_t *out)
+{
+	float max = (1 << s->fmt.depth) - 1;
+
+	switch (p->channels | (s->bytes << 4) | (s->swap << 8)) {
+		HFILTER_CASE(1, 1, 0);
+		HFILTER_CASE(2, 1, 0);
+		HFILTER_CASE(3, 1, 0);
+		HFILTER_CASE(4, 1, 0);
+		HFILTER_CASE(1, 2, 0);
+		HFILTER_CASE(2, 2, 0);
+		HFILTER_CASE(3, 2, 0);
+		HFILTER_CASE(4, 2, 0);
+		HFILTER_CASE(1, 2, 1);
+		HFILTER_CASE(2, 2, 1);
+		HFILTER_CASE(3, 2, 1);
+		HFILTER_CASE(4, 2, 1);
+	default:
+		break;
+	}
+}
+
+
+/* Nearest neighbor line: copy of whole pixels, inlined with a constant
+ * pixel size */
+static inline __attribute__((always_inline)) void
+nearest_line(const uint8_t *in,
+	     const unsigned int *start,
+	     unsigned int width,
+	     unsigned int pixel_bytes,
+	     uint8_t *out)
+{
+	for (unsigned int x = 0; x < width; x++) {
+		memcpy(out + (size_t)x * pixel_bytes,
+		       in + (size_t)start[x] * pixel_bytes,
+		       pixel_bytes);
+	}
+}
+
+
+static void nearest(const struct scale *s,
+		    const struct scale_plane *p,
+		    unsigned int y)
+{
+	const uint8_t *in = p->in + (size_t)p->v.start[y] * p->in_stride;
+	uint8_t *out = p->out + (size_t)y * p->out_stride;
+	unsigned int width = p->out_dim.width;
+
+	switch (p->channels * s->bytes) {
+	case 1:
+		nearest_line(in, p->h.start, width, 1, out);
+		break;
+	case 2:
+		nearest_line(in, p->h.start, width, 2, out);
+		break;
+	case 3:
+		nearest_line(in, p->h.start, width, 3, out);
+		break;
+	case 4:
+		nearest_line(in, p->h.start, width, 4, out);
+		break;
+	case 6:
+		nearest_line(in, p->h.start, width, 6, out);
+		break;
+	case 8:
+		nearest_line(in, p->h.start, width, 8, out);
+		break;
+	default:
+		nearest_line(
+			in, p->h.start, width, p->channels * s->bytes, out);
+		break;
+	}
+}
+
+
+static int scale_band(unsigned int index,
+		      unsigned int thread_index,
+		      void *userdata)
+{
+	const struct scale *s = userdata;
+	const struct scale_plane *p = &s->planes[0];
+	float *row;
+	unsigned int y, end;
+
+	for (unsigned int i = 1; i < s->plane_count; i++) {
+		if (index >= s->planes[i].first_band)
+			p = &s->planes[i];
+	}
+	y = (index - p->first_band) * BAND_HEIGHT;
+	end = y + BAND_HEIGHT;
+	if (end > p->out_dim.height)
+		end = p->out_dim.height;
+
+	if (s->method == VDEF_SCALE_METHOD_NEAREST) {
+		for (; y < end; y++)
+			nearest(s, p, y);
+		return 0;
+	}
+
+	/* Vertical filtering first: the horizontal filtering, which cannot
+	 * be vectorized across pixels, only runs on the output lines */
+	row = s->rows[thread_index];
+	for (; y < end; y++) {
+		const uint8_t *in =
+			p->in + (size_t)p->v.start[y] * p->in_stride;
+		const float *w = p->v.weight + (size_t)y * p->v.taps;
+		unsigned int len = p->in_dim.width * p->channels;
+
+		if (s->bytes == 1)
+			vfilter_u8(in, p->in_stride, len, w, p->v.taps, row);
+		else if (!s->swap)
+			vfilter_u16(in, p->in_stride, len, w, p->v.taps, row);
+		else
+			vfilter_u16_swap(
+				in, p->in_stride, len, w, p->v.taps, row);
+		hfilter_line(s, p, row, p->out + (size_t)y * p->out_stride);
+	}
+
+	return 0;
+}
+
+
+static void scale_clear(struct scale *s)
+{
+	for (unsigned int i = 0; i < s->plane_count; i++) {
+		filter_clear(&s->planes[i].h);
+		filter_clear(&s->planes[i].v);
+	}
+	if (s->rows != NULL) {
+		for (unsigned int i = 0; i < s->row_count; i++)
+			free(s->rows[i]);
+		free(s->rows);
+	}
+}
+
+
+static int scale_init(struct scale *s,
+		      const struct vdef_raw_format *format,
+		      const struct vdef_dim *in_res,
+		      const struct vdef_dim *out_res)
+{
+	int ret;
+	unsigned int channels[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int h_sub[VDEF_RAW_MAX_PLANE_COUNT];
+	unsigned int v_sub[VDEF_RAW_MAX_PLANE_COUNT];
+
+	ret = vdef_priv_get_sample_fmt(format, &s->fmt);
+	if (ret < 0)
+		return ret;
+	s->bytes = format->data_size / 8;
+	s->swap = s->bytes == 2 && format->data_little_endian != HOST_LE;
+
+	ret = get_planes(format, &s->plane_count, channels, h_sub, v_sub);
+	if (ret < 0)
+		return ret;
+
+	/* Whole chroma samples */
+	ULOG_ERRNO_RETURN_ERR_IF(in_res->width % h_sub[s->plane_count - 1] ||
+					 in_res->height %
+						 v_sub[s->plane_count - 1],
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_res->width % h_sub[s->plane_count - 1] ||
+					 out_res->height %
+						 v_sub[s->plane_count - 1],
+				 EINVAL);
+
+	for (unsigned int i = 0; i < s->plane_count; i++) {
+		struct scale_plane *p = &s->planes[i];
+
+		p->channels = channels[i];
+		p->in_dim.width = in_res->width / h_sub[i];
+		p->in_dim.height = in_res->height / v_sub[i];
+		p->out_dim.width = out_res->width / h_sub[i];
+		p->out_dim.height = out_res->height / v_sub[i];
+
+		ret = filter_init(&p->h,
+				  p->in_dim.width,
+				  p->out_dim.width,
+				  s->method);
+		if (ret < 0)
+			return ret;
+		ret = filter_init(&p->v,
+				  p->in_dim.height,
+				  p->out_dim.height,
+				  s->method);
+		if (ret < 0)
+			return ret;
+
+		p->first_band = s->band_count;
+		s->band_count += VDEF_ROUND_UP(p->out_dim.height, BAND_HEIGHT);
+	}
+
+	return 0;
+}
+
+
+/* Allocate the per-thread rows of the widest plane */
+static int scale_alloc_rows(struct scale *s, unsigned int count)
+{
+	int ret;
+	size_t row_len = 0;
+
+	if (s->method == VDEF_SCALE_METHOD_NEAREST)
+		return 0;
+
+	for (unsigned int i = 0; i < s->plane_count; i++) {
+		const struct scale_plane *p = &s->planes[i];
+		size_t len = (size_t)p->in_dim.width * p->channels;
+		if (len > row_len)
+			row_len = len;
+	}
+
+	s->rows = calloc(count, sizeof(*s->rows));
+	if (s->rows == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	s->row_count = count;
+	for (unsigned int i = 0; i < count; i++) {
+		s->rows[i] = malloc(row_len * sizeof(**s->rows));
+		if (s->rows[i] == NULL) {
+			ret = -ENOMEM;
+			ULOG_ERRNO("malloc", -ret);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+
+int vdef_scaler_new(const struct vdef_raw_format *format,
+		    const struct vdef_dim *in_res,
+		    const struct vdef_dim *out_res,
+		    enum vdef_scale_method method,
+		    struct vdef_thread_pool *pool,
+		    struct vdef_scaler **ret_obj)
+{
+	int ret;
+	struct vdef_scaler *scaler;
+
+	ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_is_raw_format_valid(format), EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_res == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(vdef_dim_is_null(in_res), EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_res == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(vdef_dim_is_null(out_res), EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(method >= VDEF_SCALE_METHOD_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	scaler = calloc(1, sizeof(*scaler));
+	if (scaler == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	scaler->format = *format;
+	scaler->in_res = *in_res;
+	scaler->out_res = *out_res;
+	scaler->pool = pool;
+	scaler->s.method = method;
+
+	ret = scale_init(&scaler->s, format, in_res, out_res);
+	if (ret < 0)
+		goto error;
+	ret = scale_alloc_rows(&scaler->s,
+			       vdef_priv_thread_pool_get_thread_count(pool));
+	if (ret < 0)
+		goto error;
+
+	*ret_obj = scaler;
+	return 0;
+
+error:
+	vdef_scaler_destroy(scaler);
+	return ret;
+}
+
+
+int vdef_scaler_destroy(struct vdef_scaler *scaler)
+{
+	if (scaler == NULL)
+		return 0;
+
+	scale_clear(&scaler->s);
+	free(scaler);
+
+	return 0;
+}
+
+
+int vdef_scaler_run(struct vdef_scaler *scaler,
+		    const struct vdef_raw_frame *in_frame,
+		    const void *const *in_plane,
+		    const struct vdef_raw_frame *out_frame,
+		    void *const *out_plane)
+{
+	struct scale *s;
+
+	ULOG_ERRNO_RETURN_ERR_IF(scaler == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_raw_format_cmp(&in_frame->format, &scaler->format),
+		EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_raw_format_cmp(&out_frame->format, &scaler->format),
+		EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_dim_cmp(&in_frame->info.resolution, &scaler->in_res),
+		EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_dim_cmp(&out_frame->info.resolution, &scaler->out_res),
+		EINVAL);
+
+	s = &scaler->s;
+	for (unsigned int i = 0; i < s->plane_count; i++) {
+		struct scale_plane *p = &s->planes[i];
+
+		ULOG_ERRNO_RETURN_ERR_IF(in_plane[i] == NULL, EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(out_plane[i] == NULL, EINVAL);
+		p->in = in_plane[i];
+		p->in_stride = in_frame->plane_stride[i];
+		p->out = out_plane[i];
+		p->out_stride = out_frame->plane_stride[i];
+	}
+
+	return vdef_priv_thread_pool_run(
+		scaler->pool, s->band_count, &scale_band, s);
+}
+
+
+int vdef_scale(const struct vdef_raw_frame *in_frame,
+	       const void *const *in_plane,
+	       const struct vdef_raw_frame *out_frame,
+	       void *const *out_plane,
+	       enum vdef_scale_method method,
+	       struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct vdef_scaler *scaler = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(
+		!vdef_raw_format_cmp(&in_frame->format, &out_frame->format),
+		EINVAL);
+
+	ret = vdef_scaler_new(&in_frame->format,
+			      &in_frame->info.resolution,
+			      &out_frame->info.resolution,
+			      method,
+			      pool,
+			      &scaler);
+	if (ret < 0)
+		return ret;
+
+	ret = vdef_scaler_run(scaler, in_frame, in_plane, out_frame, out_plane);
+
+	vdef_scaler_destroy(scaler);
+	return ret;
+}
+
+
+int vdef_scale_to_resolution(const struct vdef_raw_frame *in_frame,
+			     const void *const *in_plane,
+			     enum vdef_resolution resolution,
+			     struct vdef_raw_frame *out_frame,
+			     void *const *out_plane,
+			     enum vdef_scale_method method,
+			     struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct vdef_raw_frame frame;
+
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+
+	frame = *out_frame;
+	ret = vdef_resolution_to_dim(resolution, &frame.info.resolution);
+	if (ret < 0) {
+		ULOG_ERRNO("vdef_resolution_to_dim", -ret);
+		return -EINVAL;
+	}
+
+	ret = vdef_scale(in_frame, in_plane, &frame, out_plane, method, pool);
+	if (ret < 0)
+		return ret;
+
+	out_frame->info.resolution = frame.info.resolution;
+	return 0;
+}
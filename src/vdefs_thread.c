@@ -0,0 +1,367 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* A range of tasks packs the first task index in the lower 32 bits and the
+ * end task index in the upper 32 bits, so that it is updated atomically */
+#define RANGE_BEGIN(_range) ((uint32_t)((_range) & UINT32_MAX))
+#define RANGE_END(_range) ((uint32_t)((_range) >> 32))
+#define RANGE(_begin, _end) (((uint64_t)(_end) << 32) | (_begin))
+
+
+struct worker {
+	struct vdef_thread_pool *pool;
+	unsigned int index;
+
+	/* Remaining tasks of the current run (see RANGE()); the worker takes
+	 * tasks from the beginning, other workers steal from the end */
+	_Atomic uint64_t range;
+
+	/* Last run processed (worker threads only) */
+	unsigned int generation;
+
+	pthread_t thread;
+	bool started;
+};
+
+
+struct vdef_thread_pool {
+	/* Workers; the first one is the calling thread of
+	 * vdef_thread_pool_run() */
+	struct worker *workers;
+	unsigned int thread_count;
+
+	/* Serializes the runs */
+	pthread_mutex_t run_mutex;
+
+	/* Run start and end signaling */
+	pthread_mutex_t mutex;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	unsigned int generation;
+	unsigned int pending;
+	bool stop;
+
+	/* Current run */
+	int (*task)(unsigned int index,
+		    unsigned int thread_index,
+		    void *userdata);
+	void *userdata;
+	atomic_int ret;
+};
+
+
+/* Take the first task of the worker range */
+static bool pop_task(struct worker *w, unsigned int *index)
+{
+	uint64_t range = atomic_load(&w->range);
+	uint32_t begin;
+
+	do {
+		begin = RANGE_BEGIN(range);
+		if (begin >= RANGE_END(range))
+			return false;
+	} while (!atomic_compare_exchange_weak(
+		&w->range, &range, RANGE(begin + 1, RANGE_END(range))));
+
+	*index = begin;
+	return true;
+}
+
+
+/* Steal the second half of the remaining tasks of another worker; the first
+ * stolen task is returned and the others become the worker range */
+static bool steal_task(struct worker *w, unsigned int *index)
+{
+	struct vdef_thread_pool *pool = w->pool;
+
+	for (unsigned int i = 1; i < pool->thread_count; i++) {
+		struct worker *victim =
+			&pool->workers[(w->index + i) % pool->thread_count];
+		uint64_t range = atomic_load(&victim->range);
+		uint32_t begin, end, mid;
+
+		do {
+			begin = RANGE_BEGIN(range);
+			end = RANGE_END(range);
+			if (begin >= end)
+				break;
+			mid = end - (end - begin + 1) / 2;
+		} while (!atomic_compare_exchange_weak(
+			&victim->range, &range, RANGE(begin, mid)));
+		if (begin >= end)
+			continue;
+
+		/* The worker range is empty: no other worker can modify it */
+		atomic_store(&w->range, RANGE(mid + 1, end));
+		*index = mid;
+		return true;
+	}
+
+	return false;
+}
+
+
+static void worker_run(struct worker *w)
+{
+	int ret, expected = 0;
+	struct vdef_thread_pool *pool = w->pool;
+	unsigned int index;
+
+	while (atomic_load(&pool->ret) == 0) {
+		if (!pop_task(w, &index) && !steal_task(w, &index))
+			break;
+		ret = pool->task(index, w->index, pool->userdata);
+		if (ret < 0) {
+			atomic_compare_exchange_strong(
+				&pool->ret, &expected, ret);
+		}
+	}
+}
+
+
+static void *worker_thread(void *userdata)
+{
+	struct worker *w = userdata;
+	struct vdef_thread_pool *pool = w->pool;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (1) {
+		while (!pool->stop && w->generation == pool->generation)
+			pthread_cond_wait(&pool->start_cond, &pool->mutex);
+		if (pool->stop)
+			break;
+		w->generation = pool->generation;
+		pthread_mutex_unlock(&pool->mutex);
+
+		worker_run(w);
+
+		pthread_mutex_lock(&pool->mutex);
+		pool->pending--;
+		if (pool->pending == 0)
+			pthread_cond_signal(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+
+int vdef_thread_pool_new(unsigned int thread_count,
+			 struct vdef_thread_pool **ret_obj)
+{
+	int ret;
+	struct vdef_thread_pool *pool;
+	long cpus;
+
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	if (thread_count == 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cpus > 0 ? cpus : 1;
+	}
+
+	pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	pthread_mutex_init(&pool->run_mutex, NULL);
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->start_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+	atomic_init(&pool->ret, 0);
+
+	pool->workers = calloc(thread_count, sizeof(*pool->workers));
+	if (pool->workers == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		goto error;
+	}
+	pool->thread_count = thread_count;
+	for (unsigned int i = 0; i < thread_count; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+		atomic_init(&pool->workers[i].range, 0);
+	}
+
+	for (unsigned int i = 1; i < thread_count; i++) {
+		struct worker *w = &pool->workers[i];
+		ret = pthread_create(&w->thread, NULL, &worker_thread, w);
+		if (ret != 0) {
+			ULOG_ERRNO("pthread_create", ret);
+			ret = -ret;
+			goto error;
+		}
+		w->started = true;
+	}
+
+	*ret_obj = pool;
+	return 0;
+
+error:
+	vdef_thread_pool_destroy(pool);
+	return ret;
+}
+
+
+int vdef_thread_pool_destroy(struct vdef_thread_pool *pool)
+{
+	if (pool == NULL)
+		return 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->start_cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (unsigned int i = 0; i < pool->thread_count; i++) {
+		if (pool->workers[i].started)
+			pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->start_cond);
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_mutex_destroy(&pool->run_mutex);
+	free(pool->workers);
+	free(pool);
+
+	return 0;
+}
+
+
+unsigned int
+vdef_thread_pool_get_thread_count(const struct vdef_thread_pool *pool)
+{
+	return pool != NULL ? pool->thread_count : 0;
+}
+
+
+int vdef_thread_pool_run(struct vdef_thread_pool *pool,
+			 unsigned int task_count,
+			 int (*task)(unsigned int index,
+				     unsigned int thread_index,
+				     void *userdata),
+			 void *userdata)
+{
+	int ret;
+	unsigned int count;
+
+	ULOG_ERRNO_RETURN_ERR_IF(pool == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(task == NULL, EINVAL);
+
+	if (task_count == 0)
+		return 0;
+
+	pthread_mutex_lock(&pool->run_mutex);
+
+	pool->task = task;
+	pool->userdata = userdata;
+	atomic_store(&pool->ret, 0);
+
+	/* Contiguous ranges of tasks, so that consecutive bands of a frame
+	 * are processed by the same thread unless stolen */
+	count = pool->thread_count;
+	if (count > task_count)
+		count = task_count;
+	for (unsigned int i = 0; i < pool->thread_count; i++) {
+		uint32_t begin = (uint64_t)task_count * i / count;
+		uint32_t end = (uint64_t)task_count * (i + 1) / count;
+		if (i >= count)
+			begin = end = task_count;
+		atomic_store(&pool->workers[i].range, RANGE(begin, end));
+	}
+
+	/* Wake up the worker threads and process tasks in the calling
+	 * thread until all tasks are taken */
+	if (pool->thread_count > 1) {
+		pthread_mutex_lock(&pool->mutex);
+		pool->generation++;
+		pool->pending = pool->thread_count - 1;
+		pthread_cond_broadcast(&pool->start_cond);
+		pthread_mutex_unlock(&pool->mutex);
+	}
+
+	worker_run(&pool->workers[0]);
+
+	if (pool->thread_count > 1) {
+		pthread_mutex_lock(&pool->mutex);
+		while (pool->pending > 0)
+			pthread_cond_wait(&pool->done_cond, &pool->mutex);
+		pthread_mutex_unlock(&pool->mutex);
+	}
+
+	ret = atomic_load(&pool->ret);
+	pool->task = NULL;
+	pool->userdata = NULL;
+
+	pthread_mutex_unlock(&pool->run_mutex);
+
+	return ret;
+}
+
+
+int vdef_priv_thread_pool_run(struct vdef_thread_pool *pool,
+			      unsigned int task_count,
+			      int (*task)(unsigned int index,
+					  unsigned int thread_index,
+					  void *userdata),
+			      void *userdata)
+{
+	int ret;
+
+	if (pool != NULL)
+		return vdef_thread_pool_run(pool, task_count, task, userdata);
+
+	for (unsigned int i = 0; i < task_count; i++) {
+		ret = task(i, 0, userdata);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+
+unsigned int
+vdef_priv_thread_pool_get_thread_count(const struct vdef_thread_pool *pool)
+{
+	return pool != NULL ? pool->thread_count : 1;
+}
@@ -0,0 +1,369 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Conversion of a plane, one row of tiles at a time */
+struct tile_plane {
+	/* Input plane and stride */
+	const uint8_t *in;
+	size_t in_stride;
+
+	/* Output plane and stride */
+	uint8_t *out;
+	size_t out_stride;
+
+	/* Tile dimension (in bytes and lines) */
+	unsigned int tile_width;
+	unsigned int tile_height;
+
+	/* Plane dimension (in bytes and lines), excluding the tile padding */
+	size_t line_bytes;
+	unsigned int lines;
+
+	/* Sample size in bytes of the interleaved pairs to swap (e.g. from
+	 * NV21 to NV12 chroma samples), 0 if the samples are only copied */
+	unsigned int swap_bytes;
+};
+
+
+struct tile_conv {
+	/* True when converting from the tiled layout to the linear layout */
+	bool detile;
+
+	/* Number of tile rows */
+	unsigned int rows;
+
+	/* Bands of tile rows (see vdef_calc_raw_frame_bands()); the last
+	 * band gets the remaining rows */
+	unsigned int band_rows;
+	unsigned int band_count;
+
+	unsigned int plane_count;
+	struct tile_plane plane[VDEF_RAW_MAX_PLANE_COUNT];
+};
+
+
+static inline __attribute__((always_inline)) void
+copy_lines(uint8_t *dst,
+	   size_t dst_stride,
+	   const uint8_t *src,
+	   size_t src_stride,
+	   size_t width,
+	   unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
+		memcpy(dst + i * dst_stride, src + i * src_stride, width);
+}
+
+
+/* Copy a block of lines between a tile and a linear plane */
+VDEF_PRIV_TARGET_CLONES
+static void copy_block(uint8_t *dst,
+		       size_t dst_stride,
+		       const uint8_t *src,
+		       size_t src_stride,
+		       size_t width,
+		       unsigned int count)
+{
+	/* Constant widths of whole tiles let the compiler expand the copies
+	 * to vector moves (8-bit, 10-bit packed and 16-bit data) */
+	switch (width) {
+	case 64:
+		copy_lines(dst, dst_stride, src, src_stride, 64, count);
+		break;
+	case 80:
+		copy_lines(dst, dst_stride, src, src_stride, 80, count);
+		break;
+	case 128:
+		copy_lines(dst, dst_stride, src, src_stride, 128, count);
+		break;
+	default:
+		copy_lines(dst, dst_stride, src, src_stride, width, count);
+		break;
+	}
+}
+
+
+/* Convert a row of tiles of a plane; the tiles are processed one after the
+ * other so that each tile is read or written sequentially */
+static void convert_tile_row(const struct tile_plane *p,
+			     bool detile,
+			     unsigned int row)
+{
+	unsigned int y = row * p->tile_height;
+	unsigned int count, cols;
+	size_t tile_size = (size_t)p->tile_width * p->tile_height;
+	size_t tiled_stride, linear_stride;
+	const uint8_t *in;
+	uint8_t *out;
+
+	if (y >= p->lines)
+		return;
+	count = p->lines - y;
+	if (count > p->tile_height)
+		count = p->tile_height;
+	cols = VDEF_ROUND_UP(p->line_bytes, p->tile_width);
+
+	tiled_stride = detile ? p->in_stride : p->out_stride;
+	linear_stride = detile ? p->out_stride : p->in_stride;
+	in = p->in + (detile ? row * tiled_stride * p->tile_height
+			     : y * linear_stride);
+	out = p->out + (detile ? y * linear_stride
+			       : row * tiled_stride * p->tile_height);
+
+	for (unsigned int c = 0; c < cols; c++) {
+		size_t x = (size_t)c * p->tile_width;
+		size_t width = p->line_bytes - x;
+		if (width > p->tile_width)
+			width = p->tile_width;
+		if (detile) {
+			copy_block(out + x,
+				   linear_stride,
+				   in + c * tile_size,
+				   p->tile_width,
+				   width,
+				   count);
+		} else {
+			copy_block(out + c * tile_size,
+				   p->tile_width,
+				   in + x,
+				   linear_stride,
+				   width,
+				   count);
+		}
+		if (p->swap_bytes == 0 || detile)
+			continue;
+		for (unsigned int i = 0; i < count; i++) {
+			uint8_t *line = out + c * tile_size + i * p->tile_width;
+			vdef_priv_swap_pairs(line,
+					     line,
+					     width / (2 * p->swap_bytes),
+					     p->swap_bytes);
+		}
+	}
+
+	if (p->swap_bytes == 0 || !detile)
+		return;
+	for (unsigned int i = 0; i < count; i++) {
+		uint8_t *line = out + i * linear_stride;
+		vdef_priv_swap_pairs(line,
+				     line,
+				     p->line_bytes / (2 * p->swap_bytes),
+				     p->swap_bytes);
+	}
+}
+
+
+static void convert_band(const struct tile_conv *conv,
+			 unsigned int row0,
+			 unsigned int row1)
+{
+	for (unsigned int r = row0; r < row1; r++) {
+		for (unsigned int p = 0; p < conv->plane_count; p++)
+			convert_tile_row(&conv->plane[p], conv->detile, r);
+	}
+}
+
+
+static int convert_task(unsigned int index,
+			unsigned int thread_index,
+			void *userdata)
+{
+	const struct tile_conv *conv = userdata;
+	unsigned int row0 = index * conv->band_rows;
+	unsigned int row1 = row0 + conv->band_rows;
+
+	(void)thread_index;
+
+	if (index + 1 == conv->band_count)
+		row1 = conv->rows;
+	convert_band(conv, row0, row1);
+
+	return 0;
+}
+
+
+static bool is_yuv_order(enum vdef_raw_pix_order order)
+{
+	return order == VDEF_RAW_PIX_ORDER_YUV ||
+	       order == VDEF_RAW_PIX_ORDER_YVU;
+}
+
+
+/* Formats must only differ by their pixel layout, and by their chroma order
+ * for semi-planar YUV formats of 8-bit or 16-bit data */
+static bool is_tile_compatible(const struct vdef_raw_format *f1,
+			       const struct vdef_raw_format *f2)
+{
+	struct vdef_raw_format f = *f2;
+
+	f.pix_layout = f1->pix_layout;
+	f.pix_order = f1->pix_order;
+	if (!vdef_raw_format_cmp(f1, &f))
+		return false;
+	if (f1->pix_order == f2->pix_order)
+		return true;
+
+	return (f1->pix_format == VDEF_RAW_PIX_FORMAT_YUV420 ||
+		f1->pix_format == VDEF_RAW_PIX_FORMAT_YUV422 ||
+		f1->pix_format == VDEF_RAW_PIX_FORMAT_YUV444) &&
+	       f1->data_layout == VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR &&
+	       (f1->data_size == 8 || f1->data_size == 16) &&
+	       is_yuv_order(f1->pix_order) && is_yuv_order(f2->pix_order);
+}
+
+
+int vdef_priv_pix_layout_check(const struct vdef_raw_format *in_format,
+			       const struct vdef_raw_format *out_format)
+{
+	bool detile =
+		in_format->pix_layout == VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16;
+	const struct vdef_raw_format *tiled = detile ? in_format : out_format;
+	const struct vdef_raw_format *linear = detile ? out_format : in_format;
+
+	if (tiled->pix_layout != VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16 ||
+	    linear->pix_layout != VDEF_RAW_PIX_LAYOUT_LINEAR ||
+	    !is_tile_compatible(tiled, linear))
+		return -ENOTSUP;
+
+	return 0;
+}
+
+
+static int init_tile_conv(const struct vdef_raw_frame *in_frame,
+			  const void *const *in_plane,
+			  const struct vdef_raw_frame *out_frame,
+			  void *const *out_plane,
+			  struct tile_conv *conv)
+{
+	int ret;
+	const struct vdef_raw_format *tiled, *linear;
+	const struct vdef_dim *res = &in_frame->info.resolution;
+	unsigned int group_samples, group_bytes;
+
+	ret = vdef_priv_pix_layout_check(&in_frame->format, &out_frame->format);
+	if (ret < 0)
+		return ret;
+	conv->detile = in_frame->format.pix_layout ==
+		       VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16;
+	tiled = conv->detile ? &in_frame->format : &out_frame->format;
+	linear = conv->detile ? &out_frame->format : &in_frame->format;
+
+	ret = vdef_get_raw_data_packing_group(
+		linear, &group_samples, &group_bytes);
+	if (ret < 0)
+		return ret;
+
+	conv->rows = 0;
+	conv->plane_count = vdef_get_raw_frame_plane_count(linear);
+	for (unsigned int i = 0; i < conv->plane_count; i++) {
+		struct tile_plane *p = &conv->plane[i];
+		struct vdef_dim tile;
+		unsigned int samples, rows;
+		size_t cols;
+		size_t tiled_stride, linear_stride;
+
+		ret = vdef_get_raw_frame_plane_tile(tiled, i, &tile);
+		if (ret < 0)
+			return ret;
+		ret = vdef_priv_get_plane_samples(
+			linear, res, i, &samples, &p->lines);
+		if (ret < 0)
+			return ret;
+		p->tile_width = tile.width;
+		p->tile_height = tile.height;
+		p->line_bytes = (size_t)VDEF_ROUND_UP(samples, group_samples) *
+				group_bytes;
+		p->in = in_plane[i];
+		p->in_stride = in_frame->plane_stride[i];
+		p->out = out_plane[i];
+		p->out_stride = out_frame->plane_stride[i];
+		p->swap_bytes = 0;
+		if (i == 1 && tiled->pix_order != linear->pix_order)
+			p->swap_bytes = linear->data_size / 8;
+
+		/* The tiled stride must hold whole tiles */
+		tiled_stride = conv->detile ? p->in_stride : p->out_stride;
+		linear_stride = conv->detile ? p->out_stride : p->in_stride;
+		cols = VDEF_ROUND_UP(p->line_bytes, tile.width);
+		ULOG_ERRNO_RETURN_ERR_IF(tiled_stride < cols * tile.width,
+					 EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(linear_stride < p->line_bytes, EINVAL);
+
+		rows = VDEF_ROUND_UP(p->lines, tile.height);
+		if (rows > conv->rows)
+			conv->rows = rows;
+	}
+
+	return 0;
+}
+
+
+int vdef_convert_pix_layout(const struct vdef_raw_frame *in_frame,
+			    const void *const *in_plane,
+			    const struct vdef_raw_frame *out_frame,
+			    void *const *out_plane,
+			    struct vdef_thread_pool *pool)
+{
+	int ret;
+	struct tile_conv conv;
+	unsigned int band_height = 0;
+
+	ULOG_ERRNO_RETURN_ERR_IF(in_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(in_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_frame == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_plane == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!vdef_dim_cmp(&in_frame->info.resolution,
+					       &out_frame->info.resolution),
+				 EINVAL);
+
+	ret = init_tile_conv(in_frame, in_plane, out_frame, out_plane, &conv);
+	if (ret < 0)
+		return ret;
+
+	/* The bands start on whole rows of tiles in every plane */
+	ret = vdef_calc_raw_frame_bands(conv.detile ? &in_frame->format
+						    : &out_frame->format,
+					&in_frame->info.resolution,
+					&band_height,
+					&conv.band_count);
+	if (ret < 0)
+		return ret;
+	conv.band_rows = VDEF_ROUND_UP(band_height, conv.plane[0].tile_height);
+
+	return vdef_priv_thread_pool_run(
+		pool, conv.band_count, &convert_task, &conv);
+}
@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* PQ reference peak luminance (in cd/m2) */
+#define PQ_PEAK_LUMINANCE 10000.f
+
+/* Source peak luminance when the mdcv and cll metadata are unknown
+ * (in cd/m2) */
+#define DEFAULT_SRC_PEAK_LUMINANCE 1000.f
+
+/* Hable filmic curve constants */
+#define HABLE_A 0.15f
+#define HABLE_B 0.50f
+#define HABLE_C 0.10f
+#define HABLE_D 0.20f
+#define HABLE_E 0.02f
+#define HABLE_F 0.30f
+
+
+static inline float pq_encode(float nits)
+{
+	return vdef_transfer_function_from_linear(VDEF_TRANSFER_FUNCTION_PQ,
+						  nits / PQ_PEAK_LUMINANCE);
+}
+
+
+static inline float pq_decode(float v)
+{
+	return vdef_transfer_function_to_linear(VDEF_TRANSFER_FUNCTION_PQ, v) *
+	       PQ_PEAK_LUMINANCE;
+}
+
+
+static inline float hable(float x)
+{
+	return (x * (HABLE_A * x + HABLE_C * HABLE_B) + HABLE_D * HABLE_E) /
+		       (x * (HABLE_A * x + HABLE_B) + HABLE_D * HABLE_F) -
+	       HABLE_E / HABLE_F;
+}
+
+
+/* Rec. ITU-R BT.2390-10 EETF, on PQ encoded values normalized to the source
+ * range */
+static float bt2390_eetf(const struct vdef_priv_tone_curve *curve, float e)
+{
+	float t, t2, t3, ks = curve->knee;
+
+	e = e > 0.f ? e : 0.f;
+	e = e < 1.f ? e : 1.f;
+	if (e > ks) {
+		t = (e - ks) / (1.f - ks);
+		t2 = t * t;
+		t3 = t2 * t;
+		e = (2.f * t3 - 3.f * t2 + 1.f) * ks +
+		    (t3 - 2.f * t2 + t) * (1.f - ks) +
+		    (-2.f * t3 + 3.f * t2) * curve->max_lum;
+	}
+	return e + curve->min_lum * powf(1.f - e, 4.f);
+}
+
+
+int vdef_priv_tone_curve_init(struct vdef_priv_tone_curve *curve,
+			      enum vdef_tone_map_method method,
+			      const struct vdef_format_info *hdr_info)
+{
+	float peak = 0.f, black = 0.f;
+
+	ULOG_ERRNO_RETURN_ERR_IF(curve == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(method >= VDEF_TONE_MAP_METHOD_MAX, EINVAL);
+
+	memset(curve, 0, sizeof(*curve));
+	curve->method = method;
+
+	if (hdr_info != NULL) {
+		peak = hdr_info->mdcv.max_display_mastering_luminance;
+		black = hdr_info->mdcv.min_display_mastering_luminance;
+		if (hdr_info->cll.max_cll > 0 &&
+		    (peak <= 0.f || hdr_info->cll.max_cll < peak))
+			peak = hdr_info->cll.max_cll;
+	}
+	if (!(peak > 0.f))
+		peak = DEFAULT_SRC_PEAK_LUMINANCE;
+	peak = peak < PQ_PEAK_LUMINANCE ? peak : PQ_PEAK_LUMINANCE;
+	peak = peak > VDEF_TONE_MAP_SDR_PEAK_LUMINANCE
+		       ? peak
+		       : VDEF_TONE_MAP_SDR_PEAK_LUMINANCE;
+	black = black > 0.f ? black : 0.f;
+	black = black < peak / 2.f ? black : 0.f;
+	curve->src_peak = peak;
+	curve->src_black = black;
+
+	/* BT.2390 parameters (the SDR black level is 0) */
+	curve->pq_black = pq_encode(black);
+	curve->pq_range = pq_encode(peak) - curve->pq_black;
+	curve->min_lum = -curve->pq_black / curve->pq_range;
+	curve->max_lum = (pq_encode(VDEF_TONE_MAP_SDR_PEAK_LUMINANCE) -
+			  curve->pq_black) /
+			 curve->pq_range;
+	curve->knee = 1.5f * curve->max_lum - 0.5f;
+	curve->knee = curve->knee > 0.f ? curve->knee : 0.f;
+
+	/* Reinhard and Hable parameters */
+	curve->white = peak / VDEF_TONE_MAP_SDR_PEAK_LUMINANCE;
+	curve->norm = 1.f / hable(curve->white);
+
+	return 0;
+}
+
+
+float vdef_priv_tone_curve_apply(const struct vdef_priv_tone_curve *curve,
+				 float value)
+{
+	float x = value * PQ_PEAK_LUMINANCE / VDEF_TONE_MAP_SDR_PEAK_LUMINANCE;
+	float w = curve->white, e;
+
+	if (!(x > 0.f))
+		return 0.f;
+
+	switch (curve->method) {
+	case VDEF_TONE_MAP_METHOD_BT2390:
+		e = (pq_encode(value * PQ_PEAK_LUMINANCE) - curve->pq_black) /
+		    curve->pq_range;
+		e = bt2390_eetf(curve, e);
+		x = pq_decode(e * curve->pq_range + curve->pq_black) /
+		    VDEF_TONE_MAP_SDR_PEAK_LUMINANCE;
+		break;
+	case VDEF_TONE_MAP_METHOD_REINHARD:
+		x = x < w ? x : w;
+		x = x * (1.f + x / (w * w)) / (1.f + x);
+		break;
+	case VDEF_TONE_MAP_METHOD_HABLE:
+		x = x < w ? x : w;
+		x = hable(x) * curve->norm;
+		break;
+	default:
+		return 0.f;
+	}
+
+	x = x > 0.f ? x : 0.f;
+	return x < 1.f ? x : 1.f;
+}
+
+
+int vdef_tone_map_get_sdr_info(const struct vdef_format_info *hdr_info,
+			       struct vdef_format_info *sdr_info)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(hdr_info == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(sdr_info == NULL, EINVAL);
+
+	*sdr_info = *hdr_info;
+	sdr_info->bit_depth = 8;
+	sdr_info->color_primaries = VDEF_COLOR_PRIMARIES_BT709;
+	sdr_info->transfer_function = VDEF_TRANSFER_FUNCTION_BT709;
+	sdr_info->matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+	sdr_info->dynamic_range = VDEF_DYNAMIC_RANGE_SDR;
+	sdr_info->tone_mapping = VDEF_TONE_MAPPING_STANDARD;
+	memset(&sdr_info->mdcv, 0, sizeof(sdr_info->mdcv));
+	memset(&sdr_info->cll, 0, sizeof(sdr_info->cll));
+
+	return 0;
+}
@@ -0,0 +1,498 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "vdefs_priv.h"
+#include <video-defs/vdefs.h>
+
+#define ULOG_TAG vdef
+#include <ulog.h>
+
+
+/* Rec. ITU-R BT.2020-2 OETF constants (also used for BT.601 and BT.709,
+ * whose rounded constants describe the same curve) */
+#define BT2020_ALPHA 1.09929682680944
+#define BT2020_BETA 0.018053968510807
+
+/* SMPTE ST 2084 constants */
+#define PQ_M1 (2610. / 16384.)
+#define PQ_M2 (2523. / 4096. * 128.)
+#define PQ_C1 (3424. / 4096.)
+#define PQ_C2 (2413. / 4096. * 32.)
+#define PQ_C3 (2392. / 4096. * 32.)
+
+/* Rec. ITU-R BT.2100-2 HLG OETF constants */
+#define HLG_A 0.17883277
+#define HLG_B 0.28466892
+#define HLG_C 0.55991073
+
+/* Float input table mantissa bits, depending on the code values bit depth:
+ * the error is within 1 code value up to 12 bits */
+#define FLOAT_MANTISSA_BITS 10
+#define FLOAT_MANTISSA_BITS_16 12
+
+
+/* Lookup tables, built on first use; a table is never replaced once
+ * published, so lookups only need an atomic load */
+static _Atomic(struct vdef_transfer_lut *)
+	s_luts[VDEF_TRANSFER_FUNCTION_MAX][VDEF_TRANSFER_LUT_DIR_MAX][16];
+
+
+static double to_linear(enum vdef_transfer_function transfer, double v)
+{
+	double p;
+
+	v = v > 0. ? v : 0.;
+	v = v < 1. ? v : 1.;
+
+	switch (transfer) {
+	case VDEF_TRANSFER_FUNCTION_BT601:
+	case VDEF_TRANSFER_FUNCTION_BT709:
+	case VDEF_TRANSFER_FUNCTION_BT2020:
+		if (v < 4.5 * BT2020_BETA)
+			return v / 4.5;
+		return pow((v + BT2020_ALPHA - 1.) / BT2020_ALPHA, 1. / 0.45);
+	case VDEF_TRANSFER_FUNCTION_PQ:
+		p = pow(v, 1. / PQ_M2);
+		p = fmax(p - PQ_C1, 0.) / (PQ_C2 - PQ_C3 * p);
+		return pow(p, 1. / PQ_M1);
+	case VDEF_TRANSFER_FUNCTION_HLG:
+		if (v <= 0.5)
+			return v * v / 3.;
+		return (exp((v - HLG_C) / HLG_A) + HLG_B) / 12.;
+	case VDEF_TRANSFER_FUNCTION_SRGB:
+		if (v <= 0.04045)
+			return v / 12.92;
+		return pow((v + 0.055) / 1.055, 2.4);
+	default:
+		return NAN;
+	}
+}
+
+
+static double from_linear(enum vdef_transfer_function transfer, double v)
+{
+	double p;
+
+	v = v > 0. ? v : 0.;
+	v = v < 1. ? v : 1.;
+
+	switch (transfer) {
+	case VDEF_TRANSFER_FUNCTION_BT601:
+	case VDEF_TRANSFER_FUNCTION_BT709:
+	case VDEF_TRANSFER_FUNCTION_BT2020:
+		if (v < BT2020_BETA)
+			return 4.5 * v;
+		return BT2020_ALPHA * pow(v, 0.45) - (BT2020_ALPHA - 1.);
+	case VDEF_TRANSFER_FUNCTION_PQ:
+		p = pow(v, PQ_M1);
+		return pow((PQ_C1 + PQ_C2 * p) / (1. + PQ_C3 * p), PQ_M2);
+	case VDEF_TRANSFER_FUNCTION_HLG:
+		if (v <= 1. / 12.)
+			return sqrt(3. * v);
+		return HLG_A * log(12. * v - HLG_B) + HLG_C;
+	case VDEF_TRANSFER_FUNCTION_SRGB:
+		if (v <= 0.0031308)
+			return 12.92 * v;
+		return 1.055 * pow(v, 1. / 2.4) - 0.055;
+	default:
+		return NAN;
+	}
+}
+
+
+static uint16_t quantize(double v, unsigned int max)
+{
+	v = round(v * max);
+	v = v > 0. ? v : 0.;
+	v = v < max ? v : max;
+	return (uint16_t)v;
+}
+
+
+static void lut_destroy(struct vdef_transfer_lut *lut)
+{
+	if (lut == NULL)
+		return;
+	free(lut->u16);
+	free(lut->f32);
+	free(lut->from_f32);
+	free(lut);
+}
+
+
+/* Linear light value at the center of a float input table entry */
+static double float_entry_value(const struct vdef_transfer_lut *lut,
+				unsigned int index)
+{
+	const int32_t lo = (127 - VDEF_PRIV_TRANSFER_FLOAT_OCTAVES) << 23;
+	int32_t bits;
+	float v;
+
+	if (index == 0)
+		return 0.;
+	if (index == lut->float_max)
+		return 1.;
+	bits = lo + (int32_t)((index - 1) << lut->float_shift) +
+	       (1 << (lut->float_shift - 1));
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+
+/* Display table: PQ is tone mapped to the SDR range (the BT.709 OETF is
+ * then used as the display encoding, as in vdef_tone_map() with a BT.709
+ * output) */
+static int display_table_build(struct vdef_transfer_lut *lut)
+{
+	int ret;
+	struct vdef_priv_tone_curve curve;
+	bool hdr = lut->transfer == VDEF_TRANSFER_FUNCTION_PQ;
+
+	ret = vdef_priv_tone_curve_init(
+		&curve, VDEF_TONE_MAP_METHOD_BT2390, NULL);
+	if (ret < 0)
+		return ret;
+
+	for (unsigned int i = 0; i <= lut->max; i++) {
+		double v = to_linear(lut->transfer, (double)i / lut->max);
+		if (hdr)
+			v = vdef_priv_tone_curve_apply(&curve, v);
+		v = from_linear(VDEF_TRANSFER_FUNCTION_BT709, v);
+		lut->u16[i] = quantize(v, lut->max);
+	}
+
+	return 0;
+}
+
+
+static int lut_build(enum vdef_transfer_function transfer,
+		     enum vdef_transfer_lut_dir dir,
+		     unsigned int bit_depth,
+		     struct vdef_transfer_lut **ret_obj)
+{
+	int ret;
+	struct vdef_transfer_lut *lut;
+	unsigned int code_max = (1u << bit_depth) - 1;
+	unsigned int mantissa_bits;
+
+	lut = calloc(1, sizeof(*lut));
+	if (lut == NULL) {
+		ret = -ENOMEM;
+		ULOG_ERRNO("calloc", -ret);
+		return ret;
+	}
+	lut->transfer = transfer;
+	lut->dir = dir;
+	lut->bit_depth = bit_depth;
+
+	if (dir == VDEF_TRANSFER_LUT_DIR_TO_LINEAR) {
+		lut->max = code_max;
+		lut->u16 = malloc((lut->max + 1) * sizeof(*lut->u16));
+		lut->f32 = malloc((lut->max + 1) * sizeof(*lut->f32));
+		if (lut->u16 == NULL || lut->f32 == NULL)
+			goto error;
+		for (unsigned int i = 0; i <= lut->max; i++) {
+			double v = to_linear(transfer, (double)i / lut->max);
+			lut->u16[i] = quantize(v, UINT16_MAX);
+			lut->f32[i] = v;
+		}
+	} else if (dir == VDEF_TRANSFER_LUT_DIR_TO_BT709) {
+		lut->max = code_max;
+		lut->u16 = malloc((lut->max + 1) * sizeof(*lut->u16));
+		if (lut->u16 == NULL)
+			goto error;
+		ret = display_table_build(lut);
+		if (ret < 0) {
+			lut_destroy(lut);
+			return ret;
+		}
+	} else {
+		mantissa_bits = bit_depth > 12 ? FLOAT_MANTISSA_BITS_16
+					       : FLOAT_MANTISSA_BITS;
+		lut->max = UINT16_MAX;
+		lut->float_shift = 23 - mantissa_bits;
+		lut->float_max =
+			(VDEF_PRIV_TRANSFER_FLOAT_OCTAVES << mantissa_bits) + 1;
+		lut->u16 = malloc((lut->max + 1) * sizeof(*lut->u16));
+		lut->from_f32 =
+			malloc((lut->float_max + 1) * sizeof(*lut->from_f32));
+		if (lut->u16 == NULL || lut->from_f32 == NULL)
+			goto error;
+		for (unsigned int i = 0; i <= lut->max; i++) {
+			double v = from_linear(transfer, (double)i / lut->max);
+			lut->u16[i] = quantize(v, code_max);
+		}
+		for (unsigned int i = 0; i <= lut->float_max; i++) {
+			double v = from_linear(transfer,
+					       float_entry_value(lut, i));
+			lut->from_f32[i] = quantize(v, code_max);
+		}
+	}
+
+	*ret_obj = lut;
+	return 0;
+
+error:
+	ret = -ENOMEM;
+	ULOG_ERRNO("malloc", -ret);
+	lut_destroy(lut);
+	return ret;
+}
+
+
+__attribute__((destructor)) static void lut_cleanup(void)
+{
+	for (unsigned int t = 0; t < VDEF_TRANSFER_FUNCTION_MAX; t++) {
+		for (unsigned int d = 0; d < VDEF_TRANSFER_LUT_DIR_MAX; d++) {
+			for (unsigned int b = 0; b < 16; b++)
+				lut_destroy(atomic_exchange(&s_luts[t][d][b],
+							    NULL));
+		}
+	}
+}
+
+
+/* The lookups are plain loads: the index computation is vectorized per
+ * chunk, but gathers are no faster than scalar loads on most CPUs (and GCC
+ * does not emit them for the generic tuning) */
+VDEF_PRIV_TARGET_CLONES
+static void apply_u16(const uint16_t *table,
+		      unsigned int max,
+		      const uint16_t *src,
+		      uint16_t *dst,
+		      size_t count)
+{
+	uint32_t idx[VDEF_PRIV_CHUNK];
+
+	for (size_t i = 0; i < count; i += VDEF_PRIV_CHUNK) {
+		size_t n = count - i < VDEF_PRIV_CHUNK ? count - i
+						       : VDEF_PRIV_CHUNK;
+		for (size_t j = 0; j < n; j++) {
+			uint32_t v = src[i + j];
+			idx[j] = v < max ? v : max;
+		}
+		for (size_t j = 0; j < n; j++)
+			dst[i + j] = table[idx[j]];
+	}
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void apply_to_f32(const float *table,
+			 unsigned int max,
+			 const uint16_t *src,
+			 float *dst,
+			 size_t count)
+{
+	uint32_t idx[VDEF_PRIV_CHUNK];
+
+	for (size_t i = 0; i < count; i += VDEF_PRIV_CHUNK) {
+		size_t n = count - i < VDEF_PRIV_CHUNK ? count - i
+						       : VDEF_PRIV_CHUNK;
+		for (size_t j = 0; j < n; j++) {
+			uint32_t v = src[i + j];
+			idx[j] = v < max ? v : max;
+		}
+		for (size_t j = 0; j < n; j++)
+			dst[i + j] = table[idx[j]];
+	}
+}
+
+
+VDEF_PRIV_TARGET_CLONES
+static void apply_from_f32(const struct vdef_transfer_lut *lut,
+			   const float *src,
+			   uint16_t *dst,
+			   size_t count)
+{
+	uint32_t idx[VDEF_PRIV_CHUNK];
+
+	for (size_t i = 0; i < count; i += VDEF_PRIV_CHUNK) {
+		size_t n = count - i < VDEF_PRIV_CHUNK ? count - i
+						       : VDEF_PRIV_CHUNK;
+		for (size_t j = 0; j < n; j++) {
+			idx[j] = vdef_priv_transfer_float_index(lut,
+								src[i + j]);
+		}
+		for (size_t j = 0; j < n; j++)
+			dst[i + j] = lut->from_f32[idx[j]];
+	}
+}
+
+
+float vdef_transfer_function_to_linear(enum vdef_transfer_function transfer,
+				       float value)
+{
+	return to_linear(transfer, value);
+}
+
+
+float vdef_transfer_function_from_linear(enum vdef_transfer_function transfer,
+					 float value)
+{
+	return from_linear(transfer, value);
+}
+
+
+static int lut_get(enum vdef_transfer_function transfer,
+		   enum vdef_transfer_lut_dir dir,
+		   unsigned int bit_depth,
+		   const struct vdef_transfer_lut **ret_lut)
+{
+	int ret;
+	_Atomic(struct vdef_transfer_lut *) *slot;
+	struct vdef_transfer_lut *lut, *expected = NULL;
+
+	slot = &s_luts[transfer][dir][bit_depth - 1];
+	lut = atomic_load_explicit(slot, memory_order_acquire);
+	if (lut != NULL) {
+		*ret_lut = lut;
+		return 0;
+	}
+
+	ret = lut_build(transfer, dir, bit_depth, &lut);
+	if (ret < 0)
+		return ret;
+
+	if (!atomic_compare_exchange_strong_explicit(slot,
+						     &expected,
+						     lut,
+						     memory_order_acq_rel,
+						     memory_order_acquire)) {
+		/* Another thread has published the same table in the
+		 * meantime */
+		lut_destroy(lut);
+		lut = expected;
+	}
+
+	*ret_lut = lut;
+	return 0;
+}
+
+
+int vdef_transfer_lut_get(enum vdef_transfer_function transfer,
+			  enum vdef_transfer_lut_dir dir,
+			  unsigned int bit_depth,
+			  const struct vdef_transfer_lut **ret_lut)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(transfer == VDEF_TRANSFER_FUNCTION_UNKNOWN,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(transfer >= VDEF_TRANSFER_FUNCTION_MAX,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(dir >= VDEF_TRANSFER_LUT_DIR_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(bit_depth < 1 || bit_depth > 16, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_lut == NULL, EINVAL);
+
+	return lut_get(transfer, dir, bit_depth, ret_lut);
+}
+
+
+int vdef_tone_mapping_lut_get(enum vdef_tone_mapping tone_mapping,
+			      enum vdef_transfer_lut_dir dir,
+			      unsigned int bit_depth,
+			      const struct vdef_transfer_lut **ret_lut)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(tone_mapping == VDEF_TONE_MAPPING_UNKNOWN,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(tone_mapping >= VDEF_TONE_MAPPING_MAX,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(dir >= VDEF_TRANSFER_LUT_DIR_MAX, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(bit_depth < 1 || bit_depth > 16, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_lut == NULL, EINVAL);
+
+	/* VDEF_TONE_MAPPING_STANDARD has no curve, and the P-log curve is not
+	 * defined yet */
+	return -ENOTSUP;
+}
+
+
+int vdef_format_info_lut_get(const struct vdef_format_info *info,
+			     enum vdef_transfer_lut_dir dir,
+			     const struct vdef_transfer_lut **ret_lut)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(info == NULL, EINVAL);
+
+	if (info->tone_mapping == VDEF_TONE_MAPPING_P_LOG) {
+		return vdef_tone_mapping_lut_get(
+			info->tone_mapping, dir, info->bit_depth, ret_lut);
+	}
+	return vdef_transfer_lut_get(
+		info->transfer_function, dir, info->bit_depth, ret_lut);
+}
+
+
+int vdef_transfer_lut_apply(const struct vdef_transfer_lut *lut,
+			    const uint16_t *src,
+			    uint16_t *dst,
+			    size_t count)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(lut == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(src == NULL && count > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(dst == NULL && count > 0, EINVAL);
+
+	apply_u16(lut->u16, lut->max, src, dst, count);
+
+	return 0;
+}
+
+
+int vdef_transfer_lut_apply_to_float(const struct vdef_transfer_lut *lut,
+				     const uint16_t *src,
+				     float *dst,
+				     size_t count)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(lut == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(lut->dir != VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(src == NULL && count > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(dst == NULL && count > 0, EINVAL);
+
+	apply_to_f32(lut->f32, lut->max, src, dst, count);
+
+	return 0;
+}
+
+
+int vdef_transfer_lut_apply_from_float(const struct vdef_transfer_lut *lut,
+				       const float *src,
+				       uint16_t *dst,
+				       size_t count)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(lut == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(lut->dir != VDEF_TRANSFER_LUT_DIR_FROM_LINEAR,
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(src == NULL && count > 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(dst == NULL && count > 0, EINVAL);
+
+	apply_from_f32(lut, src, dst, count);
+
+	return 0;
+}
@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <video-defs/vdefs.h>
+
+
+#define DEFAULT_FRAME_COUNT 20
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+
+struct bench_frame {
+	struct vdef_raw_frame frame;
+	struct vdef_raw_layout layout;
+	uint8_t *data;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+};
+
+
+/* Kernel run on the bands of a frame */
+struct bench_kernel {
+	const char *name;
+	const struct vdef_raw_format *in_format;
+	const struct vdef_raw_format *out_format;
+	int (*run)(const struct vdef_raw_frame *in_frame,
+		   const void *const *in_plane,
+		   const struct vdef_raw_frame *out_frame,
+		   void *const *out_plane);
+};
+
+
+struct bench_bands {
+	const struct bench_kernel *kernel;
+	const struct bench_frame *in;
+	const struct bench_frame *out;
+	unsigned int band_height;
+};
+
+
+static int convert_pix_layout(const struct vdef_raw_frame *in_frame,
+			      const void *const *in_plane,
+			      const struct vdef_raw_frame *out_frame,
+			      void *const *out_plane)
+{
+	return vdef_convert_pix_layout(
+		in_frame, in_plane, out_frame, out_plane, NULL);
+}
+
+
+static const struct bench_kernel s_kernels[] = {
+	{
+		"yuv-to-rgb",
+		&vdef_i420,
+		&vdef_rgb,
+		&vdef_convert_yuv_to_rgb,
+	},
+	{
+		"raw-data",
+		&vdef_nv12_10_packed,
+		&vdef_nv12_10_16le,
+		&vdef_convert_raw_data,
+	},
+	{
+		"pix-layout",
+		&vdef_nv21_hisi_tile,
+		&vdef_nv21,
+		&convert_pix_layout,
+	},
+};
+
+
+static const struct vdef_dim s_res_2160p = {3840, 2160};
+
+
+static int bench_frame_alloc(struct bench_frame *f,
+			     const struct vdef_raw_format *format)
+{
+	int ret;
+
+	memset(f, 0, sizeof(*f));
+	ret = vdef_calc_raw_layout(
+		format, &s_res_2160p, NULL, NULL, NULL, &f->layout);
+	if (ret < 0)
+		return ret;
+	f->data = calloc(1, f->layout.size);
+	if (f->data == NULL)
+		return -ENOMEM;
+	ret = vdef_raw_layout_get_planes(
+		&f->layout, f->data, f->layout.size, f->plane);
+	if (ret < 0)
+		return ret;
+	f->frame.format = *format;
+	f->frame.info.resolution = s_res_2160p;
+	f->frame.info.matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+	memcpy(f->frame.plane_stride,
+	       f->layout.plane_stride,
+	       sizeof(f->frame.plane_stride));
+
+	return 0;
+}
+
+
+static void bench_frame_free(struct bench_frame *f)
+{
+	free(f->data);
+	memset(f, 0, sizeof(*f));
+}
+
+
+static int get_band(const struct bench_frame *f,
+		    unsigned int band_height,
+		    unsigned int index,
+		    struct vdef_raw_frame *view,
+		    void **plane)
+{
+	int ret;
+	size_t offset[VDEF_RAW_MAX_PLANE_COUNT];
+
+	ret = vdef_calc_raw_frame_band(
+		&f->frame, band_height, index, view, offset);
+	if (ret < 0)
+		return ret;
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		plane[i] = f->plane[i];
+		if (plane[i] != NULL)
+			plane[i] = (uint8_t *)plane[i] + offset[i];
+	}
+
+	return 0;
+}
+
+
+static int band_task(unsigned int index,
+		     unsigned int thread_index,
+		     void *userdata)
+{
+	int ret;
+	struct bench_bands *bands = userdata;
+	struct vdef_raw_frame in, out;
+	void *in_plane[VDEF_RAW_MAX_PLANE_COUNT];
+	void *out_plane[VDEF_RAW_MAX_PLANE_COUNT];
+
+	(void)thread_index;
+
+	ret = get_band(bands->in, bands->band_height, index, &in, in_plane);
+	if (ret < 0)
+		return ret;
+	ret = get_band(bands->out, bands->band_height, index, &out, out_plane);
+	if (ret < 0)
+		return ret;
+
+	return bands->kernel->run(
+		&in, (const void *const *)in_plane, &out, out_plane);
+}
+
+
+/* FNV-1a hash of the output frame, to check that the output does not
+ * depend on the thread count */
+static uint64_t frame_hash(const struct bench_frame *f)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < f->layout.size; i++)
+		hash = (hash ^ f->data[i]) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+
+static uint64_t get_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* Thread counts: powers of 2, then the maximum */
+static unsigned int next_thread_count(unsigned int count, unsigned int max)
+{
+	if (count < max && count * 2 > max)
+		return max;
+	return count * 2;
+}
+
+
+static int bench_kernel(const struct bench_kernel *kernel,
+			unsigned int max_threads,
+			unsigned int band_height,
+			unsigned int frame_count)
+{
+	int ret;
+	struct bench_frame in, out;
+	struct bench_bands bands;
+	struct vdef_thread_pool *pool;
+	unsigned int band_count;
+	uint64_t ref_hash = 0, hash, start, elapsed, ref_elapsed = 0;
+
+	ret = bench_frame_alloc(&in, kernel->in_format);
+	if (ret < 0)
+		goto out;
+	ret = bench_frame_alloc(&out, kernel->out_format);
+	if (ret < 0)
+		goto out;
+	srand(42);
+	for (size_t i = 0; i < in.layout.size; i++)
+		in.data[i] = rand();
+
+	bands.kernel = kernel;
+	bands.in = &in;
+	bands.out = &out;
+	bands.band_height = band_height;
+	ret = vdef_calc_raw_frame_bands(&in.frame.format,
+					&s_res_2160p,
+					&bands.band_height,
+					&band_count);
+	if (ret < 0)
+		goto out;
+
+	printf("%s: " VDEF_RAW_FORMAT_TO_STR_FMT
+	       " to " VDEF_RAW_FORMAT_TO_STR_FMT
+	       ", %u bands of %u lines\n",
+	       kernel->name,
+	       VDEF_RAW_FORMAT_TO_STR_ARG(kernel->in_format),
+	       VDEF_RAW_FORMAT_TO_STR_ARG(kernel->out_format),
+	       band_count,
+	       bands.band_height);
+	printf("  threads  ms/frame     fps  speedup\n");
+
+	for (unsigned int t = 1; t <= max_threads;
+	     t = next_thread_count(t, max_threads)) {
+		ret = vdef_thread_pool_new(t, &pool);
+		if (ret < 0)
+			goto out;
+
+		/* Warm up, then time the frames */
+		memset(out.data, 0, out.layout.size);
+		ret = vdef_thread_pool_run(
+			pool, band_count, &band_task, &bands);
+		if (ret < 0) {
+			vdef_thread_pool_destroy(pool);
+			goto out;
+		}
+		start = get_time_us();
+		for (unsigned int i = 0; i < frame_count; i++) {
+			ret = vdef_thread_pool_run(
+				pool, band_count, &band_task, &bands);
+			if (ret < 0)
+				break;
+		}
+		elapsed = get_time_us() - start;
+		vdef_thread_pool_destroy(pool);
+		if (ret < 0)
+			goto out;
+		if (elapsed == 0)
+			elapsed = 1;
+
+		hash = frame_hash(&out);
+		if (t == 1) {
+			ref_hash = hash;
+			ref_elapsed = elapsed;
+		}
+		printf("  %7u  %8.2f  %6.1f  %6.2fx%s\n",
+		       t,
+		       elapsed / 1000. / frame_count,
+		       frame_count * 1000000. / elapsed,
+		       (double)ref_elapsed / elapsed,
+		       hash == ref_hash ? "" : "  (output mismatch)");
+		if (hash != ref_hash)
+			ret = -EPROTO;
+	}
+
+out:
+	if (ret < 0)
+		fprintf(stderr, "%s: %s\n", kernel->name, strerror(-ret));
+	bench_frame_free(&in);
+	bench_frame_free(&out);
+	return ret;
+}
+
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s [options]\n"
+	       "Options:\n"
+	       "  -h  Print this message and exit\n"
+	       "  -n  Number of timed frames per thread count (default %d)\n"
+	       "  -t  Maximum number of threads (default: online CPUs)\n"
+	       "  -b  Band height in lines (default %d)\n",
+	       prog,
+	       DEFAULT_FRAME_COUNT,
+	       VDEF_RAW_FRAME_BAND_DEFAULT_HEIGHT);
+}
+
+
+/* Time pixel kernels run on the bands of 2160p frames with 1 to N
+ * threads */
+int main(int argc, char **argv)
+{
+	int ret = 0, c;
+	unsigned int frame_count = DEFAULT_FRAME_COUNT;
+	unsigned int max_threads = 0, band_height = 0;
+	long cpus;
+
+	while ((c = getopt(argc, argv, "hn:t:b:")) != -1) {
+		switch (c) {
+		case 'n':
+			frame_count = atoi(optarg);
+			break;
+		case 't':
+			max_threads = atoi(optarg);
+			break;
+		case 'b':
+			band_height = atoi(optarg);
+			break;
+		case 'h':
+			usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (frame_count == 0)
+		frame_count = 1;
+	if (max_threads == 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		max_threads = cpus > 0 ? cpus : 1;
+	}
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_kernels); i++) {
+		int err = bench_kernel(
+			&s_kernels[i], max_threads, band_height, frame_count);
+		if (err < 0)
+			ret = err;
+		printf("\n");
+	}
+
+	return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -29,11 +29,25 @@
 
 static CU_SuiteInfo s_suites[] = {
 	{FN("calc"), NULL, NULL, g_vdef_test_calc},
+	{FN("convert"), NULL, NULL, g_vdef_test_convert},
 	{FN("csv"), NULL, NULL, g_vdef_test_csv},
+	{FN("data"), NULL, NULL, g_vdef_test_data},
+	{FN("demosaic"), NULL, NULL, g_vdef_test_demosaic},
 	{FN("frac"), NULL, NULL, g_vdef_test_frac},
 	{FN("framerate"), NULL, NULL, g_vdef_test_framerate},
+	{FN("gamut"), NULL, NULL, g_vdef_test_gamut},
 	{FN("json"), NULL, NULL, g_vdef_test_json},
+	{FN("layout"), NULL, NULL, g_vdef_test_layout},
+	{FN("lut3d"), NULL, NULL, g_vdef_test_lut3d},
+	{FN("order"), NULL, NULL, g_vdef_test_order},
+	{FN("plan"), NULL, NULL, g_vdef_test_plan},
+	{FN("pool"), NULL, NULL, g_vdef_test_pool},
 	{FN("resolution"), NULL, NULL, g_vdef_test_resolution},
+	{FN("scale"), NULL, NULL, g_vdef_test_scale},
+	{FN("thread"), NULL, NULL, g_vdef_test_thread},
+	{FN("tile"), NULL, NULL, g_vdef_test_tile},
+	{FN("tone-map"), NULL, NULL, g_vdef_test_tone_map},
+	{FN("transfer"), NULL, NULL, g_vdef_test_transfer},
 	{FN("utils"), NULL, NULL, g_vdef_test_utils},
 
 	CU_SUITE_INFO_NULL,
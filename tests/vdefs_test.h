@@ -36,6 +36,7 @@
 #include <errno.h>
 #include <json-c/json.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -44,12 +45,69 @@
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(*x))
 
 
+/* Test frame in a contiguous buffer */
+struct vdef_test_frame {
+	struct vdef_raw_frame frame;
+	struct vdef_raw_layout layout;
+	uint8_t *data;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+};
+
+
 extern CU_TestInfo g_vdef_test_calc[];
+extern CU_TestInfo g_vdef_test_convert[];
 extern CU_TestInfo g_vdef_test_csv[];
+extern CU_TestInfo g_vdef_test_data[];
+extern CU_TestInfo g_vdef_test_demosaic[];
 extern CU_TestInfo g_vdef_test_frac[];
 extern CU_TestInfo g_vdef_test_framerate[];
+extern CU_TestInfo g_vdef_test_gamut[];
 extern CU_TestInfo g_vdef_test_json[];
+extern CU_TestInfo g_vdef_test_layout[];
+extern CU_TestInfo g_vdef_test_lut3d[];
+extern CU_TestInfo g_vdef_test_order[];
+extern CU_TestInfo g_vdef_test_plan[];
+extern CU_TestInfo g_vdef_test_pool[];
 extern CU_TestInfo g_vdef_test_resolution[];
+extern CU_TestInfo g_vdef_test_scale[];
+extern CU_TestInfo g_vdef_test_thread[];
+extern CU_TestInfo g_vdef_test_tile[];
+extern CU_TestInfo g_vdef_test_tone_map[];
+extern CU_TestInfo g_vdef_test_transfer[];
 extern CU_TestInfo g_vdef_test_utils[];
 
+
+/* Get a sample of an 8-bit or 16-bit data format (the padding bits of the
+ * 16-bit data are removed) */
+unsigned int vdef_test_sample_get(const struct vdef_raw_format *format,
+				  const uint8_t *p);
+
+
+/* Set a sample of an 8-bit or 16-bit data format */
+void vdef_test_sample_set(const struct vdef_raw_format *format,
+			  uint8_t *p,
+			  unsigned int v);
+
+
+/* Allocate a zeroed frame with the default layout of the format */
+void vdef_test_frame_alloc(struct vdef_test_frame *f,
+			   const struct vdef_raw_format *format,
+			   const struct vdef_dim *resolution);
+
+
+/* Allocate a zeroed frame with the plane strides aligned to stride_align
+ * bytes (0 for no alignment) */
+void vdef_test_frame_alloc_aligned(struct vdef_test_frame *f,
+				   const struct vdef_raw_format *format,
+				   const struct vdef_dim *resolution,
+				   unsigned int stride_align);
+
+
+/* Set the frame info color parameters (the resolution is kept) */
+void vdef_test_frame_set_info(struct vdef_test_frame *f,
+			      const struct vdef_format_info *info);
+
+
+void vdef_test_frame_free(struct vdef_test_frame *f);
+
 #endif /* _VDEFS_TEST_H_ */
@@ -59,6 +59,54 @@ static const struct vdef_raw_format vdef_rgba_planar = {
 	.data_size = 8,
 };
 
+/* Interleaved YUV422 formats not defined by the library; their default
+ * stride holds 2 samples per pixel */
+static const struct vdef_raw_format vdef_uyvy = {
+	.pix_format = VDEF_RAW_PIX_FORMAT_YUV422,
+	.pix_order = VDEF_RAW_PIX_ORDER_UYVY,
+	.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+	.pix_size = 8,
+	.data_layout = VDEF_RAW_DATA_LAYOUT_INTERLEAVED,
+	.data_pad_low = false,
+	.data_little_endian = false,
+	.data_size = 8,
+};
+
+static const struct vdef_raw_format vdef_yuyv_10_16le = {
+	.pix_format = VDEF_RAW_PIX_FORMAT_YUV422,
+	.pix_order = VDEF_RAW_PIX_ORDER_YUYV,
+	.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+	.pix_size = 10,
+	.data_layout = VDEF_RAW_DATA_LAYOUT_INTERLEAVED,
+	.data_pad_low = false,
+	.data_little_endian = true,
+	.data_size = 16,
+};
+
+/* Planar and semi-planar YUV422 formats, not affected by the interleaved
+ * YUV422 stride */
+static const struct vdef_raw_format vdef_i422 = {
+	.pix_format = VDEF_RAW_PIX_FORMAT_YUV422,
+	.pix_order = VDEF_RAW_PIX_ORDER_YUV,
+	.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+	.pix_size = 8,
+	.data_layout = VDEF_RAW_DATA_LAYOUT_PLANAR_Y_U_V,
+	.data_pad_low = false,
+	.data_little_endian = false,
+	.data_size = 8,
+};
+
+static const struct vdef_raw_format vdef_nv16 = {
+	.pix_format = VDEF_RAW_PIX_FORMAT_YUV422,
+	.pix_order = VDEF_RAW_PIX_ORDER_YUV,
+	.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+	.pix_size = 8,
+	.data_layout = VDEF_RAW_DATA_LAYOUT_SEMI_PLANAR_Y_UV,
+	.data_pad_low = false,
+	.data_little_endian = false,
+	.data_size = 8,
+};
+
 
 struct single_test {
 	/* Resolution */
@@ -269,6 +317,12 @@ struct test_case raw10_packed = {.fmt = &vdef_raw10_packed,
 						 .size_align = {1024},
 						 .expected_size = {6291456},
 					 },
+					 {
+						 .res = {1001, 10},
+						 .expected_stride = {1255},
+						 .expected_scanline = {10},
+						 .expected_size = {12550},
+					 },
 					 END_TEST_ARRAY,
 				 }};
 struct test_case raw10 = {.fmt = &vdef_raw10,
@@ -331,6 +385,12 @@ struct test_case raw12_packed = {.fmt = &vdef_raw12_packed,
 						 .size_align = {1024},
 						 .expected_size = {6291456},
 					 },
+					 {
+						 .res = {1001, 10},
+						 .expected_stride = {1503},
+						 .expected_scanline = {10},
+						 .expected_size = {15030},
+					 },
 					 END_TEST_ARRAY,
 				 }};
 struct test_case raw12 = {.fmt = &vdef_raw12,
@@ -393,6 +453,12 @@ struct test_case raw14_packed = {.fmt = &vdef_raw14_packed,
 						 .size_align = {1024},
 						 .expected_size = {8388608},
 					 },
+					 {
+						 .res = {1001, 10},
+						 .expected_stride = {1757},
+						 .expected_scanline = {10},
+						 .expected_size = {17570},
+					 },
 					 END_TEST_ARRAY,
 				 }};
 struct test_case raw14 = {.fmt = &vdef_raw14,
@@ -993,6 +1059,12 @@ struct test_case nv12_10_packed = {
 			.size_align = {1024, 512},
 			.expected_size = {6291456, 2621440},
 		},
+		{
+			.res = {1002, 10},
+			.expected_stride = {1255, 1255},
+			.expected_scanline = {10, 5},
+			.expected_size = {12550, 6275},
+		},
 		END_TEST_ARRAY,
 	}};
 struct test_case nv12_10_16be = {
@@ -1314,6 +1386,139 @@ struct test_case nv21_10_16le_high = {
 		},
 		END_TEST_ARRAY,
 	}};
+struct test_case yuyv = {.fmt = &vdef_yuyv,
+			 .tests = {
+				 {
+					 .res = {8000, 6000},
+					 .expected_stride = {16000},
+					 .expected_scanline = {6000},
+					 .expected_size = {96000000},
+				 },
+				 {
+					 .res = {1920, 1080},
+					 .expected_stride = {3840},
+					 .expected_scanline = {1080},
+					 .expected_size = {4147200},
+				 },
+				 {
+					 .res = {1280, 720},
+					 .expected_stride = {2560},
+					 .expected_scanline = {720},
+					 .expected_size = {1843200},
+				 },
+				 {
+					 .res = {1920, 1080},
+					 .stride_align = {1024},
+					 .expected_stride = {4096},
+					 .scanline_align = {1024},
+					 .expected_scanline = {2048},
+					 .size_align = {1024},
+					 .expected_size = {8388608},
+				 },
+				 END_TEST_ARRAY,
+			 }};
+struct test_case yvyu = {.fmt = &vdef_yvyu,
+			 .tests = {
+				 {
+					 .res = {8000, 6000},
+					 .expected_stride = {16000},
+					 .expected_scanline = {6000},
+					 .expected_size = {96000000},
+				 },
+				 {
+					 .res = {1920, 1080},
+					 .expected_stride = {3840},
+					 .expected_scanline = {1080},
+					 .expected_size = {4147200},
+				 },
+				 {
+					 .res = {1280, 720},
+					 .expected_stride = {2560},
+					 .expected_scanline = {720},
+					 .expected_size = {1843200},
+				 },
+				 {
+					 .res = {1920, 1080},
+					 .stride_align = {1024},
+					 .expected_stride = {4096},
+					 .scanline_align = {1024},
+					 .expected_scanline = {2048},
+					 .size_align = {1024},
+					 .expected_size = {8388608},
+				 },
+				 END_TEST_ARRAY,
+			 }};
+struct test_case uyvy = {.fmt = &vdef_uyvy,
+			 .tests = {
+				 {
+					 .res = {1920, 1080},
+					 .expected_stride = {3840},
+					 .expected_scanline = {1080},
+					 .expected_size = {4147200},
+				 },
+				 {
+					 .res = {1280, 720},
+					 .stride_align = {1024},
+					 .expected_stride = {3072},
+					 .expected_scanline = {720},
+					 .expected_size = {2211840},
+				 },
+				 END_TEST_ARRAY,
+			 }};
+struct test_case yuyv_10_16le = {
+	.fmt = &vdef_yuyv_10_16le,
+	.tests = {
+		{
+			.res = {1920, 1080},
+			.expected_stride = {7680},
+			.expected_scanline = {1080},
+			.expected_size = {8294400},
+		},
+		{
+			.res = {1280, 720},
+			.stride_align = {1024},
+			.expected_stride = {5120},
+			.expected_scanline = {720},
+			.expected_size = {3686400},
+		},
+		END_TEST_ARRAY,
+	}};
+struct test_case i422 = {
+	.fmt = &vdef_i422,
+	.tests = {
+		{
+			.res = {1920, 1080},
+			.expected_stride = {1920, 960, 960},
+			.expected_scanline = {1080, 1080, 1080},
+			.expected_size = {2073600, 1036800, 1036800},
+		},
+		{
+			.res = {1280, 720},
+			.stride_align = {1024, 512, 0},
+			.expected_stride = {2048, 1024, 640},
+			.expected_scanline = {720, 720, 720},
+			.expected_size = {1474560, 737280, 460800},
+		},
+		END_TEST_ARRAY,
+	}};
+struct test_case nv16 = {
+	.fmt = &vdef_nv16,
+	.tests = {
+		{
+			.res = {1920, 1080},
+			.expected_stride = {1920, 1920},
+			.expected_scanline = {1080, 1080},
+			.expected_size = {2073600, 2073600},
+		},
+		{
+			.res = {1280, 720},
+			.stride_align = {1024, 512},
+			.expected_stride = {2048, 1536},
+			.expected_scanline = {720, 720},
+			.expected_size = {1474560, 1105920},
+		},
+		END_TEST_ARRAY,
+	}};
 struct test_case i444 = {
 	.fmt = &vdef_i444,
 	.tests = {
@@ -1600,6 +1805,135 @@ struct test_case abgr = {.fmt = &vdef_abgr,
 			 }};
 
 
+struct test_case nv21_hisi_tile = {
+	.fmt = &vdef_nv21_hisi_tile,
+	.tests = {
+		{
+			.res = {4000, 3000},
+			.expected_stride = {4032, 4032},
+			.expected_scanline = {3008, 1504},
+			.expected_size = {12128256, 6064128},
+		},
+		{
+			.res = {1920, 1080},
+			.expected_stride = {1920, 1920},
+			.expected_scanline = {1088, 544},
+			.expected_size = {2088960, 1044480},
+		},
+		{
+			.res = {1280, 720},
+			.expected_stride = {1280, 1280},
+			.expected_scanline = {720, 360},
+			.expected_size = {921600, 460800},
+		},
+		{
+			.res = {1920, 1080},
+			.stride_align = {1024, 512},
+			.expected_stride = {2048, 2048},
+			.scanline_align = {1024, 512},
+			.expected_scanline = {2048, 1024},
+			.size_align = {1024, 512},
+			.expected_size = {4194304, 2097152},
+		},
+		END_TEST_ARRAY,
+	}};
+struct test_case nv21_hisi_tile_compressed = {
+	.fmt = &vdef_nv21_hisi_tile_compressed,
+	.tests = {
+		{
+			.res = {4000, 3000},
+			.expected_stride = {4032, 4032},
+			.expected_scanline = {3008, 1504},
+			.expected_size = {12128256, 6064128},
+		},
+		{
+			.res = {1920, 1080},
+			.expected_stride = {1920, 1920},
+			.expected_scanline = {1088, 544},
+			.expected_size = {2088960, 1044480},
+		},
+		{
+			.res = {1280, 720},
+			.expected_stride = {1280, 1280},
+			.expected_scanline = {720, 360},
+			.expected_size = {921600, 460800},
+		},
+		{
+			.res = {1920, 1080},
+			.stride_align = {1024, 512},
+			.expected_stride = {2048, 2048},
+			.scanline_align = {1024, 512},
+			.expected_scanline = {2048, 1024},
+			.size_align = {1024, 512},
+			.expected_size = {4194304, 2097152},
+		},
+		END_TEST_ARRAY,
+	}};
+struct test_case nv21_hisi_tile_10_packed = {
+	.fmt = &vdef_nv21_hisi_tile_10_packed,
+	.tests = {
+		{
+			.res = {4000, 3000},
+			.expected_stride = {5040, 5040},
+			.expected_scanline = {3008, 1504},
+			.expected_size = {15160320, 7580160},
+		},
+		{
+			.res = {1920, 1080},
+			.expected_stride = {2400, 2400},
+			.expected_scanline = {1088, 544},
+			.expected_size = {2611200, 1305600},
+		},
+		{
+			.res = {1280, 720},
+			.expected_stride = {1600, 1600},
+			.expected_scanline = {720, 360},
+			.expected_size = {1152000, 576000},
+		},
+		{
+			.res = {1920, 1080},
+			.stride_align = {1024, 512},
+			.expected_stride = {3072, 2560},
+			.scanline_align = {1024, 512},
+			.expected_scanline = {2048, 1024},
+			.size_align = {1024, 512},
+			.expected_size = {6291456, 2621440},
+		},
+		END_TEST_ARRAY,
+	}};
+struct test_case nv21_hisi_tile_compressed_10_packed = {
+	.fmt = &vdef_nv21_hisi_tile_compressed_10_packed,
+	.tests = {
+		{
+			.res = {4000, 3000},
+			.expected_stride = {5040, 5040},
+			.expected_scanline = {3008, 1504},
+			.expected_size = {15160320, 7580160},
+		},
+		{
+			.res = {1920, 1080},
+			.expected_stride = {2400, 2400},
+			.expected_scanline = {1088, 544},
+			.expected_size = {2611200, 1305600},
+		},
+		{
+			.res = {1280, 720},
+			.expected_stride = {1600, 1600},
+			.expected_scanline = {720, 360},
+			.expected_size = {1152000, 576000},
+		},
+		{
+			.res = {1920, 1080},
+			.stride_align = {1024, 512},
+			.expected_stride = {3072, 2560},
+			.scanline_align = {1024, 512},
+			.expected_scanline = {2048, 1024},
+			.size_align = {1024, 512},
+			.expected_size = {6291456, 2621440},
+		},
+		END_TEST_ARRAY,
+	}};
+
 struct test_case *all_tests[] = {
 	/* RAW formats */
 	&raw8,
@@ -1640,6 +1974,14 @@ struct test_case *all_tests[] = {
 	&nv21_10_16be,
 	&nv21_10_16le_high,
 	&nv21_10_16be_high,
+	/* YUV422 interleaved formats */
+	&yuyv,
+	&yvyu,
+	&uyvy,
+	&yuyv_10_16le,
+	/* YUV422 planar and semi-planar formats */
+	&i422,
+	&nv16,
 	/* YUV444 planar formats */
 	&i444,
 	&i444_semi,
@@ -1652,6 +1994,11 @@ struct test_case *all_tests[] = {
 	&rgba_planar,
 	&bgra,
 	&abgr,
+	/* Hardware specific formats */
+	&nv21_hisi_tile,
+	&nv21_hisi_tile_compressed,
+	&nv21_hisi_tile_10_packed,
+	&nv21_hisi_tile_compressed_10_packed,
 	NULL,
 };
 
@@ -1681,10 +2028,145 @@ static void test_calc_raw_contiguous_frame_size(void)
 	}
 }
 
+
+static void test_get_raw_frame_plane_tile(void)
+{
+	int res;
+	struct vdef_dim tile;
+
+	/* Invalid arguments */
+	res = vdef_get_raw_frame_plane_tile(NULL, 0, &tile);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_get_raw_frame_plane_tile(&vdef_nv21_hisi_tile, 0, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_get_raw_frame_plane_tile(&vdef_nv21_hisi_tile, 2, &tile);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Linear layout */
+	res = vdef_get_raw_frame_plane_tile(&vdef_nv21, 0, &tile);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* Tiled layouts */
+	res = vdef_get_raw_frame_plane_tile(&vdef_nv21_hisi_tile, 0, &tile);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(tile.width, 64);
+	CU_ASSERT_EQUAL(tile.height, 16);
+
+	res = vdef_get_raw_frame_plane_tile(&vdef_nv21_hisi_tile, 1, &tile);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(tile.width, 64);
+	CU_ASSERT_EQUAL(tile.height, 8);
+
+	res = vdef_get_raw_frame_plane_tile(
+		&vdef_nv21_hisi_tile_compressed_10_packed, 0, &tile);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(tile.width, 80);
+	CU_ASSERT_EQUAL(tile.height, 16);
+
+	res = vdef_get_raw_frame_plane_tile(
+		&vdef_nv21_hisi_tile_10_packed, 1, &tile);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(tile.width, 80);
+	CU_ASSERT_EQUAL(tile.height, 8);
+}
+
+
+static void test_get_raw_data_packing_group(void)
+{
+	int res;
+	unsigned int samples, bytes;
+	struct vdef_raw_format fmt = vdef_raw8;
+
+	/* Invalid arguments */
+	res = vdef_get_raw_data_packing_group(NULL, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	fmt.data_size = 0;
+	res = vdef_get_raw_data_packing_group(&fmt, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Optional outputs */
+	res = vdef_get_raw_data_packing_group(&vdef_raw8, NULL, NULL);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Byte-aligned data sizes */
+	res = vdef_get_raw_data_packing_group(&vdef_raw8, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 1);
+	CU_ASSERT_EQUAL(bytes, 1);
+
+	res = vdef_get_raw_data_packing_group(&vdef_raw10, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 1);
+	CU_ASSERT_EQUAL(bytes, 2);
+
+	res = vdef_get_raw_data_packing_group(&vdef_raw32, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 1);
+	CU_ASSERT_EQUAL(bytes, 4);
+
+	/* Packed data sizes */
+	res = vdef_get_raw_data_packing_group(
+		&vdef_raw10_packed, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 4);
+	CU_ASSERT_EQUAL(bytes, 5);
+
+	res = vdef_get_raw_data_packing_group(
+		&vdef_bayer_rggb_12_packed, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 2);
+	CU_ASSERT_EQUAL(bytes, 3);
+
+	res = vdef_get_raw_data_packing_group(
+		&vdef_raw14_packed, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 4);
+	CU_ASSERT_EQUAL(bytes, 7);
+
+	res = vdef_get_raw_data_packing_group(
+		&vdef_nv12_10_packed, &samples, &bytes);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(samples, 4);
+	CU_ASSERT_EQUAL(bytes, 5);
+}
+
+
+static void test_calc_rgb_pix_size(void)
+{
+	const struct vdef_raw_format *formats[] = {&vdef_rgb, &vdef_rgba};
+
+	for (size_t i = 0; i < ARRAY_SIZE(formats); i++) {
+		struct vdef_raw_format fmt = *formats[i];
+
+		/* 8-bit, or up to 16 bits in 16-bit data */
+		CU_ASSERT_TRUE(vdef_is_raw_format_valid(&fmt));
+		fmt.data_size = 16;
+		fmt.pix_size = 10;
+		CU_ASSERT_TRUE(vdef_is_raw_format_valid(&fmt));
+		fmt.pix_size = 16;
+		CU_ASSERT_TRUE(vdef_is_raw_format_valid(&fmt));
+
+		/* Packed or unpadded data */
+		fmt.data_size = 10;
+		fmt.pix_size = 10;
+		CU_ASSERT_FALSE(vdef_is_raw_format_valid(&fmt));
+		fmt.data_size = 12;
+		fmt.pix_size = 12;
+		CU_ASSERT_FALSE(vdef_is_raw_format_valid(&fmt));
+	}
+}
+
+
 CU_TestInfo g_vdef_test_calc[] = {
 	{FN("vdef-calc-raw-contiguous-frame-size"),
 	 &test_calc_raw_contiguous_frame_size},
 	{FN("calc-frame-size"), &test_calc_raw_frame_size},
+	{FN("get-raw-frame-plane-tile"), &test_get_raw_frame_plane_tile},
+	{FN("get-raw-data-packing-group"), &test_get_raw_data_packing_group},
+	{FN("calc-rgb-pix-size"), &test_calc_rgb_pix_size},
 
 	CU_TEST_INFO_NULL,
 };
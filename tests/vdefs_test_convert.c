@@ -0,0 +1,786 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <math.h>
+
+
+static const struct vdef_dim s_test_res[] = {
+	{37, 9},
+	{133, 4},
+	{129, 3},
+};
+
+
+static const enum vdef_matrix_coefs s_test_matrix[] = {
+	VDEF_MATRIX_COEFS_BT601_525,
+	VDEF_MATRIX_COEFS_BT709,
+	VDEF_MATRIX_COEFS_BT2020_NON_CST,
+};
+
+
+/* Address of a Y (0), U (1) or V (2) sample of a YUV 4:2:0 or 4:4:4 planar
+ * or semi-planar frame (the last chroma samples are used for the last pixels
+ * of odd dimensions frames) */
+static uint8_t *yuv_sample_ptr(struct vdef_test_frame *f,
+			       unsigned int c,
+			       unsigned int x,
+			       unsigned y)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	unsigned int bytes = format->data_size / 8;
+	bool first = (c == 1) == (format->pix_order == VDEF_RAW_PIX_ORDER_YUV);
+	unsigned int sub =
+		(format->pix_format == VDEF_RAW_PIX_FORMAT_YUV420) ? 2 : 1;
+	const struct vdef_dim *res = &f->frame.info.resolution;
+	uint8_t *plane;
+
+	if (c == 0) {
+		return (uint8_t *)f->plane[0] + y * f->frame.plane_stride[0] +
+		       x * bytes;
+	}
+	x /= sub;
+	y /= sub;
+	if (x >= res->width / sub)
+		x = res->width / sub - 1;
+	if (y >= res->height / sub)
+		y = res->height / sub - 1;
+	if (format->data_layout == VDEF_RAW_DATA_LAYOUT_PLANAR) {
+		plane = f->plane[first ? 1 : 2];
+		return plane + y * f->frame.plane_stride[first ? 1 : 2] +
+		       x * bytes;
+	}
+	plane = f->plane[1];
+	return plane + y * f->frame.plane_stride[1] +
+	       (2 * x + (first ? 0 : 1)) * bytes;
+}
+
+
+/* Address of a R (0), G (1), B (2) or A (3) sample of a packed RGB frame */
+static uint8_t *rgb_sample_ptr(struct vdef_test_frame *f,
+			       unsigned int c,
+			       unsigned int x,
+			       unsigned y)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	const char *order = vdef_raw_pix_order_to_str(format->pix_order);
+	unsigned int n = vdef_get_raw_frame_component_count(format->pix_format);
+	unsigned int bytes = format->data_size / 8;
+	unsigned int pos = 0;
+
+	while (pos < n && (unsigned int)(order[pos] - 'A') != c)
+		pos++;
+	return (uint8_t *)f->plane[0] + y * f->frame.plane_stride[0] +
+	       (x * n + pos) * bytes;
+}
+
+
+static void fill_yuv(struct vdef_test_frame *f)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	unsigned int max = (1 << format->pix_size) - 1;
+	const struct vdef_dim *res = &f->frame.info.resolution;
+
+	for (unsigned int y = 0; y < res->height; y++) {
+		for (unsigned int x = 0; x < res->width; x++) {
+			for (unsigned int c = 0; c < 3; c++) {
+				if (c > 0 && ((x | y) & 1))
+					continue;
+				vdef_test_sample_set(format,
+						     yuv_sample_ptr(f, c, x, y),
+						     rand() % (max + 1));
+			}
+		}
+	}
+}
+
+
+static void fill_rgb(struct vdef_test_frame *f)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	unsigned int max = (1 << format->pix_size) - 1;
+	unsigned int n;
+	const struct vdef_dim *res = &f->frame.info.resolution;
+
+	n = vdef_get_raw_frame_component_count(format->pix_format);
+	for (unsigned int y = 0; y < res->height; y++) {
+		for (unsigned int x = 0; x < res->width; x++) {
+			for (unsigned int c = 0; c < n; c++) {
+				vdef_test_sample_set(format,
+						     rgb_sample_ptr(f, c, x, y),
+						     rand() % (max + 1));
+			}
+		}
+	}
+}
+
+
+static void check_yuv_to_rgb(struct vdef_test_frame *in,
+			     struct vdef_test_frame *out)
+{
+	const struct vdef_raw_format *in_fmt = &in->frame.format;
+	const struct vdef_raw_format *out_fmt = &out->frame.format;
+	enum vdef_matrix_coefs matrix = in->frame.info.matrix_coefs;
+	bool full_range = in->frame.info.full_range;
+	const float *mat = vdef_yuv_to_rgb_norm_matrix[matrix][full_range];
+	unsigned int depth = in_fmt->pix_size;
+	float scale = full_range ? (1 << depth) - 1 : 255 << (depth - 8);
+	float off[3];
+	unsigned int out_max = (1 << out_fmt->pix_size) - 1;
+	unsigned int n;
+	const struct vdef_dim *res = &in->frame.info.resolution;
+	unsigned int errors = 0;
+
+	n = vdef_get_raw_frame_component_count(out_fmt->pix_format);
+	off[0] = full_range ? 0 : 16 << (depth - 8);
+	off[1] = off[2] = 1 << (depth - 1);
+
+	for (unsigned int y = 0; y < res->height; y++) {
+		for (unsigned int x = 0; x < res->width; x++) {
+			float yuv[3];
+			for (unsigned int k = 0; k < 3; k++) {
+				uint8_t *p = yuv_sample_ptr(in, k, x, y);
+				yuv[k] = (vdef_test_sample_get(in_fmt, p) -
+					  off[k]) /
+					 scale;
+			}
+			for (unsigned int c = 0; c < n; c++) {
+				uint8_t *p = rgb_sample_ptr(out, c, x, y);
+				float v = 1.f;
+				int expected, actual;
+				if (c < 3) {
+					v = yuv[0] * mat[c] +
+					    yuv[1] * mat[3 + c] +
+					    yuv[2] * mat[6 + c];
+				}
+				v = v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+				expected = lrintf(v * out_max);
+				actual = vdef_test_sample_get(out_fmt, p);
+				if (abs(expected - actual) > 1)
+					errors++;
+			}
+		}
+	}
+	CU_ASSERT_EQUAL(errors, 0);
+}
+
+
+static void test_convert_yuv_to_rgb(void)
+{
+	const struct vdef_raw_format *in_formats[] = {
+		&vdef_i420,
+		&vdef_yv12,
+		&vdef_nv12,
+		&vdef_nv21,
+		&vdef_i420_10_16le,
+		&vdef_i420_10_16be,
+		&vdef_i420_10_16le_high,
+		&vdef_yv12_10_16be_high,
+		&vdef_nv12_10_16le,
+		&vdef_nv21_10_16be_high,
+		&vdef_i444,
+	};
+	/* 16-bit outputs (no predefined formats) */
+	const struct vdef_raw_format rgb_10_16le = {
+		.pix_format = VDEF_RAW_PIX_FORMAT_RGB24,
+		.pix_order = VDEF_RAW_PIX_ORDER_RGB,
+		.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+		.pix_size = 10,
+		.data_layout = VDEF_RAW_DATA_LAYOUT_PACKED,
+		.data_little_endian = true,
+		.data_size = 16,
+	};
+	const struct vdef_raw_format bgra_10_16le_high = {
+		.pix_format = VDEF_RAW_PIX_FORMAT_RGBA32,
+		.pix_order = VDEF_RAW_PIX_ORDER_BGRA,
+		.pix_layout = VDEF_RAW_PIX_LAYOUT_LINEAR,
+		.pix_size = 10,
+		.data_layout = VDEF_RAW_DATA_LAYOUT_PACKED,
+		.data_pad_low = true,
+		.data_little_endian = true,
+		.data_size = 16,
+	};
+	const struct vdef_raw_format *out_formats[] = {
+		&vdef_rgb,
+		&vdef_bgr,
+		&vdef_rgba,
+		&vdef_bgra,
+		&vdef_abgr,
+		&rgb_10_16le,
+		&bgra_10_16le_high,
+	};
+	struct vdef_test_frame in, out;
+	int res;
+
+	srand(42);
+	for (unsigned int r = 0; r < ARRAY_SIZE(s_test_res); r++) {
+		for (unsigned int i = 0; i < ARRAY_SIZE(in_formats); i++) {
+			vdef_test_frame_alloc(
+				&in, in_formats[i], &s_test_res[r]);
+			fill_yuv(&in);
+			for (unsigned int o = 0; o < ARRAY_SIZE(out_formats);
+			     o++) {
+				vdef_test_frame_alloc(
+					&out, out_formats[o], &s_test_res[r]);
+				/* All matrices in limited and full range */
+				for (unsigned int m = 0;
+				     m < 2 * ARRAY_SIZE(s_test_matrix);
+				     m++) {
+					in.frame.info.matrix_coefs =
+						s_test_matrix[m / 2];
+					in.frame.info.full_range = m % 2;
+					res = vdef_convert_yuv_to_rgb(
+						&in.frame,
+						(const void *const *)in.plane,
+						&out.frame,
+						out.plane);
+					CU_ASSERT_EQUAL(res, 0);
+					check_yuv_to_rgb(&in, &out);
+				}
+				vdef_test_frame_free(&out);
+			}
+			vdef_test_frame_free(&in);
+		}
+	}
+}
+
+
+static void test_convert_yuv_to_rgb_invalid(void)
+{
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_qcif = {176, 144};
+	struct vdef_dim res_cif = {352, 288};
+	const void *const *in_plane;
+	int res;
+
+	vdef_test_frame_alloc(&in, &vdef_nv12, &res_qcif);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &res_qcif);
+	in_plane = (const void *const *)in.plane;
+	in.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+
+	/* Invalid arguments */
+	res = vdef_convert_yuv_to_rgb(NULL, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_yuv_to_rgb(&in.frame, NULL, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_yuv_to_rgb(&in.frame, in_plane, NULL, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_yuv_to_rgb(&in.frame, in_plane, &out.frame, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Resolution mismatch */
+	out.frame.info.resolution = res_cif;
+	res = vdef_convert_yuv_to_rgb(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	out.frame.info.resolution = res_qcif;
+
+	/* Unknown matrix */
+	in.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_UNKNOWN;
+	res = vdef_convert_yuv_to_rgb(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	in.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+
+	/* Unsupported formats */
+	in.frame.format = vdef_nv12_10_packed;
+	res = vdef_convert_yuv_to_rgb(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	in.frame.format = vdef_nv21_hisi_tile;
+	res = vdef_convert_yuv_to_rgb(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	in.frame.format = vdef_nv12;
+	out.frame.format = vdef_i420;
+	res = vdef_convert_yuv_to_rgb(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+/* Sum of the RGB values of count x count pixels */
+static void get_rgb_sum(struct vdef_test_frame *f,
+			unsigned int x,
+			unsigned int y,
+			unsigned int count,
+			float rgb[3])
+{
+	for (unsigned int k = 0; k < 3; k++) {
+		rgb[k] = 0.f;
+		for (unsigned int r = 0; r < count; r++) {
+			for (unsigned int h = 0; h < count; h++) {
+				uint8_t *p = rgb_sample_ptr(f, k, x + h, y + r);
+				rgb[k] += vdef_test_sample_get(
+					&f->frame.format, p);
+			}
+		}
+	}
+}
+
+
+static void check_rgb_to_yuv(struct vdef_test_frame *in,
+			     struct vdef_test_frame *out)
+{
+	const struct vdef_raw_format *in_fmt = &in->frame.format;
+	const struct vdef_raw_format *out_fmt = &out->frame.format;
+	enum vdef_matrix_coefs matrix = out->frame.info.matrix_coefs;
+	bool full_range = out->frame.info.full_range;
+	const float *mat = vdef_rgb_to_yuv_norm_matrix[matrix][full_range];
+	unsigned int depth = out_fmt->pix_size;
+	float scale = full_range ? (1 << depth) - 1 : 255 << (depth - 8);
+	float in_max = (1 << in_fmt->pix_size) - 1;
+	int out_max = (1 << depth) - 1;
+	float off[3];
+	unsigned int sub =
+		(out_fmt->pix_format == VDEF_RAW_PIX_FORMAT_YUV420) ? 2 : 1;
+	const struct vdef_dim *res = &in->frame.info.resolution;
+	unsigned int errors = 0;
+
+	off[0] = full_range ? 0 : 16 << (depth - 8);
+	off[1] = off[2] = 1 << (depth - 1);
+
+	for (unsigned int y = 0; y < res->height; y++) {
+		for (unsigned int x = 0; x < res->width; x++) {
+			for (unsigned int c = 0; c < 3; c++) {
+				float rgb[3], v;
+				unsigned int count = (c == 0) ? 1 : sub;
+				int expected, actual;
+				uint8_t *p;
+				if (c > 0 && (x % sub || y % sub ||
+					      x + sub > res->width ||
+					      y + sub > res->height))
+					continue;
+				get_rgb_sum(in, x, y, count, rgb);
+				v = (rgb[0] * mat[c] + rgb[1] * mat[3 + c] +
+				     rgb[2] * mat[6 + c]) /
+				    (in_max * count * count);
+				expected = lrintf(v * scale + off[c]);
+				expected = expected < 0 ? 0 : expected;
+				expected =
+					expected > out_max ? out_max : expected;
+				p = yuv_sample_ptr(out, c, x, y);
+				actual = vdef_test_sample_get(out_fmt, p);
+				if (abs(expected - actual) > 1)
+					errors++;
+			}
+		}
+	}
+	CU_ASSERT_EQUAL(errors, 0);
+}
+
+
+static void test_convert_rgb_to_yuv(void)
+{
+	const struct vdef_raw_format *in_formats[] = {
+		&vdef_rgb,
+		&vdef_bgr,
+		&vdef_rgba,
+		&vdef_abgr,
+	};
+	const struct vdef_raw_format *out_formats[] = {
+		&vdef_i420,
+		&vdef_yv12,
+		&vdef_nv12,
+		&vdef_nv21,
+		&vdef_i444,
+		&vdef_i420_10_16le,
+		&vdef_nv12_10_16le,
+		&vdef_nv21_10_16le,
+	};
+	struct vdef_test_frame in, out;
+	int res;
+
+	srand(42);
+	for (unsigned int r = 0; r < ARRAY_SIZE(s_test_res); r++) {
+		for (unsigned int i = 0; i < ARRAY_SIZE(in_formats); i++) {
+			vdef_test_frame_alloc(
+				&in, in_formats[i], &s_test_res[r]);
+			fill_rgb(&in);
+			for (unsigned int o = 0; o < ARRAY_SIZE(out_formats);
+			     o++) {
+				vdef_test_frame_alloc(
+					&out, out_formats[o], &s_test_res[r]);
+				/* All matrices in limited and full range */
+				for (unsigned int m = 0;
+				     m < 2 * ARRAY_SIZE(s_test_matrix);
+				     m++) {
+					out.frame.info.matrix_coefs =
+						s_test_matrix[m / 2];
+					out.frame.info.full_range = m % 2;
+					res = vdef_convert_rgb_to_yuv(
+						&in.frame,
+						(const void *const *)in.plane,
+						&out.frame,
+						out.plane);
+					CU_ASSERT_EQUAL(res, 0);
+					check_rgb_to_yuv(&in, &out);
+				}
+				vdef_test_frame_free(&out);
+			}
+			vdef_test_frame_free(&in);
+		}
+	}
+}
+
+
+static void test_convert_rgb_to_yuv_invalid(void)
+{
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_qcif = {176, 144};
+	struct vdef_dim res_cif = {352, 288};
+	const void *const *in_plane;
+	int res;
+
+	vdef_test_frame_alloc(&in, &vdef_rgb, &res_qcif);
+	vdef_test_frame_alloc(&out, &vdef_nv12, &res_qcif);
+	in_plane = (const void *const *)in.plane;
+	out.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+
+	/* Invalid arguments */
+	res = vdef_convert_rgb_to_yuv(NULL, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_rgb_to_yuv(&in.frame, NULL, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_rgb_to_yuv(&in.frame, in_plane, NULL, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_rgb_to_yuv(&in.frame, in_plane, &out.frame, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Resolution mismatch */
+	out.frame.info.resolution = res_cif;
+	res = vdef_convert_rgb_to_yuv(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	out.frame.info.resolution = res_qcif;
+
+	/* Unknown matrix */
+	out.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_UNKNOWN;
+	res = vdef_convert_rgb_to_yuv(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	out.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+
+	/* Unsupported formats */
+	out.frame.format = vdef_nv12_10_packed;
+	res = vdef_convert_rgb_to_yuv(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	out.frame.format = vdef_nv21_hisi_tile;
+	res = vdef_convert_rgb_to_yuv(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	out.frame.format = vdef_nv12;
+	in.frame.format = vdef_i420;
+	res = vdef_convert_rgb_to_yuv(
+		&in.frame, in_plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void check_fixed_tables(enum vdef_matrix_coefs m,
+			       unsigned int r,
+			       enum vdef_fixed_depth d)
+{
+	unsigned int depth = 8 + 2 * d;
+	/* 8-bit normalized values to n-bit values */
+	float off_scale = 255 << (depth - 8);
+	/* Full range scale over limited range scale */
+	float scale = r ? 1.f : ((1 << depth) - 1) / off_scale;
+	const int32_t *yuv2rgb_off = vdef_yuv_to_rgb_fixed_offset[m][r][d];
+	const int32_t *yuv2rgb_mat = vdef_yuv_to_rgb_fixed_matrix[m][r][d];
+	const int32_t *rgb2yuv_off = vdef_rgb_to_yuv_fixed_offset[m][r][d];
+	const int32_t *rgb2yuv_mat = vdef_rgb_to_yuv_fixed_matrix[m][r][d];
+	float v;
+
+	for (unsigned int i = 0; i < 3; i++) {
+		v = vdef_yuv_to_rgb_norm_offset[m][r][i] * off_scale;
+		CU_ASSERT_EQUAL(yuv2rgb_off[i], lrintf(v));
+		v = vdef_rgb_to_yuv_norm_offset[m][r][i] * off_scale;
+		CU_ASSERT_EQUAL(rgb2yuv_off[i], lrintf(v));
+	}
+	for (unsigned int i = 0; i < 9; i++) {
+		v = vdef_yuv_to_rgb_norm_matrix[m][r][i] * scale *
+		    (1 << VDEF_YUV_TO_RGB_FIXED_SHIFT);
+		CU_ASSERT(fabsf(yuv2rgb_mat[i] - v) <= 1.f);
+		v = vdef_rgb_to_yuv_norm_matrix[m][r][i] / scale *
+		    (1 << VDEF_RGB_TO_YUV_FIXED_SHIFT);
+		CU_ASSERT(fabsf(rgb2yuv_mat[i] - v) <= 1.f);
+	}
+}
+
+
+static void test_fixed_tables(void)
+{
+	for (unsigned int m = 1; m < VDEF_MATRIX_COEFS_MAX; m++) {
+		for (unsigned int r = 0; r < 2; r++) {
+			for (unsigned int d = 0; d < VDEF_FIXED_DEPTH_MAX; d++)
+				check_fixed_tables(m, r, d);
+		}
+	}
+}
+
+
+static void test_fixed_tables_10bit_range(void)
+{
+	const int32_t *mat =
+		vdef_rgb_to_yuv_fixed_matrix[VDEF_MATRIX_COEFS_BT709][0]
+					    [VDEF_FIXED_DEPTH_10];
+	const int32_t *off =
+		vdef_rgb_to_yuv_fixed_offset[VDEF_MATRIX_COEFS_BT709][0]
+					    [VDEF_FIXED_DEPTH_10];
+	const int32_t rgb[][3] = {
+		{0, 0, 0},
+		{1023, 1023, 1023},
+		{1023, 0, 0},
+		{0, 0, 1023},
+	};
+	/* Limited range 10-bit luma is [64 .. 940] and chroma is
+	 * [64 .. 960] */
+	const int32_t expected[][3] = {
+		{64, 512, 512},
+		{940, 512, 512},
+		{250, 409, 960},
+		{127, 960, 471},
+	};
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(rgb); i++) {
+		for (unsigned int c = 0; c < 3; c++) {
+			int32_t v = rgb[i][0] * mat[c] +
+				    rgb[i][1] * mat[3 + c] +
+				    rgb[i][2] * mat[6 + c];
+			v = ((v + (1 << (VDEF_RGB_TO_YUV_FIXED_SHIFT - 1))) >>
+			     VDEF_RGB_TO_YUV_FIXED_SHIFT) +
+			    off[c];
+			CU_ASSERT_EQUAL(v, expected[i][c]);
+		}
+	}
+}
+
+
+static const struct vdef_raw_format *s_test_chroma_formats[][4] = {
+	{&vdef_i420, &vdef_yv12, &vdef_nv12, &vdef_nv21},
+	{&vdef_i420_10_16le,
+	 &vdef_yv12_10_16le,
+	 &vdef_nv12_10_16le,
+	 &vdef_nv21_10_16le},
+	{&vdef_i420_10_16be,
+	 &vdef_yv12_10_16be,
+	 &vdef_nv12_10_16be,
+	 &vdef_nv21_10_16be},
+	{&vdef_i420_10_16le_high,
+	 &vdef_yv12_10_16le_high,
+	 &vdef_nv12_10_16le_high,
+	 &vdef_nv21_10_16le_high},
+	{&vdef_i420_10_16be_high,
+	 &vdef_yv12_10_16be_high,
+	 &vdef_nv12_10_16be_high,
+	 &vdef_nv21_10_16be_high},
+};
+
+
+static const struct vdef_dim s_test_chroma_res[] = {
+	{36, 9},
+	{130, 4},
+	{37, 5},
+};
+
+
+static void check_chroma(struct vdef_test_frame *in,
+			 struct vdef_test_frame *out)
+{
+	const struct vdef_dim *res = &in->frame.info.resolution;
+
+	for (unsigned int y = 0; y < res->height; y++) {
+		for (unsigned int x = 0; x < res->width; x++) {
+			for (unsigned int c = 0; c < 3; c++) {
+				uint8_t *i = yuv_sample_ptr(in, c, x, y);
+				uint8_t *o = yuv_sample_ptr(out, c, x, y);
+				CU_ASSERT_EQUAL(
+					vdef_test_sample_get(&in->frame.format,
+							     i),
+					vdef_test_sample_get(&out->frame.format,
+							     o));
+			}
+		}
+	}
+}
+
+
+static void test_convert_chroma(const struct vdef_raw_format *in_format,
+				const struct vdef_raw_format *out_format,
+				const struct vdef_dim *res)
+{
+	int ret;
+	struct vdef_test_frame in, out, tmp;
+	bool in_place;
+
+	vdef_test_frame_alloc(&in, in_format, res);
+	vdef_test_frame_alloc(&out, out_format, res);
+	fill_yuv(&in);
+
+	ret = vdef_convert_yuv_chroma(&in.frame,
+				      (const void *const *)in.plane,
+				      &out.frame,
+				      out.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	check_chroma(&in, &out);
+
+	/* In place, only between formats of the same data layout */
+	vdef_test_frame_alloc(&tmp, in_format, res);
+	memcpy(tmp.data, in.data, in.layout.size);
+	in_place = in_format->data_layout == out_format->data_layout;
+	ret = vdef_convert_yuv_chroma_in_place(
+		&tmp.frame, tmp.plane, out_format);
+	CU_ASSERT_EQUAL(ret, in_place ? 0 : -ENOTSUP);
+	if (ret == 0) {
+		CU_ASSERT_TRUE(
+			vdef_raw_format_cmp(&tmp.frame.format, out_format));
+		CU_ASSERT_PTR_EQUAL(tmp.plane[0], tmp.data);
+		check_chroma(&in, &tmp);
+	}
+
+	vdef_test_frame_free(&tmp);
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&in);
+}
+
+
+static void test_convert_yuv_chroma(void)
+{
+	srand(42);
+
+	for (size_t i = 0; i < ARRAY_SIZE(s_test_chroma_formats); i++) {
+		for (size_t j = 0; j < 4; j++) {
+			for (size_t k = 0; k < 4; k++) {
+				for (size_t r = 0;
+				     r < ARRAY_SIZE(s_test_chroma_res);
+				     r++) {
+					test_convert_chroma(
+						s_test_chroma_formats[i][j],
+						s_test_chroma_formats[i][k],
+						&s_test_chroma_res[r]);
+				}
+			}
+		}
+	}
+}
+
+
+static void test_convert_yuv_chroma_invalid(void)
+{
+	int ret;
+	struct vdef_dim res = {32, 8};
+	struct vdef_test_frame in, out;
+
+	vdef_test_frame_alloc(&in, &vdef_nv12, &res);
+	vdef_test_frame_alloc(&out, &vdef_i420, &res);
+
+	/* Invalid arguments */
+	ret = vdef_convert_yuv_chroma(
+		NULL, (const void *const *)in.plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_yuv_chroma(&in.frame, NULL, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_yuv_chroma(
+		&in.frame, (const void *const *)in.plane, NULL, out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_yuv_chroma(
+		&in.frame, (const void *const *)in.plane, &out.frame, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_yuv_chroma_in_place(NULL, in.plane, &vdef_i420);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_yuv_chroma_in_place(&in.frame, NULL, &vdef_i420);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_yuv_chroma_in_place(&in.frame, in.plane, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* Resolution mismatch */
+	out.frame.info.resolution.width = 30;
+	ret = vdef_convert_yuv_chroma(&in.frame,
+				      (const void *const *)in.plane,
+				      &out.frame,
+				      out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame.info.resolution = res;
+
+	/* Sample storage mismatch */
+	out.frame.format = vdef_i420_10_16le;
+	ret = vdef_convert_yuv_chroma(&in.frame,
+				      (const void *const *)in.plane,
+				      &out.frame,
+				      out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	ret = vdef_convert_yuv_chroma_in_place(
+		&in.frame, in.plane, &vdef_nv21_10_16be);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* Unsupported formats */
+	in.frame.format = vdef_nv12_10_packed;
+	out.frame.format = vdef_nv21_10_packed;
+	ret = vdef_convert_yuv_chroma(&in.frame,
+				      (const void *const *)in.plane,
+				      &out.frame,
+				      out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	in.frame.format = vdef_nv21_hisi_tile;
+	ret = vdef_convert_yuv_chroma_in_place(&in.frame, in.plane, &vdef_nv12);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	in.frame.format = vdef_rgb;
+	ret = vdef_convert_yuv_chroma_in_place(&in.frame, in.plane, &vdef_rgb);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* Planar to semi-planar in place */
+	out.frame.format = vdef_i420;
+	ret = vdef_convert_yuv_chroma_in_place(
+		&out.frame, out.plane, &vdef_nv12);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	CU_ASSERT_TRUE(vdef_raw_format_cmp(&out.frame.format, &vdef_i420));
+
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&in);
+}
+
+
+CU_TestInfo g_vdef_test_convert[] = {
+	{FN("convert-yuv-to-rgb"), &test_convert_yuv_to_rgb},
+	{FN("convert-yuv-to-rgb-invalid"), &test_convert_yuv_to_rgb_invalid},
+	{FN("convert-rgb-to-yuv"), &test_convert_rgb_to_yuv},
+	{FN("convert-rgb-to-yuv-invalid"), &test_convert_rgb_to_yuv_invalid},
+	{FN("fixed-tables"), &test_fixed_tables},
+	{FN("fixed-tables-10bit-range"), &test_fixed_tables_10bit_range},
+	{FN("convert-yuv-chroma"), &test_convert_yuv_chroma},
+	{FN("convert-yuv-chroma-invalid"), &test_convert_yuv_chroma_invalid},
+
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,685 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+static const struct vdef_dim s_test_res[] = {
+	{37, 9},
+	{64, 4},
+	{130, 3},
+};
+
+
+static const struct vdef_raw_format *s_test_packed_formats[][5] = {
+	{&vdef_nv12_10_packed,
+	 &vdef_nv12_10_16le,
+	 &vdef_nv12_10_16be,
+	 &vdef_nv12_10_16le_high,
+	 &vdef_nv12_10_16be_high},
+	{&vdef_nv21_10_packed,
+	 &vdef_nv21_10_16le,
+	 &vdef_nv21_10_16be,
+	 &vdef_nv21_10_16le_high,
+	 &vdef_nv21_10_16be_high},
+	{&vdef_raw10_packed, &vdef_raw10, NULL, NULL, NULL},
+};
+
+
+/* Number of samples per line of a plane */
+static unsigned int plane_samples(const struct vdef_raw_format *format,
+				  const struct vdef_dim *res,
+				  unsigned int plane)
+{
+	if (format->pix_format == VDEF_RAW_PIX_FORMAT_RAW || plane == 0)
+		return res->width;
+	if (format->data_layout == VDEF_RAW_DATA_LAYOUT_PLANAR)
+		return res->width / 2;
+	return res->width / 2 * 2;
+}
+
+
+/* Number of lines of a plane */
+static unsigned int plane_lines(const struct vdef_raw_format *format,
+				const struct vdef_dim *res,
+				unsigned int plane)
+{
+	if (format->pix_format == VDEF_RAW_PIX_FORMAT_RAW)
+		return res->height;
+	return plane == 0 ? res->height : res->height / 2;
+}
+
+
+/* Reference packed sample accessors, bit by bit */
+static unsigned int packed_get(const struct vdef_raw_format *format,
+			       const uint8_t *line,
+			       unsigned int i)
+{
+	unsigned int d = format->data_size;
+	unsigned int v = 0;
+
+	for (unsigned int b = 0; b < d; b++) {
+		unsigned int pos = i * d + b;
+		if (format->data_little_endian) {
+			v |= ((line[pos / 8] >> (pos % 8)) & 1) << b;
+		} else {
+			v |= ((line[pos / 8] >> (7 - pos % 8)) & 1)
+			     << (d - 1 - b);
+		}
+	}
+
+	return v;
+}
+
+
+static void packed_set(const struct vdef_raw_format *format,
+		       uint8_t *line,
+		       unsigned int i,
+		       unsigned int v)
+{
+	unsigned int d = format->data_size;
+
+	for (unsigned int b = 0; b < d; b++) {
+		unsigned int pos = i * d + b;
+		unsigned int bit = format->data_little_endian
+					   ? (v >> b) & 1
+					   : (v >> (d - 1 - b)) & 1;
+		unsigned int shift = format->data_little_endian ? pos % 8
+								: 7 - pos % 8;
+		line[pos / 8] &= ~(1 << shift);
+		line[pos / 8] |= bit << shift;
+	}
+}
+
+
+static uint32_t sample_get(const struct vdef_raw_format *format,
+			   const uint8_t *line,
+			   unsigned int i)
+{
+	unsigned int bytes = format->data_size / 8;
+	const uint8_t *p = line + bytes * i;
+	uint32_t v = 0;
+
+	for (unsigned int k = 0; k < bytes; k++) {
+		unsigned int b = format->data_little_endian ? bytes - 1 - k : k;
+		v = (v << 8) | p[b];
+	}
+	if (format->data_pad_low)
+		v >>= format->data_size - format->pix_size;
+	return v;
+}
+
+
+static void sample_set(const struct vdef_raw_format *format,
+		       uint8_t *line,
+		       unsigned int i,
+		       uint32_t v)
+{
+	unsigned int bytes = format->data_size / 8;
+	uint8_t *p = line + bytes * i;
+
+	if (format->data_pad_low)
+		v <<= format->data_size - format->pix_size;
+	for (unsigned int k = 0; k < bytes; k++) {
+		unsigned int b = format->data_little_endian ? k : bytes - 1 - k;
+		p[b] = v >> (8 * k);
+	}
+}
+
+
+static uint32_t rand_sample(const struct vdef_raw_format *format)
+{
+	uint32_t v = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+
+	return format->pix_size >= 32 ? v : v % (1u << format->pix_size);
+}
+
+
+/* MIPI CSI-2 packing groups of known samples (MSBs of each sample, then
+ * the LSBs of the samples, first sample in the lowest bits) */
+static const struct {
+	unsigned int depth;
+	unsigned int count;
+	unsigned int samples[4];
+	unsigned int size;
+	uint8_t bytes[7];
+} s_test_mipi_groups[] = {
+	{10,
+	 4,
+	 {0x155, 0x2aa, 0x3ff, 0x001},
+	 5,
+	 {0x55, 0xaa, 0xff, 0x00, 0x79}},
+	{12, 2, {0xabc, 0x123}, 3, {0xab, 0x12, 0x3c}},
+	{14,
+	 4,
+	 {0x3fff, 0x0001, 0x2abc, 0x1234},
+	 7,
+	 {0xff, 0x00, 0xaa, 0x48, 0x7f, 0xc0, 0xd3}},
+};
+
+
+/* Reference MIPI CSI-2 packed sample reader */
+static unsigned int mipi_get(const struct vdef_raw_format *format,
+			     const uint8_t *line,
+			     unsigned int i)
+{
+	unsigned int d = format->data_size;
+	unsigned int n = d == 12 ? 2 : 4;
+	unsigned int low = d - 8;
+	const uint8_t *p = line + i / n * (n * d / 8);
+	unsigned int v = p[i % n] << low;
+
+	for (unsigned int b = 0; b < low; b++) {
+		unsigned int pos = i % n * low + b;
+		v |= ((p[n + pos / 8] >> (pos % 8)) & 1) << b;
+	}
+
+	return v;
+}
+
+
+static void test_data_packed(const struct vdef_raw_format *packed_format,
+			     const struct vdef_raw_format *format,
+			     const struct vdef_dim *res)
+{
+	int ret;
+	struct vdef_test_frame packed, unpacked, repacked;
+	unsigned int plane_count;
+
+	vdef_test_frame_alloc(&packed, packed_format, res);
+	vdef_test_frame_alloc(&unpacked, format, res);
+	vdef_test_frame_alloc(&repacked, packed_format, res);
+
+	plane_count = vdef_get_raw_frame_plane_count(packed_format);
+	for (unsigned int p = 0; p < plane_count; p++) {
+		unsigned int n = plane_samples(packed_format, res, p);
+		for (unsigned int y = 0; y < plane_lines(format, res, p); y++) {
+			uint8_t *line = (uint8_t *)packed.plane[p] +
+					y * packed.frame.plane_stride[p];
+			for (unsigned int i = 0; i < n; i++) {
+				packed_set(packed_format,
+					   line,
+					   i,
+					   rand_sample(format));
+			}
+		}
+	}
+
+	/* Unpack */
+	ret = vdef_convert_raw_data(&packed.frame,
+				    (const void *const *)packed.plane,
+				    &unpacked.frame,
+				    unpacked.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (unsigned int p = 0; p < plane_count; p++) {
+		unsigned int n = plane_samples(packed_format, res, p);
+		for (unsigned int y = 0; y < plane_lines(format, res, p); y++) {
+			uint8_t *in = (uint8_t *)packed.plane[p] +
+				      y * packed.frame.plane_stride[p];
+			uint8_t *out = (uint8_t *)unpacked.plane[p] +
+				       y * unpacked.frame.plane_stride[p];
+			for (unsigned int i = 0; i < n; i++) {
+				CU_ASSERT_EQUAL(
+					packed_get(packed_format, in, i),
+					sample_get(format, out, i));
+			}
+		}
+	}
+
+	/* Pack */
+	ret = vdef_convert_raw_data(&unpacked.frame,
+				    (const void *const *)unpacked.plane,
+				    &repacked.frame,
+				    repacked.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(packed.data, repacked.data, packed.layout.size),
+			0);
+
+	vdef_test_frame_free(&repacked);
+	vdef_test_frame_free(&unpacked);
+	vdef_test_frame_free(&packed);
+}
+
+
+static void test_data_packed_10bit(void)
+{
+	srand(42);
+
+	for (size_t i = 0; i < ARRAY_SIZE(s_test_packed_formats); i++) {
+		for (size_t j = 1; j < 5; j++) {
+			if (s_test_packed_formats[i][j] == NULL)
+				continue;
+			for (size_t r = 0; r < ARRAY_SIZE(s_test_res); r++) {
+				test_data_packed(s_test_packed_formats[i][0],
+						 s_test_packed_formats[i][j],
+						 &s_test_res[r]);
+			}
+		}
+	}
+}
+
+
+static void test_data_packed_bayer(void)
+{
+	static const char *const names[] = {
+		"raw",
+		"bayer_rggb_",
+		"bayer_bggr_",
+		"bayer_grbg_",
+		"bayer_gbrg_",
+	};
+	static const unsigned int depths[] = {10, 12, 14};
+
+	srand(42);
+
+	for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(depths); j++) {
+			int ret;
+			char name[32];
+			struct vdef_raw_format packed, unpacked;
+
+			/* Get the formats from the registered formats */
+			snprintf(name,
+				 sizeof(name),
+				 "%s%u_packed",
+				 names[i],
+				 depths[j]);
+			ret = vdef_raw_format_from_str(name, &packed);
+			CU_ASSERT_EQUAL_FATAL(ret, 0);
+			snprintf(name,
+				 sizeof(name),
+				 "%s%u",
+				 names[i],
+				 depths[j]);
+			ret = vdef_raw_format_from_str(name, &unpacked);
+			CU_ASSERT_EQUAL_FATAL(ret, 0);
+			CU_ASSERT_EQUAL(packed.pix_size, depths[j]);
+			CU_ASSERT_EQUAL(packed.data_size, depths[j]);
+			CU_ASSERT_EQUAL(unpacked.pix_size, depths[j]);
+			CU_ASSERT_EQUAL(unpacked.data_size, 16);
+
+			for (size_t r = 0; r < ARRAY_SIZE(s_test_res); r++) {
+				test_data_packed(
+					&packed, &unpacked, &s_test_res[r]);
+			}
+
+			/* Big-endian bitstream and 16-bit data */
+			packed.data_little_endian = false;
+			unpacked.data_little_endian = false;
+			test_data_packed(&packed, &unpacked, &s_test_res[0]);
+		}
+	}
+}
+
+
+/* Unpack and pack lines of known MIPI CSI-2 packing groups */
+static void test_data_mipi_groups(const struct vdef_raw_format *mipi_format,
+				  const struct vdef_raw_format *format,
+				  unsigned int g)
+{
+	int ret;
+	/* Vector blocks and a scalar tail */
+	struct vdef_dim res = {52, 3};
+	struct vdef_test_frame mipi, unpacked, repacked;
+	unsigned int n = s_test_mipi_groups[g].count;
+	unsigned int size = s_test_mipi_groups[g].size;
+
+	vdef_test_frame_alloc(&mipi, mipi_format, &res);
+	vdef_test_frame_alloc(&unpacked, format, &res);
+	vdef_test_frame_alloc(&repacked, mipi_format, &res);
+	CU_ASSERT_EQUAL(mipi.frame.plane_stride[0], res.width / n * size);
+
+	for (unsigned int y = 0; y < res.height; y++) {
+		uint8_t *line = mipi.plane[0] + y * mipi.frame.plane_stride[0];
+		for (unsigned int i = 0; i < res.width / n; i++) {
+			memcpy(line + i * size,
+			       s_test_mipi_groups[g].bytes,
+			       size);
+		}
+	}
+
+	ret = vdef_convert_raw_data(&mipi.frame,
+				    (const void *const *)mipi.plane,
+				    &unpacked.frame,
+				    unpacked.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (unsigned int y = 0; y < res.height; y++) {
+		uint8_t *line = unpacked.plane[0] +
+				y * unpacked.frame.plane_stride[0];
+		for (unsigned int i = 0; i < res.width; i++) {
+			CU_ASSERT_EQUAL(sample_get(format, line, i),
+					s_test_mipi_groups[g].samples[i % n]);
+		}
+	}
+
+	ret = vdef_convert_raw_data(&unpacked.frame,
+				    (const void *const *)unpacked.plane,
+				    &repacked.frame,
+				    repacked.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(mipi.data, repacked.data, mipi.layout.size), 0);
+
+	vdef_test_frame_free(&repacked);
+	vdef_test_frame_free(&unpacked);
+	vdef_test_frame_free(&mipi);
+}
+
+
+/* Pack and unpack random samples, with incomplete last packing groups */
+static void test_data_mipi_random(const struct vdef_raw_format *mipi_format,
+				  const struct vdef_raw_format *format,
+				  const struct vdef_dim *res)
+{
+	int ret;
+	struct vdef_test_frame mipi, unpacked, out;
+
+	vdef_test_frame_alloc(&unpacked, format, res);
+	vdef_test_frame_alloc(&mipi, mipi_format, res);
+	vdef_test_frame_alloc(&out, format, res);
+
+	for (unsigned int y = 0; y < res->height; y++) {
+		uint8_t *line = unpacked.plane[0] +
+				y * unpacked.frame.plane_stride[0];
+		for (unsigned int i = 0; i < res->width; i++)
+			sample_set(format, line, i, rand_sample(format));
+	}
+
+	ret = vdef_convert_raw_data(&unpacked.frame,
+				    (const void *const *)unpacked.plane,
+				    &mipi.frame,
+				    mipi.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (unsigned int y = 0; y < res->height; y++) {
+		uint8_t *in = unpacked.plane[0] +
+			      y * unpacked.frame.plane_stride[0];
+		uint8_t *line = mipi.plane[0] + y * mipi.frame.plane_stride[0];
+		for (unsigned int i = 0; i < res->width; i++) {
+			CU_ASSERT_EQUAL(mipi_get(mipi_format, line, i),
+					sample_get(format, in, i));
+		}
+	}
+
+	ret = vdef_convert_raw_data(&mipi.frame,
+				    (const void *const *)mipi.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(
+		memcmp(unpacked.data, out.data, unpacked.layout.size), 0);
+
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&mipi);
+	vdef_test_frame_free(&unpacked);
+}
+
+
+static void test_data_mipi(void)
+{
+	static const char *const orders[] = {"rggb", "bggr", "grbg", "gbrg"};
+
+	srand(42);
+
+	for (size_t g = 0; g < ARRAY_SIZE(s_test_mipi_groups); g++) {
+		unsigned int depth = s_test_mipi_groups[g].depth;
+		for (size_t i = 0; i < ARRAY_SIZE(orders); i++) {
+			int ret;
+			char name[32];
+			struct vdef_raw_format mipi, unpacked;
+
+			/* Get the formats from the registered formats */
+			snprintf(name,
+				 sizeof(name),
+				 "bayer_%s_%u_mipi",
+				 orders[i],
+				 depth);
+			ret = vdef_raw_format_from_str(name, &mipi);
+			CU_ASSERT_EQUAL_FATAL(ret, 0);
+			snprintf(name,
+				 sizeof(name),
+				 "bayer_%s_%u",
+				 orders[i],
+				 depth);
+			ret = vdef_raw_format_from_str(name, &unpacked);
+			CU_ASSERT_EQUAL_FATAL(ret, 0);
+			CU_ASSERT_TRUE(vdef_is_raw_format_valid(&mipi));
+			CU_ASSERT_EQUAL(mipi.pix_layout,
+					VDEF_RAW_PIX_LAYOUT_MIPI_CSI2);
+			CU_ASSERT_EQUAL(mipi.data_size, depth);
+
+			test_data_mipi_groups(&mipi, &unpacked, g);
+			for (size_t r = 0; r < ARRAY_SIZE(s_test_res); r++) {
+				test_data_mipi_random(
+					&mipi, &unpacked, &s_test_res[r]);
+			}
+
+			/* Big-endian 16-bit data with low padding */
+			unpacked.data_little_endian = false;
+			unpacked.data_pad_low = true;
+			test_data_mipi_groups(&mipi, &unpacked, g);
+			test_data_mipi_random(&mipi, &unpacked, &s_test_res[0]);
+		}
+	}
+}
+
+
+static const struct vdef_raw_format *s_test_storage_formats[][4] = {
+	{&vdef_i420_10_16le,
+	 &vdef_i420_10_16be,
+	 &vdef_i420_10_16le_high,
+	 &vdef_i420_10_16be_high},
+	{&vdef_nv12_10_16le,
+	 &vdef_nv12_10_16be,
+	 &vdef_nv12_10_16le_high,
+	 &vdef_nv12_10_16be_high},
+	{&vdef_raw16, &vdef_raw16_be, NULL, NULL},
+	{&vdef_raw32, &vdef_raw32_be, NULL, NULL},
+	{&vdef_i420, &vdef_i420, NULL, NULL},
+};
+
+
+static void test_data_storage(const struct vdef_raw_format *in_format,
+			      const struct vdef_raw_format *out_format,
+			      const struct vdef_dim *res)
+{
+	int ret;
+	struct vdef_test_frame in, out, tmp;
+	unsigned int plane_count;
+
+	vdef_test_frame_alloc(&in, in_format, res);
+	vdef_test_frame_alloc(&out, out_format, res);
+	vdef_test_frame_alloc(&tmp, in_format, res);
+
+	plane_count = vdef_get_raw_frame_plane_count(in_format);
+	for (unsigned int p = 0; p < plane_count; p++) {
+		unsigned int n = plane_samples(in_format, res, p);
+		for (unsigned int y = 0; y < plane_lines(in_format, res, p);
+		     y++) {
+			uint8_t *line = (uint8_t *)in.plane[p] +
+					y * in.frame.plane_stride[p];
+			for (unsigned int i = 0; i < n; i++) {
+				uint32_t v = rand_sample(in_format);
+				sample_set(in_format, line, i, v);
+			}
+		}
+	}
+	memcpy(tmp.data, in.data, in.layout.size);
+
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (unsigned int p = 0; p < plane_count; p++) {
+		unsigned int n = plane_samples(in_format, res, p);
+		for (unsigned int y = 0; y < plane_lines(in_format, res, p);
+		     y++) {
+			uint8_t *l1 = (uint8_t *)in.plane[p] +
+				      y * in.frame.plane_stride[p];
+			uint8_t *l2 = (uint8_t *)out.plane[p] +
+				      y * out.frame.plane_stride[p];
+			for (unsigned int i = 0; i < n; i++) {
+				CU_ASSERT_EQUAL(sample_get(in_format, l1, i),
+						sample_get(out_format, l2, i));
+			}
+		}
+	}
+
+	/* In place */
+	ret = vdef_convert_raw_data_in_place(&tmp.frame, tmp.plane, out_format);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_TRUE(vdef_raw_format_cmp(&tmp.frame.format, out_format));
+	CU_ASSERT_EQUAL(memcmp(tmp.data, out.data, out.layout.size), 0);
+
+	vdef_test_frame_free(&tmp);
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&in);
+}
+
+
+static void test_data_endianness_padding(void)
+{
+	srand(42);
+
+	for (size_t i = 0; i < ARRAY_SIZE(s_test_storage_formats); i++) {
+		for (size_t j = 0; j < 4; j++) {
+			for (size_t k = 0; k < 4; k++) {
+				const struct vdef_raw_format *f1, *f2;
+				f1 = s_test_storage_formats[i][j];
+				f2 = s_test_storage_formats[i][k];
+				if (f1 == NULL || f2 == NULL)
+					continue;
+				for (size_t r = 0; r < ARRAY_SIZE(s_test_res);
+				     r++) {
+					test_data_storage(
+						f1, f2, &s_test_res[r]);
+				}
+			}
+		}
+	}
+}
+
+
+static void test_data_invalid(void)
+{
+	int ret;
+	struct vdef_dim res = {32, 8};
+	struct vdef_test_frame in, out;
+
+	vdef_test_frame_alloc(&in, &vdef_nv12_10_packed, &res);
+	vdef_test_frame_alloc(&out, &vdef_nv12_10_16le, &res);
+
+	/* Invalid arguments */
+	ret = vdef_convert_raw_data(
+		NULL, (const void *const *)in.plane, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_raw_data(&in.frame, NULL, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_raw_data(
+		&in.frame, (const void *const *)in.plane, NULL, out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_raw_data(
+		&in.frame, (const void *const *)in.plane, &out.frame, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* Resolution mismatch */
+	out.frame.info.resolution.height = 6;
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame.info.resolution = res;
+
+	/* Formats that differ by more than the sample storage */
+	out.frame.format = vdef_i420_10_16le;
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	out.frame.format = vdef_nv12;
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* In place with a different data size */
+	ret = vdef_convert_raw_data_in_place(
+		&in.frame, in.plane, &vdef_nv12_10_16le);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	ret = vdef_convert_raw_data_in_place(NULL, in.plane, &vdef_nv12);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_raw_data_in_place(&in.frame, NULL, &vdef_nv12);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_raw_data_in_place(&in.frame, in.plane, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* MIPI CSI-2 packing to or from other than 16-bit data */
+	in.frame.format = vdef_bayer_rggb_10_mipi;
+	out.frame.format = vdef_bayer_rggb_10_packed;
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	out.frame.format = vdef_bayer_rggb_10;
+	out.frame.format.data_size = 32;
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* MIPI CSI-2 packing of non-packed data */
+	in.frame.format = vdef_bayer_rggb_10;
+	in.frame.format.pix_layout = VDEF_RAW_PIX_LAYOUT_MIPI_CSI2;
+	CU_ASSERT_FALSE(vdef_is_raw_format_valid(&in.frame.format));
+
+	/* Tiled pixel layout */
+	in.frame.format = vdef_nv21_hisi_tile_10_packed;
+	out.frame.format = vdef_nv21_hisi_tile_10_packed;
+	out.frame.format.data_size = 16;
+	ret = vdef_convert_raw_data(&in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&in);
+}
+
+
+CU_TestInfo g_vdef_test_data[] = {
+	{FN("data-packed-10bit"), &test_data_packed_10bit},
+	{FN("data-packed-bayer"), &test_data_packed_bayer},
+	{FN("data-mipi"), &test_data_mipi},
+	{FN("data-endianness-padding"), &test_data_endianness_padding},
+	{FN("data-invalid"), &test_data_invalid},
+
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,463 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+/* Test image generator: value of the component c (0: R, 1: G, 2: B) of the
+ * pixel (x, y) for a given bit depth */
+typedef unsigned int (*image_fn)(unsigned int c,
+				 unsigned int x,
+				 unsigned int y,
+				 unsigned int depth);
+
+
+static const struct vdef_raw_format *s_test_bayer_formats[] = {
+	&vdef_bayer_rggb,
+	&vdef_bayer_bggr,
+	&vdef_bayer_grbg,
+	&vdef_bayer_gbrg,
+	&vdef_bayer_rggb_12,
+	&vdef_bayer_gbrg_14,
+};
+
+
+/* Address of the component c (for RGB formats) of the pixel (x, y) of a
+ * packed frame */
+static uint8_t *sample_ptr(struct vdef_test_frame *f,
+			   unsigned int c,
+			   unsigned int x,
+			   unsigned int y)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	unsigned int bytes = format->data_size / 8;
+	unsigned int n = vdef_get_raw_frame_component_count(format->pix_format);
+
+	if (format->pix_format == VDEF_RAW_PIX_FORMAT_BAYER)
+		n = 1;
+	return (uint8_t *)f->plane[0] + y * f->frame.plane_stride[0] +
+	       (x * n + c) * bytes;
+}
+
+
+/* CFA color of the pixel (x, y) */
+static unsigned int
+cfa_color(const struct vdef_raw_format *format, unsigned int x, unsigned y)
+{
+	const char *order;
+	unsigned int pos = (y % 2) * 2 + (x % 2);
+
+	switch (format->pix_order) {
+	case VDEF_RAW_PIX_ORDER_RGGB:
+		order = "RGGB";
+		break;
+	case VDEF_RAW_PIX_ORDER_BGGR:
+		order = "BGGR";
+		break;
+	case VDEF_RAW_PIX_ORDER_GRBG:
+		order = "GRBG";
+		break;
+	default:
+		order = "GBRG";
+		break;
+	}
+	return order[pos] == 'R' ? 0 : (order[pos] == 'G' ? 1 : 2);
+}
+
+
+static void mosaic(struct vdef_test_frame *f, image_fn fn)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	const struct vdef_dim *res = &f->frame.info.resolution;
+
+	for (unsigned int y = 0; y < res->height; y++) {
+		for (unsigned int x = 0; x < res->width; x++) {
+			unsigned int c = cfa_color(format, x, y);
+			vdef_test_sample_set(format,
+					     sample_ptr(f, 0, x, y),
+					     fn(c, x, y, format->pix_size));
+		}
+	}
+}
+
+
+static unsigned int
+image_flat(unsigned int c, unsigned int x, unsigned int y, unsigned int depth)
+{
+	static const unsigned int values[3] = {200, 60, 130};
+
+	(void)x;
+	(void)y;
+
+	return values[c] << (depth - 8);
+}
+
+
+static unsigned int
+image_ramp(unsigned int c, unsigned int x, unsigned int y, unsigned int depth)
+{
+	static const unsigned int dx[3] = {2, 1, 3};
+	static const unsigned int dy[3] = {1, 3, 2};
+
+	return (10 + dx[c] * x + dy[c] * y) << (depth - 8);
+}
+
+
+static unsigned int
+image_edge(unsigned int c, unsigned int x, unsigned int y, unsigned int depth)
+{
+	(void)c;
+	(void)y;
+
+	return (x < 16 ? 50 : 200) << (depth - 8);
+}
+
+
+static unsigned int
+image_random(unsigned int c, unsigned int x, unsigned int y, unsigned int depth)
+{
+	(void)c;
+	(void)x;
+	(void)y;
+
+	return rand() % (1 << depth);
+}
+
+
+/* Sum of the absolute differences between the output frame and the image,
+ * on the pixels of [border, size - border) */
+static unsigned int get_error(struct vdef_test_frame *out,
+			      image_fn fn,
+			      unsigned int in_depth,
+			      unsigned int border,
+			      unsigned int *max_error)
+{
+	const struct vdef_raw_format *format = &out->frame.format;
+	const struct vdef_dim *res = &out->frame.info.resolution;
+	unsigned int out_max = (1 << format->pix_size) - 1;
+	unsigned int in_max = (1 << in_depth) - 1;
+	unsigned int sum = 0;
+
+	*max_error = 0;
+	for (unsigned int y = border; y < res->height - border; y++) {
+		for (unsigned int x = border; x < res->width - border; x++) {
+			for (unsigned int c = 0; c < 3; c++) {
+				unsigned int v = vdef_test_sample_get(
+					format, sample_ptr(out, c, x, y));
+				unsigned int e = (fn(c, x, y, in_depth) *
+							  out_max +
+						  in_max / 2) /
+						 in_max;
+				e = v > e ? v - e : e - v;
+				sum += e;
+				if (e > *max_error)
+					*max_error = e;
+			}
+		}
+	}
+
+	return sum;
+}
+
+
+static unsigned int run_demosaic(const struct vdef_raw_format *in_format,
+				 const struct vdef_raw_format *out_format,
+				 const struct vdef_dim *res,
+				 image_fn fn,
+				 enum vdef_demosaic_method method,
+				 unsigned int border,
+				 unsigned int *max_error)
+{
+	int ret;
+	struct vdef_test_frame in, out;
+	unsigned int sum;
+
+	vdef_test_frame_alloc(&in, in_format, res);
+	vdef_test_frame_alloc(&out, out_format, res);
+	mosaic(&in, fn);
+
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    method,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	sum = get_error(&out, fn, in_format->pix_size, border, max_error);
+
+	if (out_format->pix_format == VDEF_RAW_PIX_FORMAT_RGBA32) {
+		unsigned int max = (1 << out_format->pix_size) - 1;
+		for (unsigned int y = 0; y < res->height; y++) {
+			for (unsigned int x = 0; x < res->width; x++) {
+				CU_ASSERT_EQUAL(
+					vdef_test_sample_get(
+						out_format,
+						sample_ptr(&out, 3, x, y)),
+					max);
+			}
+		}
+	}
+
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&in);
+
+	return sum;
+}
+
+
+static void test_demosaic_flat(void)
+{
+	struct vdef_dim res = {37, 21};
+	struct vdef_raw_format rgb16 = vdef_rgb;
+	const struct vdef_raw_format *out_formats[] = {
+		&vdef_rgb,
+		&vdef_rgba,
+		&rgb16,
+	};
+
+	rgb16.pix_size = 16;
+	rgb16.data_size = 16;
+	rgb16.data_little_endian = true;
+
+	for (size_t i = 0; i < ARRAY_SIZE(s_test_bayer_formats); i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(out_formats); j++) {
+			for (int m = 0; m < VDEF_DEMOSAIC_METHOD_MAX; m++) {
+				unsigned int max_error;
+				run_demosaic(s_test_bayer_formats[i],
+					     out_formats[j],
+					     &res,
+					     &image_flat,
+					     m,
+					     0,
+					     &max_error);
+				CU_ASSERT_EQUAL(max_error, 0);
+			}
+		}
+	}
+}
+
+
+static void test_demosaic_ramp(void)
+{
+	struct vdef_dim res = {40, 24};
+
+	/* Both methods are exact on linear images, except near the mirrored
+	 * borders */
+	for (size_t i = 0; i < ARRAY_SIZE(s_test_bayer_formats); i++) {
+		for (int m = 0; m < VDEF_DEMOSAIC_METHOD_MAX; m++) {
+			unsigned int max_error;
+			run_demosaic(s_test_bayer_formats[i],
+				     &vdef_rgb,
+				     &res,
+				     &image_ramp,
+				     m,
+				     3,
+				     &max_error);
+			CU_ASSERT(max_error <= 1);
+		}
+	}
+}
+
+
+static void test_demosaic_edge(void)
+{
+	struct vdef_dim res = {32, 16};
+
+	/* The edge-aware method interpolates along the vertical edge */
+	for (size_t i = 0; i < ARRAY_SIZE(s_test_bayer_formats); i++) {
+		unsigned int max_error, bilinear, edge_aware;
+		bilinear = run_demosaic(s_test_bayer_formats[i],
+					&vdef_rgb,
+					&res,
+					&image_edge,
+					VDEF_DEMOSAIC_METHOD_BILINEAR,
+					0,
+					&max_error);
+		edge_aware = run_demosaic(s_test_bayer_formats[i],
+					  &vdef_rgb,
+					  &res,
+					  &image_edge,
+					  VDEF_DEMOSAIC_METHOD_EDGE_AWARE,
+					  0,
+					  &max_error);
+		CU_ASSERT(edge_aware < bilinear);
+	}
+}
+
+
+static void test_demosaic_threads(void)
+{
+	int ret;
+	struct vdef_dim res = {67, 301};
+	struct vdef_test_frame in, out1, out2;
+	struct vdef_thread_pool *pool;
+
+	srand(42);
+	vdef_test_frame_alloc(&in, &vdef_bayer_grbg_12, &res);
+	vdef_test_frame_alloc(&out1, &vdef_rgb, &res);
+	vdef_test_frame_alloc(&out2, &vdef_rgb, &res);
+	mosaic(&in, &image_random);
+
+	for (int m = 0; m < VDEF_DEMOSAIC_METHOD_MAX; m++) {
+		ret = vdef_demosaic(&in.frame,
+				    (const void *const *)in.plane,
+				    &out1.frame,
+				    out1.plane,
+				    m,
+				    NULL);
+		CU_ASSERT_EQUAL(ret, 0);
+		for (unsigned int t = 1; t <= 7; t++) {
+			ret = vdef_thread_pool_new(t, &pool);
+			CU_ASSERT_EQUAL_FATAL(ret, 0);
+			memset(out2.data, 0, out2.layout.size);
+			ret = vdef_demosaic(&in.frame,
+					    (const void *const *)in.plane,
+					    &out2.frame,
+					    out2.plane,
+					    m,
+					    pool);
+			CU_ASSERT_EQUAL(ret, 0);
+			CU_ASSERT_EQUAL(
+				memcmp(out1.data, out2.data, out1.layout.size),
+				0);
+			vdef_thread_pool_destroy(pool);
+		}
+	}
+
+	vdef_test_frame_free(&out2);
+	vdef_test_frame_free(&out1);
+	vdef_test_frame_free(&in);
+}
+
+
+static void test_demosaic_invalid(void)
+{
+	int ret;
+	struct vdef_dim res = {16, 16};
+	struct vdef_test_frame in, out;
+
+	vdef_test_frame_alloc(&in, &vdef_bayer_rggb, &res);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &res);
+
+	/* Invalid arguments */
+	ret = vdef_demosaic(NULL,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_demosaic(&in.frame,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    NULL,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_MAX,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* Resolution mismatch or too small */
+	out.frame.info.resolution.width = 8;
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	in.frame.info.resolution.height = 2;
+	out.frame.info.resolution = in.frame.info.resolution;
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	in.frame.info.resolution = res;
+	out.frame.info.resolution = res;
+
+	/* Unsupported formats */
+	in.frame.format = vdef_bayer_rggb_10_packed;
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	in.frame.format = vdef_raw8;
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	in.frame.format = vdef_bayer_rggb;
+	out.frame.format = vdef_i420;
+	ret = vdef_demosaic(&in.frame,
+			    (const void *const *)in.plane,
+			    &out.frame,
+			    out.plane,
+			    VDEF_DEMOSAIC_METHOD_BILINEAR,
+			    NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&in);
+}
+
+
+CU_TestInfo g_vdef_test_demosaic[] = {
+	{FN("demosaic-flat"), &test_demosaic_flat},
+	{FN("demosaic-ramp"), &test_demosaic_ramp},
+	{FN("demosaic-edge"), &test_demosaic_edge},
+	{FN("demosaic-threads"), &test_demosaic_threads},
+	{FN("demosaic-invalid"), &test_demosaic_invalid},
+
+	CU_TEST_INFO_NULL,
+};
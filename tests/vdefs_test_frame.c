@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+unsigned int vdef_test_sample_get(const struct vdef_raw_format *format,
+				  const uint8_t *p)
+{
+	unsigned int v;
+
+	if (format->data_size == 8)
+		return p[0];
+	v = format->data_little_endian ? (p[0] | (p[1] << 8))
+				       : ((p[0] << 8) | p[1]);
+	return format->data_pad_low ? v >> (16 - format->pix_size) : v;
+}
+
+
+void vdef_test_sample_set(const struct vdef_raw_format *format,
+			  uint8_t *p,
+			  unsigned int v)
+{
+	if (format->data_size == 8) {
+		p[0] = v;
+		return;
+	}
+	if (format->data_pad_low)
+		v <<= 16 - format->pix_size;
+	p[format->data_little_endian ? 0 : 1] = v & 0xff;
+	p[format->data_little_endian ? 1 : 0] = v >> 8;
+}
+
+
+void vdef_test_frame_alloc(struct vdef_test_frame *f,
+			   const struct vdef_raw_format *format,
+			   const struct vdef_dim *resolution)
+{
+	vdef_test_frame_alloc_aligned(f, format, resolution, 0);
+}
+
+
+void vdef_test_frame_alloc_aligned(struct vdef_test_frame *f,
+				   const struct vdef_raw_format *format,
+				   const struct vdef_dim *resolution,
+				   unsigned int stride_align)
+{
+	int res;
+	unsigned int align[VDEF_RAW_MAX_PLANE_COUNT];
+
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++)
+		align[i] = stride_align;
+	memset(f, 0, sizeof(*f));
+	res = vdef_calc_raw_layout(
+		format, resolution, align, NULL, NULL, &f->layout);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	f->data = calloc(1, f->layout.size);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f->data);
+	res = vdef_raw_layout_get_planes(
+		&f->layout, f->data, f->layout.size, f->plane);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	f->frame.format = *format;
+	f->frame.info.resolution = *resolution;
+	memcpy(f->frame.plane_stride,
+	       f->layout.plane_stride,
+	       sizeof(f->frame.plane_stride));
+}
+
+
+void vdef_test_frame_set_info(struct vdef_test_frame *f,
+			      const struct vdef_format_info *info)
+{
+	f->frame.info.bit_depth = info->bit_depth;
+	f->frame.info.full_range = info->full_range;
+	f->frame.info.color_primaries = info->color_primaries;
+	f->frame.info.transfer_function = info->transfer_function;
+	f->frame.info.matrix_coefs = info->matrix_coefs;
+	f->frame.info.dynamic_range = info->dynamic_range;
+	f->frame.info.tone_mapping = info->tone_mapping;
+}
+
+
+void vdef_test_frame_free(struct vdef_test_frame *f)
+{
+	free(f->data);
+	memset(f, 0, sizeof(*f));
+}
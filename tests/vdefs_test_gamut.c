@@ -0,0 +1,564 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <math.h>
+
+
+static const struct vdef_dim s_res = {130, 20};
+
+
+/* Reference colors (8-bit non-linear RGB) */
+static const uint8_t s_colors[][3] = {
+	{0, 0, 0},
+	{255, 255, 255},
+	{128, 128, 128},
+	{255, 0, 0},
+	{0, 255, 0},
+	{0, 0, 255},
+	{200, 150, 100},
+	{30, 60, 220},
+};
+
+
+/* Color parameters of the test frames */
+static const struct vdef_format_info s_srgb_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT709,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_SRGB,
+	.matrix_coefs = VDEF_MATRIX_COEFS_IDENTITY,
+};
+
+
+static const struct vdef_format_info s_bt709_rgb_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT709,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_BT709,
+	.matrix_coefs = VDEF_MATRIX_COEFS_IDENTITY,
+};
+
+
+static const struct vdef_format_info s_bt709_yuv_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT709,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_BT709,
+	.matrix_coefs = VDEF_MATRIX_COEFS_BT709,
+};
+
+
+static const struct vdef_format_info s_bt2020_rgb_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT2020,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_BT2020,
+	.matrix_coefs = VDEF_MATRIX_COEFS_IDENTITY,
+};
+
+
+static const struct vdef_format_info s_bt2020_yuv_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT2020,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_BT2020,
+	.matrix_coefs = VDEF_MATRIX_COEFS_BT2020_NON_CST,
+};
+
+
+/* Get a sample of a packed RGB frame (8-bit or 16-bit little-endian) */
+static unsigned int
+rgb_get(const struct vdef_test_frame *f, unsigned int i, unsigned int c)
+{
+	unsigned int bytes = f->frame.format.data_size / 8;
+	const uint8_t *p = f->data + (3 * i + c) * bytes;
+
+	return f->frame.format.data_size == 8 ? p[0] : p[0] | (p[1] << 8);
+}
+
+
+/* Fill a packed 8-bit RGB frame with the reference colors */
+static void fill_colors(struct vdef_test_frame *f)
+{
+	unsigned int count = f->frame.info.resolution.width *
+			     f->frame.info.resolution.height;
+
+	for (unsigned int i = 0; i < count; i++)
+		memcpy(f->data + 3 * i, s_colors[i % ARRAY_SIZE(s_colors)], 3);
+}
+
+
+/* Reference conversion of a color with hard clipping */
+static void ref_convert(const uint8_t *color,
+			enum vdef_transfer_function in_transfer,
+			const float *mat,
+			enum vdef_transfer_function out_transfer,
+			unsigned int out_max,
+			unsigned int *out)
+{
+	float lin[3];
+
+	for (unsigned int k = 0; k < 3; k++) {
+		lin[k] = vdef_transfer_function_to_linear(in_transfer,
+							  color[k] / 255.f);
+	}
+	for (unsigned int c = 0; c < 3; c++) {
+		float v = lin[c];
+		if (mat != NULL) {
+			v = lin[0] * mat[c] + lin[1] * mat[3 + c] +
+			    lin[2] * mat[6 + c];
+		}
+		v = vdef_transfer_function_from_linear(out_transfer, v);
+		out[c] = lroundf(v * out_max);
+	}
+}
+
+
+static void test_gamut_identity(void)
+{
+	int res;
+	struct vdef_test_frame in, out;
+
+	vdef_test_frame_alloc(&in, &vdef_rgb, &s_res);
+	vdef_test_frame_set_info(&in, &s_srgb_info);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &s_res);
+	vdef_test_frame_set_info(&out, &s_srgb_info);
+	srand(42);
+	for (size_t i = 0; i < in.layout.size; i++)
+		in.data[i] = rand() % 256;
+
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	for (size_t i = 0; i < in.layout.size; i++) {
+		if (abs(in.data[i] - out.data[i]) > 1) {
+			CU_FAIL("identity conversion mismatch");
+			break;
+		}
+	}
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void check_reference(enum vdef_color_primaries in_primaries,
+			    enum vdef_transfer_function in_transfer,
+			    enum vdef_color_primaries out_primaries,
+			    enum vdef_transfer_function out_transfer,
+			    const float *mat,
+			    const struct vdef_raw_format *out_format,
+			    unsigned int tolerance)
+{
+	int res;
+	struct vdef_test_frame in, out;
+	unsigned int out_max = (1 << out_format->pix_size) - 1;
+	unsigned int count = s_res.width * s_res.height;
+	unsigned int ref[3];
+	struct vdef_format_info in_info = {
+		.color_primaries = in_primaries,
+		.transfer_function = in_transfer,
+		.matrix_coefs = VDEF_MATRIX_COEFS_IDENTITY,
+	};
+	struct vdef_format_info out_info = {
+		.color_primaries = out_primaries,
+		.transfer_function = out_transfer,
+		.matrix_coefs = VDEF_MATRIX_COEFS_IDENTITY,
+	};
+
+	vdef_test_frame_alloc(&in, &vdef_rgb, &s_res);
+	vdef_test_frame_set_info(&in, &in_info);
+	vdef_test_frame_alloc(&out, out_format, &s_res);
+	vdef_test_frame_set_info(&out, &out_info);
+	fill_colors(&in);
+
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	for (unsigned int i = 0; i < count; i++) {
+		const uint8_t *color = s_colors[i % ARRAY_SIZE(s_colors)];
+		ref_convert(
+			color, in_transfer, mat, out_transfer, out_max, ref);
+		for (unsigned int c = 0; c < 3; c++) {
+			unsigned int v = rgb_get(&out, i, c);
+			CU_ASSERT(v + tolerance >= ref[c] &&
+				  v <= ref[c] + tolerance);
+		}
+	}
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_gamut_reference(void)
+{
+	struct vdef_raw_format rgb16 = vdef_rgb;
+
+	rgb16.data_size = 16;
+	rgb16.pix_size = 16;
+	rgb16.data_little_endian = true;
+
+	check_reference(VDEF_COLOR_PRIMARIES_BT709,
+			VDEF_TRANSFER_FUNCTION_SRGB,
+			VDEF_COLOR_PRIMARIES_BT2020,
+			VDEF_TRANSFER_FUNCTION_BT2020,
+			vdef_bt709_to_bt2020_matrix,
+			&vdef_rgb,
+			1);
+	check_reference(VDEF_COLOR_PRIMARIES_BT2020,
+			VDEF_TRANSFER_FUNCTION_HLG,
+			VDEF_COLOR_PRIMARIES_BT709,
+			VDEF_TRANSFER_FUNCTION_BT709,
+			vdef_bt2020_to_bt709_matrix,
+			&vdef_rgb,
+			1);
+	check_reference(VDEF_COLOR_PRIMARIES_BT709,
+			VDEF_TRANSFER_FUNCTION_BT709,
+			VDEF_COLOR_PRIMARIES_BT709,
+			VDEF_TRANSFER_FUNCTION_SRGB,
+			NULL,
+			&vdef_rgb,
+			1);
+	check_reference(VDEF_COLOR_PRIMARIES_BT709,
+			VDEF_TRANSFER_FUNCTION_BT709,
+			VDEF_COLOR_PRIMARIES_BT2020,
+			VDEF_TRANSFER_FUNCTION_BT2020,
+			vdef_bt709_to_bt2020_matrix,
+			&rgb16,
+			64);
+}
+
+
+static void convert_color(const uint8_t *color,
+			  enum vdef_gamut_clip_method clip,
+			  unsigned int *out_color)
+{
+	int res;
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_1 = {1, 1};
+	/* BT.709 transfer function with the BT.2020 primaries */
+	struct vdef_format_info in_info = s_bt709_rgb_info;
+
+	in_info.color_primaries = VDEF_COLOR_PRIMARIES_BT2020;
+
+	vdef_test_frame_alloc(&in, &vdef_rgb, &res_1);
+	vdef_test_frame_set_info(&in, &in_info);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &res_1);
+	vdef_test_frame_set_info(&out, &s_bt709_rgb_info);
+	memcpy(in.data, color, 3);
+
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 clip,
+				 NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	for (unsigned int c = 0; c < 3; c++)
+		out_color[c] = out.data[c];
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_gamut_clip(void)
+{
+	static const uint8_t green[3] = {0, 255, 0};
+	static const uint8_t gray[3] = {128, 128, 128};
+	unsigned int hard[3], soft[3];
+
+	/* BT.2020 green is outside of the BT.709 gamut */
+	convert_color(green, VDEF_GAMUT_CLIP_METHOD_HARD, hard);
+	CU_ASSERT_EQUAL(hard[0], 0);
+	CU_ASSERT_EQUAL(hard[1], 255);
+	CU_ASSERT_EQUAL(hard[2], 0);
+
+	/* Soft clipping desaturates towards the luminance and compresses the
+	 * highlights */
+	convert_color(green, VDEF_GAMUT_CLIP_METHOD_SOFT, soft);
+	CU_ASSERT(soft[0] <= 1);
+	CU_ASSERT(soft[2] > 64);
+	CU_ASSERT(soft[1] > soft[2]);
+	CU_ASSERT(soft[1] < 255);
+
+	/* Neutral colors are not changed */
+	convert_color(gray, VDEF_GAMUT_CLIP_METHOD_HARD, hard);
+	convert_color(gray, VDEF_GAMUT_CLIP_METHOD_SOFT, soft);
+	for (unsigned int c = 0; c < 3; c++) {
+		CU_ASSERT(abs((int)hard[c] - 128) <= 1);
+		CU_ASSERT_EQUAL(soft[c], hard[c]);
+	}
+}
+
+
+/* BT.2020 10-bit I420 to BT.709 8-bit NV12 (e.g. SDR proxy of a BT.2020
+ * recording), checked by converting back to RGB */
+static void test_gamut_yuv(void)
+{
+	int res;
+	struct vdef_test_frame rgb_in, yuv_in, yuv_out, rgb_out;
+	struct vdef_dim res_flat = {34, 18};
+	unsigned int count = res_flat.width * res_flat.height;
+	unsigned int ref[3];
+
+	for (unsigned int k = 0; k < ARRAY_SIZE(s_colors); k++) {
+		vdef_test_frame_alloc(&rgb_in, &vdef_rgb, &res_flat);
+		vdef_test_frame_set_info(&rgb_in, &s_bt2020_rgb_info);
+		vdef_test_frame_alloc(&yuv_in, &vdef_i420_10_16le, &res_flat);
+		vdef_test_frame_set_info(&yuv_in, &s_bt2020_yuv_info);
+		vdef_test_frame_alloc(&yuv_out, &vdef_nv12, &res_flat);
+		vdef_test_frame_set_info(&yuv_out, &s_bt709_yuv_info);
+		vdef_test_frame_alloc(&rgb_out, &vdef_rgb, &res_flat);
+		vdef_test_frame_set_info(&rgb_out, &s_bt709_rgb_info);
+		for (unsigned int i = 0; i < count; i++)
+			memcpy(rgb_in.data + 3 * i, s_colors[k], 3);
+
+		res = vdef_convert_rgb_to_yuv(&rgb_in.frame,
+					      (const void *const *)rgb_in.plane,
+					      &yuv_in.frame,
+					      yuv_in.plane);
+		CU_ASSERT_EQUAL(res, 0);
+		res = vdef_convert_gamut(&yuv_in.frame,
+					 (const void *const *)yuv_in.plane,
+					 &yuv_out.frame,
+					 yuv_out.plane,
+					 VDEF_GAMUT_CLIP_METHOD_HARD,
+					 NULL);
+		CU_ASSERT_EQUAL(res, 0);
+		res = vdef_convert_yuv_to_rgb(
+			&yuv_out.frame,
+			(const void *const *)yuv_out.plane,
+			&rgb_out.frame,
+			rgb_out.plane);
+		CU_ASSERT_EQUAL(res, 0);
+
+		ref_convert(s_colors[k],
+			    VDEF_TRANSFER_FUNCTION_BT2020,
+			    vdef_bt2020_to_bt709_matrix,
+			    VDEF_TRANSFER_FUNCTION_BT709,
+			    255,
+			    ref);
+		for (unsigned int i = 0; i < count; i++) {
+			for (unsigned int c = 0; c < 3; c++) {
+				int v = rgb_get(&rgb_out, i, c);
+				CU_ASSERT(abs(v - (int)ref[c]) <= 3);
+			}
+		}
+
+		vdef_test_frame_free(&rgb_in);
+		vdef_test_frame_free(&yuv_in);
+		vdef_test_frame_free(&yuv_out);
+		vdef_test_frame_free(&rgb_out);
+	}
+}
+
+
+static void test_gamut_threads(void)
+{
+	int res;
+	struct vdef_test_frame in, out[3];
+	struct vdef_dim res_odd = {131, 67};
+	const unsigned int threads[3] = {1, 3, 0};
+	struct vdef_thread_pool *pool;
+	struct vdef_format_info in_info = s_bt2020_yuv_info;
+
+	in_info.transfer_function = VDEF_TRANSFER_FUNCTION_HLG;
+
+	vdef_test_frame_alloc(&in, &vdef_i420, &res_odd);
+	vdef_test_frame_set_info(&in, &in_info);
+	srand(42);
+	for (size_t i = 0; i < in.layout.size; i++)
+		in.data[i] = rand() % 256;
+
+	for (unsigned int i = 0; i < 3; i++) {
+		vdef_test_frame_alloc(&out[i], &vdef_nv12, &res_odd);
+		vdef_test_frame_set_info(&out[i], &s_bt709_yuv_info);
+		res = vdef_thread_pool_new(threads[i], &pool);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		res = vdef_convert_gamut(&in.frame,
+					 (const void *const *)in.plane,
+					 &out[i].frame,
+					 out[i].plane,
+					 VDEF_GAMUT_CLIP_METHOD_SOFT,
+					 pool);
+		CU_ASSERT_EQUAL(res, 0);
+		vdef_thread_pool_destroy(pool);
+	}
+	CU_ASSERT_EQUAL(memcmp(out[0].data, out[1].data, out[0].layout.size),
+			0);
+	CU_ASSERT_EQUAL(memcmp(out[0].data, out[2].data, out[0].layout.size),
+			0);
+
+	vdef_test_frame_free(&in);
+	for (unsigned int i = 0; i < 3; i++)
+		vdef_test_frame_free(&out[i]);
+}
+
+
+static void test_gamut_invalid(void)
+{
+	int res;
+	struct vdef_test_frame in, out, bayer;
+	struct vdef_dim res_small = {16, 16};
+
+	vdef_test_frame_alloc(&in, &vdef_i420, &res_small);
+	vdef_test_frame_set_info(&in, &s_bt2020_yuv_info);
+	vdef_test_frame_alloc(&out, &vdef_nv12, &res_small);
+	vdef_test_frame_set_info(&out, &s_bt709_yuv_info);
+	vdef_test_frame_alloc(&bayer, &vdef_bayer_rggb, &res_small);
+	vdef_test_frame_set_info(&bayer, &s_bt709_yuv_info);
+
+	/* Invalid arguments */
+	res = vdef_convert_gamut(
+		NULL,
+		(const void *const *)in.plane,
+		&out.frame,
+		out.plane,
+		0,
+		NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_gamut(
+		&in.frame, NULL, &out.frame, out.plane, 0, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_gamut(
+		&in.frame,
+		(const void *const *)in.plane,
+		NULL,
+		out.plane,
+		0,
+		NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_gamut(
+		&in.frame,
+		(const void *const *)in.plane,
+		&out.frame,
+		NULL,
+		0,
+		NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_MAX,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Resolution mismatch */
+	out.frame.info.resolution.width = 18;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	out.frame.info.resolution.width = 16;
+
+	/* Unknown color parameters */
+	in.frame.info.color_primaries = VDEF_COLOR_PRIMARIES_UNKNOWN;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	in.frame.info.color_primaries = VDEF_COLOR_PRIMARIES_BT2020;
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_UNKNOWN;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_BT709;
+	in.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_UNKNOWN;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	in.frame.info.matrix_coefs = VDEF_MATRIX_COEFS_BT2020_NON_CST;
+
+	/* Unsupported conversions */
+	in.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_PQ;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	in.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_BT2020;
+	in.frame.info.color_primaries = VDEF_COLOR_PRIMARIES_DCI_P3;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	in.frame.info.color_primaries = VDEF_COLOR_PRIMARIES_BT2020;
+
+	/* Unsupported formats */
+	res = vdef_convert_gamut(&bayer.frame,
+				 (const void *const *)bayer.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* Valid conversion */
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, 0);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&bayer);
+}
+
+
+CU_TestInfo g_vdef_test_gamut[] = {
+	{FN("gamut-identity"), &test_gamut_identity},
+	{FN("gamut-reference"), &test_gamut_reference},
+	{FN("gamut-clip"), &test_gamut_clip},
+	{FN("gamut-yuv"), &test_gamut_yuv},
+	{FN("gamut-threads"), &test_gamut_threads},
+	{FN("gamut-invalid"), &test_gamut_invalid},
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,740 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <pthread.h>
+
+
+#define LAYOUT_CACHE_THREAD_COUNT 4
+
+
+struct layout_cache_thread_ctx {
+	struct vdef_raw_layout_cache *cache;
+	const struct vdef_raw_layout *layout;
+};
+
+
+static void test_calc_raw_layout(void)
+{
+	int res;
+	struct vdef_raw_layout layout;
+	struct vdef_dim res_1080p = {1920, 1080};
+	struct vdef_dim res_null = {0, 1080};
+	unsigned int stride_align[VDEF_RAW_MAX_PLANE_COUNT] = {64, 64, 64};
+	unsigned int size_align[VDEF_RAW_MAX_PLANE_COUNT] = {4096, 4096, 4096};
+
+	/* Invalid arguments */
+	res = vdef_calc_raw_layout(
+		NULL, &res_1080p, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_layout(&vdef_i420, NULL, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_layout(
+		&vdef_i420, &res_null, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_layout(
+		&vdef_i420, &res_1080p, NULL, NULL, NULL, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* I420 without alignment */
+	res = vdef_calc_raw_layout(
+		&vdef_i420, &res_1080p, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(vdef_raw_format_cmp(&layout.format, &vdef_i420));
+	CU_ASSERT_TRUE(vdef_dim_cmp(&layout.resolution, &res_1080p));
+	CU_ASSERT_EQUAL(layout.plane_count, 3);
+	CU_ASSERT_EQUAL(layout.plane_stride[0], 1920);
+	CU_ASSERT_EQUAL(layout.plane_stride[1], 960);
+	CU_ASSERT_EQUAL(layout.plane_stride[2], 960);
+	CU_ASSERT_EQUAL(layout.plane_stride[3], 0);
+	CU_ASSERT_EQUAL(layout.plane_scanline[0], 1080);
+	CU_ASSERT_EQUAL(layout.plane_scanline[1], 540);
+	CU_ASSERT_EQUAL(layout.plane_scanline[2], 540);
+	CU_ASSERT_EQUAL(layout.plane_offset[0], 0);
+	CU_ASSERT_EQUAL(layout.plane_offset[1], 2073600);
+	CU_ASSERT_EQUAL(layout.plane_offset[2], 2073600 + 518400);
+	CU_ASSERT_EQUAL(layout.plane_offset[3], 0);
+	CU_ASSERT_EQUAL(layout.size, 3110400);
+	CU_ASSERT_EQUAL(layout.size,
+			vdef_calc_raw_contiguous_frame_size(&vdef_i420,
+							    &res_1080p,
+							    NULL,
+							    NULL,
+							    NULL,
+							    NULL,
+							    NULL));
+
+	/* NV12 with stride and size alignment */
+	res = vdef_calc_raw_layout(&vdef_nv12,
+				   &res_1080p,
+				   stride_align,
+				   NULL,
+				   size_align,
+				   &layout);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(layout.plane_count, 2);
+	CU_ASSERT_EQUAL(layout.plane_stride[0], 1920);
+	CU_ASSERT_EQUAL(layout.plane_stride[1], 1920);
+	CU_ASSERT_EQUAL(layout.plane_size[0], 2076672);
+	CU_ASSERT_EQUAL(layout.plane_size[1], 1040384);
+	CU_ASSERT_EQUAL(layout.plane_offset[1], 2076672);
+	CU_ASSERT_EQUAL(layout.size, 2076672 + 1040384);
+}
+
+
+static void test_calc_raw_contiguous_frame_planes(void)
+{
+	ssize_t res;
+	uint8_t *buf;
+	size_t buf_size = 3110400;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+	size_t plane_size[VDEF_RAW_MAX_PLANE_COUNT];
+	size_t plane_stride[VDEF_RAW_MAX_PLANE_COUNT] = {0};
+	struct vdef_dim res_1080p = {1920, 1080};
+
+	buf = malloc(buf_size);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+
+	/* Invalid arguments */
+	res = vdef_calc_raw_contiguous_frame_planes(NULL,
+						    buf_size,
+						    &vdef_i420,
+						    &res_1080p,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    plane,
+						    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_contiguous_frame_planes(buf,
+						    buf_size,
+						    &vdef_i420,
+						    &res_1080p,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* I420 */
+	res = vdef_calc_raw_contiguous_frame_planes(buf,
+						    buf_size,
+						    &vdef_i420,
+						    &res_1080p,
+						    plane_stride,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    plane,
+						    plane_size);
+	CU_ASSERT_EQUAL(res, 3110400);
+	CU_ASSERT_PTR_EQUAL(plane[0], buf);
+	CU_ASSERT_PTR_EQUAL(plane[1], buf + 2073600);
+	CU_ASSERT_PTR_EQUAL(plane[2], buf + 2073600 + 518400);
+	CU_ASSERT_PTR_NULL(plane[3]);
+	CU_ASSERT_EQUAL(plane_stride[0], 1920);
+	CU_ASSERT_EQUAL(plane_stride[1], 960);
+	CU_ASSERT_EQUAL(plane_size[0], 2073600);
+	CU_ASSERT_EQUAL(plane_size[1], 518400);
+	CU_ASSERT_EQUAL(plane_size[2], 518400);
+	CU_ASSERT_EQUAL(plane_size[3], 0);
+
+	/* NV12 */
+	res = vdef_calc_raw_contiguous_frame_planes(buf,
+						    buf_size,
+						    &vdef_nv12,
+						    &res_1080p,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    plane,
+						    NULL);
+	CU_ASSERT_EQUAL(res, 3110400);
+	CU_ASSERT_PTR_EQUAL(plane[0], buf);
+	CU_ASSERT_PTR_EQUAL(plane[1], buf + 2073600);
+	CU_ASSERT_PTR_NULL(plane[2]);
+	CU_ASSERT_PTR_NULL(plane[3]);
+
+	/* Buffer too small: the plane pointers are not written */
+	memset(plane, 0, sizeof(plane));
+	res = vdef_calc_raw_contiguous_frame_planes(buf,
+						    buf_size - 1,
+						    &vdef_nv12,
+						    &res_1080p,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    NULL,
+						    plane,
+						    NULL);
+	CU_ASSERT_EQUAL(res, -ENOBUFS);
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++)
+		CU_ASSERT_PTR_NULL(plane[i]);
+
+	free(buf);
+}
+
+
+static void test_raw_layout_get_planes(void)
+{
+	int res;
+	uint8_t *buf;
+	struct vdef_raw_layout layout;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+	struct vdef_dim res_1080p = {1920, 1080};
+
+	res = vdef_calc_raw_layout(
+		&vdef_i420, &res_1080p, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, 0);
+
+	buf = malloc(layout.size);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+
+	res = vdef_raw_layout_get_planes(NULL, buf, layout.size, plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_raw_layout_get_planes(&layout, buf, layout.size - 1, plane);
+	CU_ASSERT_EQUAL(res, -ENOBUFS);
+
+	res = vdef_raw_layout_get_planes(&layout, buf, layout.size, plane);
+	CU_ASSERT_EQUAL(res, 0);
+	for (unsigned int i = 0; i < layout.plane_count; i++)
+		CU_ASSERT_PTR_EQUAL(plane[i], buf + layout.plane_offset[i]);
+	CU_ASSERT_PTR_NULL(plane[3]);
+
+	free(buf);
+}
+
+
+static void test_raw_layout_cache_get(void)
+{
+	int res;
+	struct vdef_raw_layout_cache *cache = NULL;
+	const struct vdef_raw_layout *layout1 = NULL, *layout2 = NULL;
+	const struct vdef_raw_layout *layout3 = NULL, *layout4 = NULL;
+	struct vdef_dim res_1080p = {1920, 1080};
+	struct vdef_dim res_720p = {1280, 720};
+	struct vdef_dim res_null = {0, 0};
+	unsigned int no_align[VDEF_RAW_MAX_PLANE_COUNT] = {0};
+	unsigned int stride_align[VDEF_RAW_MAX_PLANE_COUNT] = {64, 64};
+
+	res = vdef_raw_layout_cache_new(NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_raw_layout_cache_new(&cache);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(cache);
+
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv12, &res_1080p, NULL, NULL, NULL, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Invalid resolution: nothing is cached */
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv12, &res_null, NULL, NULL, NULL, &layout1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	CU_ASSERT_PTR_NULL(layout1);
+
+	/* Same key: same layout */
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv12, &res_1080p, NULL, NULL, NULL, &layout1);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv12, &res_1080p, NULL, NULL, NULL, &layout2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL(layout1);
+	CU_ASSERT_TRUE(layout1 == layout2);
+	CU_ASSERT_EQUAL(layout1->size, 3110400);
+
+	/* NULL and zero alignment arrays are the same key */
+	res = vdef_raw_layout_cache_get(cache,
+					&vdef_nv12,
+					&res_1080p,
+					no_align,
+					NULL,
+					no_align,
+					&layout2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(layout1 == layout2);
+
+	/* Different keys: different layouts */
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv12, &res_720p, NULL, NULL, NULL, &layout3);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(layout1 != layout3);
+	CU_ASSERT_EQUAL(layout3->size, 1382400);
+
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv21, &res_1080p, NULL, NULL, NULL, &layout4);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(layout1 != layout4);
+
+	res = vdef_raw_layout_cache_get(cache,
+					&vdef_nv12,
+					&res_720p,
+					stride_align,
+					NULL,
+					NULL,
+					&layout4);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(layout3 != layout4);
+
+	/* Previous layouts are still valid */
+	res = vdef_raw_layout_cache_get(
+		cache, &vdef_nv12, &res_720p, NULL, NULL, NULL, &layout2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(layout2 == layout3);
+
+	res = vdef_raw_layout_cache_destroy(cache);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+static void *layout_cache_thread(void *userdata)
+{
+	struct layout_cache_thread_ctx *ctx = userdata;
+	struct vdef_dim res_2160p = {3840, 2160};
+
+	(void)vdef_raw_layout_cache_get(ctx->cache,
+					&vdef_i420,
+					&res_2160p,
+					NULL,
+					NULL,
+					NULL,
+					&ctx->layout);
+
+	return NULL;
+}
+
+
+static void test_raw_layout_cache_threads(void)
+{
+	int res;
+	struct vdef_raw_layout_cache *cache = NULL;
+	pthread_t threads[LAYOUT_CACHE_THREAD_COUNT];
+	struct layout_cache_thread_ctx ctx[LAYOUT_CACHE_THREAD_COUNT] = {0};
+
+	res = vdef_raw_layout_cache_new(&cache);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(cache);
+
+	for (unsigned int i = 0; i < LAYOUT_CACHE_THREAD_COUNT; i++) {
+		ctx[i].cache = cache;
+		res = pthread_create(
+			&threads[i], NULL, layout_cache_thread, &ctx[i]);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+	for (unsigned int i = 0; i < LAYOUT_CACHE_THREAD_COUNT; i++)
+		pthread_join(threads[i], NULL);
+
+	/* All threads must get the same layout */
+	CU_ASSERT_PTR_NOT_NULL(ctx[0].layout);
+	for (unsigned int i = 1; i < LAYOUT_CACHE_THREAD_COUNT; i++)
+		CU_ASSERT_TRUE(ctx[i].layout == ctx[0].layout);
+
+	res = vdef_raw_layout_cache_destroy(cache);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+static void test_get_raw_frame_crop_align(void)
+{
+	int res;
+	struct vdef_rect align;
+
+	/* Invalid arguments */
+	res = vdef_get_raw_frame_crop_align(NULL, &align);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_get_raw_frame_crop_align(&vdef_i420, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Unsupported layouts */
+	res = vdef_get_raw_frame_crop_align(&vdef_nv21_hisi_tile, &align);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* YUV 4:2:0 */
+	res = vdef_get_raw_frame_crop_align(&vdef_i420, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align.left, 2);
+	CU_ASSERT_EQUAL(align.top, 2);
+	CU_ASSERT_EQUAL(align.width, 2);
+	CU_ASSERT_EQUAL(align.height, 2);
+
+	res = vdef_get_raw_frame_crop_align(&vdef_nv12_10_packed, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align.left, 4);
+	CU_ASSERT_EQUAL(align.top, 2);
+	CU_ASSERT_EQUAL(align.width, 2);
+	CU_ASSERT_EQUAL(align.height, 2);
+
+	/* RGB */
+	res = vdef_get_raw_frame_crop_align(&vdef_rgba, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align.left, 1);
+	CU_ASSERT_EQUAL(align.top, 1);
+	CU_ASSERT_EQUAL(align.width, 1);
+	CU_ASSERT_EQUAL(align.height, 1);
+
+	/* Bayer */
+	res = vdef_get_raw_frame_crop_align(&vdef_bayer_rggb_12_packed, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align.left, 2);
+	CU_ASSERT_EQUAL(align.top, 2);
+	CU_ASSERT_EQUAL(align.width, 2);
+	CU_ASSERT_EQUAL(align.height, 2);
+}
+
+
+static void test_calc_raw_frame_crop(void)
+{
+	int res;
+	struct vdef_raw_frame frame = {0};
+	struct vdef_raw_frame view;
+	struct vdef_rect crop;
+	size_t plane_offset[VDEF_RAW_MAX_PLANE_COUNT];
+
+	frame.format = vdef_i420;
+	frame.info.resolution.width = 1920;
+	frame.info.resolution.height = 1080;
+	frame.plane_stride[0] = 2048;
+	frame.plane_stride[1] = 1024;
+	frame.plane_stride[2] = 1024;
+
+	/* Invalid arguments */
+	crop = (struct vdef_rect){0, 0, 640, 480};
+	res = vdef_calc_raw_frame_crop(NULL, &crop, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_crop(
+		&frame, NULL, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, NULL, plane_offset);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, &view, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Outside of the frame */
+	crop = (struct vdef_rect){1600, 0, 640, 480};
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -ERANGE);
+
+	/* I420 aligned crop */
+	crop = (struct vdef_rect){100, 50, 640, 480};
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(vdef_raw_format_cmp(&view.format, &vdef_i420));
+	CU_ASSERT_EQUAL(view.info.resolution.width, 640);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 480);
+	CU_ASSERT_EQUAL(view.plane_stride[0], 2048);
+	CU_ASSERT_EQUAL(view.plane_stride[1], 1024);
+	CU_ASSERT_EQUAL(view.plane_stride[2], 1024);
+	CU_ASSERT_EQUAL(plane_offset[0], 50 * 2048 + 100);
+	CU_ASSERT_EQUAL(plane_offset[1], 25 * 1024 + 50);
+	CU_ASSERT_EQUAL(plane_offset[2], 25 * 1024 + 50);
+	CU_ASSERT_EQUAL(plane_offset[3], 0);
+
+	/* I420 unaligned crop */
+	crop = (struct vdef_rect){101, 51, 639, 479};
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EPROTO);
+
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, true, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(crop.left, 100);
+	CU_ASSERT_EQUAL(crop.top, 50);
+	CU_ASSERT_EQUAL(crop.width, 640);
+	CU_ASSERT_EQUAL(crop.height, 480);
+	CU_ASSERT_EQUAL(view.info.resolution.width, 640);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 480);
+	CU_ASSERT_EQUAL(plane_offset[0], 50 * 2048 + 100);
+	CU_ASSERT_EQUAL(plane_offset[1], 25 * 1024 + 50);
+
+	/* Centered crop */
+	crop = (struct vdef_rect){-1, -1, 1280, 720};
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(crop.left, 320);
+	CU_ASSERT_EQUAL(crop.top, 180);
+	CU_ASSERT_EQUAL(plane_offset[0], 180 * 2048 + 320);
+	CU_ASSERT_EQUAL(plane_offset[1], 90 * 1024 + 160);
+
+	/* NV12 10-bit packed crop */
+	frame.format = vdef_nv12_10_packed;
+	frame.plane_stride[0] = 2400;
+	frame.plane_stride[1] = 2400;
+	frame.plane_stride[2] = 0;
+	crop = (struct vdef_rect){102, 50, 640, 480};
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, true, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(crop.left, 100);
+	CU_ASSERT_EQUAL(crop.width, 642);
+	CU_ASSERT_EQUAL(plane_offset[0], 50 * 2400 + 125);
+	CU_ASSERT_EQUAL(plane_offset[1], 25 * 2400 + 125);
+	CU_ASSERT_EQUAL(plane_offset[2], 0);
+
+	/* RGBA crop */
+	frame.format = vdef_rgba;
+	frame.plane_stride[0] = 7680;
+	frame.plane_stride[1] = 0;
+	crop = (struct vdef_rect){3, 5, 7, 9};
+	res = vdef_calc_raw_frame_crop(
+		&frame, &crop, false, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(plane_offset[0], 5 * 7680 + 3 * 4);
+	CU_ASSERT_EQUAL(view.info.resolution.width, 7);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 9);
+}
+
+
+static void test_get_raw_frame_band_align(void)
+{
+	int res;
+	unsigned int align;
+
+	/* Invalid arguments */
+	res = vdef_get_raw_frame_band_align(NULL, &align);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_get_raw_frame_band_align(&vdef_i420, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Unsupported layouts */
+	res = vdef_get_raw_frame_band_align(&vdef_nv21_hisi_tile_compressed,
+					    &align);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* YUV 4:2:0 */
+	res = vdef_get_raw_frame_band_align(&vdef_i420, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align, 2);
+
+	res = vdef_get_raw_frame_band_align(&vdef_nv12_10_packed, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align, 2);
+
+	/* YUV 4:2:2 interleaved */
+	res = vdef_get_raw_frame_band_align(&vdef_yuyv, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align, 1);
+
+	/* RGB */
+	res = vdef_get_raw_frame_band_align(&vdef_rgba, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align, 1);
+
+	/* Bayer */
+	res = vdef_get_raw_frame_band_align(&vdef_bayer_rggb_12_packed,
+					    &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align, 2);
+
+	/* Tiled: whole rows of tiles */
+	res = vdef_get_raw_frame_band_align(&vdef_nv21_hisi_tile, &align);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(align, 16);
+}
+
+
+static void test_calc_raw_frame_bands(void)
+{
+	int res;
+	struct vdef_dim resolution = {1920, 1080};
+	unsigned int height, count;
+
+	/* Invalid arguments */
+	height = 0;
+	res = vdef_calc_raw_frame_bands(NULL, &resolution, &height, &count);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_bands(&vdef_i420, NULL, &height, &count);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_bands(&vdef_i420, &resolution, NULL, &count);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_bands(
+		&vdef_i420, &resolution, &height, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_bands(&vdef_i420,
+					&(struct vdef_dim){1920, 0},
+					&height,
+					&count);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Default height */
+	height = 0;
+	res = vdef_calc_raw_frame_bands(
+		&vdef_i420, &resolution, &height, &count);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(height, VDEF_RAW_FRAME_BAND_DEFAULT_HEIGHT);
+	CU_ASSERT_EQUAL(count, 17);
+
+	/* Aligned height */
+	height = 33;
+	res = vdef_calc_raw_frame_bands(
+		&vdef_i420, &resolution, &height, &count);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(height, 34);
+	CU_ASSERT_EQUAL(count, 32);
+
+	height = 33;
+	res = vdef_calc_raw_frame_bands(
+		&vdef_nv21_hisi_tile, &resolution, &height, &count);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(height, 48);
+	CU_ASSERT_EQUAL(count, 23);
+
+	/* Frame smaller than a band */
+	height = 64;
+	res = vdef_calc_raw_frame_bands(
+		&vdef_i420, &(struct vdef_dim){64, 15}, &height, &count);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(height, 15);
+	CU_ASSERT_EQUAL(count, 1);
+}
+
+
+static void test_calc_raw_frame_band(void)
+{
+	int res;
+	struct vdef_raw_frame frame = {0};
+	struct vdef_raw_frame view;
+	size_t plane_offset[VDEF_RAW_MAX_PLANE_COUNT];
+
+	frame.format = vdef_i420;
+	frame.info.resolution.width = 1920;
+	frame.info.resolution.height = 1080;
+	frame.plane_stride[0] = 2048;
+	frame.plane_stride[1] = 1024;
+	frame.plane_stride[2] = 1024;
+
+	/* Invalid arguments */
+	res = vdef_calc_raw_frame_band(NULL, 64, 0, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_band(&frame, 0, 0, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_band(&frame, 64, 0, NULL, plane_offset);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_calc_raw_frame_band(&frame, 64, 0, &view, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Unaligned band height */
+	res = vdef_calc_raw_frame_band(&frame, 63, 0, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EPROTO);
+
+	/* Outside of the frame */
+	res = vdef_calc_raw_frame_band(&frame, 64, 17, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -ERANGE);
+
+	/* I420 bands */
+	res = vdef_calc_raw_frame_band(&frame, 64, 2, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(vdef_raw_format_cmp(&view.format, &vdef_i420));
+	CU_ASSERT_EQUAL(view.info.resolution.width, 1920);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 64);
+	CU_ASSERT_EQUAL(view.plane_stride[0], 2048);
+	CU_ASSERT_EQUAL(view.plane_stride[1], 1024);
+	CU_ASSERT_EQUAL(plane_offset[0], 128 * 2048);
+	CU_ASSERT_EQUAL(plane_offset[1], 64 * 1024);
+	CU_ASSERT_EQUAL(plane_offset[2], 64 * 1024);
+	CU_ASSERT_EQUAL(plane_offset[3], 0);
+
+	/* Last band */
+	res = vdef_calc_raw_frame_band(&frame, 64, 16, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 56);
+	CU_ASSERT_EQUAL(plane_offset[0], 1024 * 2048);
+	CU_ASSERT_EQUAL(plane_offset[1], 512 * 1024);
+
+	/* Single band of an odd frame height */
+	frame.info.resolution.height = 15;
+	res = vdef_calc_raw_frame_band(&frame, 15, 0, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 15);
+	CU_ASSERT_EQUAL(plane_offset[0], 0);
+
+	/* Tiled bands: whole rows of tiles */
+	frame.format = vdef_nv21_hisi_tile;
+	frame.info.resolution.height = 1080;
+	frame.plane_stride[0] = 1920;
+	frame.plane_stride[1] = 1920;
+	frame.plane_stride[2] = 0;
+	res = vdef_calc_raw_frame_band(&frame, 24, 1, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, -EPROTO);
+
+	res = vdef_calc_raw_frame_band(&frame, 32, 3, &view, plane_offset);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(view.info.resolution.height, 32);
+	CU_ASSERT_EQUAL(plane_offset[0], 96 * 1920);
+	CU_ASSERT_EQUAL(plane_offset[1], 48 * 1920);
+	CU_ASSERT_EQUAL(plane_offset[2], 0);
+}
+
+
+CU_TestInfo g_vdef_test_layout[] = {
+	{FN("calc-raw-layout"), &test_calc_raw_layout},
+	{FN("calc-raw-contiguous-frame-planes"),
+	 &test_calc_raw_contiguous_frame_planes},
+	{FN("raw-layout-get-planes"), &test_raw_layout_get_planes},
+	{FN("raw-layout-cache-get"), &test_raw_layout_cache_get},
+	{FN("raw-layout-cache-threads"), &test_raw_layout_cache_threads},
+	{FN("get-raw-frame-crop-align"), &test_get_raw_frame_crop_align},
+	{FN("calc-raw-frame-crop"), &test_calc_raw_frame_crop},
+	{FN("get-raw-frame-band-align"), &test_get_raw_frame_band_align},
+	{FN("calc-raw-frame-bands"), &test_calc_raw_frame_bands},
+	{FN("calc-raw-frame-band"), &test_calc_raw_frame_band},
+
+	CU_TEST_INFO_NULL,
+};
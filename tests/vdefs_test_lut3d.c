@@ -0,0 +1,562 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <pthread.h>
+
+
+#define LUT3D_THREAD_COUNT 8
+
+
+struct lut3d_thread_ctx {
+	const struct vdef_format_info *src;
+	const struct vdef_format_info *dst;
+	const struct vdef_lut3d *lut;
+};
+
+
+static const struct vdef_dim s_res = {131, 67};
+
+
+static const unsigned int s_sizes[] = {17, 33, 65};
+
+
+/* HDR10 (yuv) or BT.709 SDR format info; RGB formats use the identity
+ * matrix coefficients */
+static void info_init(struct vdef_format_info *info, bool hdr, bool yuv)
+{
+	memset(info, 0, sizeof(*info));
+	info->bit_depth = hdr ? 10 : 8;
+	info->color_primaries =
+		hdr ? VDEF_COLOR_PRIMARIES_BT2020 : VDEF_COLOR_PRIMARIES_BT709;
+	info->transfer_function = hdr ? VDEF_TRANSFER_FUNCTION_PQ
+				      : VDEF_TRANSFER_FUNCTION_BT709;
+	info->dynamic_range =
+		hdr ? VDEF_DYNAMIC_RANGE_HDR10 : VDEF_DYNAMIC_RANGE_SDR;
+	info->tone_mapping = VDEF_TONE_MAPPING_STANDARD;
+	if (!yuv)
+		info->matrix_coefs = VDEF_MATRIX_COEFS_IDENTITY;
+	else if (hdr)
+		info->matrix_coefs = VDEF_MATRIX_COEFS_BT2020_NON_CST;
+	else
+		info->matrix_coefs = VDEF_MATRIX_COEFS_BT709;
+}
+
+
+/* Smooth 10-bit YUV content: luma ramp and moderate chroma ramps (some
+ * colors are still clipped by the conversions) */
+static void fill_yuv10(struct vdef_test_frame *f)
+{
+	for (unsigned int y = 0; y < s_res.height; y++) {
+		uint16_t *p = (uint16_t *)((uint8_t *)f->plane[0] +
+					   y * f->frame.plane_stride[0]);
+		for (unsigned int x = 0; x < s_res.width; x++)
+			p[x] = 64 + (876 * x) / (s_res.width - 1);
+	}
+	for (unsigned int y = 0; y < s_res.height / 2; y++) {
+		uint16_t *u = (uint16_t *)((uint8_t *)f->plane[1] +
+					   y * f->frame.plane_stride[1]);
+		uint16_t *v = (uint16_t *)((uint8_t *)f->plane[2] +
+					   y * f->frame.plane_stride[2]);
+		for (unsigned int x = 0; x < s_res.width / 2; x++) {
+			u[x] = 452 + (120 * y) / (s_res.height / 2);
+			v[x] = 572 - (120 * x) / (s_res.width / 2);
+		}
+	}
+}
+
+
+/* Maximum and mean absolute differences of two 8-bit frames */
+static void frame_diff(const struct vdef_test_frame *a,
+		       const struct vdef_test_frame *b,
+		       unsigned int *max,
+		       float *mean)
+{
+	uint64_t sum = 0;
+
+	*max = 0;
+	for (size_t i = 0; i < a->layout.size; i++) {
+		unsigned int d = abs(a->data[i] - b->data[i]);
+		*max = d > *max ? d : *max;
+		sum += d;
+	}
+	*mean = (float)sum / a->layout.size;
+}
+
+
+static void test_lut3d_identity(void)
+{
+	int res;
+	const struct vdef_lut3d *lut = NULL;
+	struct vdef_format_info info;
+	struct vdef_test_frame in, out;
+	unsigned int max;
+	float mean;
+
+	info_init(&info, false, false);
+	res = vdef_lut3d_get(&info,
+			     &info,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lut);
+
+	vdef_test_frame_alloc(&in, &vdef_rgb, &s_res);
+	vdef_test_frame_set_info(&in, &info);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &s_res);
+	vdef_test_frame_set_info(&out, &info);
+	srand(42);
+	for (size_t i = 0; i < in.layout.size; i++)
+		in.data[i] = rand() % 256;
+
+	res = vdef_lut3d_apply(lut,
+			       &in.frame,
+			       (const void *const *)in.plane,
+			       &out.frame,
+			       out.plane,
+			       NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	frame_diff(&in, &out, &max, &mean);
+	CU_ASSERT(max <= 1);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+/* Compare the table conversion with the reference conversion */
+static void check_reference(const struct vdef_format_info *src,
+			    const struct vdef_raw_format *src_format,
+			    const struct vdef_format_info *dst,
+			    const struct vdef_raw_format *dst_format,
+			    bool tone_map,
+			    unsigned int *max,
+			    float *mean)
+{
+	int res;
+	const struct vdef_lut3d *lut = NULL;
+	struct vdef_test_frame in, ref, out;
+
+	vdef_test_frame_alloc(&in, src_format, &s_res);
+	vdef_test_frame_set_info(&in, src);
+	vdef_test_frame_alloc(&ref, dst_format, &s_res);
+	vdef_test_frame_set_info(&ref, dst);
+	vdef_test_frame_alloc(&out, dst_format, &s_res);
+	vdef_test_frame_set_info(&out, dst);
+	fill_yuv10(&in);
+
+	if (tone_map) {
+		res = vdef_tone_map(&in.frame,
+				    (const void *const *)in.plane,
+				    src,
+				    &ref.frame,
+				    ref.plane,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_SOFT,
+				    NULL);
+	} else {
+		res = vdef_convert_gamut(&in.frame,
+					 (const void *const *)in.plane,
+					 &ref.frame,
+					 ref.plane,
+					 VDEF_GAMUT_CLIP_METHOD_SOFT,
+					 NULL);
+	}
+	CU_ASSERT_EQUAL(res, 0);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_sizes); i++) {
+		res = vdef_lut3d_get(src,
+				     dst,
+				     s_sizes[i],
+				     VDEF_TONE_MAP_METHOD_BT2390,
+				     VDEF_GAMUT_CLIP_METHOD_SOFT,
+				     &lut);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		res = vdef_lut3d_apply(lut,
+				       &in.frame,
+				       (const void *const *)in.plane,
+				       &out.frame,
+				       out.plane,
+				       NULL);
+		CU_ASSERT_EQUAL(res, 0);
+		frame_diff(&ref, &out, &max[i], &mean[i]);
+	}
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&ref);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_lut3d_reference(void)
+{
+	struct vdef_format_info src, dst;
+	unsigned int max[ARRAY_SIZE(s_sizes)];
+	float mean[ARRAY_SIZE(s_sizes)];
+
+	/* HDR10 YUV to SDR YUV (tone mapping); the interpolation error
+	 * decreases with the table size */
+	info_init(&src, true, true);
+	info_init(&dst, false, true);
+	check_reference(
+		&src, &vdef_i420_10_16le, &dst, &vdef_nv12, true, max, mean);
+	CU_ASSERT(mean[0] > mean[1] && mean[1] > mean[2]);
+	CU_ASSERT(mean[2] < 1.f);
+	CU_ASSERT(max[2] <= 16);
+
+	/* HDR10 YUV to HDR RGB (gamut conversion); the PQ curve is steep near
+	 * black so the clipped components have larger errors */
+	info_init(&dst, true, false);
+	dst.color_primaries = VDEF_COLOR_PRIMARIES_BT709;
+	check_reference(
+		&src, &vdef_i420_10_16le, &dst, &vdef_rgb, false, max, mean);
+	CU_ASSERT(mean[0] > mean[1] && mean[1] > mean[2]);
+	CU_ASSERT(mean[2] < 3.f);
+}
+
+
+static void *lut3d_thread(void *userdata)
+{
+	struct lut3d_thread_ctx *ctx = userdata;
+
+	(void)vdef_lut3d_get(ctx->src,
+			     ctx->dst,
+			     33,
+			     VDEF_TONE_MAP_METHOD_HABLE,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &ctx->lut);
+
+	return NULL;
+}
+
+
+static void test_lut3d_cache(void)
+{
+	int res;
+	const struct vdef_lut3d *lut1 = NULL, *lut2 = NULL;
+	struct vdef_format_info src, dst, other;
+	pthread_t threads[LUT3D_THREAD_COUNT];
+	struct lut3d_thread_ctx ctx[LUT3D_THREAD_COUNT] = {0};
+
+	info_init(&src, true, true);
+	info_init(&dst, false, true);
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut1);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+
+	/* Same conversion: the bit depth and resolution do not matter */
+	other = src;
+	other.bit_depth = 12;
+	other.resolution.width = 1920;
+	other.resolution.height = 1080;
+	res = vdef_lut3d_get(&other,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 == lut2);
+
+	/* The metadata changes the tone curve */
+	other.mdcv.max_display_mastering_luminance = 4000.f;
+	res = vdef_lut3d_get(&other,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 != lut2);
+
+	/* Different size or color parameters */
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     33,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 != lut2);
+	other = dst;
+	other.full_range = true;
+	res = vdef_lut3d_get(&src,
+			     &other,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 != lut2);
+
+	/* Without tone mapping, the metadata and method do not matter */
+	other = src;
+	other.mdcv.max_display_mastering_luminance = 4000.f;
+	res = vdef_lut3d_get(&src,
+			     &src,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut1);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_lut3d_get(&other,
+			     &other,
+			     17,
+			     VDEF_TONE_MAP_METHOD_REINHARD,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 == lut2);
+
+	/* Concurrent first use */
+	dst.color_primaries = VDEF_COLOR_PRIMARIES_BT2020;
+	for (unsigned int i = 0; i < LUT3D_THREAD_COUNT; i++) {
+		ctx[i].src = &src;
+		ctx[i].dst = &dst;
+		res = pthread_create(&threads[i], NULL, lut3d_thread, &ctx[i]);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+	for (unsigned int i = 0; i < LUT3D_THREAD_COUNT; i++)
+		pthread_join(threads[i], NULL);
+
+	/* All threads must get the same table */
+	CU_ASSERT_PTR_NOT_NULL(ctx[0].lut);
+	for (unsigned int i = 1; i < LUT3D_THREAD_COUNT; i++)
+		CU_ASSERT_TRUE(ctx[i].lut == ctx[0].lut);
+}
+
+
+static void test_lut3d_threads(void)
+{
+	int res;
+	const struct vdef_lut3d *lut = NULL;
+	struct vdef_format_info src, dst;
+	struct vdef_test_frame in, ref, out;
+	const unsigned int threads[] = {1, 3, 0};
+	struct vdef_thread_pool *pool;
+
+	info_init(&src, true, true);
+	info_init(&dst, false, true);
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     33,
+			     VDEF_TONE_MAP_METHOD_REINHARD,
+			     VDEF_GAMUT_CLIP_METHOD_SOFT,
+			     &lut);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+
+	vdef_test_frame_alloc(&in, &vdef_i420_10_16le, &s_res);
+	vdef_test_frame_set_info(&in, &src);
+	vdef_test_frame_alloc(&ref, &vdef_nv12, &s_res);
+	vdef_test_frame_set_info(&ref, &dst);
+	vdef_test_frame_alloc(&out, &vdef_nv12, &s_res);
+	vdef_test_frame_set_info(&out, &dst);
+	srand(42);
+	for (size_t i = 0; i < in.layout.size / 2; i++)
+		((uint16_t *)in.data)[i] = 64 + rand() % 877;
+
+	/* Reference: no thread pool */
+	res = vdef_lut3d_apply(lut,
+			       &in.frame,
+			       (const void *const *)in.plane,
+			       &ref.frame,
+			       ref.plane,
+			       NULL);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+
+	/* Same output whatever the number of threads */
+	for (size_t t = 0; t < ARRAY_SIZE(threads); t++) {
+		res = vdef_thread_pool_new(threads[t], &pool);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		memset(out.data, 0, out.layout.size);
+		res = vdef_lut3d_apply(lut,
+				       &in.frame,
+				       (const void *const *)in.plane,
+				       &out.frame,
+				       out.plane,
+				       pool);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT_EQUAL(memcmp(ref.data, out.data, ref.layout.size), 0);
+		vdef_thread_pool_destroy(pool);
+	}
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&ref);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_lut3d_invalid(void)
+{
+	int res;
+	const struct vdef_lut3d *lut = NULL;
+	struct vdef_format_info src, dst;
+	struct vdef_test_frame in, out;
+
+	info_init(&src, true, true);
+	info_init(&dst, false, true);
+
+	/* Invalid arguments */
+	res = vdef_lut3d_get(NULL,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_lut3d_get(&src,
+			     NULL,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     16,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_MAX,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_MAX,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Invalid or unsupported conversions */
+	src.color_primaries = VDEF_COLOR_PRIMARIES_UNKNOWN;
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	src.color_primaries = VDEF_COLOR_PRIMARIES_BT2020;
+	res = vdef_lut3d_get(&dst,
+			     &src,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	/* The P-log curve is not supported */
+	src.tone_mapping = VDEF_TONE_MAPPING_P_LOG;
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	src.tone_mapping = VDEF_TONE_MAPPING_STANDARD;
+
+	res = vdef_lut3d_get(&src,
+			     &dst,
+			     17,
+			     VDEF_TONE_MAP_METHOD_BT2390,
+			     VDEF_GAMUT_CLIP_METHOD_HARD,
+			     &lut);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	vdef_test_frame_alloc(&in, &vdef_i420_10_16le, &s_res);
+	vdef_test_frame_set_info(&in, &src);
+	vdef_test_frame_alloc(&out, &vdef_nv12, &s_res);
+	vdef_test_frame_set_info(&out, &dst);
+
+	res = vdef_lut3d_apply(NULL,
+			       &in.frame,
+			       (const void *const *)in.plane,
+			       &out.frame,
+			       out.plane,
+			       NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_lut3d_apply(lut,
+			       &in.frame,
+			       NULL,
+			       &out.frame,
+			       out.plane,
+			       NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* The frames components must match the table */
+	vdef_test_frame_free(&out);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &s_res);
+	vdef_test_frame_set_info(&out, &dst);
+	res = vdef_lut3d_apply(lut,
+			       &in.frame,
+			       (const void *const *)in.plane,
+			       &out.frame,
+			       out.plane,
+			       NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	vdef_test_frame_free(&out);
+	vdef_test_frame_alloc(&out, &vdef_bayer_rggb, &s_res);
+	vdef_test_frame_set_info(&out, &dst);
+	res = vdef_lut3d_apply(lut,
+			       &in.frame,
+			       (const void *const *)in.plane,
+			       &out.frame,
+			       out.plane,
+			       NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+CU_TestInfo g_vdef_test_lut3d[] = {
+	{FN("lut3d-identity"), &test_lut3d_identity},
+	{FN("lut3d-reference"), &test_lut3d_reference},
+	{FN("lut3d-cache"), &test_lut3d_cache},
+	{FN("lut3d-threads"), &test_lut3d_threads},
+	{FN("lut3d-invalid"), &test_lut3d_invalid},
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,414 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+/* Plane stride alignment, so that most test lines are padded */
+#define STRIDE_ALIGN 64
+
+
+/* Position of the Y0, U, Y1 and V samples in a YUV422 interleaved group */
+static const struct {
+	enum vdef_raw_pix_order order;
+	unsigned int pos[4];
+} s_yuv422_orders[] = {
+	{VDEF_RAW_PIX_ORDER_YUYV, {0, 1, 2, 3}},
+	{VDEF_RAW_PIX_ORDER_YVYU, {0, 3, 2, 1}},
+	{VDEF_RAW_PIX_ORDER_UYVY, {1, 0, 3, 2}},
+	{VDEF_RAW_PIX_ORDER_VYUY, {1, 2, 3, 0}},
+};
+
+
+static void test_frame_fill(struct vdef_test_frame *f, unsigned int seed)
+{
+	size_t size =
+		f->frame.plane_stride[0] * f->frame.info.resolution.height;
+
+	for (size_t i = 0; i < size; i++)
+		f->data[i] = (i * 131 + seed * 7 + (i >> 8)) & 0xff;
+}
+
+
+/* Get the position of the components of a packed pixel order from its
+ * name; returns false if the order does not fit in count components */
+static bool get_packed_pos(enum vdef_raw_pix_order order,
+			   unsigned int count,
+			   unsigned int pos[4])
+{
+	const char *str = vdef_raw_pix_order_to_str(order);
+
+	if (str == NULL)
+		return false;
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int c = str[i] - 'A';
+		if (c >= count)
+			return false;
+		pos[c] = i;
+	}
+	return true;
+}
+
+
+/* Check the output frame samples: each group of count samples must have
+ * the component c at in_pos[c] moved to out_pos[c] */
+static void check_frame(const struct vdef_test_frame *in,
+			const struct vdef_test_frame *out,
+			unsigned int count,
+			unsigned int groups,
+			const unsigned int *in_pos,
+			const unsigned int *out_pos)
+{
+	unsigned int bytes = in->frame.format.data_size / 8;
+	unsigned int height = in->frame.info.resolution.height;
+	unsigned int errors = 0;
+
+	for (unsigned int y = 0; y < height; y++) {
+		const uint8_t *src = in->data + y * in->frame.plane_stride[0];
+		const uint8_t *dst = out->data + y * out->frame.plane_stride[0];
+		for (unsigned int g = 0; g < groups; g++) {
+			for (unsigned int c = 0; c < count; c++) {
+				for (unsigned int b = 0; b < bytes; b++) {
+					size_t i = (g * count + in_pos[c]) *
+							   bytes +
+						   b;
+					size_t o = (g * count + out_pos[c]) *
+							   bytes +
+						   b;
+					if (src[i] != dst[o])
+						errors++;
+				}
+			}
+		}
+	}
+	CU_ASSERT_EQUAL(errors, 0);
+}
+
+
+/* Check that the last pixel of the lines of an interleaved YUV422 frame is
+ * unchanged */
+static void check_last_pixel(const struct vdef_test_frame *in,
+			     const struct vdef_test_frame *out)
+{
+	unsigned int bytes = in->frame.format.data_size / 8;
+	unsigned int width = in->frame.info.resolution.width;
+	unsigned int height = in->frame.info.resolution.height;
+	size_t stride = in->frame.plane_stride[0];
+
+	for (unsigned int y = 0; y < height; y++) {
+		size_t off = y * stride + (width - 1) * 2 * bytes;
+		CU_ASSERT_EQUAL(
+			memcmp(in->data + off, out->data + off, 2 * bytes), 0);
+	}
+}
+
+
+static void test_order_packed(void)
+{
+	static const enum vdef_raw_pix_format pix_formats[] = {
+		VDEF_RAW_PIX_FORMAT_RGB24,
+		VDEF_RAW_PIX_FORMAT_RGBA32,
+	};
+	static const unsigned int sizes[] = {8, 16};
+
+	for (unsigned int f = 0; f < ARRAY_SIZE(pix_formats); f++) {
+		unsigned int count = (f == 0) ? 3 : 4;
+		for (unsigned int s = 0; s < ARRAY_SIZE(sizes); s++) {
+			struct vdef_raw_format format = vdef_rgba;
+			unsigned int width = 37, height = 5;
+			struct vdef_dim resolution = {width, height};
+			struct vdef_test_frame in, out;
+
+			format.pix_format = pix_formats[f];
+			format.pix_size = sizes[s];
+			format.data_size = sizes[s];
+			vdef_test_frame_alloc_aligned(
+				&in, &format, &resolution, STRIDE_ALIGN);
+			vdef_test_frame_alloc_aligned(
+				&out, &format, &resolution, STRIDE_ALIGN);
+			test_frame_fill(&in, f * 2 + s);
+
+			for (unsigned int i = VDEF_RAW_PIX_ORDER_ABCD;
+			     i <= VDEF_RAW_PIX_ORDER_DCBA;
+			     i++) {
+				for (unsigned int o = VDEF_RAW_PIX_ORDER_ABCD;
+				     o <= VDEF_RAW_PIX_ORDER_DCBA;
+				     o++) {
+					unsigned int in_pos[4], out_pos[4];
+					bool valid;
+					int res;
+
+					valid = get_packed_pos(
+							i, count, in_pos) &&
+						get_packed_pos(
+							o, count, out_pos);
+					in.frame.format.pix_order = i;
+					out.frame.format.pix_order = o;
+					res = vdef_convert_pix_order(
+						&in.frame,
+						(const void *const *)in.plane,
+						&out.frame,
+						out.plane);
+					if (!valid) {
+						CU_ASSERT_EQUAL(res, -ENOTSUP);
+						continue;
+					}
+					CU_ASSERT_EQUAL(res, 0);
+					check_frame(&in,
+						    &out,
+						    count,
+						    width,
+						    in_pos,
+						    out_pos);
+				}
+			}
+
+			vdef_test_frame_free(&in);
+			vdef_test_frame_free(&out);
+		}
+	}
+}
+
+
+static void test_order_yuv422(void)
+{
+	static const unsigned int widths[] = {37, 64};
+	static const unsigned int sizes[] = {8, 16};
+
+	for (unsigned int w = 0; w < ARRAY_SIZE(widths); w++) {
+		for (unsigned int s = 0; s < ARRAY_SIZE(sizes); s++) {
+			struct vdef_raw_format format = vdef_yuyv;
+			unsigned int width = widths[w], height = 3;
+			struct vdef_dim resolution = {width, height};
+			struct vdef_test_frame in, out;
+
+			format.pix_size = sizes[s];
+			format.data_size = sizes[s];
+			vdef_test_frame_alloc_aligned(
+				&in, &format, &resolution, STRIDE_ALIGN);
+			vdef_test_frame_alloc_aligned(
+				&out, &format, &resolution, STRIDE_ALIGN);
+			test_frame_fill(&in, w * 2 + s);
+
+			for (unsigned int i = 0;
+			     i < ARRAY_SIZE(s_yuv422_orders);
+			     i++) {
+				for (unsigned int o = 0;
+				     o < ARRAY_SIZE(s_yuv422_orders);
+				     o++) {
+					int res;
+
+					in.frame.format.pix_order =
+						s_yuv422_orders[i].order;
+					out.frame.format.pix_order =
+						s_yuv422_orders[o].order;
+					CU_ASSERT_TRUE(vdef_is_raw_format_valid(
+						&out.frame.format));
+					memset(out.data,
+					       0,
+					       out.frame.plane_stride[0] *
+						       height);
+					res = vdef_convert_pix_order(
+						&in.frame,
+						(const void *const *)in.plane,
+						&out.frame,
+						out.plane);
+					CU_ASSERT_EQUAL(res, 0);
+					check_frame(&in,
+						    &out,
+						    4,
+						    width / 2,
+						    s_yuv422_orders[i].pos,
+						    s_yuv422_orders[o].pos);
+
+					/* The last pixel of odd width lines
+					 * is copied */
+					if (width % 2 != 0)
+						check_last_pixel(&in, &out);
+				}
+			}
+
+			vdef_test_frame_free(&in);
+			vdef_test_frame_free(&out);
+		}
+	}
+}
+
+
+static void test_order_in_place(void)
+{
+	static const struct {
+		const struct vdef_raw_format *in;
+		const struct vdef_raw_format *out;
+		unsigned int size;
+		unsigned int count;
+		unsigned int width;
+	} cases[] = {
+		{&vdef_bgr, &vdef_rgb, 8, 3, 53},
+		{&vdef_rgb, &vdef_bgr, 16, 3, 29},
+		{&vdef_bgra, &vdef_abgr, 16, 4, 29},
+		{&vdef_yuyv, &vdef_yvyu, 8, 2, 40},
+	};
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(cases); i++) {
+		struct vdef_raw_format format = *cases[i].in;
+		struct vdef_raw_format out_format = *cases[i].out;
+		unsigned int width = cases[i].width, height = 4;
+		struct vdef_dim resolution = {width, height};
+		unsigned int count = cases[i].count;
+		unsigned int in_pos[4], out_pos[4];
+		struct vdef_test_frame in, out;
+		int res;
+
+		format.pix_size = format.data_size = cases[i].size;
+		out_format.pix_size = out_format.data_size = cases[i].size;
+		vdef_test_frame_alloc_aligned(
+			&in, &format, &resolution, STRIDE_ALIGN);
+		vdef_test_frame_alloc_aligned(
+			&out, &format, &resolution, STRIDE_ALIGN);
+		test_frame_fill(&in, i);
+		memcpy(out.data, in.data, in.frame.plane_stride[0] * height);
+
+		/* Same format */
+		res = vdef_convert_pix_order_in_place(
+			&out.frame, out.plane, &format);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT_EQUAL(memcmp(out.data,
+				       in.data,
+				       in.frame.plane_stride[0] * height),
+				0);
+
+		res = vdef_convert_pix_order_in_place(
+			&out.frame, out.plane, &out_format);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT_TRUE(
+			vdef_raw_format_cmp(&out.frame.format, &out_format));
+		if (format.data_layout == VDEF_RAW_DATA_LAYOUT_INTERLEAVED) {
+			check_frame(&in,
+				    &out,
+				    4,
+				    width / 2,
+				    s_yuv422_orders[0].pos,
+				    s_yuv422_orders[1].pos);
+		} else {
+			get_packed_pos(format.pix_order, count, in_pos);
+			get_packed_pos(out_format.pix_order, count, out_pos);
+			check_frame(&in, &out, count, width, in_pos, out_pos);
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+static void test_order_invalid(void)
+{
+	struct vdef_raw_format format;
+	struct vdef_test_frame in, out;
+	struct vdef_dim resolution = {16, 2};
+	int res;
+
+	vdef_test_frame_alloc(&in, &vdef_rgba, &resolution);
+	vdef_test_frame_alloc(&out, &vdef_bgra, &resolution);
+
+	/* Invalid arguments */
+	res = vdef_convert_pix_order(NULL, (const void *const *)in.plane,
+				     &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_pix_order(&in.frame, NULL, &out.frame, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_pix_order(
+		&in.frame, (const void *const *)in.plane, NULL, out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_pix_order(
+		&in.frame, (const void *const *)in.plane, &out.frame, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_pix_order_in_place(NULL, in.plane, &vdef_bgra);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_pix_order_in_place(&in.frame, NULL, &vdef_bgra);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_pix_order_in_place(&in.frame, in.plane, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Resolution mismatch */
+	out.frame.info.resolution.width = 8;
+	res = vdef_convert_pix_order(&in.frame,
+				     (const void *const *)in.plane,
+				     &out.frame,
+				     out.plane);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	out.frame.info.resolution.width = 16;
+
+	/* Formats differing by more than the pixel order */
+	out.frame.format = vdef_bgr;
+	res = vdef_convert_pix_order(&in.frame,
+				     (const void *const *)in.plane,
+				     &out.frame,
+				     out.plane);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* Unsupported formats */
+	format = vdef_rgba;
+	format.data_layout = VDEF_RAW_DATA_LAYOUT_PLANAR;
+	in.frame.format = format;
+	format.pix_order = VDEF_RAW_PIX_ORDER_BGRA;
+	res = vdef_convert_pix_order_in_place(&in.frame, in.plane, &format);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	format = vdef_rgba;
+	format.pix_layout = VDEF_RAW_PIX_LAYOUT_HISI_TILE_64x16;
+	in.frame.format = format;
+	format.pix_order = VDEF_RAW_PIX_ORDER_BGRA;
+	res = vdef_convert_pix_order_in_place(&in.frame, in.plane, &format);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	in.frame.format = vdef_nv12;
+	res = vdef_convert_pix_order_in_place(&in.frame, in.plane, &vdef_nv21);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* Luma must alternate with chroma (UVYD is not an interleaved
+	 * YUV422 order) */
+	in.frame.format = vdef_yuyv;
+	format = vdef_yuyv;
+	format.pix_order = VDEF_RAW_PIX_ORDER_BCAD;
+	CU_ASSERT_FALSE(vdef_is_raw_format_valid(&format));
+	res = vdef_convert_pix_order_in_place(&in.frame, in.plane, &format);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	CU_ASSERT_TRUE(vdef_raw_format_cmp(&in.frame.format, &vdef_yuyv));
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+CU_TestInfo g_vdef_test_order[] = {
+	{FN("order-packed"), &test_order_packed},
+	{FN("order-yuv422"), &test_order_yuv422},
+	{FN("order-in-place"), &test_order_in_place},
+	{FN("order-invalid"), &test_order_invalid},
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,552 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+/* Several bands of lines, with a partial row of tiles */
+static const struct vdef_dim s_res = {260, 200};
+
+
+static const struct {
+	const struct vdef_raw_format *in_format;
+	enum vdef_transfer_function in_transfer;
+	const struct vdef_raw_format *out_format;
+	enum vdef_color_primaries out_primaries;
+	enum vdef_transfer_function out_transfer;
+	unsigned int step_count;
+	enum vdef_convert_step steps[4];
+} s_plans[] = {
+	{
+		&vdef_i420,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_i420,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		1,
+		{VDEF_CONVERT_STEP_COPY},
+	},
+	{
+		&vdef_i420,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_nv12,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		1,
+		{VDEF_CONVERT_STEP_YUV_CHROMA},
+	},
+	{
+		&vdef_nv12_10_packed,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_i420_10_16le,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		2,
+		{VDEF_CONVERT_STEP_RAW_DATA, VDEF_CONVERT_STEP_YUV_CHROMA},
+	},
+	{
+		&vdef_nv21_hisi_tile,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_nv21,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		1,
+		{VDEF_CONVERT_STEP_PIX_LAYOUT},
+	},
+	{
+		&vdef_i420,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_rgb,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		1,
+		{VDEF_CONVERT_STEP_YUV_TO_RGB},
+	},
+	{
+		&vdef_bgr,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_nv12,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		1,
+		{VDEF_CONVERT_STEP_RGB_TO_YUV},
+	},
+	{
+		&vdef_nv21_hisi_tile,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_rgb,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		2,
+		{VDEF_CONVERT_STEP_PIX_LAYOUT, VDEF_CONVERT_STEP_YUV_TO_RGB},
+	},
+	{
+		&vdef_i420,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_nv12,
+		VDEF_COLOR_PRIMARIES_BT2020,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		1,
+		{VDEF_CONVERT_STEP_GAMUT},
+	},
+	{
+		&vdef_nv12_10_packed,
+		VDEF_TRANSFER_FUNCTION_PQ,
+		&vdef_nv12,
+		VDEF_COLOR_PRIMARIES_BT709,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		2,
+		{VDEF_CONVERT_STEP_RAW_DATA, VDEF_CONVERT_STEP_TONE_MAP},
+	},
+	{
+		&vdef_i420_10_16le,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		&vdef_nv12_10_packed,
+		VDEF_COLOR_PRIMARIES_BT2020,
+		VDEF_TRANSFER_FUNCTION_BT709,
+		2,
+		{VDEF_CONVERT_STEP_GAMUT, VDEF_CONVERT_STEP_RAW_DATA},
+	},
+};
+
+
+static void fill_random(struct vdef_test_frame *f)
+{
+	unsigned int max = (1 << f->frame.format.data_size) - 1;
+
+	if (f->frame.format.data_size == 16) {
+		/* Samples within the data size */
+		uint16_t *p = (uint16_t *)f->data;
+		for (size_t i = 0; i < f->layout.size / 2; i++)
+			p[i] = rand() % (max + 1);
+	} else {
+		for (size_t i = 0; i < f->layout.size; i++)
+			f->data[i] = rand();
+	}
+}
+
+
+static void test_info_init(struct vdef_format_info *info,
+			   enum vdef_color_primaries primaries,
+			   enum vdef_transfer_function transfer)
+{
+	memset(info, 0, sizeof(*info));
+	info->resolution = s_res;
+	info->bit_depth = 8;
+	info->color_primaries = primaries;
+	info->transfer_function = transfer;
+	info->matrix_coefs = primaries == VDEF_COLOR_PRIMARIES_BT2020
+				     ? VDEF_MATRIX_COEFS_BT2020_NON_CST
+				     : VDEF_MATRIX_COEFS_BT709;
+}
+
+
+/* Get the input and output info of a s_plans entry (PQ input frames use
+ * the BT.2020 primaries) */
+static void plan_info_init(unsigned int i,
+			   struct vdef_format_info *in_info,
+			   struct vdef_format_info *out_info)
+{
+	enum vdef_color_primaries primaries = VDEF_COLOR_PRIMARIES_BT709;
+
+	if (s_plans[i].in_transfer == VDEF_TRANSFER_FUNCTION_PQ)
+		primaries = VDEF_COLOR_PRIMARIES_BT2020;
+	test_info_init(in_info, primaries, s_plans[i].in_transfer);
+	test_info_init(
+		out_info, s_plans[i].out_primaries, s_plans[i].out_transfer);
+}
+
+
+static void test_plan_steps(void)
+{
+	int res;
+	struct vdef_format_info in_info, out_info;
+	struct vdef_convert_plan *plan;
+	struct vdef_convert_plan_step step;
+	ssize_t bytes;
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_plans); i++) {
+		plan_info_init(i, &in_info, &out_info);
+		res = vdef_convert_plan_new(s_plans[i].in_format,
+					    &in_info,
+					    s_plans[i].out_format,
+					    &out_info,
+					    VDEF_TONE_MAP_METHOD_BT2390,
+					    VDEF_GAMUT_CLIP_METHOD_HARD,
+					    &plan);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+
+		CU_ASSERT_EQUAL(vdef_convert_plan_get_step_count(plan),
+				s_plans[i].step_count);
+		bytes = 0;
+		for (unsigned int j = 0; j < s_plans[i].step_count; j++) {
+			res = vdef_convert_plan_get_step(plan, j, &step);
+			CU_ASSERT_EQUAL(res, 0);
+			CU_ASSERT_EQUAL(step.step, s_plans[i].steps[j]);
+			CU_ASSERT(step.bytes > 0);
+			bytes += step.bytes;
+		}
+		CU_ASSERT_EQUAL(vdef_convert_plan_get_bytes(plan), bytes);
+
+		/* The first step reads the input format, the last one
+		 * writes the output format */
+		res = vdef_convert_plan_get_step(plan, 0, &step);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT(vdef_raw_format_cmp(&step.in_format,
+					      s_plans[i].in_format));
+		res = vdef_convert_plan_get_step(
+			plan, s_plans[i].step_count - 1, &step);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT(vdef_raw_format_cmp(&step.out_format,
+					      s_plans[i].out_format));
+
+		res = vdef_convert_plan_destroy(plan);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+}
+
+
+static void test_plan_bands(void)
+{
+	int res;
+	struct vdef_format_info info;
+	struct vdef_convert_plan *plan;
+	unsigned int height;
+
+	test_info_init(&info,
+		       VDEF_COLOR_PRIMARIES_BT709,
+		       VDEF_TRANSFER_FUNCTION_BT709);
+
+	/* Bands of whole rows of tiles */
+	res = vdef_convert_plan_new(&vdef_nv21_hisi_tile,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	height = vdef_convert_plan_get_band_height(plan);
+	CU_ASSERT(height >= 16);
+	CU_ASSERT(height <= 64);
+	CU_ASSERT_EQUAL(height % 16, 0);
+	vdef_convert_plan_destroy(plan);
+
+	/* Smaller bands for larger intermediate frames */
+	info.resolution.width = 7680;
+	res = vdef_convert_plan_new(&vdef_nv21_hisi_tile,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	CU_ASSERT(vdef_convert_plan_get_band_height(plan) <= height);
+	CU_ASSERT_EQUAL(vdef_convert_plan_get_band_height(plan) % 16, 0);
+	vdef_convert_plan_destroy(plan);
+
+	/* Frame smaller than a band */
+	info.resolution.height = 6;
+	res = vdef_convert_plan_new(&vdef_i420,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	CU_ASSERT_EQUAL(vdef_convert_plan_get_band_height(plan), 6);
+	vdef_convert_plan_destroy(plan);
+}
+
+
+/* Run a conversion step on whole frames with the public functions */
+static void run_reference(enum vdef_convert_step step,
+			  const struct vdef_format_info *hdr_info,
+			  struct vdef_test_frame *in,
+			  struct vdef_test_frame *out)
+{
+	int res = -EPROTO;
+	const void *const *in_plane = (const void *const *)in->plane;
+
+	switch (step) {
+	case VDEF_CONVERT_STEP_COPY:
+		memcpy(out->data, in->data, in->layout.size);
+		res = 0;
+		break;
+	case VDEF_CONVERT_STEP_PIX_LAYOUT:
+		res = vdef_convert_pix_layout(
+			&in->frame, in_plane, &out->frame, out->plane, NULL);
+		break;
+	case VDEF_CONVERT_STEP_RAW_DATA:
+		res = vdef_convert_raw_data(
+			&in->frame, in_plane, &out->frame, out->plane);
+		break;
+	case VDEF_CONVERT_STEP_YUV_CHROMA:
+		res = vdef_convert_yuv_chroma(
+			&in->frame, in_plane, &out->frame, out->plane);
+		break;
+	case VDEF_CONVERT_STEP_YUV_TO_RGB:
+		res = vdef_convert_yuv_to_rgb(
+			&in->frame, in_plane, &out->frame, out->plane);
+		break;
+	case VDEF_CONVERT_STEP_RGB_TO_YUV:
+		res = vdef_convert_rgb_to_yuv(
+			&in->frame, in_plane, &out->frame, out->plane);
+		break;
+	case VDEF_CONVERT_STEP_GAMUT:
+		res = vdef_convert_gamut(&in->frame,
+					 in_plane,
+					 &out->frame,
+					 out->plane,
+					 VDEF_GAMUT_CLIP_METHOD_HARD,
+					 NULL);
+		break;
+	case VDEF_CONVERT_STEP_TONE_MAP:
+		res = vdef_tone_map(&in->frame,
+				    in_plane,
+				    hdr_info,
+				    &out->frame,
+				    out->plane,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    NULL);
+		break;
+	default:
+		break;
+	}
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+/* The banded plan output is the output of the steps run on whole frames */
+static void test_plan_run(void)
+{
+	int res;
+	struct vdef_format_info in_info, out_info, info;
+	struct vdef_convert_plan *plan;
+	struct vdef_convert_plan_step step;
+	struct vdef_test_frame in, out, ref, cur, next;
+	const unsigned int threads[] = {1, 2, 4, 0};
+	struct vdef_thread_pool *pool;
+
+	srand(42);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_plans); i++) {
+		plan_info_init(i, &in_info, &out_info);
+		res = vdef_convert_plan_new(s_plans[i].in_format,
+					    &in_info,
+					    s_plans[i].out_format,
+					    &out_info,
+					    VDEF_TONE_MAP_METHOD_BT2390,
+					    VDEF_GAMUT_CLIP_METHOD_HARD,
+					    &plan);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+
+		vdef_test_frame_alloc(
+			&in, s_plans[i].in_format, &in_info.resolution);
+		vdef_test_frame_set_info(&in, &in_info);
+		fill_random(&in);
+		vdef_test_frame_alloc(
+			&out, s_plans[i].out_format, &out_info.resolution);
+		vdef_test_frame_set_info(&out, &out_info);
+
+		/* Reference: each step on the whole frame */
+		vdef_test_frame_alloc(
+			&cur, s_plans[i].in_format, &in_info.resolution);
+		vdef_test_frame_set_info(&cur, &in_info);
+		memcpy(cur.data, in.data, in.layout.size);
+		info = in_info;
+		for (unsigned int j = 0; j < s_plans[i].step_count; j++) {
+			res = vdef_convert_plan_get_step(plan, j, &step);
+			CU_ASSERT_EQUAL_FATAL(res, 0);
+			if (step.step == VDEF_CONVERT_STEP_GAMUT ||
+			    step.step == VDEF_CONVERT_STEP_TONE_MAP ||
+			    step.step == VDEF_CONVERT_STEP_RGB_TO_YUV)
+				info = out_info;
+			vdef_test_frame_alloc(
+				&next, &step.out_format, &info.resolution);
+			vdef_test_frame_set_info(&next, &info);
+			run_reference(step.step, &in_info, &cur, &next);
+			vdef_test_frame_free(&cur);
+			cur = next;
+		}
+		ref = cur;
+		CU_ASSERT_EQUAL_FATAL(ref.layout.size, out.layout.size);
+
+		for (unsigned int j = 0; j < ARRAY_SIZE(threads); j++) {
+			res = vdef_thread_pool_new(threads[j], &pool);
+			CU_ASSERT_EQUAL_FATAL(res, 0);
+			memset(out.data, 0, out.layout.size);
+			res = vdef_convert_plan_run(
+				plan,
+				&in.frame,
+				(const void *const *)in.plane,
+				&out.frame,
+				out.plane,
+				pool);
+			CU_ASSERT_EQUAL(res, 0);
+			CU_ASSERT_EQUAL(
+				memcmp(out.data, ref.data, out.layout.size), 0);
+			vdef_thread_pool_destroy(pool);
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&out);
+		vdef_test_frame_free(&ref);
+		vdef_convert_plan_destroy(plan);
+	}
+}
+
+
+static void test_plan_invalid(void)
+{
+	int res;
+	struct vdef_format_info info, out_info;
+	struct vdef_convert_plan *plan;
+	struct vdef_convert_plan_step step;
+	struct vdef_test_frame in, out;
+
+	test_info_init(&info,
+		       VDEF_COLOR_PRIMARIES_BT709,
+		       VDEF_TRANSFER_FUNCTION_BT709);
+
+	/* Invalid arguments */
+	res = vdef_convert_plan_new(NULL,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_plan_new(&vdef_i420,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_MAX,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_plan_new(&vdef_i420,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	CU_ASSERT_EQUAL(vdef_convert_plan_get_step_count(NULL), 0);
+	CU_ASSERT_EQUAL(vdef_convert_plan_get_band_height(NULL), 0);
+	CU_ASSERT_EQUAL(vdef_convert_plan_get_bytes(NULL), -EINVAL);
+	CU_ASSERT_EQUAL(vdef_convert_plan_destroy(NULL), 0);
+
+	/* Different resolutions */
+	out_info = info;
+	out_info.resolution.width = 64;
+	res = vdef_convert_plan_new(&vdef_i420,
+				    &info,
+				    &vdef_rgb,
+				    &out_info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Unsupported conversions */
+	res = vdef_convert_plan_new(&vdef_raw10_packed,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	res = vdef_convert_plan_new(&vdef_i420,
+				    &info,
+				    &vdef_rgb,
+				    &info,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    &plan);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	res = vdef_convert_plan_get_step(plan, 1, &step);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Frames not matching the plan */
+	vdef_test_frame_alloc(&in, &vdef_nv12, &info.resolution);
+	vdef_test_frame_set_info(&in, &info);
+	fill_random(&in);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &info.resolution);
+	vdef_test_frame_set_info(&out, &info);
+	res = vdef_convert_plan_run(plan,
+				    &in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane,
+				    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	in.frame.format = vdef_i420;
+	in.frame.info.resolution.height = 100;
+	res = vdef_convert_plan_run(plan,
+				    &in.frame,
+				    (const void *const *)in.plane,
+				    &out.frame,
+				    out.plane,
+				    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_convert_plan_run(
+		plan, &in.frame, NULL, &out.frame, out.plane, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+	vdef_convert_plan_destroy(plan);
+}
+
+
+static void test_plan_to_str(void)
+{
+	CU_ASSERT_STRING_EQUAL(vdef_convert_step_to_str(VDEF_CONVERT_STEP_COPY),
+			       "COPY");
+	CU_ASSERT_STRING_EQUAL(
+		vdef_convert_step_to_str(VDEF_CONVERT_STEP_TONE_MAP),
+		"TONE_MAP");
+	CU_ASSERT_STRING_EQUAL(vdef_convert_step_to_str(VDEF_CONVERT_STEP_MAX),
+			       "UNKNOWN");
+}
+
+
+CU_TestInfo g_vdef_test_plan[] = {
+	{FN("plan-steps"), &test_plan_steps},
+	{FN("plan-bands"), &test_plan_bands},
+	{FN("plan-run"), &test_plan_run},
+	{FN("plan-invalid"), &test_plan_invalid},
+	{FN("plan-to-str"), &test_plan_to_str},
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,319 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+#define POOL_FRAME_COUNT 8
+#define POOL_THREAD_COUNT 4
+#define POOL_THREAD_LOOPS 10000
+
+
+static void test_raw_frame_pool_new(void)
+{
+	int res;
+	struct vdef_raw_layout layout;
+	struct vdef_raw_frame_pool *pool = NULL;
+	struct vdef_dim res_1080p = {1920, 1080};
+
+	res = vdef_calc_raw_layout(
+		&vdef_nv12, &res_1080p, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Invalid arguments */
+	res = vdef_raw_frame_pool_new(NULL, POOL_FRAME_COUNT, 0, 0, &pool);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_raw_frame_pool_new(&layout, 0, 0, 0, &pool);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_raw_frame_pool_new(&layout, POOL_FRAME_COUNT, 48, 0, &pool);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_raw_frame_pool_new(&layout, POOL_FRAME_COUNT, 0, 0, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Default alignment */
+	res = vdef_raw_frame_pool_new(&layout, POOL_FRAME_COUNT, 0, 0, &pool);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+	CU_ASSERT_PTR_NOT_NULL(vdef_raw_frame_pool_get_layout(pool));
+	CU_ASSERT_EQUAL(vdef_raw_frame_pool_get_layout(pool)->size,
+			layout.size);
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Huge pages (falls back to regular pages if not available) */
+	pool = NULL;
+	res = vdef_raw_frame_pool_new(&layout,
+				      POOL_FRAME_COUNT,
+				      4096,
+				      VDEF_RAW_FRAME_POOL_FLAG_HUGE_PAGES,
+				      &pool);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+static void test_raw_frame_pool_get_put(void)
+{
+	int res;
+	struct vdef_raw_layout layout;
+	struct vdef_raw_frame_pool *pool = NULL;
+	struct vdef_dim res_720p = {1280, 720};
+	void *frames[POOL_FRAME_COUNT];
+	void *frame;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+	size_t align = 8192;
+
+	res = vdef_calc_raw_layout(
+		&vdef_i420, &res_720p, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_frame_pool_new(
+		&layout, POOL_FRAME_COUNT, align, 0, &pool);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+
+	/* Take all frames */
+	for (unsigned int i = 0; i < POOL_FRAME_COUNT; i++) {
+		res = vdef_raw_frame_pool_get(pool, &frames[i]);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(frames[i]);
+		CU_ASSERT_EQUAL((uintptr_t)frames[i] % align, 0);
+		for (unsigned int j = 0; j < i; j++)
+			CU_ASSERT_PTR_NOT_EQUAL(frames[i], frames[j]);
+		/* The whole frame must be writable */
+		memset(frames[i], i, layout.size);
+		res = vdef_raw_layout_get_planes(
+			&layout, frames[i], layout.size, plane);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+
+	/* Pool is empty */
+	res = vdef_raw_frame_pool_get(pool, &frame);
+	CU_ASSERT_EQUAL(res, -EAGAIN);
+
+	/* Frames are still in use */
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, -EBUSY);
+
+	/* Invalid frames */
+	res = vdef_raw_frame_pool_put(pool, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_raw_frame_pool_put(pool, (uint8_t *)frames[0] + 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_raw_frame_pool_put(pool, &frame);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Return one frame and take it again */
+	res = vdef_raw_frame_pool_put(pool, frames[3]);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_frame_pool_get(pool, &frame);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_EQUAL(frame, frames[3]);
+
+	/* Return all frames */
+	for (unsigned int i = 0; i < POOL_FRAME_COUNT; i++) {
+		res = vdef_raw_frame_pool_put(pool, frames[i]);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+
+	/* Frames returned twice are not pushed to the free list again */
+	res = vdef_raw_frame_pool_put(pool, frames[1]);
+	CU_ASSERT_EQUAL(res, -EALREADY);
+	for (unsigned int i = 0; i < POOL_FRAME_COUNT; i++) {
+		res = vdef_raw_frame_pool_get(pool, &frames[i]);
+		CU_ASSERT_EQUAL(res, 0);
+		for (unsigned int j = 0; j < i; j++)
+			CU_ASSERT_PTR_NOT_EQUAL(frames[i], frames[j]);
+	}
+	res = vdef_raw_frame_pool_get(pool, &frame);
+	CU_ASSERT_EQUAL(res, -EAGAIN);
+	for (unsigned int i = 0; i < POOL_FRAME_COUNT; i++) {
+		res = vdef_raw_frame_pool_put(pool, frames[i]);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+static void *pool_thread(void *userdata)
+{
+	struct vdef_raw_frame_pool *pool = userdata;
+	unsigned int errors = 0;
+	void *frame;
+
+	for (unsigned int i = 0; i < POOL_THREAD_LOOPS; i++) {
+		if (vdef_raw_frame_pool_get(pool, &frame) < 0) {
+			errors++;
+			continue;
+		}
+		/* Frames must not be shared between threads */
+		*(volatile pthread_t *)frame = pthread_self();
+		if (*(volatile pthread_t *)frame != pthread_self())
+			errors++;
+		if (vdef_raw_frame_pool_put(pool, frame) < 0)
+			errors++;
+	}
+
+	return (void *)(uintptr_t)errors;
+}
+
+
+static void test_raw_frame_pool_threads(void)
+{
+	int res;
+	struct vdef_raw_layout layout;
+	struct vdef_raw_frame_pool *pool = NULL;
+	struct vdef_dim res_vga = {640, 480};
+	pthread_t threads[POOL_THREAD_COUNT];
+	void *errors;
+
+	res = vdef_calc_raw_layout(
+		&vdef_gray, &res_vga, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_frame_pool_new(&layout, POOL_THREAD_COUNT, 0, 0, &pool);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+
+	/* There are as many frames as threads, so no thread can ever find
+	 * the pool empty */
+	for (unsigned int i = 0; i < POOL_THREAD_COUNT; i++) {
+		res = pthread_create(&threads[i], NULL, pool_thread, pool);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+	for (unsigned int i = 0; i < POOL_THREAD_COUNT; i++) {
+		pthread_join(threads[i], &errors);
+		CU_ASSERT_EQUAL((uintptr_t)errors, 0);
+	}
+
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+static void test_raw_frame_pool_memfd(void)
+{
+	int res, fd, status;
+	struct vdef_raw_layout layout;
+	struct vdef_raw_frame_pool *pool = NULL;
+	struct vdef_dim res_vga = {640, 480};
+	void *frame, *mapped;
+	void *plane[VDEF_RAW_MAX_PLANE_COUNT];
+	pid_t pid;
+
+	res = vdef_calc_raw_layout(
+		&vdef_nv12, &res_vga, NULL, NULL, NULL, &layout);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Not a memfd pool */
+	res = vdef_raw_frame_pool_new(&layout, POOL_FRAME_COUNT, 0, 0, &pool);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+	res = vdef_raw_frame_pool_get(pool, &frame);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_frame_pool_get_fd(pool, frame, &fd);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	res = vdef_raw_frame_pool_put(pool, frame);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Memfd pool */
+	pool = NULL;
+	res = vdef_raw_frame_pool_new(&layout,
+				      POOL_FRAME_COUNT,
+				      0,
+				      VDEF_RAW_FRAME_POOL_FLAG_MEMFD,
+				      &pool);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+	res = vdef_raw_frame_pool_get(pool, &frame);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL((uintptr_t)frame % sysconf(_SC_PAGESIZE), 0);
+	res = vdef_raw_frame_pool_get_fd(pool, frame, &fd);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(fd >= 0);
+	res = vdef_raw_frame_pool_get_fd(pool, (uint8_t *)frame + 1, &fd);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_raw_frame_pool_get_fd(pool, frame, &fd);
+	CU_ASSERT_EQUAL(res, 0);
+	memset(frame, 0, layout.size);
+
+	/* Another process fills the frame through the memfd */
+	pid = fork();
+	CU_ASSERT_TRUE_FATAL(pid >= 0);
+	if (pid == 0) {
+		if (vdef_raw_frame_map_fd(fd, &layout, &mapped) < 0)
+			_exit(1);
+		if (vdef_raw_layout_get_planes(
+			    &layout, mapped, layout.size, plane) < 0)
+			_exit(1);
+		memset(plane[0], 0x10, layout.plane_size[0]);
+		memset(plane[1], 0x80, layout.plane_size[1]);
+		vdef_raw_frame_unmap(&layout, mapped);
+		_exit(0);
+	}
+	res = waitpid(pid, &status, 0);
+	CU_ASSERT_EQUAL(res, pid);
+	CU_ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	CU_ASSERT_EQUAL(((uint8_t *)frame)[0], 0x10);
+	CU_ASSERT_EQUAL(((uint8_t *)frame)[layout.plane_offset[1] - 1], 0x10);
+	CU_ASSERT_EQUAL(((uint8_t *)frame)[layout.plane_offset[1]], 0x80);
+	CU_ASSERT_EQUAL(((uint8_t *)frame)[layout.size - 1], 0x80);
+
+	/* The frame size is sealed */
+	res = ftruncate(fd, 0);
+	CU_ASSERT_EQUAL(res, -1);
+
+	/* Mapping a frame bigger than the memfd fails */
+	layout.size *= 2;
+	res = vdef_raw_frame_map_fd(fd, &layout, &mapped);
+	CU_ASSERT_EQUAL(res, -ENOBUFS);
+
+	res = vdef_raw_frame_pool_put(pool, frame);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_raw_frame_pool_destroy(pool);
+	CU_ASSERT_EQUAL(res, 0);
+}
+
+
+CU_TestInfo g_vdef_test_pool[] = {
+	{FN("raw-frame-pool-new"), &test_raw_frame_pool_new},
+	{FN("raw-frame-pool-get-put"), &test_raw_frame_pool_get_put},
+	{FN("raw-frame-pool-threads"), &test_raw_frame_pool_threads},
+	{FN("raw-frame-pool-memfd"), &test_raw_frame_pool_memfd},
+
+	CU_TEST_INFO_NULL,
+};
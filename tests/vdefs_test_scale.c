@@ -0,0 +1,591 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+static const struct vdef_raw_format *const s_formats[] = {
+	&vdef_gray,
+	&vdef_gray16,
+	&vdef_i420,
+	&vdef_i420_10_16le,
+	&vdef_i420_10_16be,
+	&vdef_i420_10_16le_high,
+	&vdef_nv12,
+	&vdef_nv21_10_16be_high,
+	&vdef_i444,
+	&vdef_rgb,
+	&vdef_rgba,
+};
+
+
+/* Sample accessors of all the planes as a flat array (the layouts have no
+ * padding between lines) */
+static unsigned int test_get(const struct vdef_test_frame *f, size_t i)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	unsigned int shift = format->data_pad_low
+				     ? format->data_size - format->pix_size
+				     : 0;
+	unsigned int v;
+
+	if (format->data_size == 8)
+		return f->data[i];
+	if (format->data_little_endian)
+		v = f->data[2 * i] | (f->data[2 * i + 1] << 8);
+	else
+		v = (f->data[2 * i] << 8) | f->data[2 * i + 1];
+	return v >> shift;
+}
+
+
+static void test_set(struct vdef_test_frame *f, size_t i, unsigned int v)
+{
+	const struct vdef_raw_format *format = &f->frame.format;
+	unsigned int shift = format->data_pad_low
+				     ? format->data_size - format->pix_size
+				     : 0;
+
+	if (format->data_size == 8) {
+		f->data[i] = v;
+		return;
+	}
+	v <<= shift;
+	if (format->data_little_endian) {
+		f->data[2 * i] = v & 0xff;
+		f->data[2 * i + 1] = v >> 8;
+	} else {
+		f->data[2 * i] = v >> 8;
+		f->data[2 * i + 1] = v & 0xff;
+	}
+}
+
+
+static size_t test_count(const struct vdef_test_frame *f)
+{
+	return f->layout.size / (f->frame.format.data_size / 8);
+}
+
+
+static void test_fill_random(struct vdef_test_frame *f)
+{
+	unsigned int max = (1 << f->frame.format.pix_size) - 1;
+
+	for (size_t i = 0; i < test_count(f); i++)
+		test_set(f, i, rand() % (max + 1));
+}
+
+
+static int test_scale(const struct vdef_test_frame *in,
+		      struct vdef_test_frame *out,
+		      enum vdef_scale_method method,
+		      struct vdef_thread_pool *pool)
+{
+	return vdef_scale(&in->frame,
+			  (const void *const *)in->plane,
+			  &out->frame,
+			  out->plane,
+			  method,
+			  pool);
+}
+
+
+static void test_scale_identity(void)
+{
+	int ret;
+	struct vdef_dim res = {100, 62};
+	struct vdef_test_frame in, out;
+
+	for (size_t i = 0; i < ARRAY_SIZE(s_formats); i++) {
+		vdef_test_frame_alloc(&in, s_formats[i], &res);
+		vdef_test_frame_alloc(&out, s_formats[i], &res);
+		test_fill_random(&in);
+
+		for (int m = 0; m < VDEF_SCALE_METHOD_MAX; m++) {
+			memset(out.data, 0, out.layout.size);
+			ret = test_scale(&in, &out, m, NULL);
+			CU_ASSERT_EQUAL(ret, 0);
+			CU_ASSERT_EQUAL(
+				memcmp(in.data, out.data, in.layout.size), 0);
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+static void test_scale_nearest(void)
+{
+	int ret;
+	struct vdef_dim in_res = {9, 6};
+	struct vdef_dim out_res = {3, 4};
+	struct vdef_test_frame in, out;
+
+	/* Output sample centers at 1.5, 4.5 and 7.5 horizontally and 0.75,
+	 * 2.25, 3.75 and 5.25 vertically */
+	const unsigned int xs[] = {1, 4, 7};
+	const unsigned int ys[] = {0, 2, 3, 5};
+
+	vdef_test_frame_alloc(&in, &vdef_rgb, &in_res);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &out_res);
+	test_fill_random(&in);
+
+	ret = test_scale(&in, &out, VDEF_SCALE_METHOD_NEAREST, NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (unsigned int y = 0; y < out_res.height; y++) {
+		for (unsigned int x = 0; x < out_res.width; x++) {
+			CU_ASSERT_EQUAL(
+				memcmp(&out.data[(y * 3 + x) * 3],
+				       &in.data[(ys[y] * 9 + xs[x]) * 3],
+				       3),
+				0);
+		}
+	}
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_scale_area(void)
+{
+	int ret;
+	struct vdef_dim in_res = {64, 48};
+	struct vdef_dim out_res = {32, 24};
+	const struct vdef_raw_format *formats[] = {
+		&vdef_gray,
+		&vdef_gray16,
+		&vdef_i420_10_16be_high,
+	};
+	struct vdef_test_frame in, out;
+
+	/* Downscaling by 2 averages the 2x2 input blocks; the inputs are
+	 * multiples of 4 so that there is no rounding */
+	for (size_t i = 0; i < ARRAY_SIZE(formats); i++) {
+		unsigned int max = (1 << formats[i]->pix_size) - 1;
+
+		vdef_test_frame_alloc(&in, formats[i], &in_res);
+		vdef_test_frame_alloc(&out, formats[i], &out_res);
+		for (size_t k = 0; k < test_count(&in); k++)
+			test_set(&in, k, (rand() % (max + 1)) & ~3u);
+
+		ret = test_scale(&in, &out, VDEF_SCALE_METHOD_AREA, NULL);
+		CU_ASSERT_EQUAL(ret, 0);
+		for (unsigned int y = 0; y < out_res.height; y++) {
+			for (unsigned int x = 0; x < out_res.width; x++) {
+				size_t k = 2 * y * in_res.width + 2 * x;
+				unsigned int sum = test_get(&in, k) +
+						   test_get(&in, k + 1) +
+						   test_get(&in, k + 64) +
+						   test_get(&in, k + 65);
+				CU_ASSERT_EQUAL(
+					test_get(&out, y * out_res.width + x),
+					sum / 4);
+			}
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+static void test_scale_smooth(void)
+{
+	int ret;
+	struct vdef_dim in_res = {120, 80};
+	const struct vdef_dim out_res[] = {
+		{40, 30},
+		{200, 130},
+		{8, 4},
+	};
+	const enum vdef_scale_method methods[] = {
+		VDEF_SCALE_METHOD_BILINEAR,
+		VDEF_SCALE_METHOD_AREA,
+		VDEF_SCALE_METHOD_BICUBIC,
+	};
+	struct vdef_test_frame in, out;
+
+	for (size_t i = 0; i < ARRAY_SIZE(out_res); i++) {
+		vdef_test_frame_alloc(&in, &vdef_gray16, &in_res);
+		vdef_test_frame_alloc(&out, &vdef_gray16, &out_res[i]);
+
+		for (size_t m = 0; m < ARRAY_SIZE(methods); m++) {
+			/* Constant frame: unchanged */
+			for (size_t k = 0; k < test_count(&in); k++)
+				test_set(&in, k, 12345);
+			ret = test_scale(&in, &out, methods[m], NULL);
+			CU_ASSERT_EQUAL(ret, 0);
+			for (size_t k = 0; k < test_count(&out); k++)
+				CU_ASSERT_EQUAL(test_get(&out, k), 12345);
+
+			/* Horizontal gradient: monotonic output, within the
+			 * input range except for the bicubic overshoot at the
+			 * edges */
+			for (unsigned int y = 0; y < in_res.height; y++) {
+				for (unsigned int x = 0; x < in_res.width; x++)
+					test_set(&in,
+						 y * in_res.width + x,
+						 1000 + 500 * x);
+			}
+			ret = test_scale(&in, &out, methods[m], NULL);
+			CU_ASSERT_EQUAL(ret, 0);
+			for (unsigned int y = 0; y < out_res[i].height; y++) {
+				size_t k = y * out_res[i].width;
+				unsigned int prev = test_get(&out, k);
+				unsigned int first = prev;
+				bool clamped =
+					methods[m] != VDEF_SCALE_METHOD_BICUBIC;
+
+				CU_ASSERT(!clamped || prev >= 1000);
+				for (unsigned int x = 1; x < out_res[i].width;
+				     x++) {
+					unsigned int v = test_get(&out, k + x);
+					CU_ASSERT(v >= prev);
+					CU_ASSERT(!clamped ||
+						  v <= 1000 + 500 * 119);
+					prev = v;
+				}
+				/* Same output on all the lines */
+				CU_ASSERT_EQUAL(first, test_get(&out, 0));
+			}
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+static void test_scale_threads(void)
+{
+	int ret;
+	struct vdef_dim in_res = {320, 240};
+	struct vdef_dim out_res = {176, 144};
+	const unsigned int threads[] = {2, 4, 0};
+	struct vdef_thread_pool *pools[ARRAY_SIZE(threads)];
+	struct vdef_test_frame in, ref, out;
+
+	for (size_t t = 0; t < ARRAY_SIZE(threads); t++) {
+		ret = vdef_thread_pool_new(threads[t], &pools[t]);
+		CU_ASSERT_EQUAL_FATAL(ret, 0);
+	}
+
+	/* Same output whatever the number of threads */
+	for (size_t i = 0; i < ARRAY_SIZE(s_formats); i++) {
+		vdef_test_frame_alloc(&in, s_formats[i], &in_res);
+		vdef_test_frame_alloc(&ref, s_formats[i], &out_res);
+		vdef_test_frame_alloc(&out, s_formats[i], &out_res);
+		test_fill_random(&in);
+
+		for (int m = 0; m < VDEF_SCALE_METHOD_MAX; m++) {
+			ret = test_scale(&in, &ref, m, NULL);
+			CU_ASSERT_EQUAL(ret, 0);
+			for (size_t t = 0; t < ARRAY_SIZE(threads); t++) {
+				memset(out.data, 0, out.layout.size);
+				ret = test_scale(&in, &out, m, pools[t]);
+				CU_ASSERT_EQUAL(ret, 0);
+				CU_ASSERT_EQUAL(memcmp(ref.data,
+						       out.data,
+						       ref.layout.size),
+						0);
+			}
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&ref);
+		vdef_test_frame_free(&out);
+	}
+
+	for (size_t t = 0; t < ARRAY_SIZE(threads); t++)
+		vdef_thread_pool_destroy(pools[t]);
+}
+
+
+static void test_scale_scaler(void)
+{
+	int ret;
+	struct vdef_dim in_res = {320, 240};
+	struct vdef_dim out_res = {176, 144};
+	struct vdef_thread_pool *pool;
+	struct vdef_scaler *scaler;
+	struct vdef_test_frame in, ref, out;
+
+	ret = vdef_thread_pool_new(3, &pool);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* A scaler gives the output of vdef_scale() for all the frames */
+	for (size_t i = 0; i < ARRAY_SIZE(s_formats); i++) {
+		vdef_test_frame_alloc(&in, s_formats[i], &in_res);
+		vdef_test_frame_alloc(&ref, s_formats[i], &out_res);
+		vdef_test_frame_alloc(&out, s_formats[i], &out_res);
+
+		for (int m = 0; m < VDEF_SCALE_METHOD_MAX; m++) {
+			ret = vdef_scaler_new(s_formats[i],
+					      &in_res,
+					      &out_res,
+					      m,
+					      pool,
+					      &scaler);
+			CU_ASSERT_EQUAL_FATAL(ret, 0);
+			for (unsigned int f = 0; f < 3; f++) {
+				test_fill_random(&in);
+				ret = test_scale(&in, &ref, m, NULL);
+				CU_ASSERT_EQUAL(ret, 0);
+				memset(out.data, 0, out.layout.size);
+				ret = vdef_scaler_run(
+					scaler,
+					&in.frame,
+					(const void *const *)in.plane,
+					&out.frame,
+					out.plane);
+				CU_ASSERT_EQUAL(ret, 0);
+				CU_ASSERT_EQUAL(memcmp(ref.data,
+						       out.data,
+						       ref.layout.size),
+						0);
+			}
+			vdef_scaler_destroy(scaler);
+		}
+
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&ref);
+		vdef_test_frame_free(&out);
+	}
+
+	/* Frames that do not match the scaler */
+	vdef_test_frame_alloc(&in, &vdef_i420, &in_res);
+	vdef_test_frame_alloc(&out, &vdef_i420, &out_res);
+	ret = vdef_scaler_new(&vdef_i420,
+			      &in_res,
+			      &out_res,
+			      VDEF_SCALE_METHOD_BILINEAR,
+			      NULL,
+			      &scaler);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = vdef_scaler_run(scaler,
+			      &out.frame,
+			      (const void *const *)out.plane,
+			      &in.frame,
+			      in.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame.format = vdef_nv12;
+	ret = vdef_scaler_run(scaler,
+			      &in.frame,
+			      (const void *const *)in.plane,
+			      &out.frame,
+			      out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame.format = vdef_i420;
+	ret = vdef_scaler_run(NULL,
+			      &in.frame,
+			      (const void *const *)in.plane,
+			      &out.frame,
+			      out.plane);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scaler_run(scaler,
+			      &in.frame,
+			      (const void *const *)in.plane,
+			      &out.frame,
+			      out.plane);
+	CU_ASSERT_EQUAL(ret, 0);
+	vdef_scaler_destroy(scaler);
+
+	/* Invalid arguments */
+	ret = vdef_scaler_new(NULL,
+			      &in_res,
+			      &out_res,
+			      VDEF_SCALE_METHOD_BILINEAR,
+			      NULL,
+			      &scaler);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scaler_new(&vdef_i420,
+			      &in_res,
+			      NULL,
+			      VDEF_SCALE_METHOD_BILINEAR,
+			      NULL,
+			      &scaler);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scaler_new(&vdef_i420,
+			      &in_res,
+			      &out_res,
+			      VDEF_SCALE_METHOD_MAX,
+			      NULL,
+			      &scaler);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scaler_new(&vdef_i420,
+			      &in_res,
+			      &out_res,
+			      VDEF_SCALE_METHOD_BILINEAR,
+			      NULL,
+			      NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scaler_new(&vdef_nv21_hisi_tile,
+			      &in_res,
+			      &out_res,
+			      VDEF_SCALE_METHOD_BILINEAR,
+			      NULL,
+			      &scaler);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+	CU_ASSERT_EQUAL(vdef_scaler_destroy(NULL), 0);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+	vdef_thread_pool_destroy(pool);
+}
+
+
+static void test_scale_resolution(void)
+{
+	int ret;
+	struct vdef_dim in_res = {854, 480};
+	struct vdef_dim out_res;
+	struct vdef_test_frame in, out;
+
+	vdef_test_frame_alloc(&in, &vdef_nv12, &in_res);
+	ret = vdef_resolution_to_dim(VDEF_RESOLUTION_240P, &out_res);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	vdef_test_frame_alloc(&out, &vdef_nv12, &out_res);
+	test_fill_random(&in);
+
+	/* The resolution is set from the preset */
+	memset(&out.frame.info.resolution, 0, sizeof(out_res));
+	ret = vdef_scale_to_resolution(&in.frame,
+				       (const void *const *)in.plane,
+				       VDEF_RESOLUTION_240P,
+				       &out.frame,
+				       out.plane,
+				       VDEF_SCALE_METHOD_BILINEAR,
+				       NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT(vdef_dim_cmp(&out.frame.info.resolution, &out_res));
+
+	/* Unknown preset; the resolution is unchanged */
+	memset(&out.frame.info.resolution, 0, sizeof(out_res));
+	ret = vdef_scale_to_resolution(&in.frame,
+				       (const void *const *)in.plane,
+				       VDEF_RESOLUTION_MAX,
+				       &out.frame,
+				       out.plane,
+				       VDEF_SCALE_METHOD_BILINEAR,
+				       NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT(vdef_dim_is_null(&out.frame.info.resolution));
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_scale_invalid(void)
+{
+	int ret;
+	struct vdef_dim res = {64, 48};
+	struct vdef_test_frame in, out;
+	struct vdef_raw_frame frame;
+	const void *const *in_plane;
+	const struct vdef_raw_format *unsupported[] = {
+		&vdef_nv12_10_packed,
+		&vdef_nv21_hisi_tile,
+		&vdef_raw10_packed,
+		&vdef_yuyv,
+		&vdef_yvyu,
+	};
+
+	vdef_test_frame_alloc(&in, &vdef_i420, &res);
+	vdef_test_frame_alloc(&out, &vdef_i420, &res);
+	in_plane = (const void *const *)in.plane;
+
+	ret = vdef_scale(NULL, in_plane, &out.frame, out.plane, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scale(&in.frame, NULL, &out.frame, out.plane, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scale(&in.frame, in_plane, NULL, out.plane, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scale(&in.frame, in_plane, &out.frame, NULL, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = test_scale(&in, &out, VDEF_SCALE_METHOD_MAX, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_scale_to_resolution(&in.frame,
+				       in_plane,
+				       VDEF_RESOLUTION_120P,
+				       NULL,
+				       out.plane,
+				       0,
+				       NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* Different formats */
+	frame = out.frame;
+	out.frame.format = vdef_nv12;
+	ret = test_scale(&in, &out, VDEF_SCALE_METHOD_BILINEAR, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame = frame;
+
+	/* Null resolution */
+	out.frame.info.resolution.height = 0;
+	ret = test_scale(&in, &out, VDEF_SCALE_METHOD_BILINEAR, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame = frame;
+
+	/* Partial chroma samples */
+	out.frame.info.resolution.width = 63;
+	ret = test_scale(&in, &out, VDEF_SCALE_METHOD_BILINEAR, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	out.frame = frame;
+
+	/* Missing plane */
+	out.plane[2] = NULL;
+	ret = test_scale(&in, &out, VDEF_SCALE_METHOD_BILINEAR, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+
+	for (size_t i = 0; i < ARRAY_SIZE(unsupported); i++) {
+		vdef_test_frame_alloc(&in, unsupported[i], &res);
+		vdef_test_frame_alloc(&out, unsupported[i], &res);
+		ret = test_scale(&in, &out, VDEF_SCALE_METHOD_BILINEAR, NULL);
+		CU_ASSERT_EQUAL(ret, -ENOTSUP);
+		vdef_test_frame_free(&in);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+CU_TestInfo g_vdef_test_scale[] = {
+	{FN("scale-identity"), &test_scale_identity},
+	{FN("scale-nearest"), &test_scale_nearest},
+	{FN("scale-area"), &test_scale_area},
+	{FN("scale-smooth"), &test_scale_smooth},
+	{FN("scale-threads"), &test_scale_threads},
+	{FN("scale-scaler"), &test_scale_scaler},
+	{FN("scale-resolution"), &test_scale_resolution},
+	{FN("scale-invalid"), &test_scale_invalid},
+
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,314 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+
+#define TASK_COUNT 1000
+
+
+struct test_tasks {
+	atomic_uint runs[TASK_COUNT];
+	unsigned int thread_count;
+	unsigned int fail_index;
+	bool slow;
+};
+
+
+/* Kernel run on the bands of a frame */
+struct test_bands {
+	const struct vdef_test_frame *in;
+	const struct vdef_test_frame *out;
+	unsigned int band_height;
+	bool tile;
+};
+
+
+static int count_task(unsigned int index,
+		      unsigned int thread_index,
+		      void *userdata)
+{
+	struct test_tasks *tasks = userdata;
+
+	CU_ASSERT(thread_index < tasks->thread_count);
+	atomic_fetch_add(&tasks->runs[index], 1);
+
+	/* Unbalanced tasks: the other threads steal the tasks of the first
+	 * thread */
+	if (tasks->slow && index == 0)
+		usleep(10000);
+
+	return index == tasks->fail_index ? -EIO : 0;
+}
+
+
+static void fill_random(struct vdef_test_frame *f)
+{
+	for (size_t i = 0; i < f->layout.size; i++)
+		f->data[i] = rand();
+}
+
+
+/* Get a band view of a test frame */
+static int get_band(const struct vdef_test_frame *f,
+		    unsigned int band_height,
+		    unsigned int index,
+		    struct vdef_raw_frame *view,
+		    void **plane)
+{
+	int ret;
+	size_t offset[VDEF_RAW_MAX_PLANE_COUNT];
+
+	ret = vdef_calc_raw_frame_band(
+		&f->frame, band_height, index, view, offset);
+	if (ret < 0)
+		return ret;
+	for (unsigned int i = 0; i < VDEF_RAW_MAX_PLANE_COUNT; i++) {
+		plane[i] = f->plane[i];
+		if (plane[i] != NULL)
+			plane[i] = (uint8_t *)plane[i] + offset[i];
+	}
+
+	return 0;
+}
+
+
+static int band_task(unsigned int index,
+		     unsigned int thread_index,
+		     void *userdata)
+{
+	int ret;
+	struct test_bands *bands = userdata;
+	struct vdef_raw_frame in, out;
+	void *in_plane[VDEF_RAW_MAX_PLANE_COUNT];
+	void *out_plane[VDEF_RAW_MAX_PLANE_COUNT];
+
+	(void)thread_index;
+
+	ret = get_band(bands->in, bands->band_height, index, &in, in_plane);
+	if (ret < 0)
+		return ret;
+	ret = get_band(bands->out, bands->band_height, index, &out, out_plane);
+	if (ret < 0)
+		return ret;
+
+	if (bands->tile) {
+		return vdef_convert_pix_layout(&in,
+					       (const void *const *)in_plane,
+					       &out,
+					       out_plane,
+					       NULL);
+	}
+	return vdef_convert_yuv_to_rgb(
+		&in, (const void *const *)in_plane, &out, out_plane);
+}
+
+
+static void test_thread_pool_run(void)
+{
+	int res;
+	struct vdef_thread_pool *pool;
+	struct test_tasks *tasks;
+	const unsigned int threads[] = {1, 2, 3, 8, 0};
+	const unsigned int counts[] = {0, 1, 5, TASK_COUNT};
+
+	tasks = calloc(1, sizeof(*tasks));
+	CU_ASSERT_PTR_NOT_NULL_FATAL(tasks);
+	tasks->fail_index = UINT_MAX;
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(threads); i++) {
+		res = vdef_thread_pool_new(threads[i], &pool);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		tasks->thread_count = vdef_thread_pool_get_thread_count(pool);
+		if (threads[i] != 0)
+			CU_ASSERT_EQUAL(tasks->thread_count, threads[i]);
+		CU_ASSERT(tasks->thread_count > 0);
+
+		/* Each task runs exactly once, on every run of the pool */
+		for (unsigned int j = 0; j < ARRAY_SIZE(counts); j++) {
+			for (unsigned int k = 0; k < 2; k++) {
+				tasks->slow = k == 1;
+				for (unsigned int t = 0; t < TASK_COUNT; t++)
+					atomic_init(&tasks->runs[t], 0);
+				res = vdef_thread_pool_run(
+					pool, counts[j], &count_task, tasks);
+				CU_ASSERT_EQUAL(res, 0);
+				for (unsigned int t = 0; t < TASK_COUNT; t++) {
+					CU_ASSERT_EQUAL(
+						atomic_load(&tasks->runs[t]),
+						t < counts[j] ? 1 : 0);
+				}
+			}
+		}
+
+		res = vdef_thread_pool_destroy(pool);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+
+	free(tasks);
+}
+
+
+static void test_thread_pool_error(void)
+{
+	int res;
+	struct vdef_thread_pool *pool;
+	struct test_tasks *tasks;
+
+	tasks = calloc(1, sizeof(*tasks));
+	CU_ASSERT_PTR_NOT_NULL_FATAL(tasks);
+
+	res = vdef_thread_pool_new(4, &pool);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	tasks->thread_count = 4;
+	tasks->fail_index = 3;
+	res = vdef_thread_pool_run(pool, TASK_COUNT, &count_task, tasks);
+	CU_ASSERT_EQUAL(res, -EIO);
+
+	/* The pool is still usable */
+	tasks->fail_index = UINT_MAX;
+	res = vdef_thread_pool_run(pool, TASK_COUNT, &count_task, tasks);
+	CU_ASSERT_EQUAL(res, 0);
+
+	vdef_thread_pool_destroy(pool);
+	free(tasks);
+}
+
+
+/* Running a kernel on the bands of a frame gives the whole frame output
+ * whatever the thread count */
+static void test_thread_pool_bands(void)
+{
+	int res;
+	struct vdef_thread_pool *pool;
+	struct vdef_test_frame in, out, ref, tiled, linear;
+	struct test_bands bands;
+	const struct vdef_dim resolution = {640, 360};
+	const struct vdef_format_info info = {
+		.matrix_coefs = VDEF_MATRIX_COEFS_BT709,
+	};
+	const unsigned int threads[] = {1, 2, 4, 0};
+	unsigned int count;
+
+	srand(42);
+	vdef_test_frame_alloc(&in, &vdef_i420, &resolution);
+	vdef_test_frame_set_info(&in, &info);
+	fill_random(&in);
+	vdef_test_frame_alloc(&out, &vdef_rgb, &resolution);
+	vdef_test_frame_alloc(&ref, &vdef_rgb, &resolution);
+	vdef_test_frame_alloc(&tiled, &vdef_nv21_hisi_tile, &resolution);
+	fill_random(&tiled);
+	vdef_test_frame_alloc(&linear, &vdef_nv21, &resolution);
+
+	res = vdef_convert_yuv_to_rgb(&in.frame,
+				      (const void *const *)in.plane,
+				      &ref.frame,
+				      ref.plane);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(threads); i++) {
+		res = vdef_thread_pool_new(threads[i], &pool);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+
+		/* Odd requested band height */
+		bands = (struct test_bands){&in, &out, 7, false};
+		res = vdef_calc_raw_frame_bands(&in.frame.format,
+						&resolution,
+						&bands.band_height,
+						&count);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		CU_ASSERT_EQUAL(bands.band_height, 8);
+		memset(out.data, 0, out.layout.size);
+		res = vdef_thread_pool_run(pool, count, &band_task, &bands);
+		CU_ASSERT_EQUAL(res, 0);
+		CU_ASSERT_EQUAL(memcmp(out.data, ref.data, out.layout.size), 0);
+
+		/* Tiled input */
+		bands = (struct test_bands){&tiled, &linear, 0, true};
+		res = vdef_calc_raw_frame_bands(&tiled.frame.format,
+						&resolution,
+						&bands.band_height,
+						&count);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		res = vdef_thread_pool_run(pool, count, &band_task, &bands);
+		CU_ASSERT_EQUAL(res, 0);
+
+		vdef_thread_pool_destroy(pool);
+	}
+
+	/* Tiled reference */
+	vdef_test_frame_free(&ref);
+	vdef_test_frame_alloc(&ref, &vdef_nv21, &resolution);
+	res = vdef_convert_pix_layout(&tiled.frame,
+				      (const void *const *)tiled.plane,
+				      &ref.frame,
+				      ref.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(memcmp(linear.data, ref.data, ref.layout.size), 0);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+	vdef_test_frame_free(&ref);
+	vdef_test_frame_free(&tiled);
+	vdef_test_frame_free(&linear);
+}
+
+
+static void test_thread_pool_invalid(void)
+{
+	int res;
+	struct vdef_thread_pool *pool;
+	struct test_tasks tasks = {.thread_count = 1, .fail_index = UINT_MAX};
+
+	res = vdef_thread_pool_new(1, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_thread_pool_run(NULL, 1, &count_task, &tasks);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_thread_pool_new(1, &pool);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	res = vdef_thread_pool_run(pool, 1, NULL, &tasks);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	vdef_thread_pool_destroy(pool);
+
+	CU_ASSERT_EQUAL(vdef_thread_pool_get_thread_count(NULL), 0);
+	CU_ASSERT_EQUAL(vdef_thread_pool_destroy(NULL), 0);
+}
+
+
+CU_TestInfo g_vdef_test_thread[] = {
+	{FN("thread-pool-run"), &test_thread_pool_run},
+	{FN("thread-pool-error"), &test_thread_pool_error},
+	{FN("thread-pool-bands"), &test_thread_pool_bands},
+	{FN("thread-pool-invalid"), &test_thread_pool_invalid},
+	CU_TEST_INFO_NULL,
+};
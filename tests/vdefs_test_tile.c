@@ -0,0 +1,504 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+
+/* Value of the untouched tile padding bytes */
+#define PAD_VALUE 0xa5
+
+
+/* Golden tiled positions of the vdef_nv21_hisi_tile format for a 130x20
+ * frame (3 tiles of 64x16 luma and 64x8 chroma bytes per row of tiles) */
+static const struct {
+	unsigned int plane;
+	size_t offset;
+	unsigned int x;
+	unsigned int y;
+} s_golden[] = {
+	{0, 0, 0, 0},
+	{0, 63, 63, 0},
+	{0, 64, 0, 1},
+	{0, 1023, 63, 15},
+	{0, 1024, 64, 0},
+	{0, 2048, 128, 0},
+	{0, 3072, 0, 16},
+	{0, 4293, 69, 19},
+	{1, 64, 0, 1},
+	{1, 511, 63, 7},
+	{1, 512, 64, 0},
+	{1, 1536, 0, 8},
+	{1, 2625, 129, 9},
+};
+
+
+/* Fill a frame with the padding value, so that the bytes that are not
+ * written can be checked */
+static void fill_pad(struct vdef_test_frame *f)
+{
+	memset(f->data, PAD_VALUE, f->layout.size);
+}
+
+
+/* Get the dimension of a YUV420 semi-planar plane in bytes and lines */
+static void get_plane_dim(const struct vdef_test_frame *f,
+			  unsigned int plane,
+			  size_t *line_bytes,
+			  unsigned int *lines)
+{
+	unsigned int group_samples, group_bytes;
+	unsigned int width = f->frame.info.resolution.width;
+	unsigned int height = f->frame.info.resolution.height;
+
+	vdef_get_raw_data_packing_group(
+		&f->frame.format, &group_samples, &group_bytes);
+	*line_bytes = (width + group_samples - 1) / group_samples * group_bytes;
+	*lines = (plane == 0) ? height : height / 2;
+}
+
+
+/* Get the offset of a byte in a tiled plane */
+static size_t get_tiled_offset(const struct vdef_test_frame *f,
+			       unsigned int plane,
+			       size_t x,
+			       unsigned int y)
+{
+	struct vdef_dim tile;
+	size_t stride = f->frame.plane_stride[plane];
+
+	CU_ASSERT_EQUAL(
+		vdef_get_raw_frame_plane_tile(&f->frame.format, plane, &tile),
+		0);
+	return (y / tile.height) * stride * tile.height +
+	       (x / tile.width) * tile.width * tile.height +
+	       (y % tile.height) * tile.width + x % tile.width;
+}
+
+
+static uint8_t get_value(unsigned int plane, size_t x, unsigned int y)
+{
+	return (x * 3 + y * 29 + plane * 101 + (x >> 8) * 7) & 0xff;
+}
+
+
+static void fill_linear(struct vdef_test_frame *f)
+{
+	for (unsigned int p = 0; p < 2; p++) {
+		size_t line_bytes;
+		unsigned int lines;
+		get_plane_dim(f, p, &line_bytes, &lines);
+		for (unsigned int y = 0; y < lines; y++) {
+			uint8_t *line = (uint8_t *)f->plane[p] +
+					y * f->frame.plane_stride[p];
+			for (size_t x = 0; x < line_bytes; x++)
+				line[x] = get_value(p, x, y);
+		}
+	}
+}
+
+
+/* Check a tiled frame against a linear frame; the chroma samples pairs are
+ * swapped if swap_bytes is not 0 */
+static void check_tiled(const struct vdef_test_frame *tiled,
+			const struct vdef_test_frame *linear,
+			unsigned int swap_bytes)
+{
+	unsigned int errors = 0;
+
+	for (unsigned int p = 0; p < 2; p++) {
+		size_t line_bytes;
+		unsigned int lines;
+		size_t pairs_bytes;
+		const uint8_t *t = tiled->plane[p];
+		get_plane_dim(linear, p, &line_bytes, &lines);
+		pairs_bytes = 0;
+		if (swap_bytes != 0)
+			pairs_bytes = line_bytes / (2 * swap_bytes) * 2 *
+				      swap_bytes;
+		for (unsigned int y = 0; y < lines; y++) {
+			const uint8_t *l = (const uint8_t *)linear->plane[p] +
+					   y * linear->frame.plane_stride[p];
+			for (size_t x = 0; x < line_bytes; x++) {
+				size_t lx = x;
+				/* Swap the samples of the whole pairs */
+				if (p == 1 && swap_bytes != 0 &&
+				    (x ^ swap_bytes) < pairs_bytes)
+					lx = x ^ swap_bytes;
+				if (t[get_tiled_offset(tiled, p, x, y)] !=
+				    l[lx])
+					errors++;
+			}
+		}
+	}
+	CU_ASSERT_EQUAL(errors, 0);
+}
+
+
+/* Check that two linear frames are equal, excluding the stride padding */
+static void check_linear(const struct vdef_test_frame *f1,
+			 const struct vdef_test_frame *f2)
+{
+	unsigned int errors = 0;
+
+	for (unsigned int p = 0; p < 2; p++) {
+		size_t line_bytes;
+		unsigned int lines;
+		get_plane_dim(f1, p, &line_bytes, &lines);
+		for (unsigned int y = 0; y < lines; y++) {
+			if (memcmp((uint8_t *)f1->plane[p] +
+					   y * f1->frame.plane_stride[p],
+				   (uint8_t *)f2->plane[p] +
+					   y * f2->frame.plane_stride[p],
+				   line_bytes) != 0)
+				errors++;
+		}
+	}
+	CU_ASSERT_EQUAL(errors, 0);
+}
+
+
+static void test_tile_golden(void)
+{
+	struct vdef_dim res = {130, 20};
+	struct vdef_test_frame linear, tiled, out;
+	unsigned int pad_errors = 0;
+	int ret;
+
+	vdef_test_frame_alloc(&linear, &vdef_nv21, &res);
+	fill_pad(&linear);
+	vdef_test_frame_alloc(&tiled, &vdef_nv21_hisi_tile, &res);
+	fill_pad(&tiled);
+	vdef_test_frame_alloc(&out, &vdef_nv21, &res);
+	fill_pad(&out);
+	CU_ASSERT_EQUAL(tiled.frame.plane_stride[0], 192);
+	CU_ASSERT_EQUAL(tiled.frame.plane_stride[1], 192);
+	fill_linear(&linear);
+
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      &tiled.frame,
+				      tiled.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_golden); i++) {
+		const uint8_t *t = tiled.plane[s_golden[i].plane];
+		CU_ASSERT_EQUAL(t[s_golden[i].offset],
+				get_value(s_golden[i].plane,
+					  s_golden[i].x,
+					  s_golden[i].y));
+	}
+	check_tiled(&tiled, &linear, 0);
+
+	/* The tile padding is left untouched */
+	for (unsigned int y = 0; y < 32; y++) {
+		const uint8_t *t = tiled.plane[0];
+		for (unsigned int x = 0; x < 192; x++) {
+			if (x < 130 && y < 20)
+				continue;
+			if (t[get_tiled_offset(&tiled, 0, x, y)] != PAD_VALUE)
+				pad_errors++;
+		}
+	}
+	CU_ASSERT_EQUAL(pad_errors, 0);
+
+	ret = vdef_convert_pix_layout(&tiled.frame,
+				      (const void *const *)tiled.plane,
+				      &out.frame,
+				      out.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	check_linear(&linear, &out);
+
+	vdef_test_frame_free(&linear);
+	vdef_test_frame_free(&tiled);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_tile_packed(void)
+{
+	static const struct vdef_dim res[] = {
+		{200, 36},
+		{64, 16},
+		{30, 2},
+	};
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(res); i++) {
+		struct vdef_test_frame linear, tiled, out;
+		struct vdef_dim tile;
+		int ret;
+
+		vdef_test_frame_alloc(&linear, &vdef_nv21_10_packed, &res[i]);
+		fill_pad(&linear);
+		vdef_test_frame_alloc(
+			&tiled, &vdef_nv21_hisi_tile_10_packed, &res[i]);
+		fill_pad(&tiled);
+		vdef_test_frame_alloc(&out, &vdef_nv21_10_packed, &res[i]);
+		fill_pad(&out);
+		ret = vdef_get_raw_frame_plane_tile(
+			&tiled.frame.format, 0, &tile);
+		CU_ASSERT_EQUAL(ret, 0);
+		CU_ASSERT_EQUAL(tile.width, 80);
+		fill_linear(&linear);
+
+		ret = vdef_convert_pix_layout(&linear.frame,
+					      (const void *const *)linear.plane,
+					      &tiled.frame,
+					      tiled.plane,
+					      NULL);
+		CU_ASSERT_EQUAL(ret, 0);
+		check_tiled(&tiled, &linear, 0);
+
+		ret = vdef_convert_pix_layout(&tiled.frame,
+					      (const void *const *)tiled.plane,
+					      &out.frame,
+					      out.plane,
+					      NULL);
+		CU_ASSERT_EQUAL(ret, 0);
+		check_linear(&linear, &out);
+
+		vdef_test_frame_free(&linear);
+		vdef_test_frame_free(&tiled);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+static void test_tile_chroma_order(void)
+{
+	static const unsigned int sizes[] = {8, 16};
+	struct vdef_dim res = {100, 18};
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(sizes); i++) {
+		struct vdef_raw_format nv12 = vdef_nv12;
+		struct vdef_raw_format nv21 = vdef_nv21_hisi_tile;
+		struct vdef_test_frame linear, tiled, out;
+		int ret;
+
+		nv12.pix_size = nv12.data_size = sizes[i];
+		nv21.pix_size = nv21.data_size = sizes[i];
+		vdef_test_frame_alloc(&linear, &nv12, &res);
+		fill_pad(&linear);
+		vdef_test_frame_alloc(&tiled, &nv21, &res);
+		fill_pad(&tiled);
+		vdef_test_frame_alloc(&out, &nv12, &res);
+		fill_pad(&out);
+		fill_linear(&linear);
+
+		ret = vdef_convert_pix_layout(&linear.frame,
+					      (const void *const *)linear.plane,
+					      &tiled.frame,
+					      tiled.plane,
+					      NULL);
+		CU_ASSERT_EQUAL(ret, 0);
+		check_tiled(&tiled, &linear, sizes[i] / 8);
+
+		ret = vdef_convert_pix_layout(&tiled.frame,
+					      (const void *const *)tiled.plane,
+					      &out.frame,
+					      out.plane,
+					      NULL);
+		CU_ASSERT_EQUAL(ret, 0);
+		check_linear(&linear, &out);
+
+		vdef_test_frame_free(&linear);
+		vdef_test_frame_free(&tiled);
+		vdef_test_frame_free(&out);
+	}
+}
+
+
+static void test_tile_threads(void)
+{
+	static const unsigned int thread_counts[] = {0, 3, 8, 100};
+	struct vdef_dim res = {1920, 1080};
+	struct vdef_test_frame linear, ref, tiled, out;
+	struct vdef_thread_pool *pool;
+	int ret;
+
+	vdef_test_frame_alloc(&linear, &vdef_nv21, &res);
+	fill_pad(&linear);
+	vdef_test_frame_alloc(&ref, &vdef_nv21_hisi_tile, &res);
+	fill_pad(&ref);
+	vdef_test_frame_alloc(&tiled, &vdef_nv21_hisi_tile, &res);
+	fill_pad(&tiled);
+	vdef_test_frame_alloc(&out, &vdef_nv21, &res);
+	fill_pad(&out);
+	fill_linear(&linear);
+
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      &ref.frame,
+				      ref.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(thread_counts); i++) {
+		ret = vdef_thread_pool_new(thread_counts[i], &pool);
+		CU_ASSERT_EQUAL_FATAL(ret, 0);
+		memset(tiled.data, PAD_VALUE, tiled.layout.size);
+		ret = vdef_convert_pix_layout(&linear.frame,
+					      (const void *const *)linear.plane,
+					      &tiled.frame,
+					      tiled.plane,
+					      pool);
+		CU_ASSERT_EQUAL(ret, 0);
+		CU_ASSERT_EQUAL(
+			memcmp(tiled.data, ref.data, tiled.layout.size), 0);
+
+		memset(out.data, 0, out.layout.size);
+		ret = vdef_convert_pix_layout(&tiled.frame,
+					      (const void *const *)tiled.plane,
+					      &out.frame,
+					      out.plane,
+					      pool);
+		CU_ASSERT_EQUAL(ret, 0);
+		check_linear(&linear, &out);
+		vdef_thread_pool_destroy(pool);
+	}
+
+	vdef_test_frame_free(&linear);
+	vdef_test_frame_free(&ref);
+	vdef_test_frame_free(&tiled);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_tile_invalid(void)
+{
+	struct vdef_dim res = {128, 32};
+	struct vdef_raw_format format;
+	struct vdef_test_frame linear, tiled;
+	int ret;
+
+	vdef_test_frame_alloc(&linear, &vdef_nv21, &res);
+	fill_pad(&linear);
+	vdef_test_frame_alloc(&tiled, &vdef_nv21_hisi_tile, &res);
+	fill_pad(&tiled);
+
+	/* Invalid arguments */
+	ret = vdef_convert_pix_layout(NULL,
+				      (const void *const *)linear.plane,
+				      &tiled.frame,
+				      tiled.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_pix_layout(
+		&linear.frame, NULL, &tiled.frame, tiled.plane, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      NULL,
+				      tiled.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      &tiled.frame,
+				      NULL,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* Resolution mismatch */
+	tiled.frame.info.resolution.height = 16;
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      &tiled.frame,
+				      tiled.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	tiled.frame.info.resolution.height = 32;
+
+	/* Tiled stride not holding whole tiles */
+	tiled.frame.plane_stride[1] = 96;
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      &tiled.frame,
+				      tiled.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	tiled.frame.plane_stride[1] = tiled.layout.plane_stride[1];
+
+	/* Linear to linear */
+	ret = vdef_convert_pix_layout(&linear.frame,
+				      (const void *const *)linear.plane,
+				      &linear.frame,
+				      tiled.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* Compressed tiles */
+	tiled.frame.format = vdef_nv21_hisi_tile_compressed;
+	ret = vdef_convert_pix_layout(&tiled.frame,
+				      (const void *const *)tiled.plane,
+				      &linear.frame,
+				      linear.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* Formats differing by more than the pixel layout */
+	tiled.frame.format = vdef_nv21_hisi_tile_10_packed;
+	ret = vdef_convert_pix_layout(&tiled.frame,
+				      (const void *const *)tiled.plane,
+				      &linear.frame,
+				      linear.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* Chroma order change of packed data */
+	linear.frame.format = vdef_nv12_10_packed;
+	ret = vdef_convert_pix_layout(&tiled.frame,
+				      (const void *const *)tiled.plane,
+				      &linear.frame,
+				      linear.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* Other than the HiSilicon tiles */
+	format = vdef_nv21;
+	format.pix_layout = VDEF_RAW_PIX_LAYOUT_UNKNOWN;
+	tiled.frame.format = format;
+	linear.frame.format = vdef_nv21;
+	ret = vdef_convert_pix_layout(&tiled.frame,
+				      (const void *const *)tiled.plane,
+				      &linear.frame,
+				      linear.plane,
+				      NULL);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	vdef_test_frame_free(&linear);
+	vdef_test_frame_free(&tiled);
+}
+
+
+CU_TestInfo g_vdef_test_tile[] = {
+	{FN("tile-golden"), &test_tile_golden},
+	{FN("tile-packed"), &test_tile_packed},
+	{FN("tile-chroma-order"), &test_tile_chroma_order},
+	{FN("tile-threads"), &test_tile_threads},
+	{FN("tile-invalid"), &test_tile_invalid},
+	CU_TEST_INFO_NULL,
+};
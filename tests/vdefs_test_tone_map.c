@@ -0,0 +1,598 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <math.h>
+
+
+/* Test luminance values (in cd/m2) */
+static const float s_nits[] = {
+	0.f, 1.f, 10.f, 50.f, 100.f, 203.f, 500.f, 1000.f, 4000.f, 10000.f};
+
+
+/* Test colors (linear light BT.2020 RGB in cd/m2) */
+static const float s_colors[][3] = {
+	{1000.f, 200.f, 50.f},
+	{20.f, 20.f, 20.f},
+	{5.f, 80.f, 300.f},
+	{600.f, 600.f, 10.f},
+};
+
+
+/* Color parameters of the HDR frames */
+static const struct vdef_format_info s_hdr_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT2020,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_PQ,
+	.matrix_coefs = VDEF_MATRIX_COEFS_BT2020_NON_CST,
+};
+
+
+/* Color parameters of the SDR frames */
+static const struct vdef_format_info s_sdr_info = {
+	.color_primaries = VDEF_COLOR_PRIMARIES_BT709,
+	.transfer_function = VDEF_TRANSFER_FUNCTION_BT709,
+	.matrix_coefs = VDEF_MATRIX_COEFS_BT709,
+};
+
+
+static struct vdef_raw_format s_rgb16;
+
+
+static void init_rgb16(void)
+{
+	s_rgb16 = vdef_rgb;
+	s_rgb16.data_size = 16;
+	s_rgb16.pix_size = 16;
+	s_rgb16.data_little_endian = true;
+}
+
+
+static uint16_t *rgb16_ptr(const struct vdef_test_frame *f, unsigned int i)
+{
+	return (uint16_t *)f->data + 3 * i;
+}
+
+
+static uint16_t pq_code(float nits)
+{
+	float v = vdef_transfer_function_from_linear(VDEF_TRANSFER_FUNCTION_PQ,
+						     nits / 10000.f);
+	return lroundf(v * UINT16_MAX);
+}
+
+
+static uint16_t sdr_code(float v)
+{
+	v = vdef_transfer_function_from_linear(VDEF_TRANSFER_FUNCTION_BT709, v);
+	return lroundf(v * UINT16_MAX);
+}
+
+
+/* Tone map the s_nits gray levels to 16-bit SDR values */
+static void tone_map_nits(enum vdef_tone_map_method method,
+			  const struct vdef_format_info *hdr_info,
+			  uint16_t *out_val)
+{
+	int res;
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_nits = {ARRAY_SIZE(s_nits), 1};
+
+	vdef_test_frame_alloc(&in, &s_rgb16, &res_nits);
+	vdef_test_frame_set_info(&in, &s_hdr_info);
+	vdef_test_frame_alloc(&out, &s_rgb16, &res_nits);
+	vdef_test_frame_set_info(&out, &s_sdr_info);
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_nits); i++) {
+		uint16_t *p = rgb16_ptr(&in, i);
+		p[0] = p[1] = p[2] = pq_code(s_nits[i]);
+	}
+
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    hdr_info,
+			    &out.frame,
+			    out.plane,
+			    method,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	for (unsigned int i = 0; i < ARRAY_SIZE(s_nits); i++) {
+		uint16_t *p = rgb16_ptr(&out, i);
+		out_val[i] = p[1];
+		/* Gray levels stay gray */
+		CU_ASSERT(abs(p[0] - p[1]) <= 8);
+		CU_ASSERT(abs(p[2] - p[1]) <= 8);
+	}
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_tone_map_curve(void)
+{
+	uint16_t out[ARRAY_SIZE(s_nits)];
+	unsigned int peak = 7;
+
+	init_rgb16();
+
+	for (int m = 0; m < VDEF_TONE_MAP_METHOD_MAX; m++) {
+		tone_map_nits(m, NULL, out);
+
+		/* Black to black, source peak (1000 cd/m2 by default) and
+		 * above to white, monotonic in between */
+		CU_ASSERT_EQUAL(out[0], 0);
+		CU_ASSERT(out[peak] >= UINT16_MAX - 64);
+		CU_ASSERT(out[peak + 1] >= UINT16_MAX - 64);
+		for (unsigned int i = 1; i < ARRAY_SIZE(s_nits); i++)
+			CU_ASSERT(out[i] >= out[i - 1]);
+
+		/* Highlights are compressed, below the SDR peak */
+		CU_ASSERT(out[4] < sdr_code(1.f) - 1000);
+	}
+
+	/* BT.2390 leaves the dark levels unchanged */
+	tone_map_nits(VDEF_TONE_MAP_METHOD_BT2390, NULL, out);
+	CU_ASSERT(abs(out[1] - sdr_code(0.01f)) <= 128);
+	CU_ASSERT(abs(out[2] - sdr_code(0.1f)) <= 128);
+
+	/* Reinhard: x * (1 + x / w^2) / (1 + x) with w = 10 */
+	tone_map_nits(VDEF_TONE_MAP_METHOD_REINHARD, NULL, out);
+	CU_ASSERT(abs(out[4] - sdr_code(0.505f)) <= 128);
+	CU_ASSERT(abs(out[3] - sdr_code(0.5f * 1.0025f / 1.5f)) <= 128);
+}
+
+
+static void test_tone_map_metadata(void)
+{
+	struct vdef_format_info info;
+	uint16_t ref[ARRAY_SIZE(s_nits)], out[ARRAY_SIZE(s_nits)];
+
+	init_rgb16();
+	memset(&info, 0, sizeof(info));
+
+	for (int m = 0; m < VDEF_TONE_MAP_METHOD_MAX; m++) {
+		tone_map_nits(m, NULL, ref);
+
+		/* 4000 cd/m2 mastering display: 1000 cd/m2 is not the peak */
+		info.mdcv.max_display_mastering_luminance = 4000.f;
+		info.cll.max_cll = 0;
+		tone_map_nits(m, &info, out);
+		CU_ASSERT(out[7] < ref[7] - 1000);
+		CU_ASSERT(out[8] >= UINT16_MAX - 64);
+		for (unsigned int i = 1; i < 7; i++)
+			CU_ASSERT(out[i] <= ref[i]);
+
+		/* The content light level limits the peak */
+		info.cll.max_cll = 1000;
+		tone_map_nits(m, &info, out);
+		for (unsigned int i = 0; i < ARRAY_SIZE(s_nits); i++)
+			CU_ASSERT(abs(out[i] - ref[i]) <= 2);
+
+		/* Without mdcv */
+		info.mdcv.max_display_mastering_luminance = 0.f;
+		tone_map_nits(m, &info, out);
+		for (unsigned int i = 0; i < ARRAY_SIZE(s_nits); i++)
+			CU_ASSERT(abs(out[i] - ref[i]) <= 2);
+
+		/* Mastering display black level */
+		info.mdcv.min_display_mastering_luminance = 0.05f;
+		info.mdcv.max_display_mastering_luminance = 1000.f;
+		info.cll.max_cll = 0;
+		tone_map_nits(m, &info, out);
+		CU_ASSERT_EQUAL(out[0], 0);
+		if (m == VDEF_TONE_MAP_METHOD_BT2390)
+			CU_ASSERT(out[1] < ref[1]);
+		info.mdcv.min_display_mastering_luminance = 0.f;
+	}
+}
+
+
+/* HDR10 I420 10-bit to SDR NV12, compared to the 16-bit RGB conversion */
+static void test_tone_map_yuv(void)
+{
+	int res;
+	struct vdef_test_frame rgb_in, yuv_in, yuv_out, rgb_out, rgb_ref;
+	struct vdef_dim res_flat = {34, 18};
+	unsigned int count = res_flat.width * res_flat.height;
+	struct vdef_format_info info;
+
+	init_rgb16();
+	memset(&info, 0, sizeof(info));
+	info.mdcv.max_display_mastering_luminance = 1000.f;
+	info.mdcv.min_display_mastering_luminance = 0.005f;
+	info.cll.max_cll = 800;
+
+	for (unsigned int k = 0; k < ARRAY_SIZE(s_colors); k++) {
+		vdef_test_frame_alloc(&rgb_in, &s_rgb16, &res_flat);
+		vdef_test_frame_set_info(&rgb_in, &s_hdr_info);
+		vdef_test_frame_alloc(&yuv_in, &vdef_i420_10_16le, &res_flat);
+		vdef_test_frame_set_info(&yuv_in, &s_hdr_info);
+		vdef_test_frame_alloc(&yuv_out, &vdef_nv12, &res_flat);
+		vdef_test_frame_set_info(&yuv_out, &s_sdr_info);
+		vdef_test_frame_alloc(&rgb_out, &vdef_rgb, &res_flat);
+		vdef_test_frame_set_info(&rgb_out, &s_sdr_info);
+		vdef_test_frame_alloc(&rgb_ref, &s_rgb16, &res_flat);
+		vdef_test_frame_set_info(&rgb_ref, &s_sdr_info);
+		for (unsigned int i = 0; i < count; i++) {
+			for (unsigned int c = 0; c < 3; c++)
+				rgb16_ptr(&rgb_in, i)[c] =
+					pq_code(s_colors[k][c]);
+		}
+
+		/* Reference */
+		res = vdef_tone_map(&rgb_in.frame,
+				    (const void *const *)rgb_in.plane,
+				    &info,
+				    &rgb_ref.frame,
+				    rgb_ref.plane,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    NULL);
+		CU_ASSERT_EQUAL(res, 0);
+
+		/* PQ to PQ conversion to YUV, tone mapping to YUV */
+		res = vdef_convert_gamut(&rgb_in.frame,
+					 (const void *const *)rgb_in.plane,
+					 &yuv_in.frame,
+					 yuv_in.plane,
+					 VDEF_GAMUT_CLIP_METHOD_HARD,
+					 NULL);
+		CU_ASSERT_EQUAL(res, 0);
+		res = vdef_tone_map(&yuv_in.frame,
+				    (const void *const *)yuv_in.plane,
+				    &info,
+				    &yuv_out.frame,
+				    yuv_out.plane,
+				    VDEF_TONE_MAP_METHOD_BT2390,
+				    VDEF_GAMUT_CLIP_METHOD_HARD,
+				    NULL);
+		CU_ASSERT_EQUAL(res, 0);
+		res = vdef_convert_yuv_to_rgb(
+			&yuv_out.frame,
+			(const void *const *)yuv_out.plane,
+			&rgb_out.frame,
+			rgb_out.plane);
+		CU_ASSERT_EQUAL(res, 0);
+
+		for (unsigned int i = 0; i < count; i++) {
+			for (unsigned int c = 0; c < 3; c++) {
+				int ref = (rgb16_ptr(&rgb_ref, i)[c] + 128) /
+					  257;
+				int v = rgb_out.data[3 * i + c];
+				CU_ASSERT(abs(v - ref) <= 4);
+			}
+		}
+
+		vdef_test_frame_free(&rgb_in);
+		vdef_test_frame_free(&yuv_in);
+		vdef_test_frame_free(&yuv_out);
+		vdef_test_frame_free(&rgb_out);
+		vdef_test_frame_free(&rgb_ref);
+	}
+}
+
+
+/* Tone mapping keeps the hue: the tone curve is applied to the maximum
+ * component and the other components are scaled by the same gain */
+static void test_tone_map_hue(void)
+{
+	int res;
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_1 = {1, 1};
+	uint16_t *p;
+	float lin[3];
+
+	init_rgb16();
+	vdef_test_frame_alloc(&in, &s_rgb16, &res_1);
+	vdef_test_frame_set_info(&in, &s_hdr_info);
+	vdef_test_frame_alloc(&out, &s_rgb16, &res_1);
+	vdef_test_frame_set_info(&out, &s_hdr_info);
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_BT709;
+	p = rgb16_ptr(&in, 0);
+	p[0] = pq_code(800.f);
+	p[1] = pq_code(400.f);
+	p[2] = pq_code(80.f);
+
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_HABLE,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, 0);
+	p = rgb16_ptr(&out, 0);
+	for (unsigned int c = 0; c < 3; c++)
+		lin[c] = vdef_transfer_function_to_linear(
+			VDEF_TRANSFER_FUNCTION_BT709, p[c] / (float)UINT16_MAX);
+	CU_ASSERT(lin[0] < 1.f);
+	CU_ASSERT(fabsf(lin[1] / lin[0] - 0.5f) < 0.01f);
+	CU_ASSERT(fabsf(lin[2] / lin[0] - 0.1f) < 0.01f);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_tone_map_p_log(void)
+{
+	int res;
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_p_log = {16, 2};
+
+	init_rgb16();
+
+	vdef_test_frame_alloc(&in, &s_rgb16, &res_p_log);
+	vdef_test_frame_set_info(&in, &s_hdr_info);
+	vdef_test_frame_alloc(&out, &s_rgb16, &res_p_log);
+	vdef_test_frame_set_info(&out, &s_sdr_info);
+	in.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_UNKNOWN;
+	in.frame.info.tone_mapping = VDEF_TONE_MAPPING_P_LOG;
+
+	/* The P-log curve is not supported */
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_UNKNOWN;
+	out.frame.info.tone_mapping = VDEF_TONE_MAPPING_P_LOG;
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+static void test_tone_map_threads(void)
+{
+	int res;
+	struct vdef_test_frame in, out[3];
+	struct vdef_dim res_odd = {131, 67};
+	const unsigned int threads[3] = {1, 3, 0};
+	struct vdef_thread_pool *pool;
+
+	vdef_test_frame_alloc(&in, &vdef_i420_10_16le, &res_odd);
+	vdef_test_frame_set_info(&in, &s_hdr_info);
+	srand(42);
+	for (size_t i = 0; i < in.layout.size / 2; i++)
+		((uint16_t *)in.data)[i] = 64 + rand() % 877;
+
+	for (unsigned int i = 0; i < 3; i++) {
+		vdef_test_frame_alloc(&out[i], &vdef_nv12, &res_odd);
+		vdef_test_frame_set_info(&out[i], &s_sdr_info);
+		res = vdef_thread_pool_new(threads[i], &pool);
+		CU_ASSERT_EQUAL_FATAL(res, 0);
+		res = vdef_tone_map(&in.frame,
+				    (const void *const *)in.plane,
+				    NULL,
+				    &out[i].frame,
+				    out[i].plane,
+				    VDEF_TONE_MAP_METHOD_REINHARD,
+				    VDEF_GAMUT_CLIP_METHOD_SOFT,
+				    pool);
+		CU_ASSERT_EQUAL(res, 0);
+		vdef_thread_pool_destroy(pool);
+	}
+	CU_ASSERT_EQUAL(memcmp(out[0].data, out[1].data, out[0].layout.size),
+			0);
+	CU_ASSERT_EQUAL(memcmp(out[0].data, out[2].data, out[0].layout.size),
+			0);
+
+	vdef_test_frame_free(&in);
+	for (unsigned int i = 0; i < 3; i++)
+		vdef_test_frame_free(&out[i]);
+}
+
+
+static void test_tone_map_sdr_info(void)
+{
+	int res;
+	struct vdef_format_info hdr, sdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.framerate.num = 30;
+	hdr.framerate.den = 1;
+	hdr.bit_depth = 10;
+	hdr.color_primaries = VDEF_COLOR_PRIMARIES_BT2020;
+	hdr.transfer_function = VDEF_TRANSFER_FUNCTION_PQ;
+	hdr.matrix_coefs = VDEF_MATRIX_COEFS_BT2020_NON_CST;
+	hdr.dynamic_range = VDEF_DYNAMIC_RANGE_HDR10;
+	hdr.tone_mapping = VDEF_TONE_MAPPING_STANDARD;
+	hdr.resolution.width = 1920;
+	hdr.resolution.height = 1080;
+	hdr.mdcv.display_primaries = VDEF_COLOR_PRIMARIES_DCI_P3;
+	hdr.mdcv.max_display_mastering_luminance = 1000.f;
+	hdr.mdcv.min_display_mastering_luminance = 0.005f;
+	hdr.cll.max_cll = 800;
+	hdr.cll.max_fall = 200;
+
+	res = vdef_tone_map_get_sdr_info(NULL, &sdr);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_map_get_sdr_info(&hdr, NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_tone_map_get_sdr_info(&hdr, &sdr);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(sdr.framerate.num, 30);
+	CU_ASSERT_EQUAL(sdr.framerate.den, 1);
+	CU_ASSERT_EQUAL(sdr.bit_depth, 8);
+	CU_ASSERT_EQUAL(sdr.color_primaries, VDEF_COLOR_PRIMARIES_BT709);
+	CU_ASSERT_EQUAL(sdr.transfer_function, VDEF_TRANSFER_FUNCTION_BT709);
+	CU_ASSERT_EQUAL(sdr.matrix_coefs, VDEF_MATRIX_COEFS_BT709);
+	CU_ASSERT_EQUAL(sdr.dynamic_range, VDEF_DYNAMIC_RANGE_SDR);
+	CU_ASSERT_EQUAL(sdr.tone_mapping, VDEF_TONE_MAPPING_STANDARD);
+	CU_ASSERT(vdef_dim_cmp(&sdr.resolution, &hdr.resolution));
+	CU_ASSERT_EQUAL(sdr.mdcv.display_primaries,
+			VDEF_COLOR_PRIMARIES_UNKNOWN);
+	CU_ASSERT_EQUAL(sdr.mdcv.max_display_mastering_luminance, 0.f);
+	CU_ASSERT_EQUAL(sdr.cll.max_cll, 0);
+	CU_ASSERT_EQUAL(sdr.cll.max_fall, 0);
+}
+
+
+static void test_tone_map_invalid(void)
+{
+	int res;
+	struct vdef_test_frame in, out;
+	struct vdef_dim res_small = {16, 16};
+
+	vdef_test_frame_alloc(&in, &vdef_i420_10_16le, &res_small);
+	vdef_test_frame_set_info(&in, &s_hdr_info);
+	vdef_test_frame_alloc(&out, &vdef_nv12, &res_small);
+	vdef_test_frame_set_info(&out, &s_sdr_info);
+
+	/* Invalid arguments */
+	res = vdef_tone_map(NULL,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    NULL,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_MAX,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_MAX,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Unsupported transfer functions */
+	in.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_HLG;
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	in.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_PQ;
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_PQ;
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_HLG;
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	out.frame.info.transfer_function = VDEF_TRANSFER_FUNCTION_BT709;
+	out.frame.info.tone_mapping = VDEF_TONE_MAPPING_P_LOG;
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	out.frame.info.tone_mapping = VDEF_TONE_MAPPING_STANDARD;
+
+	/* The gamut conversion does not tone map */
+	res = vdef_convert_gamut(&in.frame,
+				 (const void *const *)in.plane,
+				 &out.frame,
+				 out.plane,
+				 VDEF_GAMUT_CLIP_METHOD_HARD,
+				 NULL);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+
+	/* Valid conversion */
+	res = vdef_tone_map(&in.frame,
+			    (const void *const *)in.plane,
+			    NULL,
+			    &out.frame,
+			    out.plane,
+			    VDEF_TONE_MAP_METHOD_BT2390,
+			    VDEF_GAMUT_CLIP_METHOD_HARD,
+			    NULL);
+	CU_ASSERT_EQUAL(res, 0);
+
+	vdef_test_frame_free(&in);
+	vdef_test_frame_free(&out);
+}
+
+
+CU_TestInfo g_vdef_test_tone_map[] = {
+	{FN("tone-map-curve"), &test_tone_map_curve},
+	{FN("tone-map-metadata"), &test_tone_map_metadata},
+	{FN("tone-map-yuv"), &test_tone_map_yuv},
+	{FN("tone-map-hue"), &test_tone_map_hue},
+	{FN("tone-map-p-log"), &test_tone_map_p_log},
+	{FN("tone-map-threads"), &test_tone_map_threads},
+	{FN("tone-map-sdr-info"), &test_tone_map_sdr_info},
+	{FN("tone-map-invalid"), &test_tone_map_invalid},
+	CU_TEST_INFO_NULL,
+};
@@ -0,0 +1,520 @@
+/**
+ * Copyright (c) 2019 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Parrot Drones SAS Company nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE PARROT DRONES SAS COMPANY BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vdefs_test.h"
+
+#include <math.h>
+#include <pthread.h>
+
+
+#define TRANSFER_THREAD_COUNT 8
+
+/* Number of float values checked per table */
+#define FLOAT_VALUE_COUNT 20000
+
+
+static const unsigned int s_bit_depths[] = {8, 10, 12, 16};
+
+
+struct transfer_thread_ctx {
+	const struct vdef_transfer_lut *lut;
+};
+
+
+static unsigned int abs_diff(unsigned int a, unsigned int b)
+{
+	return a > b ? a - b : b - a;
+}
+
+
+static void test_transfer_function(void)
+{
+	/* Reference values */
+	static const struct {
+		enum vdef_transfer_function transfer;
+		float linear;
+		float value;
+	} values[] = {
+		{VDEF_TRANSFER_FUNCTION_BT709, 0.18f, 0.408848f},
+		{VDEF_TRANSFER_FUNCTION_BT709, 0.01f, 0.045f},
+		{VDEF_TRANSFER_FUNCTION_PQ, 0.01f, 0.508078f},
+		{VDEF_TRANSFER_FUNCTION_PQ, 1.f, 1.f},
+		{VDEF_TRANSFER_FUNCTION_HLG, 1.f / 12.f, 0.5f},
+		{VDEF_TRANSFER_FUNCTION_HLG, 0.5f, 0.871643f},
+		{VDEF_TRANSFER_FUNCTION_SRGB, 0.18f, 0.461356f},
+		{VDEF_TRANSFER_FUNCTION_SRGB, 0.001f, 0.01292f},
+	};
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(values); i++) {
+		float v = vdef_transfer_function_from_linear(
+			values[i].transfer, values[i].linear);
+		CU_ASSERT_DOUBLE_EQUAL(v, values[i].value, 1e-5);
+		v = vdef_transfer_function_to_linear(values[i].transfer,
+						     values[i].value);
+		CU_ASSERT_DOUBLE_EQUAL(v, values[i].linear, 1e-5);
+	}
+
+	/* Round trip and clamping */
+	for (unsigned int t = VDEF_TRANSFER_FUNCTION_BT601;
+	     t < VDEF_TRANSFER_FUNCTION_MAX;
+	     t++) {
+		for (unsigned int i = 0; i <= 100; i++) {
+			float v = i / 100.f;
+			v = vdef_transfer_function_to_linear(t, v);
+			v = vdef_transfer_function_from_linear(t, v);
+			CU_ASSERT_DOUBLE_EQUAL(v, i / 100.f, 1e-5);
+		}
+		CU_ASSERT_EQUAL(vdef_transfer_function_to_linear(t, -1.f), 0.f);
+		CU_ASSERT_DOUBLE_EQUAL(
+			vdef_transfer_function_from_linear(t, 2.f), 1.f, 1e-5);
+	}
+
+	CU_ASSERT_TRUE(isnan(vdef_transfer_function_to_linear(
+		VDEF_TRANSFER_FUNCTION_UNKNOWN, 0.5f)));
+	CU_ASSERT_TRUE(isnan(vdef_transfer_function_from_linear(
+		VDEF_TRANSFER_FUNCTION_MAX, 0.5f)));
+}
+
+
+static void check_to_linear(enum vdef_transfer_function transfer,
+			    unsigned int bit_depth)
+{
+	int res;
+	const struct vdef_transfer_lut *lut = NULL;
+	unsigned int max = (1u << bit_depth) - 1;
+	unsigned int count = max < UINT16_MAX ? max + 2 : max + 1;
+	uint16_t *src, *dst;
+	float *fdst;
+
+	res = vdef_transfer_lut_get(
+		transfer, VDEF_TRANSFER_LUT_DIR_TO_LINEAR, bit_depth, &lut);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lut);
+
+	/* The last value is out of range and must be clamped (except for
+	 * 16 bits) */
+	src = malloc(count * sizeof(*src));
+	dst = malloc(count * sizeof(*dst));
+	fdst = malloc(count * sizeof(*fdst));
+	CU_ASSERT_FATAL(src != NULL && dst != NULL && fdst != NULL);
+	for (unsigned int i = 0; i < count; i++)
+		src[i] = i;
+
+	res = vdef_transfer_lut_apply(lut, src, dst, count);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_transfer_lut_apply_to_float(lut, src, fdst, count);
+	CU_ASSERT_EQUAL(res, 0);
+
+	for (unsigned int i = 0; i < count; i++) {
+		float ref = vdef_transfer_function_to_linear(
+			transfer, (float)(i < max ? i : max) / max);
+		unsigned int ref16 = lroundf(ref * UINT16_MAX);
+		if (abs_diff(dst[i], ref16) > 1 ||
+		    fabsf(fdst[i] - ref) > 1e-6f) {
+			CU_FAIL("wrong linear value");
+			break;
+		}
+	}
+	CU_ASSERT_EQUAL(dst[0], 0);
+	CU_ASSERT_EQUAL(dst[count - 1], UINT16_MAX);
+
+	/* In place */
+	res = vdef_transfer_lut_apply(lut, src, src, count);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_EQUAL(memcmp(src, dst, count * sizeof(*src)), 0);
+
+	free(src);
+	free(dst);
+	free(fdst);
+}
+
+
+static void check_from_linear(enum vdef_transfer_function transfer,
+			      unsigned int bit_depth)
+{
+	int res;
+	const struct vdef_transfer_lut *lut = NULL;
+	unsigned int max = (1u << bit_depth) - 1;
+	unsigned int tolerance = bit_depth > 12 ? 4 : 1;
+	uint16_t *src, *dst;
+	float *fsrc, ref;
+
+	res = vdef_transfer_lut_get(
+		transfer, VDEF_TRANSFER_LUT_DIR_FROM_LINEAR, bit_depth, &lut);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lut);
+
+	src = malloc((UINT16_MAX + 1) * sizeof(*src));
+	dst = malloc((UINT16_MAX + 1) * sizeof(*dst));
+	fsrc = malloc(FLOAT_VALUE_COUNT * sizeof(*fsrc));
+	CU_ASSERT_FATAL(src != NULL && dst != NULL && fsrc != NULL);
+
+	/* 16-bit linear light */
+	for (unsigned int i = 0; i <= UINT16_MAX; i++)
+		src[i] = i;
+	res = vdef_transfer_lut_apply(lut, src, dst, UINT16_MAX + 1);
+	CU_ASSERT_EQUAL(res, 0);
+	for (unsigned int i = 0; i <= UINT16_MAX; i++) {
+		ref = vdef_transfer_function_from_linear(
+			transfer, (float)i / UINT16_MAX);
+		if (abs_diff(dst[i], lroundf(ref * max)) > 1) {
+			CU_FAIL("wrong code value");
+			break;
+		}
+	}
+
+	/* Float linear light, log-spaced from 1e-7 to 1 */
+	for (unsigned int i = 0; i < FLOAT_VALUE_COUNT; i++)
+		fsrc[i] = powf(10.f, -7.f * i / (FLOAT_VALUE_COUNT - 1));
+	res = vdef_transfer_lut_apply_from_float(
+		lut, fsrc, dst, FLOAT_VALUE_COUNT);
+	CU_ASSERT_EQUAL(res, 0);
+	for (unsigned int i = 0; i < FLOAT_VALUE_COUNT; i++) {
+		ref = vdef_transfer_function_from_linear(transfer, fsrc[i]);
+		if (abs_diff(dst[i], lroundf(ref * max)) > tolerance) {
+			CU_FAIL("wrong code value from float");
+			break;
+		}
+	}
+
+	/* Out of range values */
+	fsrc[0] = 0.f;
+	fsrc[1] = -1.f;
+	fsrc[2] = NAN;
+	fsrc[3] = 2.f;
+	fsrc[4] = INFINITY;
+	res = vdef_transfer_lut_apply_from_float(lut, fsrc, dst, 5);
+	CU_ASSERT_EQUAL(res, 0);
+	ref = vdef_transfer_function_from_linear(transfer, 0.f);
+	CU_ASSERT_EQUAL(dst[0], lroundf(ref * max));
+	CU_ASSERT_EQUAL(dst[1], dst[0]);
+	CU_ASSERT_EQUAL(dst[2], dst[0]);
+	CU_ASSERT_EQUAL(dst[3], max);
+	CU_ASSERT_EQUAL(dst[4], max);
+
+	free(src);
+	free(dst);
+	free(fsrc);
+}
+
+
+static void test_transfer_lut(void)
+{
+	for (unsigned int t = VDEF_TRANSFER_FUNCTION_BT601;
+	     t < VDEF_TRANSFER_FUNCTION_MAX;
+	     t++) {
+		for (unsigned int i = 0; i < ARRAY_SIZE(s_bit_depths); i++) {
+			check_to_linear(t, s_bit_depths[i]);
+			check_from_linear(t, s_bit_depths[i]);
+		}
+	}
+}
+
+
+static void test_transfer_p_log_lut(void)
+{
+	int res;
+	const struct vdef_transfer_lut *lut = NULL;
+	struct vdef_format_info info = {
+		.bit_depth = 10,
+		.transfer_function = VDEF_TRANSFER_FUNCTION_BT709,
+		.tone_mapping = VDEF_TONE_MAPPING_P_LOG,
+	};
+
+	/* The P-log curve is not supported */
+	for (unsigned int d = 0; d < VDEF_TRANSFER_LUT_DIR_MAX; d++) {
+		res = vdef_tone_mapping_lut_get(
+			VDEF_TONE_MAPPING_P_LOG, d, 10, &lut);
+		CU_ASSERT_EQUAL(res, -ENOTSUP);
+		res = vdef_format_info_lut_get(&info, d, &lut);
+		CU_ASSERT_EQUAL(res, -ENOTSUP);
+	}
+	CU_ASSERT_PTR_NULL(lut);
+
+	/* The transfer function table is used for the standard tone
+	 * mapping */
+	info.tone_mapping = VDEF_TONE_MAPPING_STANDARD;
+	res = vdef_format_info_lut_get(
+		&info, VDEF_TRANSFER_LUT_DIR_TO_LINEAR, &lut);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL(lut);
+}
+
+
+static void check_display(enum vdef_transfer_function transfer,
+			  unsigned int bit_depth,
+			  unsigned int gray,
+			  unsigned int *ret_gray)
+{
+	int res;
+	const struct vdef_transfer_lut *lut = NULL;
+	struct vdef_format_info info = {
+		.bit_depth = bit_depth,
+		.transfer_function = transfer,
+		.tone_mapping = VDEF_TONE_MAPPING_STANDARD,
+	};
+	unsigned int max = (1u << bit_depth) - 1;
+	uint16_t *src, *dst;
+
+	res = vdef_format_info_lut_get(
+		&info, VDEF_TRANSFER_LUT_DIR_TO_BT709, &lut);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+
+	src = malloc((max + 1) * sizeof(*src));
+	dst = malloc((max + 1) * sizeof(*dst));
+	CU_ASSERT_FATAL(src != NULL && dst != NULL);
+	for (unsigned int i = 0; i <= max; i++)
+		src[i] = i;
+	res = vdef_transfer_lut_apply(lut, src, dst, max + 1);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Black to black, peak to white, monotonic in between */
+	CU_ASSERT_EQUAL(dst[0], 0);
+	CU_ASSERT_EQUAL(dst[max], max);
+	for (unsigned int i = 1; i <= max; i++) {
+		if (dst[i] < dst[i - 1]) {
+			CU_FAIL("display curve is not monotonic");
+			break;
+		}
+	}
+	*ret_gray = dst[gray];
+
+	free(src);
+	free(dst);
+}
+
+
+static void test_transfer_display_lut(void)
+{
+	unsigned int out, gray;
+	/* BT.709 code values of the mid gray */
+	unsigned int ref8 = lroundf(0.408848f * 255);
+	unsigned int ref10 = lroundf(0.408848f * 1023);
+
+	/* Same curve: identity */
+	check_display(VDEF_TRANSFER_FUNCTION_BT709, 8, ref8, &out);
+	CU_ASSERT_EQUAL(out, ref8);
+
+	/* SDR curve */
+	gray = lroundf(0.461356f * 255);
+	check_display(VDEF_TRANSFER_FUNCTION_SRGB, 8, gray, &out);
+	CU_ASSERT(abs_diff(out, ref8) <= 1);
+
+	/* HDR curve: the mid gray (18 cd/m2) is below the BT.2390 knee */
+	gray = lroundf(vdef_transfer_function_from_linear(
+			       VDEF_TRANSFER_FUNCTION_PQ, 0.0018f) *
+		       1023);
+	check_display(VDEF_TRANSFER_FUNCTION_PQ, 10, gray, &out);
+	CU_ASSERT(abs_diff(out, ref10) <= 3);
+}
+
+
+static void *transfer_thread(void *userdata)
+{
+	struct transfer_thread_ctx *ctx = userdata;
+
+	(void)vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_HLG,
+				    VDEF_TRANSFER_LUT_DIR_FROM_LINEAR,
+				    14,
+				    &ctx->lut);
+
+	return NULL;
+}
+
+
+static void test_transfer_lut_cache(void)
+{
+	int res;
+	const struct vdef_transfer_lut *lut1 = NULL, *lut2 = NULL;
+	pthread_t threads[TRANSFER_THREAD_COUNT];
+	struct transfer_thread_ctx ctx[TRANSFER_THREAD_COUNT] = {0};
+
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_PQ,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    10,
+				    &lut1);
+	CU_ASSERT_EQUAL(res, 0);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_PQ,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    10,
+				    &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_PTR_NOT_NULL(lut1);
+	CU_ASSERT_TRUE(lut1 == lut2);
+
+	/* Different keys give different tables */
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_PQ,
+				    VDEF_TRANSFER_LUT_DIR_FROM_LINEAR,
+				    10,
+				    &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 != lut2);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_PQ,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    12,
+				    &lut2);
+	CU_ASSERT_EQUAL(res, 0);
+	CU_ASSERT_TRUE(lut1 != lut2);
+
+	/* Concurrent first use */
+	for (unsigned int i = 0; i < TRANSFER_THREAD_COUNT; i++) {
+		res = pthread_create(
+			&threads[i], NULL, transfer_thread, &ctx[i]);
+		CU_ASSERT_EQUAL(res, 0);
+	}
+	for (unsigned int i = 0; i < TRANSFER_THREAD_COUNT; i++)
+		pthread_join(threads[i], NULL);
+
+	/* All threads must get the same table */
+	CU_ASSERT_PTR_NOT_NULL(ctx[0].lut);
+	for (unsigned int i = 1; i < TRANSFER_THREAD_COUNT; i++)
+		CU_ASSERT_TRUE(ctx[i].lut == ctx[0].lut);
+}
+
+
+static void test_transfer_lut_invalid(void)
+{
+	int res;
+	const struct vdef_transfer_lut *to = NULL, *from = NULL;
+	uint16_t u16 = 0;
+	float f32 = 0.f;
+
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_UNKNOWN,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    8,
+				    &to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_MAX,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    8,
+				    &to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_MAX,
+				    8,
+				    &to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    0,
+				    &to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    17,
+				    &to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    8,
+				    NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+				    8,
+				    &to);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_FROM_LINEAR,
+				    8,
+				    &from);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+
+	res = vdef_transfer_lut_apply(NULL, &u16, &u16, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply(to, NULL, &u16, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply(to, &u16, NULL, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply(to, NULL, NULL, 0);
+	CU_ASSERT_EQUAL(res, 0);
+
+	/* Wrong direction */
+	res = vdef_transfer_lut_apply_to_float(from, &u16, &f32, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply_from_float(to, &f32, &u16, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply_to_float(NULL, &u16, &f32, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply_from_float(NULL, &f32, &u16, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_get(VDEF_TRANSFER_FUNCTION_SRGB,
+				    VDEF_TRANSFER_LUT_DIR_TO_BT709,
+				    8,
+				    &to);
+	CU_ASSERT_EQUAL_FATAL(res, 0);
+	res = vdef_transfer_lut_apply_to_float(to, &u16, &f32, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_transfer_lut_apply_from_float(to, &f32, &u16, 1);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+
+	/* Tone mapping tables */
+	res = vdef_tone_mapping_lut_get(VDEF_TONE_MAPPING_UNKNOWN,
+					VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+					8,
+					&to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_mapping_lut_get(VDEF_TONE_MAPPING_MAX,
+					VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+					8,
+					&to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_mapping_lut_get(VDEF_TONE_MAPPING_P_LOG,
+					VDEF_TRANSFER_LUT_DIR_MAX,
+					8,
+					&to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_mapping_lut_get(VDEF_TONE_MAPPING_P_LOG,
+					VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+					17,
+					&to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_mapping_lut_get(VDEF_TONE_MAPPING_P_LOG,
+					VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+					8,
+					NULL);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+	res = vdef_tone_mapping_lut_get(VDEF_TONE_MAPPING_STANDARD,
+					VDEF_TRANSFER_LUT_DIR_TO_LINEAR,
+					8,
+					&to);
+	CU_ASSERT_EQUAL(res, -ENOTSUP);
+	res = vdef_format_info_lut_get(
+		NULL, VDEF_TRANSFER_LUT_DIR_TO_LINEAR, &to);
+	CU_ASSERT_EQUAL(res, -EINVAL);
+}
+
+
+CU_TestInfo g_vdef_test_transfer[] = {
+	{FN("transfer-function"), &test_transfer_function},
+	{FN("transfer-lut"), &test_transfer_lut},
+	{FN("transfer-p-log-lut"), &test_transfer_p_log_lut},
+	{FN("transfer-display-lut"), &test_transfer_display_lut},
+	{FN("transfer-lut-cache"), &test_transfer_lut_cache},
+	{FN("transfer-lut-invalid"), &test_transfer_lut_invalid},
+	CU_TEST_INFO_NULL,
+};